@@ -0,0 +1,100 @@
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "AFn.h"
+#include "Bool.h"
+#include "Compiler.h"
+#include "gc.h"
+#include "LineNumberReader.h"
+#include "Numbers.h"
+#include "Reader.h"
+#include "RunTime.h"
+#include "Symbol.h"
+#include "Var.h"
+
+// Times the same forms under the tree walker and the bytecode VM.  The runtime has no arithmetic of its own yet, so
+// the forms call a few primitives defined here.
+
+#define ITERATIONS 20
+
+static const lisp_object* invokeInc(__attribute__((unused)) const IFn *self, const lisp_object *x) {
+	return (lisp_object*)NewInteger(IntegerValue((Integer*)x) + 1);
+}
+
+static const lisp_object* invokeLess(__attribute__((unused)) const IFn *self, const lisp_object *x, const lisp_object *y) {
+	return (lisp_object*)(IntegerValue((Integer*)x) < IntegerValue((Integer*)y) ? True : False);
+}
+
+const IFn_vtable Inc_IFn_vtable = {
+	invoke0AFn,	// invoke0
+	invokeInc,	// invoke1
+	invoke2AFn,	// invoke2
+	invoke3AFn,	// invoke3
+	invoke4AFn,	// invoke4
+	invoke5AFn,	// invoke5
+	applyToAFn,	// applyTo
+};
+
+const IFn_vtable Less_IFn_vtable = {
+	invoke0AFn,	// invoke0
+	invoke1AFn,	// invoke1
+	invokeLess,	// invoke2
+	invoke3AFn,	// invoke3
+	invoke4AFn,	// invoke4
+	invoke5AFn,	// invoke5
+	applyToAFn,	// applyTo
+};
+
+interfaces Inc_interfaces = {NULL, NULL, NULL, NULL, NULL, &Inc_IFn_vtable, NULL, NULL, NULL, NULL, NULL, NULL};
+interfaces Less_interfaces = {NULL, NULL, NULL, NULL, NULL, &Less_IFn_vtable, NULL, NULL, NULL, NULL, NULL, NULL};
+
+const lisp_object Inc = {IFN_type, sizeof(lisp_object), NULL, &Inc_interfaces};
+const lisp_object Less = {IFN_type, sizeof(lisp_object), NULL, &Less_interfaces};
+
+typedef struct bench_data {
+	char *name;
+	char *form;
+} bench_data;
+
+static const lisp_object* readString(char *s) {
+	return read(MemOpenLineNumberReader(s, strlen(s)), true, '\0');
+}
+
+// Each form is a fn of n.  It is evaluated once per back end, since *use-bytecode* is read when the fn is analyzed,
+// and only the calls are timed.
+static double timeCalls(const lisp_object *form, const lisp_object *n) {
+	const IFn *f = (IFn*)Eval(form);
+	clock_t start = clock();
+	for(size_t i = 0; i < ITERATIONS; i++)
+		f->obj.fns->IFnFns->invoke1(f, n);
+	return (double)(clock() - start) / CLOCKS_PER_SEC;
+}
+
+int main(void) {
+	GC_INIT();
+	initRT();
+	internVar(LISP_ns, internSymbol1("inc"), &Inc, true);
+	internVar(LISP_ns, internSymbol1("<"), &Less, true);
+	Var *useBytecode = internVar(LISP_ns, internSymbol1("*use-bytecode*"), (lisp_object*)False, false);
+
+	bench_data data[] = {
+		{"loop", "(fn* [n] (loop [i 0] (if (< i n) (recur (inc i)) i)))"},
+		{"calls", "(fn* [n] (loop [i 0 j 0] (if (< i n) (recur (inc i) (inc (inc (inc j)))) j)))"},
+		{"let", "(fn* [n] (loop [i 0] (if (< i n) (recur (let* [a (inc i) b a] b)) i)))"},
+		{"recur", "(fn* f ([n] (f 0 n)) ([i n] (if (< i n) (recur (inc i) n) i)))"},
+		{"tail", "(fn* f ([n] (f 0 n)) ([i n] (if (< i n) (f (inc i) n) i)))"},
+	};
+	const lisp_object *n = (lisp_object*)NewInteger(100000);
+
+	printf("%-8s %12s %12s %8s\n", "bench", "tree (s)", "bytecode (s)", "speedup");
+	for(size_t i = 0; i < sizeof(data) / sizeof(data[0]); i++) {
+		const lisp_object *form = readString(data[i].form);
+		bindRoot(useBytecode, (lisp_object*)False);
+		double tree = timeCalls(form, n);
+		bindRoot(useBytecode, (lisp_object*)True);
+		double bytecode = timeCalls(form, n);
+		printf("%-8s %12.3f %12.3f %7.2fx\n", data[i].name, tree, bytecode, tree / bytecode);
+	}
+	return 0;
+}
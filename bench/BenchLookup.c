@@ -0,0 +1,75 @@
+#include <stdio.h>
+#include <time.h>
+
+#include "gc.h"
+#include "Interfaces.h"
+#include "Keyword.h"
+#include "Map.h"
+#include "Numbers.h"
+
+// Times a constant key lookup, as (:k m) does it, through a KeyLookupSite and through plain valAt.  "same" looks up
+// one map over and over, and "rotate" cycles through many maps, where only the cached hash is any help.
+
+#define KEYS 16
+#define MAPS 1000
+#define LOOKUPS 10000000
+
+static const lisp_object *maps[MAPS];
+
+static double timeValAt(const lisp_object *key, size_t stride) {
+	long sum = 0;
+	clock_t start = clock();
+	for(size_t i = 0; i < LOOKUPS; i++) {
+		const IMap *m = (IMap*)maps[(i * stride) % MAPS];
+		sum += IntegerValue((Integer*)m->obj.fns->IMapFns->valAt(m, key, NULL));
+	}
+	double ret = (double)(clock() - start) / CLOCKS_PER_SEC;
+	if(sum != (long)LOOKUPS * (KEYS / 2))
+		printf("Bad sum %ld\n", sum);
+	return ret;
+}
+
+static double timeSite(const lisp_object *key, size_t stride) {
+	long sum = 0;
+	KeyLookupSite site;
+	initKeyLookupSite(&site, key);
+	clock_t start = clock();
+	for(size_t i = 0; i < LOOKUPS; i++) {
+		const HashMap *m = (HashMap*)maps[(i * stride) % MAPS];
+		sum += IntegerValue((Integer*)siteLookupHashMap(m, &site, NULL));
+	}
+	double ret = (double)(clock() - start) / CLOCKS_PER_SEC;
+	if(sum != (long)LOOKUPS * (KEYS / 2))
+		printf("Bad sum %ld\n", sum);
+	return ret;
+}
+
+int main(void) {
+	GC_INIT();
+	const lisp_object *entries[2 * KEYS];
+	for(size_t i = 0; i < KEYS; i++) {
+		char name[8];
+		snprintf(name, sizeof(name), "k%zu", i);
+		entries[2*i] = (lisp_object*)internKeyword1(name);
+		entries[2*i+1] = (lisp_object*)NewInteger(i);
+	}
+	for(size_t i = 0; i < MAPS; i++)
+		maps[i] = (lisp_object*)CreateHashMap(2 * KEYS, entries);
+	const lisp_object *key = entries[2 * (KEYS / 2)];
+
+	struct {
+		char *name;
+		size_t stride;
+	} data[] = {
+		{"same", 0},
+		{"rotate", 1},
+	};
+
+	printf("%-8s %12s %12s %8s\n", "maps", "valAt (s)", "site (s)", "speedup");
+	for(size_t i = 0; i < sizeof(data) / sizeof(data[0]); i++) {
+		double valAt = timeValAt(key, data[i].stride);
+		double site = timeSite(key, data[i].stride);
+		printf("%-8s %12.3f %12.3f %7.2fx\n", data[i].name, valAt, site, valAt / site);
+	}
+	return 0;
+}
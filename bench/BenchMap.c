@@ -0,0 +1,117 @@
+#include <stdio.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "ChampMap.h"
+#include "gc.h"
+#include "Interfaces.h"
+#include "Map.h"
+#include "MapEntry.h"
+#include "Numbers.h"
+#include "Util.h"
+
+// Compares the HashMap node layout with the CHAMP one on the same entries: heap retained by the map, a full walk of
+// its seq, and Equiv against an equal map built in the opposite order.
+
+#define ENTRIES 100000
+#define ITERATIONS 20
+
+static const lisp_object *entries[2 * ENTRIES];
+static const lisp_object *reversed[2 * ENTRIES];
+
+typedef const lisp_object* (*MapBuilder)(size_t count, const lisp_object **entries);
+
+static const lisp_object* buildHashMap(size_t count, const lisp_object **entries) {
+	return (lisp_object*)CreateHashMap(count, entries);
+}
+
+static const lisp_object* buildChampMap(size_t count, const lisp_object **entries) {
+	return (lisp_object*)CreateChampMap(count, entries);
+}
+
+static size_t heapInUse(void) {
+	GC_gcollect();
+	return GC_get_heap_size() - GC_get_free_bytes();
+}
+
+// Builds the map in a child process, so the heap it measures holds nothing left over from the other layouts.
+// The result comes back through a temporary file: the Reader's read() shadows the system call.
+static size_t footprint(MapBuilder build) {
+	FILE *f = tmpfile();
+	size_t ret = 0;
+	if(f == NULL)
+		return 0;
+	pid_t pid = fork();
+	if(pid == 0) {
+		size_t before = heapInUse();
+		const lisp_object *map = build(2 * ENTRIES, entries);
+		size_t after = heapInUse();
+		ret = map != NULL ? after - before : 0;
+		fwrite(&ret, sizeof(ret), 1, f);
+		fflush(f);
+		_exit(0);
+	}
+	if(pid > 0) {
+		waitpid(pid, NULL, 0);
+		rewind(f);
+		if(fread(&ret, sizeof(ret), 1, f) != 1)
+			ret = 0;
+	}
+	fclose(f);
+	return ret;
+}
+
+static double timeIterate(const lisp_object *map) {
+	long sum = 0;
+	clock_t start = clock();
+	for(size_t i = 0; i < ITERATIONS; i++) {
+		for(const ISeq *s = seq(map); s != NULL; s = s->obj.fns->ISeqFns->next(s)) {
+			const MapEntry *e = (MapEntry*)s->obj.fns->ISeqFns->first(s);
+			sum += IntegerValue((Integer*)e->val);
+		}
+	}
+	double ret = (double)(clock() - start) / CLOCKS_PER_SEC;
+	if(sum != (long)ITERATIONS * ENTRIES * (ENTRIES - 1) / 2)
+		printf("Bad sum %ld\n", sum);
+	return ret;
+}
+
+static double timeEquiv(const lisp_object *x, const lisp_object *y) {
+	clock_t start = clock();
+	for(size_t i = 0; i < ITERATIONS; i++) {
+		if(!Equiv(x, y))
+			printf("Maps not equal\n");
+	}
+	return (double)(clock() - start) / CLOCKS_PER_SEC;
+}
+
+int main(void) {
+	GC_INIT();
+	for(size_t i = 0; i < ENTRIES; i++) {
+		entries[2*i] = (lisp_object*)NewInteger(i * 7919);
+		entries[2*i+1] = (lisp_object*)NewInteger(i);
+		reversed[2*(ENTRIES-1-i)] = entries[2*i];
+		reversed[2*(ENTRIES-1-i)+1] = entries[2*i+1];
+	}
+
+	struct {
+		char *name;
+		MapBuilder build;
+	} data[] = {
+		{"hamt", buildHashMap},
+		{"champ", buildChampMap},
+	};
+
+	printf("%-8s %12s %12s %12s\n", "layout", "heap (KB)", "iterate (s)", "equiv (s)");
+	for(size_t i = 0; i < sizeof(data) / sizeof(data[0]); i++) {
+		size_t heap = footprint(data[i].build);
+		const lisp_object *map = data[i].build(2 * ENTRIES, entries);
+		const lisp_object *other = data[i].build(2 * ENTRIES, reversed);
+		double iterate = timeIterate(map);
+		double equiv = timeEquiv(map, other);
+		printf("%-8s %12zu %12.3f %12.3f\n", data[i].name, heap / 1024, iterate, equiv);
+	}
+	return 0;
+}
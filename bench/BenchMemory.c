@@ -0,0 +1,109 @@
+#include <stdio.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "gc.h"
+#include "Interfaces.h"
+#include "Map.h"
+#include "Numbers.h"
+#include "PrimVector.h"
+#include "Vector.h"
+
+// Heap retained per entry by HashMaps and Vectors of several sizes, built both through a transient and one persistent
+// step at a time, and by a vector of unboxed bytes.  The keys and values are made before measuring, so the figures are
+// the trie's own overhead.
+
+#define MAX_ENTRIES 1000000
+
+static const lisp_object *entries[2 * MAX_ENTRIES];
+static const signed char bytes[MAX_ENTRIES];
+
+typedef const lisp_object* (*Builder)(size_t count);
+
+static const lisp_object* buildHashMap(size_t count) {
+	return (lisp_object*)CreateHashMap(2 * count, entries);
+}
+
+static const lisp_object* assocHashMap(size_t count) {
+	const IMap *m = (IMap*)EmptyHashMap;
+	for(size_t i = 0; i < count; i++)
+		m = m->obj.fns->IMapFns->assoc(m, entries[2*i], entries[2*i+1]);
+	return (lisp_object*)m;
+}
+
+static const lisp_object* buildVector(size_t count) {
+	return (lisp_object*)CreateVector(count, entries);
+}
+
+static const lisp_object* consVector(size_t count) {
+	const IVector *v = (IVector*)EmptyVector;
+	for(size_t i = 0; i < count; i++)
+		v = v->obj.fns->IVectorFns->cons(v, entries[i]);
+	return (lisp_object*)v;
+}
+
+static const lisp_object* buildByteVector(size_t count) {
+	return (lisp_object*)CreatePrimVectorFromArray(PRIM_BYTE, count, bytes);
+}
+
+static size_t heapInUse(void) {
+	GC_gcollect();
+	return GC_get_heap_size() - GC_get_free_bytes();
+}
+
+// Builds the collection in a child process, so the heap it measures holds nothing left over from the others.
+// The result comes back through a temporary file: the Reader's read() shadows the system call.
+static size_t footprint(Builder build, size_t count) {
+	FILE *f = tmpfile();
+	size_t ret = 0;
+	if(f == NULL)
+		return 0;
+	pid_t pid = fork();
+	if(pid == 0) {
+		size_t before = heapInUse();
+		const lisp_object *coll = build(count);
+		size_t after = heapInUse();
+		ret = coll != NULL && after > before ? after - before : 0;
+		fwrite(&ret, sizeof(ret), 1, f);
+		fflush(f);
+		_exit(0);
+	}
+	if(pid > 0) {
+		waitpid(pid, NULL, 0);
+		rewind(f);
+		if(fread(&ret, sizeof(ret), 1, f) != 1)
+			ret = 0;
+	}
+	fclose(f);
+	return ret;
+}
+
+int main(void) {
+	GC_INIT();
+	for(size_t i = 0; i < MAX_ENTRIES; i++) {
+		entries[2*i] = (lisp_object*)NewInteger(i * 7919);
+		entries[2*i+1] = (lisp_object*)NewInteger(i);
+	}
+
+	struct {
+		char *name;
+		Builder build;
+	} data[] = {
+		{"map transient", buildHashMap},
+		{"map assoc", assocHashMap},
+		{"vector transient", buildVector},
+		{"vector cons", consVector},
+		{"byte vector", buildByteVector},
+	};
+	size_t counts[] = {1000, 100000, MAX_ENTRIES};
+
+	printf("%-18s %10s %16s\n", "collection", "entries", "bytes / entry");
+	for(size_t i = 0; i < sizeof(data) / sizeof(data[0]); i++) {
+		for(size_t j = 0; j < sizeof(counts) / sizeof(counts[0]); j++) {
+			size_t heap = footprint(data[i].build, counts[j]);
+			printf("%-18s %10zu %16.1f\n", data[i].name, counts[j], (double)heap / counts[j]);
+		}
+	}
+	return 0;
+}
@@ -0,0 +1,108 @@
+#include <stdio.h>
+#include <time.h>
+
+#include "AFn.h"
+#include "gc.h"
+#include "Interfaces.h"
+#include "Map.h"
+#include "MapEntry.h"
+#include "Numbers.h"
+#include "Util.h"
+
+// Sums the values of a HashMap by walking its seq, by kvreduce, and by fold.  Times are wall clock, since fold may use
+// several threads.
+
+#define ENTRIES 1000000
+#define ITERATIONS 5
+
+static const lisp_object *entries[2 * ENTRIES];
+
+static const lisp_object* invokeSumEntry(__attribute__((unused)) const IFn *self, const lisp_object *acc, __attribute__((unused)) const lisp_object *key, const lisp_object *val) {
+	return (lisp_object*)NewInteger(IntegerValue((Integer*)acc) + IntegerValue((Integer*)val));
+}
+
+static const lisp_object* invokeZero(__attribute__((unused)) const IFn *self) {
+	return (lisp_object*)NewInteger(0);
+}
+
+static const lisp_object* invokePlus(__attribute__((unused)) const IFn *self, const lisp_object *x, const lisp_object *y) {
+	return (lisp_object*)NewInteger(IntegerValue((Integer*)x) + IntegerValue((Integer*)y));
+}
+
+const IFn_vtable SumEntry_IFn_vtable = {
+	invoke0AFn,		// invoke0
+	invoke1AFn,		// invoke1
+	invoke2AFn,		// invoke2
+	invokeSumEntry,	// invoke3
+	invoke4AFn,		// invoke4
+	invoke5AFn,		// invoke5
+	applyToAFn,		// applyTo
+};
+
+const IFn_vtable Plus_IFn_vtable = {
+	invokeZero,	// invoke0
+	invoke1AFn,	// invoke1
+	invokePlus,	// invoke2
+	invoke3AFn,	// invoke3
+	invoke4AFn,	// invoke4
+	invoke5AFn,	// invoke5
+	applyToAFn,	// applyTo
+};
+
+interfaces SumEntry_interfaces = {NULL, NULL, NULL, NULL, NULL, &SumEntry_IFn_vtable, NULL, NULL, NULL, NULL, NULL, NULL};
+interfaces Plus_interfaces = {NULL, NULL, NULL, NULL, NULL, &Plus_IFn_vtable, NULL, NULL, NULL, NULL, NULL, NULL};
+
+const lisp_object SumEntry = {IFN_type, sizeof(lisp_object), NULL, &SumEntry_interfaces};
+const lisp_object Plus = {IFN_type, sizeof(lisp_object), NULL, &Plus_interfaces};
+
+static double now(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static long sumSeq(const HashMap *hm) {
+	long sum = 0;
+	for(const ISeq *s = seq((lisp_object*)hm); s != NULL; s = s->obj.fns->ISeqFns->next(s)) {
+		const MapEntry *e = (MapEntry*)s->obj.fns->ISeqFns->first(s);
+		sum += IntegerValue((Integer*)e->val);
+	}
+	return sum;
+}
+
+static long sumKVReduce(const HashMap *hm) {
+	return IntegerValue((Integer*)kvreduceHashMap(hm, (IFn*)&SumEntry, (lisp_object*)NewInteger(0)));
+}
+
+static long sumFold(const HashMap *hm) {
+	return IntegerValue((Integer*)foldHashMap(hm, 512, (IFn*)&Plus, (IFn*)&SumEntry));
+}
+
+int main(void) {
+	GC_INIT();
+	for(size_t i = 0; i < ENTRIES; i++) {
+		entries[2*i] = (lisp_object*)NewInteger(i * 7919);
+		entries[2*i+1] = (lisp_object*)NewInteger(i);
+	}
+	const HashMap *hm = CreateHashMap(2 * ENTRIES, entries);
+
+	struct {
+		char *name;
+		long (*sum)(const HashMap*);
+	} data[] = {
+		{"seq", sumSeq},
+		{"kvreduce", sumKVReduce},
+		{"fold", sumFold},
+	};
+
+	printf("%-10s %12s\n", "walk", "time (s)");
+	for(size_t i = 0; i < sizeof(data) / sizeof(data[0]); i++) {
+		double start = now();
+		for(size_t j = 0; j < ITERATIONS; j++) {
+			if(data[i].sum(hm) != (long)ENTRIES * (ENTRIES - 1) / 2)
+				printf("Bad sum from %s\n", data[i].name);
+		}
+		printf("%-10s %12.3f\n", data[i].name, now() - start);
+	}
+	return 0;
+}
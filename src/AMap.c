@@ -43,6 +43,10 @@ interfaces KeySeq_interfaces = {
 	NULL,						// IFnFns
 	NULL,						// IVectorFns
 	NULL,						// IMapFns
+	NULL,						// ISetFns
+	toString,					// toString
+	EqualsASeq,					// Equals
+	NULL,						// HashEq
 };
 
 const KeySeq* CreateKeySeq(const ISeq *seq) {
@@ -77,8 +81,6 @@ static const KeySeq* NewKeySeq(const ISeq *seq, const IMap *map) {
 	KeySeq *ret = GC_MALLOC(sizeof(*ret));
 	ret->obj.type = KEYSEQ_type;
 	ret->obj.size = sizeof(*ret);
-	ret->obj.toString = toString;
-	ret->obj.Equals = Equals;
 	ret->obj.fns = &KeySeq_interfaces;
 
 	ret->seq = seq;
@@ -125,6 +127,10 @@ interfaces ValSeq_interfaces = {
 	NULL,						// IFnFns
 	NULL,						// IVectorFns
 	NULL,						// IMapFns
+	NULL,						// ISetFns
+	toString,					// toString
+	EqualsASeq,					// Equals
+	NULL,						// HashEq
 };
 
 const ValSeq* CreateValSeq(const ISeq *seq) {
@@ -159,8 +165,6 @@ static const ValSeq* NewValSeq(const ISeq *seq, const IMap *map) {
 	ValSeq *ret = GC_MALLOC(sizeof(*ret));
 	ret->obj.type = KEYSEQ_type;
 	ret->obj.size = sizeof(*ret);
-	ret->obj.toString = toString;
-	ret->obj.Equals = Equals;
 	ret->obj.fns = &ValSeq_interfaces;
 
 	ret->seq = seq;
@@ -45,6 +45,10 @@ interfaces RSeq_interfaces = {
 	NULL,						// IFnFns
 	NULL,						// IVectorFns
 	NULL,						// IMapFns
+	NULL,						// ISetFns
+	toString,					// toString
+	EqualsASeq,					// Equals
+	NULL,						// HashEq
 };
 
 static const lisp_object* firstRSeq(const ISeq *self) {
@@ -71,8 +75,6 @@ static RSeq* NewRSeq(const IVector *v, size_t i) {
 	RSeq *ret = GC_MALLOC(sizeof(*ret));
 	ret->obj.type = RSEQ_type;
 	ret->obj.size = sizeof(*ret);
-	ret->obj.toString = toString;
-	ret->obj.Equals = Equals;
 	ret->obj.fns = &RSeq_interfaces;
 
 	ret->v = v;
@@ -127,13 +129,13 @@ bool EqualsAVector(const struct lisp_object_struct *x, const struct lisp_object_
 	if(x == y)
 		return true;
 
-	if(isIVector(x)) {
+	if(isIVector(y)) {
 		const IVector *vy = (IVector*)y;
 		size_t count = vx->obj.fns->ICollectionFns->count((ICollection*)vx);
 		if(count != vy->obj.fns->ICollectionFns->count((ICollection*)vy))
 			return false;
 		for(size_t i = 0; i < count; i++)
-			if(!Equals(vx->obj.fns->IVectorFns->nth(vx, i, NULL), vx->obj.fns->IVectorFns->nth(vx, i, NULL)))
+			if(!Equals(vx->obj.fns->IVectorFns->nth(vx, i, NULL), vy->obj.fns->IVectorFns->nth(vy, i, NULL)))
 				return false;
 		return true;
 	}
@@ -143,10 +145,10 @@ bool EqualsAVector(const struct lisp_object_struct *x, const struct lisp_object_
 
 	const ISeq *ms = seq(y);
 	for(size_t i = 0; i < count((lisp_object*)vx); i++, ms = ms->obj.fns->ISeqFns->next(ms))
-		if(!Equals(vx->obj.fns->IVectorFns->nth(vx, i, NULL), ms->obj.fns->ISeqFns->first(ms)))
+		if(ms == NULL || !Equals(vx->obj.fns->IVectorFns->nth(vx, i, NULL), ms->obj.fns->ISeqFns->first(ms)))
 			return false;
 
-	return true;
+	return ms == NULL;
 }
 
 const lisp_object* peekAVector(const IStack *is) {
@@ -160,7 +162,7 @@ const lisp_object* peekAVector(const IStack *is) {
 
 const lisp_object* invoke1AVector(const IFn *f, const lisp_object *arg1) {
 	assert(isIVector(&f->obj));
-	if(arg1->type == INTEGER_type)
+	if(objectType(arg1) == INTEGER_type)
 		return f->obj.fns->IVectorFns->nth((IVector*)f, IntegerValue((Integer*)arg1), NULL);
 	exception e = {IllegalArgumentException, "Key must be integer"};
 	Raise(e);
@@ -172,7 +174,7 @@ size_t lengthAVector(const IVector *iv) {
 }
 
 const IVector* assocAVector(const IVector *iv, const lisp_object *key, const lisp_object *val) {
-	if(key->type == INTEGER_type) {
+	if(objectType(key) == INTEGER_type) {
 		return iv->obj.fns->IVectorFns->assocN(iv, IntegerValue((Integer*)key), val);
 	}
 	exception e = {IllegalArgumentException, "Key must be integer"};
@@ -181,7 +183,7 @@ const IVector* assocAVector(const IVector *iv, const lisp_object *key, const lis
 }
 
 const MapEntry* entryAtAVector(const IVector *iv, const lisp_object *key) {
-	if(key->type == INTEGER_type) {
+	if(objectType(key) == INTEGER_type) {
 		size_t i = IntegerValue((Integer*)key);
 		if(i < iv->obj.fns->ICollectionFns->count((ICollection*)iv)) {
 			
@@ -0,0 +1,389 @@
+#include <assert.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "ArrayMap.h"
+
+#include "AFn.h"
+#include "ASeq.h"
+#include "Error.h"
+#include "gc.h"
+#include "Interfaces.h"
+#include "Map.h"
+#include "MapEntry.h"
+#include "Murmur3.h"
+#include "Util.h"
+
+// ArrayMapSeq
+
+typedef struct {	// ArrayMapSeq
+	lisp_object obj;
+	const lisp_object *const *array;
+	size_t count;
+	size_t i;
+} ArrayMapSeq;
+
+// ArrayMapSeq function declarations.
+
+static const ArrayMapSeq *NewArrayMapSeq(const lisp_object *const *array, size_t count, size_t i);
+static const lisp_object* firstArrayMapSeq(const ISeq*);
+static const ISeq* nextArrayMapSeq(const ISeq*);
+static size_t countArrayMapSeq(const ICollection*);
+
+const Seqable_vtable ArrayMapSeq_Seqable_vtable = {
+	seqASeq,	//seq
+};
+
+const ICollection_vtable ArrayMapSeq_ICollection_vtable = {
+	countArrayMapSeq,			// count
+	(ICollectionFn1)consASeq,	// cons
+	emptyASeq,					// empty
+	EquivASeq					// Equiv
+};
+
+const ISeq_vtable ArrayMapSeq_ISeq_vtable = {
+	firstArrayMapSeq,	// first
+	nextArrayMapSeq,	// next
+	moreASeq,			// more
+	consASeq,			// cons
+};
+
+interfaces ArrayMapSeq_interfaces = {
+	&ArrayMapSeq_Seqable_vtable,	// SeqableFns
+	NULL,							// ReversibleFns
+	&ArrayMapSeq_ICollection_vtable,// ICollectionFns
+	NULL,							// IStackFns
+	&ArrayMapSeq_ISeq_vtable,		// ISeqFns
+	NULL,							// IFnFns
+	NULL,							// IVectorFns
+	NULL,							// IMapFns
+	NULL,							// ISetFns
+	toString,						// toString
+	EqualsASeq,						// Equals
+	NULL,							// HashEq
+};
+
+// ArrayMap
+
+struct ArrayMap_struct {
+	lisp_object obj;
+	const size_t count;
+	uint32_t hash;				// HashEq, computed on first use.  0 until then.
+	const lisp_object *array[];	// Keys and values, key i at array[2*i].
+};
+
+// ArrayMap Function declarations.
+
+static ArrayMap *NewArrayMap(size_t count);
+static int findIndex(const ArrayMap *am, const lisp_object *key);
+const lisp_object* siteLookupArrayMap(const ArrayMap *am, KeyLookupSite *site, const lisp_object *NotFound) {
+	assert(am->obj.type == ARRAYMAP_type);
+	if(site->map != (lisp_object*)am) {
+		int i = site->idx < am->count && am->array[2*site->idx] == site->key ? (int)site->idx : findIndex(am, site->key);
+		site->map = (lisp_object*)am;
+		site->found = i != -1;
+		site->val = i != -1 ? am->array[2*i+1] : NULL;
+		if(i != -1)
+			site->idx = i;
+	}
+	return site->found ? site->val : NotFound;
+}
+
+static const ISeq *seqArrayMap(const Seqable *obj);
+static size_t countArrayMap(const ICollection *ic);
+static const ICollection* emptyArrayMap(void);
+static bool EquivArrayMap(const ICollection*, const lisp_object*);
+static const lisp_object* invoke1ArrayMap(const IFn*, const lisp_object*);
+static const lisp_object* invoke2ArrayMap(const IFn*, const lisp_object*, const lisp_object*);
+static bool containsKeyArrayMap(const IMap*, const lisp_object*);
+static const IMap* assocArrayMap(const IMap*, const lisp_object*, const lisp_object*);
+static const IMap* withoutArrayMap(const IMap*, const lisp_object*);
+static const MapEntry* entryAtArrayMap(const IMap*, const lisp_object*);
+static const lisp_object* valAtArrayMap(const IMap*, const lisp_object*, const lisp_object*);
+static const IMap* consArrayMap(const IMap*, const lisp_object*);
+static bool EqualsArrayMap(const lisp_object *x, const lisp_object *y);
+static uint32_t HashEqArrayMap(const lisp_object *obj);
+
+const Seqable_vtable ArrayMap_Seqable_vtable = {
+	seqArrayMap // seq
+};
+
+const ICollection_vtable ArrayMap_ICollection_vtable = {
+	countArrayMap,					// count
+	(ICollectionFn1)consArrayMap,	// cons
+	emptyArrayMap,					// empty
+	EquivArrayMap,					// Equiv
+};
+
+const IFn_vtable ArrayMap_IFn_vtable = {
+	invoke0AFn,			// invoke0
+	invoke1ArrayMap,	// invoke1
+	invoke2ArrayMap,	// invoke2
+	invoke3AFn,			// invoke3
+	invoke4AFn,			// invoke4
+	invoke5AFn,			// invoke5
+	applyToAFn,			// applyTo
+};
+
+const IMap_vtable ArrayMap_IMap_vtable = {
+	containsKeyArrayMap,	// containsKey
+	assocArrayMap,			// assoc
+	withoutArrayMap,		// without
+	entryAtArrayMap,		// entryAt
+	valAtArrayMap,			// valAt
+	consArrayMap,			// cons
+};
+
+interfaces ArrayMap_interfaces = {
+	&ArrayMap_Seqable_vtable,		// SeqableFns
+	NULL,							// ReversibleFns
+	&ArrayMap_ICollection_vtable,	// ICollectionFns
+	NULL,							// IStackFns
+	NULL,							// ISeqFns
+	&ArrayMap_IFn_vtable,			// IFnFns
+	NULL,							// IVectorFns
+	&ArrayMap_IMap_vtable,			// IMapFns
+	NULL,							// ISetFns
+	toString,						// toString
+	EqualsArrayMap,					// Equals
+	HashEqArrayMap,					// HashEq
+};
+
+const ArrayMap _EmptyArrayMap = {{ARRAYMAP_type, sizeof(ArrayMap), NULL, &ArrayMap_interfaces}, 0, 0};
+const ArrayMap *const EmptyArrayMap = &_EmptyArrayMap;
+
+// ArrayMapSeq Function Definitions.
+
+static const ArrayMapSeq *NewArrayMapSeq(const lisp_object *const *array, size_t count, size_t i) {
+	ArrayMapSeq *ret = GC_MALLOC(sizeof(*ret));
+	ret->obj.type = ARRAYMAPSEQ_type;
+	ret->obj.size = sizeof(ArrayMapSeq);
+	ret->obj.fns = &ArrayMapSeq_interfaces;
+	ret->array = array;
+	ret->count = count;
+	ret->i = i;
+	return ret;
+}
+
+static const lisp_object* firstArrayMapSeq(const ISeq *o) {
+	assert(o->obj.type == ARRAYMAPSEQ_type);
+	const ArrayMapSeq *s = (ArrayMapSeq*) o;
+
+	return (lisp_object*) NewMapEntry(s->array[2*s->i], s->array[2*s->i+1]);
+}
+
+static const ISeq* nextArrayMapSeq(const ISeq *o) {
+	assert(o->obj.type == ARRAYMAPSEQ_type);
+	const ArrayMapSeq *s = (ArrayMapSeq*) o;
+
+	return s->i + 1 < s->count ? (ISeq*) NewArrayMapSeq(s->array, s->count, s->i + 1) : NULL;
+}
+
+static size_t countArrayMapSeq(const ICollection *ic) {
+	assert(ic->obj.type == ARRAYMAPSEQ_type);
+	const ArrayMapSeq *s = (ArrayMapSeq*) ic;
+
+	return s->count - s->i;
+}
+
+// ArrayMap Function Definitions.
+
+const IMap *CreateArrayMap(size_t count, const lisp_object **entries) {
+	if(count / 2 > ARRAYMAP_THRESHOLD)
+		return (IMap*) CreateHashMap(count, entries);
+	if(count == 0)
+		return (IMap*) EmptyArrayMap;
+
+	ArrayMap *ret = NewArrayMap(count / 2);
+	size_t n = 0;
+	for(size_t i = 0; i < count; i += 2) {
+		size_t j = 0;
+		while(j < n && !Equiv(ret->array[2*j], entries[i]))
+			j++;
+		ret->array[2*j  ] = entries[i];
+		ret->array[2*j+1] = entries[i+1];
+		if(j == n)
+			n++;
+	}
+	memcpy((void*) &(ret->count), &n, sizeof(n));
+
+	return (IMap*) ret;
+}
+
+static ArrayMap *NewArrayMap(size_t count) {
+	ArrayMap *ret = GC_MALLOC(sizeof(*ret) + 2 * count * sizeof(lisp_object*));
+	ret->obj.type = ARRAYMAP_type;
+	ret->obj.size = sizeof(ArrayMap);
+	ret->obj.fns = &ArrayMap_interfaces;
+	memcpy((void*) &(ret->count), &count, sizeof(count));
+
+	return ret;
+}
+
+// Returns the index of key's entry, or -1.  Keys are mostly keywords and symbols, so identity is tried before Equiv.
+static int findIndex(const ArrayMap *am, const lisp_object *key) {
+	for(size_t i = 0; i < am->count; i++) {
+		if(am->array[2*i] == key)
+			return i;
+	}
+	for(size_t i = 0; i < am->count; i++) {
+		if(Equiv(am->array[2*i], key))
+			return i;
+	}
+	return -1;
+}
+
+static const ISeq *seqArrayMap(const Seqable *obj) {
+	assert(obj->obj.type == ARRAYMAP_type);
+	const ArrayMap *am = (ArrayMap*) obj;
+
+	return am->count ? (ISeq*) NewArrayMapSeq(am->array, am->count, 0) : NULL;
+}
+
+static size_t countArrayMap(const ICollection *ic) {
+	assert(ic->obj.type == ARRAYMAP_type);
+	return ((ArrayMap*)ic)->count;
+}
+
+static const ICollection* emptyArrayMap(void) {
+	return (ICollection*) EmptyArrayMap;
+}
+
+static bool EquivArrayMapWith(const ArrayMap *am, const lisp_object *obj, bool (*valEquiv)(const lisp_object*, const lisp_object*)) {
+	if((lisp_object*)am == obj)
+		return true;
+	if(!isIMap(obj))
+		return false;
+	const IMap *im = (IMap*) obj;
+	if(im->obj.fns->ICollectionFns->count((const ICollection*)im) != am->count)
+		return false;
+	if(obj->type == ARRAYMAP_type) {
+		const ArrayMap *other = (ArrayMap*)obj;
+		if(am->hash != 0 && other->hash != 0 && am->hash != other->hash)
+			return false;
+	}
+
+	for(size_t i = 0; i < am->count; i++) {
+		if(!im->obj.fns->IMapFns->containsKey(im, am->array[2*i]))
+			return false;
+		if(!valEquiv(im->obj.fns->IMapFns->valAt(im, am->array[2*i], NULL), am->array[2*i+1]))
+			return false;
+	}
+	return true;
+}
+
+static bool EquivArrayMap(const ICollection *ic, const lisp_object *obj) {
+	assert(ic->obj.type == ARRAYMAP_type);
+	return EquivArrayMapWith((ArrayMap*)ic, obj, Equiv);
+}
+
+static bool EqualsArrayMap(const lisp_object *x, const lisp_object *y) {
+	assert(x->type == ARRAYMAP_type);
+	return EquivArrayMapWith((ArrayMap*)x, y, Equals);
+}
+
+static uint32_t HashEqArrayMap(const lisp_object *obj) {
+	assert(obj->type == ARRAYMAP_type);
+	ArrayMap *am = (ArrayMap*)obj;
+	if(am->count == 0)
+		return mixCollHash(0, 0);
+	if(am->hash == 0)
+		am->hash = hashUnordered(obj);
+	return am->hash;
+}
+
+static const lisp_object* invoke1ArrayMap(const IFn *f, const lisp_object *key) {
+	assert(f->obj.type == ARRAYMAP_type);
+	return valAtArrayMap((IMap*)f, key, NULL);
+}
+
+static const lisp_object* invoke2ArrayMap(const IFn *f, const lisp_object *key, const lisp_object *NotFound) {
+	assert(f->obj.type == ARRAYMAP_type);
+	return valAtArrayMap((IMap*)f, key, NotFound);
+}
+
+static bool containsKeyArrayMap(const IMap *im, const lisp_object *key) {
+	assert(im->obj.type == ARRAYMAP_type);
+	return findIndex((ArrayMap*)im, key) >= 0;
+}
+
+static const IMap* assocArrayMap(const IMap *im, const lisp_object *key, const lisp_object *val) {
+	assert(im->obj.type == ARRAYMAP_type);
+	const ArrayMap *am = (ArrayMap*) im;
+
+	int i = findIndex(am, key);
+	if(i >= 0) {
+		if(am->array[2*i+1] == val)
+			return im;
+		ArrayMap *ret = NewArrayMap(am->count);
+		memcpy(ret->array, am->array, 2 * am->count * sizeof(lisp_object*));
+		ret->array[2*i+1] = val;
+		return (IMap*) ret;
+	}
+
+	if(am->count >= ARRAYMAP_THRESHOLD) {
+		const lisp_object *entries[2 * (am->count + 1)];
+		memcpy(entries, am->array, 2 * am->count * sizeof(lisp_object*));
+		entries[2*am->count  ] = key;
+		entries[2*am->count+1] = val;
+		return (IMap*) CreateHashMap(2 * (am->count + 1), entries);
+	}
+
+	ArrayMap *ret = NewArrayMap(am->count + 1);
+	memcpy(ret->array, am->array, 2 * am->count * sizeof(lisp_object*));
+	ret->array[2*am->count  ] = key;
+	ret->array[2*am->count+1] = val;
+	return (IMap*) ret;
+}
+
+static const IMap* withoutArrayMap(const IMap *im, const lisp_object *key) {
+	assert(im->obj.type == ARRAYMAP_type);
+	const ArrayMap *am = (ArrayMap*) im;
+
+	int i = findIndex(am, key);
+	if(i < 0)
+		return im;
+	if(am->count == 1)
+		return (IMap*) EmptyArrayMap;
+
+	ArrayMap *ret = NewArrayMap(am->count - 1);
+	memcpy(ret->array, am->array, 2 * i * sizeof(lisp_object*));
+	memcpy(&ret->array[2*i], &am->array[2*(i+1)], 2 * (am->count - i - 1) * sizeof(lisp_object*));
+	return (IMap*) ret;
+}
+
+static const MapEntry* entryAtArrayMap(const IMap *im, const lisp_object *key) {
+	assert(im->obj.type == ARRAYMAP_type);
+	const ArrayMap *am = (ArrayMap*) im;
+
+	int i = findIndex(am, key);
+	return i >= 0 ? NewMapEntry(am->array[2*i], am->array[2*i+1]) : NULL;
+}
+
+static const lisp_object* valAtArrayMap(const IMap *im, const lisp_object *key, const lisp_object *NotFound) {
+	assert(im->obj.type == ARRAYMAP_type);
+	const ArrayMap *am = (ArrayMap*) im;
+
+	int i = findIndex(am, key);
+	return i >= 0 ? am->array[2*i+1] : NotFound;
+}
+
+static const IMap* consArrayMap(const IMap *im, const lisp_object *obj) {
+	assert(im->obj.type == ARRAYMAP_type);
+
+	if(isIVector(obj)) {
+		const IVector* v = (const IVector*) obj;
+		if(v->obj.fns->ICollectionFns->count((ICollection*)v) != 2) {
+			exception e = {IllegalArgumentException, "Vector arg to map conj must be a pair"};
+			Raise(e);
+		}
+		return assocArrayMap(im, v->obj.fns->IVectorFns->nth(v, 0, NULL), v->obj.fns->IVectorFns->nth(v, 1, NULL));
+	}
+
+	const IMap *ret = im;
+	for(const ISeq *s = seq(obj); s != NULL; s = s->obj.fns->ISeqFns->next(s)) {
+		const MapEntry *me = (MapEntry*) s->obj.fns->ISeqFns->first(s);
+		ret = ret->obj.fns->IMapFns->assoc(ret, me->key, me->val);
+	}
+	return ret;
+}
@@ -0,0 +1,22 @@
+#ifndef ARRAY_MAP_H
+#define ARRAY_MAP_H
+
+#include "LispObject.h"
+#include "Map.h"
+
+// A persistent map kept as a flat array of keys and values that is searched linearly.  For a handful of entries this
+// beats a HashMap: there are no nodes to allocate and no keys to hash.  Once it grows past ARRAYMAP_THRESHOLD entries
+// assoc returns a HashMap instead.
+typedef struct ArrayMap_struct ArrayMap;
+
+#define ARRAYMAP_THRESHOLD 8
+
+// Returns a HashMap when there are more than ARRAYMAP_THRESHOLD entries.
+const IMap *CreateArrayMap(size_t count, const lisp_object **entries);
+// Tries the entry where the key was last found before searching.
+const lisp_object* siteLookupArrayMap(const ArrayMap *am, KeyLookupSite *site, const lisp_object *NotFound);
+
+extern const ArrayMap _EmptyArrayMap;
+extern const ArrayMap *const EmptyArrayMap;
+
+#endif /* ARRAY_MAP_H */
@@ -14,9 +14,39 @@ struct Bool_struct {
 static const char* toStringTrue(const lisp_object *obj);
 static const char* toStringFalse(const lisp_object *obj);
 
-const Bool _True =  {{BOOL_type, sizeof(Bool), toStringTrue, EqualBase, NULL, &NullInterface}, true};
+static const interfaces True_interfaces = {
+	NULL,			// SeqableFns
+	NULL,			// ReversibleFns
+	NULL,			// ICollectionFns
+	NULL,			// IStackFns
+	NULL,			// ISeqFns
+	NULL,			// IFnFns
+	NULL,			// IVectorFns
+	NULL,			// IMapFns
+	NULL,			// ISetFns
+	toStringTrue,	// toString
+	EqualBase,		// Equals
+	NULL,			// HashEq
+};
+
+static const interfaces False_interfaces = {
+	NULL,			// SeqableFns
+	NULL,			// ReversibleFns
+	NULL,			// ICollectionFns
+	NULL,			// IStackFns
+	NULL,			// ISeqFns
+	NULL,			// IFnFns
+	NULL,			// IVectorFns
+	NULL,			// IMapFns
+	NULL,			// ISetFns
+	toStringFalse,	// toString
+	EqualBase,		// Equals
+	NULL,			// HashEq
+};
+
+const Bool _True =  {{BOOL_type, sizeof(Bool), NULL, &True_interfaces}, true};
 const Bool *const True = &_True;
-const Bool _False =  {{BOOL_type, sizeof(Bool), toStringFalse, EqualBase, NULL, &NullInterface}, false};
+const Bool _False =  {{BOOL_type, sizeof(Bool), NULL, &False_interfaces}, false};
 const Bool *const False = &_False;
 
 static const char* toStringTrue(const lisp_object *obj) {
@@ -0,0 +1,126 @@
+#include "Bytecode.h"
+
+#include <assert.h>
+#include <string.h>
+
+#include "Bool.h"
+#include "gc.h"
+#include "Interfaces.h"
+#include "List.h"
+#include "Util.h"
+#include "Var.h"
+
+// Code
+
+const Code* NewCode(size_t count, const instruction *code, size_t constantCount, const lisp_object *const *constants,
+		size_t exprCount, const lisp_object *const *exprs, EvalFallback evalExpr, TailCallHandler tailCall, size_t registerCount,
+		size_t localCount) {
+	Code *ret = GC_MALLOC(sizeof(*ret));
+	ret->obj.type = CODE_type;
+	ret->obj.size = sizeof(*ret);
+	ret->obj.fns = &NullInterface;
+
+	instruction *c = GC_MALLOC_ATOMIC(count * sizeof(*c));
+	memcpy(c, code, count * sizeof(*c));
+	ret->count = count;
+	ret->code = c;
+	ret->constantCount = constantCount;
+	ret->constants = constants;
+	ret->exprCount = exprCount;
+	ret->exprs = exprs;
+	ret->evalExpr = evalExpr;
+	ret->tailCall = tailCall;
+	ret->registerCount = registerCount;
+	ret->localCount = localCount;
+
+	return ret;
+}
+
+static const lisp_object* invokeRegisters(const IFn *f, size_t argc, const lisp_object **argv) {
+	switch(argc) {
+		case 0:
+			return f->obj.fns->IFnFns->invoke0(f);
+		case 1:
+			return f->obj.fns->IFnFns->invoke1(f, argv[0]);
+		case 2:
+			return f->obj.fns->IFnFns->invoke2(f, argv[0], argv[1]);
+		case 3:
+			return f->obj.fns->IFnFns->invoke3(f, argv[0], argv[1], argv[2]);
+		case 4:
+			return f->obj.fns->IFnFns->invoke4(f, argv[0], argv[1], argv[2], argv[3]);
+		case 5:
+			return f->obj.fns->IFnFns->invoke5(f, argv[0], argv[1], argv[2], argv[3], argv[4]);
+		default:
+			return f->obj.fns->IFnFns->applyTo(f, (ISeq*)CreateList(argc, argv));
+	}
+}
+
+// With GCC, dispatch is threaded through a table of label addresses, so each handler jumps straight to the next one.
+// Elsewhere it falls back to a switch in a loop.
+#ifdef __GNUC__
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wpedantic"
+#define GENERATE_LABEL(OP) &&L_##OP,
+#define VM_START		static const void *const dispatch[] = {FOREACH_OPCODE(GENERATE_LABEL)}; goto *dispatch[pc->op];
+#define VM_CASE(OP)		L_##OP:
+#define VM_DISPATCH		goto *dispatch[pc->op]
+#define VM_END
+#else
+#define VM_START		for(;;) { switch((opcode)pc->op) {
+#define VM_CASE(OP)		case OP:
+#define VM_DISPATCH		continue
+#define VM_END			} }
+#endif
+#define VM_NEXT			pc++; VM_DISPATCH
+
+const lisp_object* RunCode(const Code *c, const lisp_object **locals) {
+	assert(c->obj.type == CODE_type);
+	const lisp_object *R[c->registerCount ? c->registerCount : 1];
+	const lisp_object *const *K = c->constants;
+	const instruction *pc = c->code;
+
+	VM_START
+	VM_CASE(OP_LOADNIL)
+		R[pc->a] = NULL;
+		VM_NEXT;
+	VM_CASE(OP_LOADK)
+		R[pc->a] = K[pc->b];
+		VM_NEXT;
+	VM_CASE(OP_MOVE)
+		R[pc->a] = R[pc->b];
+		VM_NEXT;
+	VM_CASE(OP_GETLOCAL)
+		R[pc->a] = locals[pc->b];
+		VM_NEXT;
+	VM_CASE(OP_SETLOCAL)
+		locals[pc->b] = R[pc->a];
+		VM_NEXT;
+	VM_CASE(OP_GETVAR)
+		R[pc->a] = deref((Var*)K[pc->b]);
+		VM_NEXT;
+	VM_CASE(OP_EVAL)
+		R[pc->a] = c->evalExpr(c->exprs[pc->b]);
+		VM_NEXT;
+	VM_CASE(OP_JMP)
+		pc += pc->b;
+		VM_DISPATCH;
+	VM_CASE(OP_JMPF)
+		if(R[pc->a] == NULL || R[pc->a] == (lisp_object*)False) {
+			pc += pc->b;
+			VM_DISPATCH;
+		}
+		VM_NEXT;
+	VM_CASE(OP_CALL)
+		R[pc->a] = invokeRegisters((IFn*)R[pc->a], pc->c, &R[pc->a + 1]);
+		VM_NEXT;
+	VM_CASE(OP_TAILCALL)
+		return c->tailCall((IFn*)R[pc->a], pc->c, &R[pc->a + 1]);
+	VM_CASE(OP_RET)
+		return R[pc->a];
+	VM_END
+	__builtin_unreachable();
+}
+
+#ifdef __GNUC__
+#pragma GCC diagnostic pop
+#endif
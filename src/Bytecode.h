@@ -0,0 +1,59 @@
+#ifndef BYTECODE_H
+#define BYTECODE_H
+
+#include <stdint.h>
+
+#include "Interfaces.h"
+#include "LispObject.h"
+
+// Registers are temporaries private to a Code object.  Locals live in the slot frame shared with the tree walker.
+#define FOREACH_OPCODE(OP) \
+	OP(OP_LOADNIL)	/* R[a] = nil */ \
+	OP(OP_LOADK)	/* R[a] = K[b] */ \
+	OP(OP_MOVE)		/* R[a] = R[b] */ \
+	OP(OP_GETLOCAL)	/* R[a] = L[b] */ \
+	OP(OP_SETLOCAL)	/* L[b] = R[a] */ \
+	OP(OP_GETVAR)	/* R[a] = deref(K[b]) */ \
+	OP(OP_EVAL)		/* R[a] = X[b]->Eval(X[b]) */ \
+	OP(OP_JMP)		/* pc += b */ \
+	OP(OP_JMPF)		/* if R[a] is nil or false, pc += b */ \
+	OP(OP_CALL)		/* R[a] = R[a](R[a+1], ..., R[a+c]) */ \
+	OP(OP_TAILCALL)	/* return R[a](R[a+1], ..., R[a+c]), as made by tailCall */ \
+	OP(OP_RET)		/* return R[a] */
+
+#define GENERATE_OPCODE(OP) OP,
+
+typedef enum {	// opcode
+	FOREACH_OPCODE(GENERATE_OPCODE)
+} opcode;
+
+typedef struct {	// instruction
+	uint8_t op;
+	uint8_t c;
+	uint16_t a;
+	int32_t b;
+} instruction;
+
+typedef const lisp_object* (*EvalFallback)(const lisp_object *expr);
+typedef const lisp_object* (*TailCallHandler)(const IFn *f, size_t argc, const lisp_object *const *argv);
+
+typedef struct {	// Code
+	lisp_object obj;
+	size_t count;
+	const instruction *code;
+	size_t constantCount;
+	const lisp_object *const *constants;
+	size_t exprCount;
+	const lisp_object *const *exprs;
+	EvalFallback evalExpr;
+	TailCallHandler tailCall;
+	size_t registerCount;
+	size_t localCount;
+} Code;
+
+const Code* NewCode(size_t count, const instruction *code, size_t constantCount, const lisp_object *const *constants,
+		size_t exprCount, const lisp_object *const *exprs, EvalFallback evalExpr, TailCallHandler tailCall, size_t registerCount,
+		size_t localCount);
+const lisp_object* RunCode(const Code *c, const lisp_object **locals);
+
+#endif /* BYTECODE_H */
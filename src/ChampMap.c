@@ -0,0 +1,871 @@
+#include <assert.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "ChampMap.h"
+
+#include "AFn.h"
+#include "ASeq.h"
+#include "Cons.h"
+#include "Error.h"
+#include "gc.h"
+#include "Interfaces.h"
+#include "MapEntry.h"
+#include "Murmur3.h"
+#include "nodes.h"
+#include "Util.h"
+
+// One level per NODE_LOG_SIZE bits of the hash, and a collision node below that.
+#define CHAMP_MAX_DEPTH ((32 + NODE_LOG_SIZE - 1) / NODE_LOG_SIZE + 1)
+
+// ChampNode
+
+// Nodes are internal to the map, so in place of a lisp_object header they carry just their type, which tells the two
+// kinds apart.  Sub-nodes sit in the array alongside keys and values, as lisp_object pointers.
+typedef struct {	// ChampNode
+	object_type type;
+	uint32_t datamap;				// Slots holding a key and value inline.
+	uint32_t nodemap;				// Slots holding a sub-node.
+	const lisp_object *array[];		// Keys and values in datamap order, then sub-nodes in nodemap order.
+} ChampNode;
+
+// ChampCollisionNode
+
+typedef struct {	// ChampCollisionNode
+	object_type type;
+	uint32_t hash;
+	size_t count;
+	const lisp_object *array[];		// count keys and values, in no particular order.
+} ChampCollisionNode;
+
+// Node function declarations.
+
+static ChampNode *NewChampNode(uint32_t datamap, uint32_t nodemap);
+static ChampCollisionNode *NewChampCollisionNode(uint32_t hash, size_t count);
+static const lisp_object* assocChampNode(const lisp_object *node, size_t shift, uint32_t hash, const lisp_object *key, const lisp_object *val, bool *addedLeaf);
+static const lisp_object* withoutChampNode(const lisp_object *node, size_t shift, uint32_t hash, const lisp_object *key, bool *removedLeaf);
+static const lisp_object *const *findChampNode(const lisp_object *node, uint32_t hash, const lisp_object *key);
+static bool EquivChampNode(const lisp_object *x, const lisp_object *y, bool (*valEquiv)(const lisp_object*, const lisp_object*));
+
+static const ChampNode EmptyChampNode = {CHAMP_NODE_type, 0, 0};
+
+// ChampSeq
+
+typedef struct {	// ChampFrame
+	const lisp_object *node;
+	size_t pos;		// Entries are visited first, then sub-nodes.
+} ChampFrame;
+
+typedef struct {	// ChampSeq
+	lisp_object obj;
+	size_t depth;
+	ChampFrame frames[];	// The path from the root to the node holding the current entry.
+} ChampSeq;
+
+// ChampSeq function declarations.
+
+static const ChampSeq *CreateChampSeq(ChampFrame *frames, size_t depth);
+static const lisp_object* firstChampSeq(const ISeq*);
+static const ISeq* nextChampSeq(const ISeq*);
+
+const Seqable_vtable ChampSeq_Seqable_vtable = {
+	seqASeq,	//seq
+};
+
+const ICollection_vtable ChampSeq_ICollection_vtable = {
+	countASeq,					// count
+	(ICollectionFn1)consASeq,	// cons
+	emptyASeq,					// empty
+	EquivASeq					// Equiv
+};
+
+const ISeq_vtable ChampSeq_ISeq_vtable = {
+	firstChampSeq,	// first
+	nextChampSeq,	// next
+	moreASeq,		// more
+	consASeq,		// cons
+};
+
+interfaces ChampSeq_interfaces = {
+	&ChampSeq_Seqable_vtable,		// SeqableFns
+	NULL,							// ReversibleFns
+	&ChampSeq_ICollection_vtable,	// ICollectionFns
+	NULL,							// IStackFns
+	&ChampSeq_ISeq_vtable,			// ISeqFns
+	NULL,							// IFnFns
+	NULL,							// IVectorFns
+	NULL,							// IMapFns
+	NULL,							// ISetFns
+	toString,						// toString
+	EqualsASeq,						// Equals
+	NULL,							// HashEq
+};
+
+// ChampMap
+
+struct ChampMap_struct {
+	lisp_object obj;
+	const size_t count;
+	const ChampNode *const root;
+	const bool hasNull;
+	const lisp_object *const nullValue;
+	uint32_t hash;		// HashEq, computed on first use.  0 until then.
+};
+
+// ChampMap Function declarations.
+
+static const ChampMap *NewChampMap(size_t count, const ChampNode *root, bool hasNull, const lisp_object *nullValue);
+static const ISeq *seqChampMap(const Seqable *obj);
+static size_t countChampMap(const ICollection *ic);
+static const ICollection* emptyChampMap(void);
+static bool EquivChampMap(const ICollection*, const lisp_object*);
+static const lisp_object* invoke1ChampMap(const IFn*, const lisp_object*);
+static const lisp_object* invoke2ChampMap(const IFn*, const lisp_object*, const lisp_object*);
+static bool containsKeyChampMap(const IMap*, const lisp_object*);
+static const IMap* assocChampMap(const IMap*, const lisp_object*, const lisp_object*);
+static const IMap* withoutChampMap(const IMap*, const lisp_object*);
+static const MapEntry* entryAtChampMap(const IMap*, const lisp_object*);
+static const lisp_object* valAtChampMap(const IMap*, const lisp_object*, const lisp_object*);
+static const IMap* consChampMap(const IMap*, const lisp_object*);
+static bool EqualsChampMap(const lisp_object *x, const lisp_object *y);
+static uint32_t HashEqChampMap(const lisp_object *obj);
+
+const Seqable_vtable ChampMap_Seqable_vtable = {
+	seqChampMap // seq
+};
+
+const ICollection_vtable ChampMap_ICollection_vtable = {
+	countChampMap,					// count
+	(ICollectionFn1)consChampMap,	// cons
+	emptyChampMap,					// empty
+	EquivChampMap,					// Equiv
+};
+
+const IFn_vtable ChampMap_IFn_vtable = {
+	invoke0AFn,			// invoke0
+	invoke1ChampMap,	// invoke1
+	invoke2ChampMap,	// invoke2
+	invoke3AFn,			// invoke3
+	invoke4AFn,			// invoke4
+	invoke5AFn,			// invoke5
+	applyToAFn,			// applyTo
+};
+
+const IMap_vtable ChampMap_IMap_vtable = {
+	containsKeyChampMap,	// containsKey
+	assocChampMap,			// assoc
+	withoutChampMap,		// without
+	entryAtChampMap,		// entryAt
+	valAtChampMap,			// valAt
+	consChampMap,			// cons
+};
+
+interfaces ChampMap_interfaces = {
+	&ChampMap_Seqable_vtable,		// SeqableFns
+	NULL,							// ReversibleFns
+	&ChampMap_ICollection_vtable,	// ICollectionFns
+	NULL,							// IStackFns
+	NULL,							// ISeqFns
+	&ChampMap_IFn_vtable,			// IFnFns
+	NULL,							// IVectorFns
+	&ChampMap_IMap_vtable,			// IMapFns
+	NULL,							// ISetFns
+	toString,						// toString
+	EqualsChampMap,					// Equals
+	HashEqChampMap,					// HashEq
+};
+
+const ChampMap _EmptyChampMap = {{CHAMPMAP_type, sizeof(ChampMap), NULL, &ChampMap_interfaces}, 0, NULL, false, NULL, 0};
+const ChampMap *const EmptyChampMap = &_EmptyChampMap;
+
+// Node Function Definitions.
+
+// Either kind of node, read through the type both begin with.
+static object_type typeChampNode(const lisp_object *node) {
+	return ((const ChampNode*)node)->type;
+}
+
+static size_t payloadArity(const ChampNode *node) {
+	return popcount(node->datamap);
+}
+
+static size_t nodeArity(const ChampNode *node) {
+	return popcount(node->nodemap);
+}
+
+static size_t lengthChampNode(const ChampNode *node) {
+	return 2 * payloadArity(node) + nodeArity(node);
+}
+
+// Keys and values of either kind of node, for reading entry i as array[2*i] and array[2*i+1].
+static const lisp_object *const *entriesChampNode(const lisp_object *node) {
+	if(typeChampNode(node) == CHAMP_COLLISIONNODE_type)
+		return ((ChampCollisionNode*)node)->array;
+	assert(typeChampNode(node) == CHAMP_NODE_type);
+	return ((ChampNode*)node)->array;
+}
+
+// A node left holding one entry and no sub-nodes after a removal.  Its parent takes the entry inline.
+static bool isSingletonChampNode(const lisp_object *node) {
+	if(typeChampNode(node) != CHAMP_NODE_type)
+		return false;
+	const ChampNode *n = (ChampNode*)node;
+	return n->nodemap == 0 && payloadArity(n) == 1;
+}
+
+static ChampNode *NewChampNode(uint32_t datamap, uint32_t nodemap) {
+	size_t length = 2 * popcount(datamap) + popcount(nodemap);
+	ChampNode *node = GC_MALLOC(sizeof(*node) + length * sizeof(lisp_object*));
+	node->type = CHAMP_NODE_type;
+	node->datamap = datamap;
+	node->nodemap = nodemap;
+	return node;
+}
+
+static ChampNode *copyChampNode(const ChampNode *node) {
+	ChampNode *ret = NewChampNode(node->datamap, node->nodemap);
+	memcpy(ret->array, node->array, lengthChampNode(node) * sizeof(lisp_object*));
+	return ret;
+}
+
+static ChampNode *insertEntryChampNode(const ChampNode *node, uint32_t bit, const lisp_object *key, const lisp_object *val) {
+	size_t idx = index(node->datamap, bit);
+	size_t length = lengthChampNode(node);
+	ChampNode *ret = NewChampNode(node->datamap | bit, node->nodemap);
+	memcpy(ret->array, node->array, 2 * idx * sizeof(lisp_object*));
+	ret->array[2*idx  ] = key;
+	ret->array[2*idx+1] = val;
+	memcpy(&ret->array[2*(idx+1)], &node->array[2*idx], (length - 2*idx) * sizeof(lisp_object*));
+	return ret;
+}
+
+static ChampNode *removeEntryChampNode(const ChampNode *node, uint32_t bit) {
+	size_t idx = index(node->datamap, bit);
+	size_t length = lengthChampNode(node);
+	ChampNode *ret = NewChampNode(node->datamap ^ bit, node->nodemap);
+	memcpy(ret->array, node->array, 2 * idx * sizeof(lisp_object*));
+	memcpy(&ret->array[2*idx], &node->array[2*(idx+1)], (length - 2*(idx+1)) * sizeof(lisp_object*));
+	return ret;
+}
+
+// Replaces the entry at bit with sub, which holds that entry and a new one.
+static ChampNode *entryToNodeChampNode(const ChampNode *node, uint32_t bit, const lisp_object *sub) {
+	size_t idx = index(node->datamap, bit);
+	size_t nodeIdx = index(node->nodemap, bit);
+	size_t payload = payloadArity(node);
+	size_t nodes = nodeArity(node);
+	ChampNode *ret = NewChampNode(node->datamap ^ bit, node->nodemap | bit);
+	const lisp_object **dst = ret->array;
+	const lisp_object *const *src = node->array;
+
+	memcpy(dst, src, 2 * idx * sizeof(lisp_object*));
+	memcpy(&dst[2*idx], &src[2*(idx+1)], 2 * (payload - idx - 1) * sizeof(lisp_object*));
+	dst += 2 * (payload - 1);
+	src += 2 * payload;
+	memcpy(dst, src, nodeIdx * sizeof(lisp_object*));
+	dst[nodeIdx] = sub;
+	memcpy(&dst[nodeIdx+1], &src[nodeIdx], (nodes - nodeIdx) * sizeof(lisp_object*));
+	return ret;
+}
+
+// Replaces the sub-node at bit with the one entry it has left.
+static ChampNode *nodeToEntryChampNode(const ChampNode *node, uint32_t bit, const lisp_object *key, const lisp_object *val) {
+	size_t idx = index(node->datamap, bit);
+	size_t nodeIdx = index(node->nodemap, bit);
+	size_t payload = payloadArity(node);
+	size_t nodes = nodeArity(node);
+	ChampNode *ret = NewChampNode(node->datamap | bit, node->nodemap ^ bit);
+	const lisp_object **dst = ret->array;
+	const lisp_object *const *src = node->array;
+
+	memcpy(dst, src, 2 * idx * sizeof(lisp_object*));
+	dst[2*idx  ] = key;
+	dst[2*idx+1] = val;
+	memcpy(&dst[2*(idx+1)], &src[2*idx], 2 * (payload - idx) * sizeof(lisp_object*));
+	dst += 2 * (payload + 1);
+	src += 2 * payload;
+	memcpy(dst, src, nodeIdx * sizeof(lisp_object*));
+	memcpy(&dst[nodeIdx], &src[nodeIdx+1], (nodes - nodeIdx - 1) * sizeof(lisp_object*));
+	return ret;
+}
+
+// Builds the sub-tree holding two entries whose hashes agree below shift.
+static const lisp_object* mergeTwoChampNode(size_t shift, const lisp_object *key1, const lisp_object *val1, uint32_t hash1,
+		const lisp_object *key2, const lisp_object *val2, uint32_t hash2) {
+	if(hash1 == hash2) {
+		ChampCollisionNode *ret = NewChampCollisionNode(hash1, 2);
+		ret->array[0] = key1;
+		ret->array[1] = val1;
+		ret->array[2] = key2;
+		ret->array[3] = val2;
+		return (lisp_object*)ret;
+	}
+	uint32_t mask1 = mask(hash1, shift);
+	uint32_t mask2 = mask(hash2, shift);
+	if(mask1 == mask2) {
+		ChampNode *ret = NewChampNode(0, bitpos(hash1, shift));
+		ret->array[0] = mergeTwoChampNode(shift + NODE_LOG_SIZE, key1, val1, hash1, key2, val2, hash2);
+		return (lisp_object*)ret;
+	}
+	ChampNode *ret = NewChampNode(bitpos(hash1, shift) | bitpos(hash2, shift), 0);
+	size_t i = mask1 < mask2 ? 0 : 2;
+	ret->array[i  ] = key1;
+	ret->array[i+1] = val1;
+	ret->array[2-i] = key2;
+	ret->array[3-i] = val2;
+	return (lisp_object*)ret;
+}
+
+static int findIndexChampCollisionNode(const ChampCollisionNode *cnode, const lisp_object *key) {
+	for(size_t i = 0; i < cnode->count; i++) {
+		if(Equiv(key, cnode->array[2*i]))
+			return 2*i;
+	}
+	return -1;
+}
+
+static ChampCollisionNode *NewChampCollisionNode(uint32_t hash, size_t count) {
+	ChampCollisionNode *node = GC_MALLOC(sizeof(*node) + 2 * count * sizeof(lisp_object*));
+	node->type = CHAMP_COLLISIONNODE_type;
+	node->hash = hash;
+	node->count = count;
+	return node;
+}
+
+static const lisp_object* assocChampCollisionNode(const ChampCollisionNode *cnode, size_t shift, uint32_t hash, const lisp_object *key, const lisp_object *val, bool *addedLeaf) {
+	if(hash != cnode->hash) {
+		// key agrees with the colliding hash down to here, so push the collision node down a level.
+		ChampNode *ret = NewChampNode(0, bitpos(cnode->hash, shift));
+		ret->array[0] = (lisp_object*)cnode;
+		return assocChampNode((lisp_object*)ret, shift, hash, key, val, addedLeaf);
+	}
+	int idx = findIndexChampCollisionNode(cnode, key);
+	if(idx != -1) {
+		if(cnode->array[idx+1] == val)
+			return (lisp_object*)cnode;
+		ChampCollisionNode *ret = NewChampCollisionNode(hash, cnode->count);
+		memcpy(ret->array, cnode->array, 2 * cnode->count * sizeof(lisp_object*));
+		ret->array[idx+1] = val;
+		return (lisp_object*)ret;
+	}
+	*addedLeaf = true;
+	ChampCollisionNode *ret = NewChampCollisionNode(hash, cnode->count + 1);
+	memcpy(ret->array, cnode->array, 2 * cnode->count * sizeof(lisp_object*));
+	ret->array[2*cnode->count  ] = key;
+	ret->array[2*cnode->count+1] = val;
+	return (lisp_object*)ret;
+}
+
+static const lisp_object* assocChampNode(const lisp_object *node, size_t shift, uint32_t hash, const lisp_object *key, const lisp_object *val, bool *addedLeaf) {
+	if(typeChampNode(node) == CHAMP_COLLISIONNODE_type)
+		return assocChampCollisionNode((ChampCollisionNode*)node, shift, hash, key, val, addedLeaf);
+	assert(typeChampNode(node) == CHAMP_NODE_type);
+	const ChampNode *cnode = (ChampNode*)node;
+	uint32_t bit = bitpos(hash, shift);
+
+	if(cnode->datamap & bit) {
+		size_t idx = index(cnode->datamap, bit);
+		const lisp_object *lookup_key = cnode->array[2*idx];
+		const lisp_object *lookup_val = cnode->array[2*idx+1];
+		if(Equiv(key, lookup_key)) {
+			if(val == lookup_val)
+				return node;
+			ChampNode *ret = copyChampNode(cnode);
+			ret->array[2*idx+1] = val;
+			return (lisp_object*)ret;
+		}
+		*addedLeaf = true;
+		const lisp_object *sub = mergeTwoChampNode(shift + NODE_LOG_SIZE, lookup_key, lookup_val, HashEq(lookup_key), key, val, hash);
+		return (lisp_object*)entryToNodeChampNode(cnode, bit, sub);
+	}
+	if(cnode->nodemap & bit) {
+		size_t j = 2 * payloadArity(cnode) + index(cnode->nodemap, bit);
+		const lisp_object *sub = cnode->array[j];
+		const lisp_object *sub2 = assocChampNode(sub, shift + NODE_LOG_SIZE, hash, key, val, addedLeaf);
+		if(sub2 == sub)
+			return node;
+		ChampNode *ret = copyChampNode(cnode);
+		ret->array[j] = sub2;
+		return (lisp_object*)ret;
+	}
+	*addedLeaf = true;
+	return (lisp_object*)insertEntryChampNode(cnode, bit, key, val);
+}
+
+static const lisp_object* withoutChampCollisionNode(const ChampCollisionNode *cnode, const lisp_object *key, bool *removedLeaf) {
+	int i = findIndexChampCollisionNode(cnode, key);
+	if(i == -1)
+		return (lisp_object*)cnode;
+	*removedLeaf = true;
+	if(cnode->count == 2) {
+		// The parent takes the remaining entry inline, so the bit is only a placeholder.
+		ChampNode *ret = NewChampNode(bitpos(cnode->hash, 0), 0);
+		ret->array[0] = cnode->array[2-i];
+		ret->array[1] = cnode->array[3-i];
+		return (lisp_object*)ret;
+	}
+	ChampCollisionNode *ret = NewChampCollisionNode(cnode->hash, cnode->count - 1);
+	memcpy(ret->array, cnode->array, i * sizeof(lisp_object*));
+	memcpy(&ret->array[i], &cnode->array[i+2], (2*cnode->count - i - 2) * sizeof(lisp_object*));
+	return (lisp_object*)ret;
+}
+
+// Keeps the trie canonical, the shape insertion alone would have built.  Below the root, a node with a single entry
+// left is folded into its parent, and a collision node is hoisted out of nodes that hold nothing else.
+static const lisp_object* withoutChampNode(const lisp_object *node, size_t shift, uint32_t hash, const lisp_object *key, bool *removedLeaf) {
+	if(typeChampNode(node) == CHAMP_COLLISIONNODE_type)
+		return withoutChampCollisionNode((ChampCollisionNode*)node, key, removedLeaf);
+	assert(typeChampNode(node) == CHAMP_NODE_type);
+	const ChampNode *cnode = (ChampNode*)node;
+	uint32_t bit = bitpos(hash, shift);
+
+	if(cnode->datamap & bit) {
+		size_t idx = index(cnode->datamap, bit);
+		if(!Equiv(key, cnode->array[2*idx]))
+			return node;
+		*removedLeaf = true;
+		if(shift > 0 && cnode->nodemap == 0 && payloadArity(cnode) == 2) {
+			ChampNode *ret = NewChampNode(bitpos(hash, 0), 0);
+			ret->array[0] = cnode->array[2*(1-idx)];
+			ret->array[1] = cnode->array[2*(1-idx)+1];
+			return (lisp_object*)ret;
+		}
+		if(shift > 0 && payloadArity(cnode) == 1 && nodeArity(cnode) == 1 && typeChampNode(cnode->array[2]) == CHAMP_COLLISIONNODE_type)
+			return cnode->array[2];
+		return (lisp_object*)removeEntryChampNode(cnode, bit);
+	}
+	if(cnode->nodemap & bit) {
+		size_t j = 2 * payloadArity(cnode) + index(cnode->nodemap, bit);
+		const lisp_object *sub = cnode->array[j];
+		const lisp_object *sub2 = withoutChampNode(sub, shift + NODE_LOG_SIZE, hash, key, removedLeaf);
+		if(sub2 == sub)
+			return node;
+		if(shift > 0 && cnode->datamap == 0 && nodeArity(cnode) == 1 && (isSingletonChampNode(sub2) || typeChampNode(sub2) == CHAMP_COLLISIONNODE_type))
+			return sub2;
+		if(isSingletonChampNode(sub2)) {
+			const ChampNode *single = (ChampNode*)sub2;
+			return (lisp_object*)nodeToEntryChampNode(cnode, bit, single->array[0], single->array[1]);
+		}
+		ChampNode *ret = copyChampNode(cnode);
+		ret->array[j] = sub2;
+		return (lisp_object*)ret;
+	}
+	return node;
+}
+
+// Returns the slot holding key, with its value in the next slot, or NULL.
+static const lisp_object *const *findChampNode(const lisp_object *node, uint32_t hash, const lisp_object *key) {
+	for(size_t shift = 0; node != NULL; shift += NODE_LOG_SIZE) {
+		if(typeChampNode(node) == CHAMP_COLLISIONNODE_type) {
+			const ChampCollisionNode *cnode = (ChampCollisionNode*)node;
+			int i = findIndexChampCollisionNode(cnode, key);
+			return i == -1 ? NULL : &cnode->array[i];
+		}
+		assert(typeChampNode(node) == CHAMP_NODE_type);
+		const ChampNode *cnode = (ChampNode*)node;
+		uint32_t bit = bitpos(hash, shift);
+		if(cnode->datamap & bit) {
+			size_t idx = index(cnode->datamap, bit);
+			return Equiv(key, cnode->array[2*idx]) ? &cnode->array[2*idx] : NULL;
+		}
+		if((cnode->nodemap & bit) == 0)
+			return NULL;
+		node = cnode->array[2 * payloadArity(cnode) + index(cnode->nodemap, bit)];
+	}
+	return NULL;
+}
+
+// Since the trie is canonical, equal maps have the same shape and can be compared node by node without lookups.
+static bool EquivChampNode(const lisp_object *x, const lisp_object *y, bool (*valEquiv)(const lisp_object*, const lisp_object*)) {
+	if(x == y)
+		return true;
+	if(typeChampNode(x) != typeChampNode(y))
+		return false;
+
+	if(typeChampNode(x) == CHAMP_COLLISIONNODE_type) {
+		const ChampCollisionNode *cx = (ChampCollisionNode*)x;
+		const ChampCollisionNode *cy = (ChampCollisionNode*)y;
+		if(cx->hash != cy->hash || cx->count != cy->count)
+			return false;
+		for(size_t i = 0; i < cx->count; i++) {
+			int j = findIndexChampCollisionNode(cy, cx->array[2*i]);
+			if(j == -1 || !valEquiv(cx->array[2*i+1], cy->array[j+1]))
+				return false;
+		}
+		return true;
+	}
+
+	const ChampNode *nx = (ChampNode*)x;
+	const ChampNode *ny = (ChampNode*)y;
+	if(nx->datamap != ny->datamap || nx->nodemap != ny->nodemap)
+		return false;
+	size_t payload = payloadArity(nx);
+	for(size_t i = 0; i < payload; i++) {
+		if(!Equiv(nx->array[2*i], ny->array[2*i]) || !valEquiv(nx->array[2*i+1], ny->array[2*i+1]))
+			return false;
+	}
+	size_t length = lengthChampNode(nx);
+	for(size_t i = 2 * payload; i < length; i++) {
+		if(!EquivChampNode(nx->array[i], ny->array[i], valEquiv))
+			return false;
+	}
+	return true;
+}
+
+// ChampSeq Function Definitions.
+
+// Moves frames forward to the first entry at or after the top frame's position.  Returns the new depth, 0 at the end.
+static size_t advanceChampFrames(ChampFrame *frames, size_t depth) {
+	while(depth > 0) {
+		ChampFrame *top = &frames[depth-1];
+		if(typeChampNode(top->node) == CHAMP_COLLISIONNODE_type) {
+			if(top->pos < ((ChampCollisionNode*)top->node)->count)
+				return depth;
+			depth--;
+			continue;
+		}
+		const ChampNode *node = (ChampNode*)top->node;
+		size_t payload = payloadArity(node);
+		if(top->pos < payload)
+			return depth;
+		size_t j = top->pos - payload;
+		if(j < nodeArity(node)) {
+			assert(depth < CHAMP_MAX_DEPTH);
+			top->pos++;
+			frames[depth].node = node->array[2*payload + j];
+			frames[depth].pos = 0;
+			depth++;
+			continue;
+		}
+		depth--;
+	}
+	return 0;
+}
+
+static const ChampSeq *CreateChampSeq(ChampFrame *frames, size_t depth) {
+	depth = advanceChampFrames(frames, depth);
+	if(depth == 0)
+		return NULL;
+
+	ChampSeq *ret = GC_MALLOC(sizeof(*ret) + depth * sizeof(ChampFrame));
+	ret->obj.type = CHAMPSEQ_type;
+	ret->obj.size = sizeof(ChampSeq);
+	ret->obj.fns = &ChampSeq_interfaces;
+	ret->depth = depth;
+	memcpy(ret->frames, frames, depth * sizeof(ChampFrame));
+	return ret;
+}
+
+static const lisp_object* firstChampSeq(const ISeq *o) {
+	assert(o->obj.type == CHAMPSEQ_type);
+	const ChampSeq *cs = (ChampSeq*) o;
+	const ChampFrame *top = &cs->frames[cs->depth-1];
+	const lisp_object *const *array = entriesChampNode(top->node);
+
+	return (lisp_object*) NewMapEntry(array[2*top->pos], array[2*top->pos+1]);
+}
+
+static const ISeq* nextChampSeq(const ISeq *o) {
+	assert(o->obj.type == CHAMPSEQ_type);
+	const ChampSeq *cs = (ChampSeq*) o;
+	ChampFrame frames[CHAMP_MAX_DEPTH];
+
+	memcpy(frames, cs->frames, cs->depth * sizeof(ChampFrame));
+	frames[cs->depth-1].pos++;
+	return (ISeq*) CreateChampSeq(frames, cs->depth);
+}
+
+// ChampMap Function Definitions.
+
+// CreateChampMap sorts the entries into trie order and builds each node once, rather than assoc'ing them one at a time.
+
+typedef struct {	// ChampEntry
+	const lisp_object *key;
+	const lisp_object *val;
+	uint32_t hash;
+	uint64_t order;		// The hash's NODE_LOG_SIZE bit chunks, root level first.
+	size_t i;			// Position in the arguments, so later duplicates win.
+} ChampEntry;
+
+static int compareChampEntry(const void *x, const void *y) {
+	const ChampEntry *a = x;
+	const ChampEntry *b = y;
+	if(a->order != b->order)
+		return a->order < b->order ? -1 : 1;
+	return a->i < b->i ? -1 : a->i > b->i;
+}
+
+// Folds a run of entries with the same hash down to one per key, keeping the last value.  Returns the new length.
+static size_t dedupeChampEntries(ChampEntry *entries, size_t count) {
+	size_t n = 0;
+	for(size_t i = 0; i < count; i++) {
+		size_t j = 0;
+		while(j < n && !Equiv(entries[j].key, entries[i].key))
+			j++;
+		if(j == n)
+			entries[n++] = entries[i];
+		else
+			entries[j].val = entries[i].val;
+	}
+	return n;
+}
+
+// Builds the node at shift for entries, which agree on every hash chunk above shift and are in trie order.
+static const ChampNode *buildChampNode(ChampEntry *entries, size_t count, size_t shift, size_t *distinct) {
+	uint32_t datamap = 0;
+	uint32_t nodemap = 0;
+	const lisp_object *data[2*NODE_SIZE];
+	const lisp_object *nodes[NODE_SIZE];
+	size_t payload = 0;
+	size_t subnodes = 0;
+
+	for(size_t start = 0, end; start < count; start = end) {
+		uint32_t m = mask(entries[start].hash, shift);
+		for(end = start + 1; end < count && mask(entries[end].hash, shift) == m; end++)
+			;
+		size_t n = end - start;
+		if(entries[start].hash == entries[end-1].hash)
+			n = dedupeChampEntries(&entries[start], n);
+		if(n == 1) {
+			datamap |= 1 << m;
+			data[2*payload  ] = entries[start].key;
+			data[2*payload+1] = entries[start].val;
+			payload++;
+			*distinct += 1;
+		} else if(entries[start].hash == entries[end-1].hash) {
+			ChampCollisionNode *cnode = NewChampCollisionNode(entries[start].hash, n);
+			for(size_t i = 0; i < n; i++) {
+				cnode->array[2*i  ] = entries[start+i].key;
+				cnode->array[2*i+1] = entries[start+i].val;
+			}
+			nodemap |= 1 << m;
+			nodes[subnodes++] = (lisp_object*)cnode;
+			*distinct += n;
+		} else {
+			nodemap |= 1 << m;
+			nodes[subnodes++] = (lisp_object*)buildChampNode(&entries[start], n, shift + NODE_LOG_SIZE, distinct);
+		}
+	}
+
+	ChampNode *ret = NewChampNode(datamap, nodemap);
+	memcpy(ret->array, data, 2 * payload * sizeof(lisp_object*));
+	memcpy(&ret->array[2*payload], nodes, subnodes * sizeof(lisp_object*));
+	return ret;
+}
+
+const ChampMap *CreateChampMap(size_t count, const lisp_object **entries) {
+	ChampEntry *sorted = GC_MALLOC((count / 2) * sizeof(*sorted));
+	size_t n = 0;
+	bool hasNull = false;
+	const lisp_object *nullValue = NULL;
+
+	for(size_t i = 0; i < count; i += 2) {
+		if(entries[i] == NULL) {
+			hasNull = true;
+			nullValue = entries[i+1];
+			continue;
+		}
+		ChampEntry *e = &sorted[n++];
+		e->key = entries[i];
+		e->val = entries[i+1];
+		e->hash = HashEq(e->key);
+		e->order = 0;
+		for(size_t shift = 0; shift < 32; shift += NODE_LOG_SIZE)
+			e->order = (e->order << NODE_LOG_SIZE) | mask(e->hash, shift);
+		e->i = i;
+	}
+	if(n == 0)
+		return hasNull ? NewChampMap(1, NULL, true, nullValue) : EmptyChampMap;
+
+	qsort(sorted, n, sizeof(*sorted), compareChampEntry);
+	size_t distinct = 0;
+	const ChampNode *root = buildChampNode(sorted, n, 0, &distinct);
+	// The sorted entries are scratch, but a stale pointer to them on the stack would keep them alive.
+	GC_FREE(sorted);
+	return NewChampMap(hasNull ? distinct + 1 : distinct, root, hasNull, nullValue);
+}
+
+static const ChampMap *NewChampMap(size_t count, const ChampNode *root, bool hasNull, const lisp_object *nullValue) {
+	ChampMap *ret = GC_MALLOC(sizeof(*ret));
+	ret->obj.type = CHAMPMAP_type;
+	ret->obj.size = sizeof(ChampMap);
+	ret->obj.fns = &ChampMap_interfaces;
+	memcpy((void*) &(ret->count), &count, sizeof(count));
+	memcpy((void*) &(ret->root), &root, sizeof(root));
+	memcpy((void*) &(ret->hasNull), &hasNull, sizeof(hasNull));
+	memcpy((void*) &(ret->nullValue), &nullValue, sizeof(nullValue));
+
+	return ret;
+}
+
+static const ISeq *seqChampMap(const Seqable *obj) {
+	assert(obj->obj.type == CHAMPMAP_type);
+	const ChampMap *cm = (ChampMap*) obj;
+
+	const ISeq *s = NULL;
+	if(cm->root) {
+		ChampFrame frames[CHAMP_MAX_DEPTH] = {{(lisp_object*)cm->root, 0}};
+		s = (ISeq*) CreateChampSeq(frames, 1);
+	}
+
+	return cm->hasNull ? (const ISeq*) NewCons((lisp_object*)NewMapEntry(NULL, cm->nullValue), s) : s;
+}
+
+static size_t countChampMap(const ICollection *ic) {
+	assert(ic->obj.type == CHAMPMAP_type);
+	return ((ChampMap*)ic)->count;
+}
+
+static const ICollection* emptyChampMap(void) {
+	return (ICollection*) EmptyChampMap;
+}
+
+static bool EquivChampMapWith(const ChampMap *cm, const lisp_object *obj, bool (*valEquiv)(const lisp_object*, const lisp_object*)) {
+	if((lisp_object*)cm == obj)
+		return true;
+	if(!isIMap(obj))
+		return false;
+	const IMap *im = (IMap*) obj;
+	if(im->obj.fns->ICollectionFns->count((const ICollection*)im) != cm->count)
+		return false;
+
+	if(obj->type == CHAMPMAP_type) {
+		const ChampMap *other = (ChampMap*) obj;
+		if(cm->hash != 0 && other->hash != 0 && cm->hash != other->hash)
+			return false;
+		if(cm->hasNull != other->hasNull || (cm->hasNull && !valEquiv(cm->nullValue, other->nullValue)))
+			return false;
+		if(cm->root == NULL || other->root == NULL)
+			return cm->root == other->root;
+		return EquivChampNode((lisp_object*)cm->root, (lisp_object*)other->root, valEquiv);
+	}
+
+	for(const ISeq *s = seqChampMap((const Seqable*)cm); s != NULL; s = s->obj.fns->ISeqFns->next(s)) {
+		const MapEntry *me = (const MapEntry*) s->obj.fns->ISeqFns->first(s);
+		if(!im->obj.fns->IMapFns->containsKey(im, me->key))
+			return false;
+		if(!valEquiv(im->obj.fns->IMapFns->valAt(im, me->key, NULL), me->val))
+			return false;
+	}
+	return true;
+}
+
+static bool EquivChampMap(const ICollection *ic, const lisp_object *obj) {
+	assert(ic->obj.type == CHAMPMAP_type);
+	return EquivChampMapWith((ChampMap*)ic, obj, Equiv);
+}
+
+static bool EqualsChampMap(const lisp_object *x, const lisp_object *y) {
+	assert(x->type == CHAMPMAP_type);
+	return EquivChampMapWith((ChampMap*)x, y, Equals);
+}
+
+static uint32_t HashEqChampMap(const lisp_object *obj) {
+	assert(obj->type == CHAMPMAP_type);
+	ChampMap *cm = (ChampMap*)obj;
+	if(cm->count == 0)
+		return mixCollHash(0, 0);
+	if(cm->hash == 0)
+		cm->hash = hashUnordered(obj);
+	return cm->hash;
+}
+
+static const lisp_object* invoke1ChampMap(const IFn *f, const lisp_object *key) {
+	assert(f->obj.type == CHAMPMAP_type);
+	return valAtChampMap((IMap*)f, key, NULL);
+}
+
+static const lisp_object* invoke2ChampMap(const IFn *f, const lisp_object *key, const lisp_object *NotFound) {
+	assert(f->obj.type == CHAMPMAP_type);
+	return valAtChampMap((IMap*)f, key, NotFound);
+}
+
+static bool containsKeyChampMap(const IMap *im, const lisp_object *key) {
+	assert(im->obj.type == CHAMPMAP_type);
+	const ChampMap *cm = (ChampMap*)im;
+
+	if(key == NULL)
+		return cm->hasNull;
+	return findChampNode((lisp_object*)cm->root, HashEq(key), key) != NULL;
+}
+
+static const IMap* assocChampMap(const IMap *im, const lisp_object *key, const lisp_object *val) {
+	assert(im->obj.type == CHAMPMAP_type);
+	const ChampMap *cm = (ChampMap*) im;
+
+	if(key == NULL) {
+		if(cm->hasNull && val == cm->nullValue)
+			return im;
+		return (IMap*) NewChampMap(cm->hasNull ? cm->count : cm->count + 1, cm->root, true, val);
+	}
+
+	bool addedLeaf = false;
+	const lisp_object *root = cm->root ? (lisp_object*)cm->root : (lisp_object*)&EmptyChampNode;
+	const lisp_object *newRoot = assocChampNode(root, 0, HashEq(key), key, val, &addedLeaf);
+	if(newRoot == (lisp_object*)cm->root)
+		return im;
+	return (IMap*) NewChampMap(addedLeaf ? cm->count + 1 : cm->count, (ChampNode*)newRoot, cm->hasNull, cm->nullValue);
+}
+
+static const IMap* withoutChampMap(const IMap *im, const lisp_object *key) {
+	assert(im->obj.type == CHAMPMAP_type);
+	const ChampMap *cm = (ChampMap*) im;
+
+	if(key == NULL)
+		return cm->hasNull ? (IMap*) NewChampMap(cm->count - 1, cm->root, false, NULL) : im;
+	if(cm->root == NULL)
+		return im;
+
+	bool removedLeaf = false;
+	const lisp_object *newRoot = withoutChampNode((lisp_object*)cm->root, 0, HashEq(key), key, &removedLeaf);
+	if(!removedLeaf)
+		return im;
+	const ChampNode *root = (ChampNode*)newRoot;
+	if(root->datamap == 0 && root->nodemap == 0)
+		root = NULL;
+	return (IMap*) NewChampMap(cm->count - 1, root, cm->hasNull, cm->nullValue);
+}
+
+static const MapEntry* entryAtChampMap(const IMap *im, const lisp_object *key) {
+	assert(im->obj.type == CHAMPMAP_type);
+	const ChampMap *cm = (ChampMap*) im;
+
+	if(key == NULL)
+		return cm->hasNull ? NewMapEntry(NULL, cm->nullValue) : NULL;
+
+	const lisp_object *const *slot = findChampNode((lisp_object*)cm->root, HashEq(key), key);
+	return slot ? NewMapEntry(slot[0], slot[1]) : NULL;
+}
+
+static const lisp_object* valAtChampMap(const IMap *im, const lisp_object *key, const lisp_object *NotFound) {
+	assert(im->obj.type == CHAMPMAP_type);
+	const ChampMap *cm = (ChampMap*) im;
+
+	if(key == NULL)
+		return cm->hasNull ? cm->nullValue : NotFound;
+
+	const lisp_object *const *slot = findChampNode((lisp_object*)cm->root, HashEq(key), key);
+	return slot ? slot[1] : NotFound;
+}
+
+static const IMap* consChampMap(const IMap *im, const lisp_object *obj) {
+	assert(im->obj.type == CHAMPMAP_type);
+
+	if(isIVector(obj)) {
+		const IVector* v = (const IVector*) obj;
+		if(v->obj.fns->ICollectionFns->count((ICollection*)v) != 2) {
+			exception e = {IllegalArgumentException, "Vector arg to map conj must be a pair"};
+			Raise(e);
+		}
+		return assocChampMap(im, v->obj.fns->IVectorFns->nth(v, 0, NULL), v->obj.fns->IVectorFns->nth(v, 1, NULL));
+	}
+
+	const IMap *ret = im;
+	for(const ISeq *s = seq(obj); s != NULL; s = s->obj.fns->ISeqFns->next(s)) {
+		const MapEntry *me = (MapEntry*) s->obj.fns->ISeqFns->first(s);
+		ret = assocChampMap(ret, me->key, me->val);
+	}
+	return ret;
+}
@@ -0,0 +1,16 @@
+#ifndef CHAMP_MAP_H
+#define CHAMP_MAP_H
+
+#include "LispObject.h"
+
+// A persistent hash map using the CHAMP node layout.  Each node has separate bitmaps for inline entries and for
+// sub-nodes, with the entries packed ahead of the sub-nodes.  Removing a key compacts the trie, so maps with the same
+// keys always have the same shape.
+typedef struct ChampMap_struct ChampMap;
+
+const ChampMap *CreateChampMap(size_t count, const lisp_object **entries);
+
+extern const ChampMap _EmptyChampMap;
+extern const ChampMap *const EmptyChampMap;
+
+#endif /* CHAMP_MAP_H */
@@ -1,21 +1,26 @@
 #include "Compiler.h"
 
 #include <ctype.h>
+#include <stdint.h>
 #include <dlfcn.h>
 #include <stdio.h>
 #include <string.h>
 
+#include "ArrayMap.h"
 #include "Bool.h"
+#include "Bytecode.h"
 #include "Error.h"
 #include "gc.h"
 #include "Interfaces.h"
 #include "Keyword.h"
 #include "List.h"
 #include "Map.h"
+#include "Native.h"
 #include "MapEntry.h"
 #include "Numbers.h"
 #include "Reader.h"
 #include "RunTime.h"
+#include "Set.h"
 #include "Strings.h"
 #include "StringWriter.h"
 #include "Symbol.h"
@@ -50,6 +55,7 @@ Var *LOOP_LOCALS = NULL;
 Var *PROTOCOL_CALLSITES = NULL;
 Var *SOURCE = NULL;
 Var *SOURCE_PATH = NULL;
+Var *USE_BYTECODE = NULL;
 Var *VARS = NULL;
 Var *VAR_CALLSITES = NULL;
 Var *WARN_ON_REFLECTION = NULL;
@@ -78,6 +84,7 @@ typedef enum {	// expr_type
 	LOCALBINDINGEXPR_type,
 	OBJEXPR_type,
 	VECTOREXPR_type,
+	SETEXPR_type,
 	DEFEXPR_type,
 	BODYEXPR_type,
 	METHODPARAMEXPR_type,
@@ -104,7 +111,7 @@ typedef enum {	// PATHTYPE
 	BRANCH
 } PATHTYPE;
 
-#define EXPR_OBJECT {EXPR_type, 0, NULL, NULL, NULL, &NullInterface}
+#define EXPR_OBJECT {EXPR_type, 0, NULL, &NullInterface}
 
 static int registerConstant(const lisp_object *obj);
 static int registerKeywordCallsite(const Keyword *k);
@@ -200,6 +207,12 @@ static ObjMethod* NewObjMethod(ObjExpr *objx, ObjMethod *parent) {
 	return ret;
 }
 
+// The rev a Var had when code that inlined its value was compiled.
+typedef struct {	// VarRev
+	const Var *v;
+	size_t rev;
+} VarRev;
+
 #define OBJEXPR_DEF \
 	EXPR_BASE \
 	const char *name; \
@@ -215,6 +228,9 @@ static ObjMethod* NewObjMethod(ObjExpr *objx, ObjMethod *parent) {
 	const IMap *keywords; \
 	const IMap *vars; \
 	/* Class compiledClass; */ \
+	const IFn *compiledFn; \
+	const VarRev *compiledRevs; \
+	size_t compiledRevCount; \
 	int line; \
 	int column; \
 	const IVector *constants; \
@@ -256,16 +272,55 @@ const ObjExpr* NewObjExpr(const lisp_object *tag) {
 	return ret;
 }
 
-static void CompileObjExpr(__attribute__((unused)) const ObjExpr *self, __attribute__((unused)) const char *superName, __attribute__((unused)) size_t interfaceNames_count, __attribute__((unused)) const char **interfaceNames, __attribute__((unused)) bool oneTimeUse) {
-	// TODO CompileObjExpr
-}
-
-static void /* TODO */ getCompiledClass(__attribute__((unused)) const ObjExpr *self) {
-	// TODO getCompiledClass
+// Only fns that the native back end can JIT are compiled; everything else is left to the interpreter.  A fn qualifies
+// if it closes over nothing, and every Var it refers to is bound to a native primitive, which is inlined.  The JIT is
+// handed what each Var's name resolves to, so the primitive inlined is the one the Var holds, whatever it is called.
+// The revs are kept so that EvalFn can tell when one of the Vars has been rebound.
+static void CompileObjExpr(ObjExpr *self, __attribute__((unused)) const char *superName, __attribute__((unused)) size_t interfaceNames_count, __attribute__((unused)) const char **interfaceNames, __attribute__((unused)) bool oneTimeUse) {
+	self->compiledFn = NULL;
+	self->compiledRevs = NULL;
+	self->compiledRevCount = 0;
+	if(self->type != FNEXPR_type || !self->canBeDirect)
+		return;
+	size_t n = count((lisp_object*)self->vars);
+	VarRev *revs = GC_MALLOC((n ? n : 1) * sizeof(*revs));
+	const IMap *ops = (IMap*) EmptyHashMap;
+	size_t i = 0;
+	for(const ISeq *s = keys((lisp_object*)self->vars); s != NULL; s = s->obj.fns->ISeqFns->next(s), i++) {
+		const Var *v = (Var*) s->obj.fns->ISeqFns->first(s);
+		const size_t rev = getRevVar(v);
+		const lisp_object *val = deref(v);
+		if(!isNativePrimitive(val))
+			return;
+		// The JIT only sees operators by name, so Vars that share a name must hold the same primitive.
+		const lisp_object *name = (lisp_object*)getSymbolVar(v);
+		const lisp_object *prev = ops->obj.fns->IMapFns->valAt(ops, name, NULL);
+		if(prev != NULL && prev != val)
+			return;
+		ops = ops->obj.fns->IMapFns->assoc(ops, name, val);
+		revs[i] = (VarRev){v, rev};
+	}
+	self->compiledFn = JitFn(self->src, ops);
+	self->compiledRevs = revs;
+	self->compiledRevCount = n;
+}
+
+// True if none of the Vars that the compiled fn inlined has been rebound since.
+static bool isCompiledFnCurrent(const ObjExpr *self) {
+	for(size_t i = 0; i < self->compiledRevCount; i++) {
+		if(getRevVar(self->compiledRevs[i].v) != self->compiledRevs[i].rev)
+			return false;
+	}
+	return true;
+}
+
+static const IFn* getCompiledClass(const ObjExpr *self) {
+	return self->compiledFn;
 }
 
 // LocalBinding
 typedef struct {	// LocalBinding
+	lisp_object obj;
 	const Symbol *sym;
 	const Symbol *tag;
 	const Expr *init;
@@ -284,6 +339,8 @@ static LocalBinding* NewLocalBinding(int num, const Symbol *sym, const Symbol *t
 		exception e = {UnsupportedOperationException, "Can't type hint a local with a primitive initializer"};
 		Raise(e);
 	}
+	ret->obj.type = LOCALBINDING_type;
+	ret->obj.fns = &NullInterface;
 	ret->index = num;
 	ret->sym = sym;
 	ret->tag = tag;
@@ -311,7 +368,7 @@ static void closeOver(const LocalBinding *b, ObjMethod *method) {
 				method->useThis = true;
 			if(deref(IN_CATCH_FINALLY)) {
 				const IMap *m = method->localsUsedInCatchFinally;
-				method->localsUsedInCatchFinally = m->obj.fns->IMapFns->assoc(m, (lisp_object*)b->index, (lisp_object*)True);
+				method->localsUsedInCatchFinally = m->obj.fns->IMapFns->assoc(m, (lisp_object*)NewInteger(b->index), (lisp_object*)True);
 			}
 		} else {
 			method->objx->closes = (IMap*)assoc((lisp_object*)method->objx->closes, (lisp_object*)b, (lisp_object*)b);
@@ -343,7 +400,7 @@ static LocalBinding* referenceLocal(const Symbol *sym) {
 
 static size_t getAndIncLocalNum() {
 	const Integer *I = (Integer*)deref(NEXT_LOCAL_NUM);
-	assert(((lisp_object*)I)->type == INTEGER_type);
+	assert(objectType((lisp_object*)I) == INTEGER_type);
 	const size_t i = IntegerValue(I);
 	ObjMethod *m = (ObjMethod*)deref(METHOD);
 	if(i > m->maxLocal)
@@ -364,6 +421,28 @@ static const LocalBinding* registerLocal(const Symbol *sym,  const Symbol *tag,
 	return b;
 }
 
+// Local slot frames
+// At runtime the locals of a method live in a flat array indexed by LocalBinding.index.  The array is sized from
+// NEXT_LOCAL_NUM at analysis time, so reading or writing a local never allocates.
+static __thread const lisp_object **LocalSlots = NULL;
+
+// Returned by recur to its enclosing loop, after the loop locals have been rebound in place.
+static const lisp_object RecurMarker = {EXPR_type, sizeof(lisp_object), NULL, &NullInterface};
+
+// Returned by an invoke in tail position, instead of making the call.  The Fn whose body is running makes the call
+// described by PendingTailCall once its frame is gone, so a chain of tail calls runs in constant stack.
+static const lisp_object TailCallMarker = {EXPR_type, sizeof(lisp_object), NULL, &NullInterface};
+
+typedef struct {	// TailCall
+	const IFn *f;
+	size_t argc;
+	const lisp_object *argv[MAX_POSITIONAL_ARITY];
+} TailCall;
+
+static __thread TailCall PendingTailCall;
+
+static const Code* compileBytecodeBody(const Expr *x, size_t loopStart);
+
 // MethodParamExpr
 typedef struct {	// MethodParamExpr
 	EXPR_BASE
@@ -399,6 +478,7 @@ typedef struct {	// FnMethod
 	// Class argClasses[];
 	// Class retClass;
 	const char *prim;
+	const Code *code;	// The body lowered to bytecode when *use-bytecode* was set as the fn was analyzed, or NULL.
 } FnMethod;
 
 static FnMethod* NewFnMethod(ObjExpr *objx, ObjMethod *parent) {
@@ -407,13 +487,14 @@ static FnMethod* NewFnMethod(ObjExpr *objx, ObjMethod *parent) {
 	ret->obj.type = FNMETHOD_type;
 	ret->reqParms = (IVector*)EmptyVector;
 	ret->restParm = NULL;
+	ret->code = NULL;
  
 	return ret;
 }
 
 static char classChar(const lisp_object *x) {
 	object_type c = ERROR_type;
-	if(x->type == SYMBOL_type)
+	if(x && objectType(x) == SYMBOL_type)
 		c = primClass((Symbol*)x);
 	if(c == ERROR_type || !isPrimitive(c))
 		return 'O';
@@ -468,16 +549,16 @@ static const FnMethod* parseFnMethod(ObjExpr *objx, const ISeq *form, const lisp
 			(lisp_object*)METHOD_RETURN_CONTEXT, (lisp_object*)True,
 		};
 		size_t mapArgc = sizeof(mapArgs)/sizeof(mapArgs[0]);
-		pushThreadBindings((IMap*)CreateHashMap(mapArgc, mapArgs));
+		pushThreadBindings(CreateArrayMap(mapArgc, mapArgs));
 
 		method->prim = primInterface(parms);
 		if(method->prim) {
 			// TODO replace '.' to '/' in method->prim
 		}
 
-		if(rettag->type == STRING_type)
+		if(rettag && objectType(rettag) == STRING_type)
 			rettag = (lisp_object*)internSymbol2(NULL, toString(rettag));
-		if(rettag->type != SYMBOL_type)
+		if(rettag && objectType(rettag) != SYMBOL_type)
 			rettag = NULL;
 		if(rettag) {
 			// TODO Handle primative return type.
@@ -494,10 +575,10 @@ static const FnMethod* parseFnMethod(ObjExpr *objx, const ISeq *form, const lisp
 		PSTATE state = REQ;
 		const IVector *argLocals = (IVector*) EmptyVector;
 		size_t argTypesCount = 0;
-		object_type *argTypes = GC_MALLOC_ATOMIC(argTypesCount);
+		object_type *argTypes = GC_MALLOC_ATOMIC(sizeof(*argTypes));
 		// TODO argClass
 		for(size_t i = 0; i < count((lisp_object*)parms); i++) {
-			if(parms->obj.fns->IVectorFns->nth(parms, i, NULL)->type != SYMBOL_type) {
+			if(objectType(parms->obj.fns->IVectorFns->nth(parms, i, NULL)) != SYMBOL_type) {
 				exception e = {IllegalArgumentException, "fn params must be symbols."};
 				Raise(e);
 			}
@@ -531,7 +612,7 @@ static const FnMethod* parseFnMethod(ObjExpr *objx, const ISeq *form, const lisp
 				if(state == REST)
 				pc = ISEQ_interface;
 				argTypesCount++;
-				GC_realloc(argTypes, argTypesCount);
+				argTypes = GC_realloc(argTypes, argTypesCount * sizeof(*argTypes));
 				argTypes[argTypesCount-1] = pc;
 				const LocalBinding *lb = isPrimitive(pc) ? registerLocal(p, NULL, (Expr*)NewMethodParamExpr(pc), true)
 														: registerLocal(p, state == REST ? ISEQSymbol : tagOf((lisp_object*)p), NULL, true);
@@ -681,7 +762,7 @@ static const Expr* parseConstant(__attribute__((unused)) Expr_Context context, c
 		return FalseExpr;
 	if(isNumber(v))
 		return parseNumber((Number*)v);
-	if(v->type == STRING_type)
+	if(objectType(v) == STRING_type)
 		return NewStringExpr((String*)v);
 	if(isICollection(v) && v->fns->ICollectionFns->count((ICollection*)v) == 0)
 		return NewEmptyExpr((ICollection*)v);
@@ -791,9 +872,10 @@ static const lisp_object* EvalMap(const Expr *self){
 	size_t count = m->keyVals->obj.fns->ICollectionFns->count((ICollection*)m->keyVals);
 	const lisp_object* entries[count];
 	for(size_t i = 0; i < count; i++) {
-		entries[i] = m->keyVals->obj.fns->IVectorFns->nth(m->keyVals, i, NULL);
+		const Expr *e = (Expr*) m->keyVals->obj.fns->IVectorFns->nth(m->keyVals, i, NULL);
+		entries[i] = e->Eval(e);
 	}
-	return (lisp_object*)CreateHashMap(count, entries);
+	return (lisp_object*)CreateArrayMap(count, entries);
 }
 
 static const Expr* parseMapExpr(Expr_Context context, const IMap *form) {
@@ -801,7 +883,7 @@ static const Expr* parseMapExpr(Expr_Context context, const IMap *form) {
 	bool keysConstant = true;
 	bool valsConstant = true;
 	bool allConstantKeysUnique = true;
-	const IMap *constantKeys = (IMap*) EmptyHashMap;
+	const IMap *constantKeys = (IMap*) EmptyArrayMap;
 	for(const ISeq *s = form->obj.fns->SeqableFns->seq((Seqable*)form); s != NULL; s = s->obj.fns->ISeqFns->next(s)) {
 		MapEntry *e = (MapEntry*)s->obj.fns->ISeqFns->first(s);
 		const Expr *key = Analyze(context == EVAL ? EVAL : EXPRESSION, e->key, NULL);
@@ -811,7 +893,7 @@ static const Expr* parseMapExpr(Expr_Context context, const IMap *form) {
 
 		if(IsLiteralExpr(key)) {
 			const lisp_object *k = key->Eval(key);
-			if(constantKeys->obj.fns->IMapFns->entryAt(constantKeys, k)) {
+			if(constantKeys->obj.fns->IMapFns->containsKey(constantKeys, k)) {
 				allConstantKeysUnique = false;
 			} else {
 				constantKeys = constantKeys->obj.fns->IMapFns->assoc(constantKeys, k, k);
@@ -826,6 +908,7 @@ static const Expr* parseMapExpr(Expr_Context context, const IMap *form) {
 	MapExpr *ret = GC_MALLOC(sizeof(*ret));
 	ret->obj.type = EXPR_type;
 	ret->obj.fns = &NullInterface;
+	ret->type = MAPEXPR_type;
 	ret->keyVals = keyVals;
 	ret->Eval = EvalMap;
 
@@ -838,7 +921,7 @@ static const Expr* parseMapExpr(Expr_Context context, const IMap *form) {
 			Raise(e);
 		}
 		if(valsConstant) {
-			const IMap *m = (IMap*)EmptyHashMap;
+			const IMap *m = (IMap*)EmptyArrayMap;
 			for(size_t i = 0; i < keyVals->obj.fns->ICollectionFns->count((ICollection*)keyVals); i+=2) {
 				Expr *k = (Expr*)keyVals->obj.fns->IVectorFns->nth(keyVals, i, NULL);
 				Expr *v = (Expr*)keyVals->obj.fns->IVectorFns->nth(keyVals, i+1, NULL);
@@ -861,12 +944,18 @@ typedef struct {	// KeywordInvokeExpr
 	int column;
 	int siteIndex;
 	const char *source;
+	KeyLookupSite site;
 } KeywordInvokeExpr;
 
 static const lisp_object* EvalKwInvoke(const Expr *self) {
-	assert(self->type == KEYWORDEXPR_type);
-	const KeywordInvokeExpr *KWI = (KeywordInvokeExpr*)self;
-	return ((lisp_object*)KWI->kw->k)->fns->IFnFns->invoke1((IFn*)KWI->kw->k, KWI->target->Eval(KWI->target));
+	assert(self->type == KWINVOKEEXPR_type);
+	KeywordInvokeExpr *KWI = (KeywordInvokeExpr*)self;
+	const lisp_object *target = KWI->target->Eval(KWI->target);
+	if(target && objectType(target) == HASHMAP_type)
+		return siteLookupHashMap((HashMap*)target, &KWI->site, NULL);
+	if(target && objectType(target) == ARRAYMAP_type)
+		return siteLookupArrayMap((ArrayMap*)target, &KWI->site, NULL);
+	return ((lisp_object*)KWI->kw->k)->fns->IFnFns->invoke1((IFn*)KWI->kw->k, target);
 }
 
 static Expr* NewKeyWordInvokeExpr(const char *source, const Symbol *tag, const KeywordExpr *kw, const Expr *target) {
@@ -881,6 +970,7 @@ static Expr* NewKeyWordInvokeExpr(const char *source, const Symbol *tag, const K
 	ret->target = target;
 	ret->tag = (lisp_object*)tag;
 	ret->siteIndex = registerKeywordCallsite(kw->k);
+	initKeyLookupSite(&ret->site, (lisp_object*)kw->k);
 
 	return (Expr*) ret;
 }
@@ -912,6 +1002,15 @@ static const Expr* NewVarExpr(const Var *v, const Symbol *tag) {
 }
 
 // InvokeExpr
+
+// The root of a non-dynamic Var as a call site last saw it.  A record is never changed once it is published, and a
+// site replaces it with a single pointer store, so a reader gets the fn, its vtable and the rev that go together.
+typedef struct {	// LinkedFn
+	const IFn *fn;
+	const IFn_vtable *fns;
+	size_t rev;
+} LinkedFn;
+
 typedef struct {	// InvokeExpr
 	EXPR_BASE
 	const Expr *fexpr;
@@ -922,36 +1021,97 @@ typedef struct {	// InvokeExpr
 	bool tailPosition;
 	const char *source;
 	bool isProtocol;
-	bool isDirect;
+	bool isDirect;	// The fn is a non-dynamic Var, whose root is cached in linked.
 	int siteIndex;
 	// Class protocolOn;
 	// public java.lang.reflect.Method onMethod;
+	const LinkedFn *linked;
 } InvokeExpr;
 
+static const lisp_object* invokeArgs(const IFn_vtable *fns, const IFn *f, size_t argc, const lisp_object *const *argv) {
+	switch(argc) {
+		case 0:
+			return fns->invoke0(f);
+		case 1:
+			return fns->invoke1(f, argv[0]);
+		case 2:
+			return fns->invoke2(f, argv[0], argv[1]);
+		case 3:
+			return fns->invoke3(f, argv[0], argv[1], argv[2]);
+		case 4:
+			return fns->invoke4(f, argv[0], argv[1], argv[2], argv[3]);
+		case 5:
+			return fns->invoke5(f, argv[0], argv[1], argv[2], argv[3], argv[4]);
+		default:
+			return fns->applyTo(f, (ISeq*)CreateList(argc, argv));
+	}
+}
+
+// Relinks only when the Var has been rebound since the site was linked, so a call through a global costs a compare
+// rather than a deref.  Returns NULL when the root is not a fn.
+static const LinkedFn* linkedFn(InvokeExpr *Invk) {
+	const Var *v = ((VarExpr*)Invk->fexpr)->v;
+	const size_t rev = getRevVar(v);
+	const LinkedFn *link = Invk->linked;
+	if(link == NULL || link->rev != rev) {
+		const lisp_object *root = deref(v);
+		if(!isIFn(root))
+			return NULL;
+		LinkedFn *fresh = GC_MALLOC(sizeof(*fresh));
+		fresh->fn = (IFn*)root;
+		fresh->fns = root->fns->IFnFns;
+		fresh->rev = rev;
+		Invk->linked = link = fresh;
+	}
+	return link;
+}
+
 static const lisp_object* EvalInvoke(const Expr *self) {
 	assert(self->type == INVOKEEXPR_type);
 	const InvokeExpr *Invk = (InvokeExpr*)self;
+	const lisp_object *ret = NULL;
 	TRY
-		IFn *f = (IFn*) Invk->fexpr->Eval(Invk->fexpr);
-		const IVector *args = (IVector*)EmptyVector;
-		for(size_t i = 0; i < Invk->args->obj.fns->ICollectionFns->count((ICollection*)Invk->args); i++) {
-			Expr *ith = (Expr*)Invk->args->obj.fns->IVectorFns->nth(Invk->args, i, NULL);
-			args = args->obj.fns->IVectorFns->cons(args, ith->Eval(ith));
+		const LinkedFn *link = Invk->isDirect ? linkedFn((InvokeExpr*)Invk) : NULL;
+		const IFn *f = link ? link->fn : (IFn*) Invk->fexpr->Eval(Invk->fexpr);
+		const IFn_vtable *fns = link ? link->fns : f->obj.fns->IFnFns;
+		const size_t argc = Invk->args->obj.fns->ICollectionFns->count((ICollection*)Invk->args);
+		if(argc > MAX_POSITIONAL_ARITY) {
+			const lisp_object **argv = GC_MALLOC(argc * sizeof(*argv));
+			for(size_t i = 0; i < argc; i++) {
+				const Expr *ith = (Expr*)Invk->args->obj.fns->IVectorFns->nth(Invk->args, i, NULL);
+				argv[i] = ith->Eval(ith);
+			}
+			ret = fns->applyTo(f, (ISeq*)CreateList(argc, argv));
+		} else if(Invk->tailPosition) {
+			// Evaluated straight into the pending call, which the enclosing Fn makes after this frame is gone.
+			TailCall call = {f, argc, {NULL}};
+			for(size_t i = 0; i < argc; i++) {
+				const Expr *ith = (Expr*)Invk->args->obj.fns->IVectorFns->nth(Invk->args, i, NULL);
+				call.argv[i] = ith->Eval(ith);
+			}
+			PendingTailCall = call;
+			ret = &TailCallMarker;
+		} else {
+			// Positional calls evaluate into a stack array and dispatch straight to invokeN.
+			const lisp_object *argv[MAX_POSITIONAL_ARITY];
+			for(size_t i = 0; i < argc; i++) {
+				const Expr *ith = (Expr*)Invk->args->obj.fns->IVectorFns->nth(Invk->args, i, NULL);
+				argv[i] = ith->Eval(ith);
+			}
+			ret = invokeArgs(fns, f, argc, argv);
 		}
-		return f->obj.fns->IFnFns->applyTo(f, args->obj.fns->SeqableFns->seq((Seqable*)args));
 	EXCEPT(CompilerExcp)
 		ReRaise;
 	EXCEPT(ANY)
 		exception e = {CompilerException, _ctx.id->msg};
 		Raise(e);
 	ENDTRY
-	__builtin_unreachable();
+	return ret;
 }
 
 static const lisp_object* sigTag(size_t argCount, const Var *v) {
 	const IMap *meta = ((lisp_object*)v)->meta;
-	const MapEntry *me = meta->obj.fns->IMapFns->entryAt(meta, (lisp_object*)arglistsKW);
-	const lisp_object *arglists = me ? me->val : NULL;
+	const lisp_object *arglists = meta->obj.fns->IMapFns->valAt(meta, (lisp_object*)arglistsKW, NULL);
 
 	for(const ISeq *s = seq(arglists); s != NULL; s = s->obj.fns->ISeqFns->next(s)) {
 		const Vector *sig = (Vector*)s->obj.fns->ISeqFns->first(s);
@@ -978,6 +1138,7 @@ static Expr* NewInvokeExpr(const char *source, int line, int column, const Symbo
 
 	if(fexpr->type == VAREXPR_type) {
 		// TODO This is for protocols.
+		ret->isDirect = !isDynamic(((VarExpr*)fexpr)->v);
 	}
 
 	if(tag) {
@@ -1014,8 +1175,7 @@ static const Expr* parseInvokeExpr(Expr_Context context, const ISeq *form) {
 	if((fexpr->type == VAREXPR_type) && (context != EVAL)) {
 		const Var *v = ((VarExpr*)fexpr)->v;
 		const IMap *vMeta = ((lisp_object*)v)->meta;
-		const MapEntry *me = vMeta->obj.fns->IMapFns->entryAt(vMeta, (lisp_object*)arglistsKW);
-		const lisp_object *arglist = me ? me->val : NULL;
+		const lisp_object *arglist = vMeta->obj.fns->IMapFns->valAt(vMeta, (lisp_object*)arglistsKW, NULL);
 		size_t arity = count((lisp_object*)form->obj.fns->ISeqFns->next(form));
 		for(const ISeq *s = seq(arglist); s != NULL; s->obj.fns->ISeqFns->next(s)) {
 			const IVector *args = (IVector*) s->obj.fns->ISeqFns->first(s);
@@ -1052,10 +1212,10 @@ typedef struct {	// LocalBindingExpr
 	bool shouldClear;
 } LocalBindingExpr;
 
-static const lisp_object* EvalLocalBinding(__attribute__((unused)) const Expr *self) {
-	exception e = {UnsupportedOperationException, "Can't eval locals"};
-	Raise(e);
-	__builtin_unreachable();
+static const lisp_object* EvalLocalBinding(const Expr *self) {
+	assert(self->type == LOCALBINDINGEXPR_type);
+	const LocalBindingExpr *lbe = (LocalBindingExpr*)self;
+	return LocalSlots[lbe->b->index];
 }
 
 static Expr* NewLocalBindingExpr(LocalBinding *b, const Symbol *tag) {
@@ -1102,16 +1262,22 @@ typedef struct {	// VectorExpr
 	const IVector *args;
 } VectorExpr;
 
-static const lisp_object* EvalVector(const Expr *self) {
-	assert(self->type == VECTOREXPR_type);
-	const IVector *args = ((VectorExpr*)self)->args;
-	const IVector *ret = (IVector*) EmptyVector;
-	for(size_t i = 0; i < ret->obj.fns->ICollectionFns->count((ICollection*)ret); i++) {
+// Evaluates each of args into an array and builds the vector from it in one go, rather than one persistent cons each.
+static const Vector* evalVectorArgs(const IVector *args) {
+	const size_t argc = args->obj.fns->ICollectionFns->count((ICollection*)args);
+	if(argc == 0)
+		return EmptyVector;
+	const lisp_object **argv = GC_MALLOC(argc * sizeof(*argv));
+	for(size_t i = 0; i < argc; i++) {
 		const Expr *e = (Expr*) args->obj.fns->IVectorFns->nth(args, i, NULL);
-		ret = ret->obj.fns->IVectorFns->cons(ret, e->Eval(e));
+		argv[i] = e->Eval(e);
 	}
+	return CreateVector(argc, argv);
+}
 
-	return (lisp_object*) ret;
+static const lisp_object* EvalVector(const Expr *self) {
+	assert(self->type == VECTOREXPR_type);
+	return (lisp_object*) evalVectorArgs(((VectorExpr*)self)->args);
 }
 
 static Expr* NewVectorExpr(const IVector *args) {
@@ -1127,27 +1293,72 @@ static Expr* NewVectorExpr(const IVector *args) {
 
 static const Expr* parseVectorExpr(Expr_Context context, const IVector *form) {
 	bool constant = true;
-	const IVector *args = (IVector*)EmptyVector;
-	for(size_t i = 0; i < count((lisp_object*)form); i++) {
+	const size_t argc = count((lisp_object*)form);
+	const lisp_object **argv = GC_MALLOC((argc ? argc : 1) * sizeof(*argv));
+	for(size_t i = 0; i < argc; i++) {
 		const Expr *v = Analyze(context == EVAL ? EVAL : EXPRESSION, form->obj.fns->IVectorFns->nth(form, i, NULL), NULL);
-		args = args->obj.fns->IVectorFns->cons(args, (lisp_object*)v);
+		argv[i] = (lisp_object*)v;
 		if(!IsLiteralExpr(v))
 			constant = false;
 	}
+	const IVector *args = (IVector*)CreateVector(argc, argv);
 
 	const Expr *ret = NewVectorExpr(args);
 	if(((lisp_object*)form)->meta)
 		return NewMetaExpr(ret, parseMapExpr(context == EVAL ? EVAL : EXPRESSION, ((lisp_object*)form)->meta));
 
-	if(constant) {
-		const IVector *rv = (IVector*)EmptyVector;
-		for(size_t i = 0; i < count((lisp_object*)args); i++) {
-			const Expr *ce = (Expr*) args->obj.fns->IVectorFns->nth(args, i, NULL);
-			rv = rv->obj.fns->IVectorFns->cons(rv, ce->Eval(ce));
-		}
-		return NewConstantExpr((lisp_object*)rv);
+	if(constant)
+		return NewConstantExpr((lisp_object*)evalVectorArgs(args));
+
+	return ret;
+}
+
+// SetExpr
+typedef struct {	// SetExpr
+	EXPR_BASE
+	const IVector *keys;
+} SetExpr;
+
+static const lisp_object* EvalSet(const Expr *self) {
+	assert(self->type == SETEXPR_type);
+	const IVector *keys = ((SetExpr*)self)->keys;
+	TransientHashSet *ret = asTransientHashSet(EmptyHashSet);
+	for(size_t i = 0; i < count((lisp_object*)keys); i++) {
+		const Expr *e = (Expr*) keys->obj.fns->IVectorFns->nth(keys, i, NULL);
+		ret = conjTHS(ret, e->Eval(e));
+	}
+
+	return (lisp_object*) asPersistentHashSet(ret);
+}
+
+static Expr* NewSetExpr(const IVector *keys) {
+	SetExpr *ret = GC_MALLOC(sizeof(*ret));
+	ret->obj.type = EXPR_type;
+	ret->obj.fns = &NullInterface;
+	ret->type = SETEXPR_type;
+	ret->Eval = EvalSet;
+
+	ret->keys = keys;
+	return (Expr*) ret;
+}
+
+static const Expr* parseSetExpr(Expr_Context context, const ISet *form) {
+	bool constant = true;
+	const IVector *keys = (IVector*)EmptyVector;
+	for(const ISeq *s = seq((lisp_object*)form); s != NULL; s = s->obj.fns->ISeqFns->next(s)) {
+		const Expr *e = Analyze(context == EVAL ? EVAL : EXPRESSION, s->obj.fns->ISeqFns->first(s), NULL);
+		keys = keys->obj.fns->IVectorFns->cons(keys, (lisp_object*)e);
+		if(!IsLiteralExpr(e))
+			constant = false;
 	}
 
+	const Expr *ret = NewSetExpr(keys);
+	if(((lisp_object*)form)->meta)
+		return NewMetaExpr(ret, parseMapExpr(context == EVAL ? EVAL : EXPRESSION, ((lisp_object*)form)->meta));
+
+	if(constant)
+		return NewConstantExpr(ret->Eval(ret));
+
 	return ret;
 }
 
@@ -1168,6 +1379,7 @@ typedef struct {	// DefExpr
 static const lisp_object* EvalDef(const Expr *self) {
 	assert(self->type == DEFEXPR_type);
 	const DefExpr *defx = (DefExpr*)self;
+	const lisp_object *ret = NULL;
 	TRY
 		if(defx->initProvided) {
 			bindRoot(defx->v, defx->init->Eval(defx->init));
@@ -1176,14 +1388,14 @@ static const lisp_object* EvalDef(const Expr *self) {
 				setMeta(defx->v, meta);
 			}
 		}
-		return (lisp_object*) setDynamic1(defx->v, defx->isDynamic);
+		ret = (lisp_object*) setDynamic1(defx->v, defx->isDynamic);
 	EXCEPT(CompilerExcp)
 		ReRaise;
 	EXCEPT(ANY)
 		exception e = {CompilerException, _ctx.id->msg};
 		Raise(e);
 	ENDTRY
-	__builtin_unreachable();
+	return ret;
 }
 
 static Expr* NewDefExpr(const char *source, int line, int column, Var *v, const Expr *init, const Expr *meta, bool initProvided, bool isDynamic, bool shadowsCoreMapping) {
@@ -1208,7 +1420,7 @@ static Expr* NewDefExpr(const char *source, int line, int column, Var *v, const
 
 static const Expr* parseDefExpr(Expr_Context context, const lisp_object *form) {
 	const String *docstring = NULL;
-	if(count(form) == 4 && third(form)->type == STRING_type) {
+	if(count(form) == 4 && objectType(third(form)) == STRING_type) {
 		docstring = (String*)third(form);
 		form = (lisp_object*)listStar3(first(form), second(form), fourth(form), NULL);
 	}
@@ -1219,7 +1431,7 @@ static const Expr* parseDefExpr(Expr_Context context, const lisp_object *form) {
 	} else if(count(form) < 2) {
 		exception e = {RuntimeException, "Too few arguments to def"};
 		Raise(e);
-	} else if(second(form)->type != SYMBOL_type) {
+	} else if(objectType(second(form)) != SYMBOL_type) {
 		exception e = {RuntimeException, "First argument to def must be a Symbol"};
 		Raise(e);
 	}
@@ -1279,8 +1491,9 @@ static const lisp_object* EvalBody(const Expr *self) {
 	assert(self->type == BODYEXPR_type);
 	const BodyExpr *b = (BodyExpr*)self;
 	const lisp_object *ret = NULL;
-	for(const ISeq *s = b->exprs->obj.fns->SeqableFns->seq((Seqable*)b->exprs); s != NULL; s = s->obj.fns->ISeqFns->next(s)) {
-		const Expr *e = (Expr*) s->obj.fns->ISeqFns->first(s);
+	const size_t n = b->exprs->obj.fns->ICollectionFns->count((ICollection*)b->exprs);
+	for(size_t i = 0; i < n; i++) {
+		const Expr *e = (Expr*) b->exprs->obj.fns->IVectorFns->nth(b->exprs, i, NULL);
 		ret = e->Eval(e);
 	}
 	return ret;
@@ -1323,12 +1536,32 @@ typedef struct {	// LetExpr
 	const IVector *bindingInits;
 	const Expr *body;
 	bool isLoop;
+	size_t frameSize;	// Non-zero when this let is not inside a method, and so owns the frame its locals live in.
 } LetExpr;
 
-static const lisp_object* EvalLet(__attribute__((unused)) const Expr *self) {
-	exception e = {UnsupportedOperationException, "Can't eval let/loop"};
-	Raise(e);
-	__builtin_unreachable();
+static const lisp_object* EvalLet(const Expr *self) {
+	assert(self->type == LETEXPR_type);
+	const LetExpr *l = (LetExpr*)self;
+	const lisp_object **outerSlots = LocalSlots;
+	const lisp_object *frame[l->frameSize ? l->frameSize : 1];
+	const lisp_object *ret = NULL;
+	TRY
+		if(l->frameSize) {
+			memset(frame, '\0', sizeof(frame));
+			LocalSlots = frame;
+		}
+		const size_t n = l->bindingInits->obj.fns->ICollectionFns->count((ICollection*)l->bindingInits);
+		for(size_t i = 0; i < n; i++) {
+			const BindingInit *bi = (BindingInit*) l->bindingInits->obj.fns->IVectorFns->nth(l->bindingInits, i, NULL);
+			LocalSlots[bi->binding->index] = bi->Init->Eval(bi->Init);
+		}
+		do {
+			ret = l->body->Eval(l->body);
+		} while(l->isLoop && ret == &RecurMarker);
+	FINALLY
+		LocalSlots = outerSlots;
+	ENDTRY
+	return ret;
 }
 
 static Expr* NewLetExpr(const IVector *bindingInits, const Expr *body, bool isLoop) {
@@ -1341,10 +1574,11 @@ static Expr* NewLetExpr(const IVector *bindingInits, const Expr *body, bool isLo
 	ret->bindingInits = bindingInits;
 	ret->body = body;
 	ret->isLoop = isLoop;
+	ret->frameSize = 0;
 	return (Expr*) ret;
 }
 
-static const Expr* parseLetExpr(Expr_Context context, const lisp_object *form) {
+static const Expr* analyzeLet(Expr_Context context, const lisp_object *form, ObjMethod *method) {
 	bool isLoop = Equals(first(form), (lisp_object*)LoopSymbol);
 	if(!isIVector(second(form))) {
 		exception e = {IllegalArgumentException, "Bad binding form, expected vector"};
@@ -1359,12 +1593,10 @@ static const Expr* parseLetExpr(Expr_Context context, const lisp_object *form) {
 
 	const ISeq *body = next((lisp_object*)next(form));
 
-	if(context == EVAL || (context == EXPRESSION && isLoop))
-		Analyze(context, (lisp_object*)listStar1((lisp_object*)listStar2((lisp_object*)FnOnceSymbol, (lisp_object*)EmptyVector, (ISeq*)form), NULL), NULL);
-	ObjMethod *method = (ObjMethod*)deref(METHOD);
 	const IMap *backupMethodLocals = method->locals;
 	const IMap *backupMethodIndexLocals = method->indexLocals;
 	const IVector *recurMismatches = (IVector*)EmptyVector;
+	const Expr *ret = NULL;
 
 	for(size_t i = 0; i < bindings->obj.fns->ICollectionFns->count((ICollection*)bindings)/2; i++)
 		recurMismatches = recurMismatches->obj.fns->IVectorFns->cons(recurMismatches, (lisp_object*)False);
@@ -1372,7 +1604,7 @@ static const Expr* parseLetExpr(Expr_Context context, const lisp_object *form) {
 	while(true) {
 		const lisp_object *mapArgs[] = {(lisp_object*)LOCAL_ENV, deref(LOCAL_ENV), (lisp_object*)NEXT_LOCAL_NUM, deref(NEXT_LOCAL_NUM)};
 		size_t mapArgc = sizeof(mapArgs)/sizeof(mapArgs[0]);
-		const IMap *dynamicBindings = (IMap*)CreateHashMap(mapArgc, mapArgs);
+		const IMap *dynamicBindings = CreateArrayMap(mapArgc, mapArgs);
 
 		method->locals = backupMethodLocals;
 		method->indexLocals = backupMethodIndexLocals;
@@ -1388,7 +1620,7 @@ static const Expr* parseLetExpr(Expr_Context context, const lisp_object *form) {
 			const IVector *loopLocals = (IVector*)EmptyVector;
 			for(size_t i = 0; i < bindings->obj.fns->ICollectionFns->count((ICollection*)bindings); i+=2) {
 				const lisp_object *obj = bindings->obj.fns->IVectorFns->nth(bindings, i, NULL);
-				if(obj->type != SYMBOL_type) {
+				if(objectType(obj) != SYMBOL_type) {
 					exception e = {IllegalArgumentException, WriteString(AddString(AddString(NewStringWriter(),
 									"Bad binding form, expected symbol, got: "), toString(obj)))};
 					Raise(e);
@@ -1401,11 +1633,12 @@ static const Expr* parseLetExpr(Expr_Context context, const lisp_object *form) {
 				}
 				const Expr *init = Analyze(EXPRESSION, bindings->obj.fns->IVectorFns->nth(bindings, i+1, NULL), getNameSymbol(sym));
 				if(isLoop) {
-					if(boolCast(recurMismatches->obj.fns->IVectorFns->nth(recurMismatches, 1/2, NULL))) {
+					const object_type *primc = maybePrimitiveType(init);
+					if(boolCast(recurMismatches->obj.fns->IVectorFns->nth(recurMismatches, i/2, NULL))) {
 						// init = StaticMethodExpr(...)		// TODO
-					} else if(*maybePrimitiveType(init) == INTEGER_type) {
+					} else if(primc && *primc == INTEGER_type) {
 						// init = StaticMethodExpr(...)		// TODO
-					} else if(*maybePrimitiveType(init) == FLOAT_type) {
+					} else if(primc && *primc == FLOAT_type) {
 						// init = StaticMethodExpr(...)		// TODO
 					}
 				}
@@ -1418,13 +1651,13 @@ static const Expr* parseLetExpr(Expr_Context context, const lisp_object *form) {
 							(lisp_object*)NO_RECUR, NULL
 						};
 						size_t mapArgc = sizeof(mapArgs)/sizeof(mapArgs[0]);
-						pushThreadBindings((IMap*)CreateHashMap(mapArgc, mapArgs));
-						const LocalBinding *lb = registerLocal(sym, tagOf((lisp_object*)sym), init, false);
-						const BindingInit *bi = NewBindingInit(lb, init);
-						bindingInits = bindingInits->obj.fns->IVectorFns->cons(bindingInits, (lisp_object*)bi);
-						if(isLoop)
-							loopLocals = loopLocals->obj.fns->IVectorFns->cons(loopLocals, (lisp_object*)bi);
+						pushThreadBindings(CreateArrayMap(mapArgc, mapArgs));
 					}
+					const LocalBinding *lb = registerLocal(sym, tagOf((lisp_object*)sym), init, false);
+					const BindingInit *bi = NewBindingInit(lb, init);
+					bindingInits = bindingInits->obj.fns->IVectorFns->cons(bindingInits, (lisp_object*)bi);
+					if(isLoop)
+						loopLocals = loopLocals->obj.fns->IVectorFns->cons(loopLocals, (lisp_object*)lb);
 				FINALLY
 					if(isLoop)
 						popThreadBindings();
@@ -1444,9 +1677,9 @@ static const Expr* parseLetExpr(Expr_Context context, const lisp_object *form) {
 						(lisp_object*)METHOD_RETURN_CONTEXT, (context == RETURN ? deref(METHOD_RETURN_CONTEXT) : NULL)
 					};
 					size_t mapArgc = sizeof(mapArgs)/sizeof(mapArgs[0]);
-					pushThreadBindings((IMap*)CreateHashMap(mapArgc, mapArgs));
-					bodyExpr = parseBodyExpr((isLoop ? RETURN: context), (lisp_object*)body);
+					pushThreadBindings(CreateArrayMap(mapArgc, mapArgs));
 				}
+				bodyExpr = parseBodyExpr((isLoop ? RETURN: context), (lisp_object*)body);
 			FINALLY
 				if(isLoop) {
 					popThreadBindings();
@@ -1460,28 +1693,213 @@ static const Expr* parseLetExpr(Expr_Context context, const lisp_object *form) {
 				}
 			ENDTRY
 			if(!moreMismatches)
-				return NewLetExpr(bindingInits, bodyExpr, isLoop);
+				ret = NewLetExpr(bindingInits, bodyExpr, isLoop);
 		FINALLY
 			popThreadBindings();
 		ENDTRY
+		// Returning from inside the TRY would leave its context on the exception stack and skip the pop.
+		if(ret)
+			return ret;
 	}
 }
 
+static const Expr* parseLetExpr(Expr_Context context, const lisp_object *form) {
+	if(deref(METHOD))
+		return analyzeLet(context, form, (ObjMethod*)deref(METHOD));
+
+	// Outside of a method, the let gets a method of its own to number its locals.  Slot 0 is reserved for this, as
+	// in FnMethod.  It is bound the way parseFnMethod binds a method, since Eval may be called without compilerLoad.
+	ObjMethod *method = NewObjMethod((ObjExpr*)NewObjExpr(NULL), NULL);
+	method->locals = (IMap*) EmptyHashMap;
+	method->indexLocals = (IMap*) EmptyHashMap;
+	const PathNode *pnode = NewPathNode(PATH, NULL);
+	const lisp_object *mapArgs[] = {
+		(lisp_object*)METHOD, (lisp_object*)method,
+		(lisp_object*)LOCAL_ENV, NULL,
+		(lisp_object*)NEXT_LOCAL_NUM, (lisp_object*)NewInteger(1),
+		(lisp_object*)CLEAR_PATH, (lisp_object*)pnode,
+		(lisp_object*)CLEAR_ROOT, (lisp_object*)pnode,
+		(lisp_object*)CLEAR_SITES, (lisp_object*)EmptyHashMap,
+	};
+	size_t mapArgc = sizeof(mapArgs)/sizeof(mapArgs[0]);
+	LetExpr *ret = NULL;
+	TRY
+		pushThreadBindings(CreateArrayMap(mapArgc, mapArgs));
+		ret = (LetExpr*) analyzeLet(context, form, method);
+	FINALLY
+		popThreadBindings();
+	ENDTRY
+	ret->frameSize = method->maxLocal + 1;
+	return (Expr*)ret;
+}
+
 // FnExpr
 typedef struct {	// FnExpr
 	OBJEXPR_DEF	
 
 	const FnMethod *variadicMethod;
 	const ICollection *methods;
+	const FnMethod *methodArray[MAX_POSITIONAL_ARITY + 1];	// Indexed by the number of required params.
 	bool hasPrimSigs;
 	bool hasMeta;
 	bool hasEnclosingMethod;
 } FnExpr;
 
+// Fn
+// A fn that the JIT could not compile.  Each call evaluates the matching method over a fresh slot frame.
+typedef struct {	// Fn
+	lisp_object obj;
+	const FnExpr *fn;
+} Fn;
+
+static const FnMethod* methodForArity(const Fn *f, size_t argc) {
+	const FnExpr *fn = f->fn;
+	if(argc <= MAX_POSITIONAL_ARITY && fn->methodArray[argc])
+		return fn->methodArray[argc];
+	if(fn->variadicMethod && argc >= count((lisp_object*)fn->variadicMethod->reqParms))
+		return fn->variadicMethod;
+	NewArityError(argc, fn->name ? fn->name : "fn");
+	__builtin_unreachable();
+}
+
+// Returns &TailCallMarker if the body ends in a call in tail position.
+static const lisp_object* runMethod(const Fn *f, const FnMethod *m, size_t argc, const lisp_object *const *argv) {
+	const lisp_object **outerSlots = LocalSlots;
+	const lisp_object *frame[m->maxLocal + 1];
+	const lisp_object *ret = NULL;
+	TRY
+		memset(frame, '\0', sizeof(frame));
+		LocalSlots = frame;
+		if(!f->fn->canBeDirect)
+			frame[0] = (lisp_object*)f;
+		const size_t req = count((lisp_object*)m->reqParms);
+		for(size_t i = 0; i < req; i++) {
+			const LocalBinding *lb = (LocalBinding*) m->reqParms->obj.fns->IVectorFns->nth(m->reqParms, i, NULL);
+			frame[lb->index] = argv[i];
+		}
+		if(m->restParm && argc > req)
+			frame[m->restParm->index] = (lisp_object*)CreateList(argc - req, argv + req);
+		do {
+			ret = m->code ? RunCode(m->code, frame) : m->body->Eval(m->body);
+		} while(ret == &RecurMarker);
+	FINALLY
+		LocalSlots = outerSlots;
+	ENDTRY
+	return ret;
+}
+
+// Tail calls to other Fns reuse this loop rather than nesting a call, which is what keeps the stack flat for mutual
+// recursion.  Any other IFn is called normally, since it cannot return a tail call.
+static const lisp_object* invokeFn(const Fn *f, size_t argc, const lisp_object *const *argv) {
+	const lisp_object *ret = runMethod(f, methodForArity(f, argc), argc, argv);
+	while(ret == &TailCallMarker) {
+		const TailCall call = PendingTailCall;
+		if(((lisp_object*)call.f)->type == FN_type) {
+			f = (Fn*)call.f;
+			ret = runMethod(f, methodForArity(f, call.argc), call.argc, call.argv);
+		} else {
+			ret = invokeArgs(((lisp_object*)call.f)->fns->IFnFns, call.f, call.argc, call.argv);
+		}
+	}
+	return ret;
+}
+
+static const lisp_object* invoke0Fn(const IFn *self) {
+	return invokeFn((Fn*)self, 0, NULL);
+}
+
+static const lisp_object* invoke1Fn(const IFn *self, const lisp_object *arg1) {
+	const lisp_object *argv[] = {arg1};
+	return invokeFn((Fn*)self, 1, argv);
+}
+
+static const lisp_object* invoke2Fn(const IFn *self, const lisp_object *arg1, const lisp_object *arg2) {
+	const lisp_object *argv[] = {arg1, arg2};
+	return invokeFn((Fn*)self, 2, argv);
+}
+
+static const lisp_object* invoke3Fn(const IFn *self, const lisp_object *arg1, const lisp_object *arg2, const lisp_object *arg3) {
+	const lisp_object *argv[] = {arg1, arg2, arg3};
+	return invokeFn((Fn*)self, 3, argv);
+}
+
+static const lisp_object* invoke4Fn(const IFn *self, const lisp_object *arg1, const lisp_object *arg2, const lisp_object *arg3,
+		const lisp_object *arg4) {
+	const lisp_object *argv[] = {arg1, arg2, arg3, arg4};
+	return invokeFn((Fn*)self, 4, argv);
+}
+
+static const lisp_object* invoke5Fn(const IFn *self, const lisp_object *arg1, const lisp_object *arg2, const lisp_object *arg3,
+		const lisp_object *arg4, const lisp_object *arg5) {
+	const lisp_object *argv[] = {arg1, arg2, arg3, arg4, arg5};
+	return invokeFn((Fn*)self, 5, argv);
+}
+
+static const lisp_object* applyToFn(const IFn *self, const ISeq *args) {
+	const size_t argc = count((lisp_object*)args);
+	const lisp_object **argv = GC_MALLOC((argc ? argc : 1) * sizeof(*argv));
+	for(size_t i = 0; i < argc; i++, args = args->obj.fns->ISeqFns->next(args))
+		argv[i] = args->obj.fns->ISeqFns->first(args);
+	return invokeFn((Fn*)self, argc, argv);
+}
+
+static const char* toStringFn(const lisp_object *obj) {
+	assert(obj->type == FN_type);
+	const char *name = ((Fn*)obj)->fn->name;
+	return name ? name : "fn";
+}
+
+const IFn_vtable Fn_IFn_vtable = {
+	invoke0Fn,	// invoke0
+	invoke1Fn,	// invoke1
+	invoke2Fn,	// invoke2
+	invoke3Fn,	// invoke3
+	invoke4Fn,	// invoke4
+	invoke5Fn,	// invoke5
+	applyToFn,	// applyTo
+};
+
+interfaces Fn_interfaces = {
+	NULL,			// SeqableFns
+	NULL,			// ReversibleFns
+	NULL,			// ICollectionFns
+	NULL,			// IStackFns
+	NULL,			// ISeqFns
+	&Fn_IFn_vtable,	// IFnFns
+	NULL,			// IVectorFns
+	NULL,			// IMapFns
+	NULL,			// ISetFns
+	toStringFn,		// toString
+	EqualBase,		// Equals
+	NULL,			// HashEq
+};
+
+static const lisp_object* EvalFn(const Expr *self) {
+	assert(self->type == FNEXPR_type);
+	const FnExpr *fn = (FnExpr*)self;
+	if(fn->compiledFn) {
+		if(isCompiledFnCurrent((ObjExpr*)fn))
+			return (lisp_object*)fn->compiledFn;
+		// A fn made from here on has to see the new roots, so it is left to the interpreter.
+		((FnExpr*)fn)->compiledFn = NULL;
+	}
+	if(count((lisp_object*)fn->closes) > 0) {
+		exception e = {UnsupportedOperationException, "Can't eval fn that closes over locals."};
+		Raise(e);
+	}
+	Fn *ret = GC_MALLOC(sizeof(*ret));
+	ret->obj.type = FN_type;
+	ret->obj.size = sizeof(*ret);
+	ret->obj.fns = &Fn_interfaces;
+	ret->fn = fn;
+	return (lisp_object*)ret;
+}
+
 static Expr* NewFnExpr(const lisp_object *tag) {
 	FnExpr *ret = (FnExpr*)NewObjExpr(tag);
 	ret = GC_realloc(ret, sizeof(*ret));
 	ret->type = FNEXPR_type;
+	ret->Eval = EvalFn;
 
 	ret->variadicMethod = NULL;
 	return (Expr*) ret;
@@ -1510,7 +1928,7 @@ static const Expr* parseFnExpr(Expr_Context context, const ISeq *form, const cha
 
 	const Symbol *nm = NULL;
 	sw = NewStringWriter();
-	if(second((lisp_object*)form)->type == SYMBOL_type) {
+	if(objectType(second((lisp_object*)form)) == SYMBOL_type) {
 		nm = (Symbol*)second((lisp_object*)form);
 		AddString(sw, getNameSymbol(nm));
 	} else if(name) {
@@ -1541,7 +1959,7 @@ static const Expr* parseFnExpr(Expr_Context context, const ISeq *form, const cha
 			(lisp_object*)NO_RECUR, NULL,
 		};
 		size_t mapArgc = sizeof(mapArgs)/sizeof(mapArgs[0]);
-		pushThreadBindings((IMap*)CreateHashMap(mapArgc, mapArgs));
+		pushThreadBindings(CreateArrayMap(mapArgc, mapArgs));
 
 		if(nm) {
 			fn->thisName = getNameSymbol(nm);
@@ -1553,7 +1971,7 @@ static const Expr* parseFnExpr(Expr_Context context, const ISeq *form, const cha
 		fn->line = lineDeref();
 		fn->column = columnDeref();
 		const FnMethod *methodArray[MAX_POSITIONAL_ARITY + 1];
-		memset(&methodArray, sizeof(methodArray), '\0');
+		memset(&methodArray, '\0', sizeof(methodArray));
 		const FnMethod *VariadicMethod = NULL;
 		bool useThis = false;
 
@@ -1613,7 +2031,16 @@ static const Expr* parseFnExpr(Expr_Context context, const ISeq *form, const cha
 			}
 		}
 
+		// Each method body is lowered once here, after its arg slots are final, and every call runs the same Code.
+		if(boolCast(deref(USE_BYTECODE))) {
+			for(const ISeq *s = methods->obj.fns->SeqableFns->seq((Seqable*)methods); s != NULL; s = s->obj.fns->ISeqFns->next(s)) {
+				FnMethod *fm = (FnMethod*)s->obj.fns->ISeqFns->first(s);
+				fm->code = compileBytecodeBody(fm->body, 0);
+			}
+		}
+
 		fn->methods = methods;
+		memcpy(fn->methodArray, methodArray, sizeof(methodArray));
 		fn->variadicMethod = VariadicMethod;
 		fn->keywords = (IMap*) deref(KEYWORDS);
 		fn->vars = (IMap*) deref(VARS);
@@ -1697,15 +2124,15 @@ static const Expr* parseIfExpr(Expr_Context context, const lisp_object *frm) {
 	};
 	size_t margc = sizeof(margs) / sizeof(margs[0]);
 	TRY
-		pushThreadBindings((IMap*)CreateHashMap(margc, margs));
+		pushThreadBindings(CreateArrayMap(margc, margs));
 		thenExpr = Analyze(context, third(frm), NULL);
 	FINALLY
 		popThreadBindings();
 	ENDTRY
 
 	TRY
-		pushThreadBindings((IMap*)CreateHashMap(margc, margs));
-		thenExpr = Analyze(context, third(frm), NULL);
+		pushThreadBindings(CreateArrayMap(margc, margs));
+		elseExpr = Analyze(context, fourth(frm), NULL);
 	FINALLY
 		popThreadBindings();
 	ENDTRY
@@ -1725,9 +2152,19 @@ typedef struct {	// RecurExpr
 
 static const lisp_object* EvalRecur(const Expr *self) {
 	assert(self->type == RECUREXPR_type);
-	exception e = {UnsupportedOperationException, "Can't eval recur"};
-	Raise(e);
-	__builtin_unreachable();
+	const RecurExpr *r = (RecurExpr*)self;
+	const size_t n = r->args->obj.fns->ICollectionFns->count((ICollection*)r->args);
+	// All arguments are evaluated before any slot is rebound, since they may refer to the loop locals.
+	const lisp_object *vals[n ? n : 1];
+	for(size_t i = 0; i < n; i++) {
+		const Expr *arg = (Expr*) r->args->obj.fns->IVectorFns->nth(r->args, i, NULL);
+		vals[i] = arg->Eval(arg);
+	}
+	for(size_t i = 0; i < n; i++) {
+		const LocalBinding *lb = (LocalBinding*) r->loopLocals->obj.fns->IVectorFns->nth(r->loopLocals, i, NULL);
+		LocalSlots[lb->index] = vals[i];
+	}
+	return &RecurMarker;
 }
 
 static Expr* NewRecurExpr(const IVector *loopLocals, const IVector *args, size_t line, size_t column, const char *source) {
@@ -1777,9 +2214,9 @@ static const Expr* parseRecurExpr(Expr_Context context, const lisp_object *frm)
 		if(primc) {
 			bool mismatch = false;
 			const object_type *pc = maybePrimitiveType((Expr*)args->obj.fns->IVectorFns->nth(args, i, NULL));
-			if(*primc == INTEGER_type && *pc != INTEGER_type)
+			if(*primc == INTEGER_type && (pc == NULL || *pc != INTEGER_type))
 				mismatch = true;
-			else if(*primc == FLOAT_type && *pc != FLOAT_type)
+			else if(*primc == FLOAT_type && (pc == NULL || *pc != FLOAT_type))
 				mismatch = true;
 			if(mismatch) {
 				lb->recurMismatch = true;
@@ -1876,6 +2313,252 @@ static const Expr* parseHostExpr(Expr_Context context, const lisp_object *frm) {
 	size_t column = columnDeref();
 }
 
+// Bytecode
+// Lowers an analyzed Expr tree to the register bytecode run by Bytecode.c.  Locals keep their slot indices, so any
+// Expr without an opcode of its own can still be handed back to the tree walker through OP_EVAL.
+typedef struct {	// BytecodeBuilder
+	instruction *code;
+	size_t count;
+	size_t capacity;
+	const lisp_object **exprs;
+	size_t exprCount;
+	size_t nextRegister;
+	size_t registerCount;
+	size_t localCount;
+} BytecodeBuilder;
+
+#define NO_LOOP SIZE_MAX
+
+static void compileBytecodeExpr(BytecodeBuilder *bb, const Expr *e, size_t dst, size_t loopStart);
+
+static size_t emit(BytecodeBuilder *bb, opcode op, size_t a, int32_t b, size_t c) {
+	if(bb->count == bb->capacity) {
+		bb->capacity = bb->capacity ? 2 * bb->capacity : 16;
+		bb->code = GC_REALLOC(bb->code, bb->capacity * sizeof(*bb->code));
+	}
+	instruction i = {op, c, a, b};
+	bb->code[bb->count] = i;
+	return bb->count++;
+}
+
+static void patchJump(BytecodeBuilder *bb, size_t at) {
+	bb->code[at].b = bb->count - at;
+}
+
+static size_t allocRegisters(BytecodeBuilder *bb, size_t n) {
+	size_t ret = bb->nextRegister;
+	bb->nextRegister += n;
+	if(bb->nextRegister > UINT16_MAX) {
+		exception e = {RuntimeException, "Expression needs too many registers"};
+		Raise(e);
+	}
+	if(bb->nextRegister > bb->registerCount)
+		bb->registerCount = bb->nextRegister;
+	return ret;
+}
+
+static int32_t bytecodeConstant(const lisp_object *x) {
+	int id = registerConstant(x);
+	if(id < 0) {
+		exception e = {IllegalStateException, "CONSTANTS is not bound"};
+		Raise(e);
+	}
+	return id;
+}
+
+static int32_t bytecodeVar(const Var *v) {
+	const lisp_object *id = get(deref(VARS), (lisp_object*)v, NULL);
+	if(id) {
+		assert(objectType(id) == INTEGER_type);
+		return IntegerValue((Integer*)id);
+	}
+	return bytecodeConstant((lisp_object*)v);
+}
+
+static const lisp_object* evalExprFallback(const lisp_object *x) {
+	const Expr *e = (Expr*)x;
+	return e->Eval(e);
+}
+
+// OP_TAILCALL leaves the call to the Fn running this Code, exactly as EvalInvoke does in tail position.
+static const lisp_object* pendTailCall(const IFn *f, size_t argc, const lisp_object *const *argv) {
+	assert(argc <= MAX_POSITIONAL_ARITY);
+	TailCall call = {f, argc, {NULL}};
+	memcpy(call.argv, argv, argc * sizeof(*argv));
+	PendingTailCall = call;
+	return &TailCallMarker;
+}
+
+static const Expr* nthExpr(const IVector *v, size_t i) {
+	return (Expr*) v->obj.fns->IVectorFns->nth(v, i, NULL);
+}
+
+static size_t countExprs(const IVector *v) {
+	return v->obj.fns->ICollectionFns->count((ICollection*)v);
+}
+
+static void compileBytecodeInvoke(BytecodeBuilder *bb, const Expr *fexpr, const IVector *args, size_t dst, bool tailPosition) {
+	size_t argc = countExprs(args);
+	if(argc > UINT8_MAX) {
+		exception e = {RuntimeException, "Too many arguments to compile to bytecode"};
+		Raise(e);
+	}
+	size_t base = allocRegisters(bb, argc + 1);
+	compileBytecodeExpr(bb, fexpr, base, NO_LOOP);
+	for(size_t i = 0; i < argc; i++)
+		compileBytecodeExpr(bb, nthExpr(args, i), base + 1 + i, NO_LOOP);
+	if(tailPosition && argc <= MAX_POSITIONAL_ARITY) {
+		emit(bb, OP_TAILCALL, base, 0, argc);
+	} else {
+		emit(bb, OP_CALL, base, 0, argc);
+		if(dst != base)
+			emit(bb, OP_MOVE, dst, base, 0);
+	}
+	bb->nextRegister = base;
+}
+
+static void compileBytecodeExpr(BytecodeBuilder *bb, const Expr *e, size_t dst, size_t loopStart) {
+	switch(e->type) {
+		case NILEXPR_type:
+			emit(bb, OP_LOADNIL, dst, 0, 0);
+			return;
+		case NUMBEREXPR_type: {
+			const NumberExpr *n = (NumberExpr*)e;
+			emit(bb, OP_LOADK, dst, n->id >= 0 ? n->id : bytecodeConstant((lisp_object*)n->n), 0);
+			return;
+		}
+		case BOOLEXPR_type:
+		case CONSTANTEXPR_type:
+		case STRINGEXPR_type:
+		case EMPTYEXPR_type:
+		case KEYWORDEXPR_type:
+			emit(bb, OP_LOADK, dst, bytecodeConstant(e->Eval(e)), 0);
+			return;
+		case VAREXPR_type:
+			emit(bb, OP_GETVAR, dst, bytecodeVar(((VarExpr*)e)->v), 0);
+			return;
+		case LOCALBINDINGEXPR_type:
+			emit(bb, OP_GETLOCAL, dst, ((LocalBindingExpr*)e)->b->index, 0);
+			return;
+		case BODYEXPR_type: {
+			const IVector *exprs = ((BodyExpr*)e)->exprs;
+			size_t n = countExprs(exprs);
+			for(size_t i = 0; i < n; i++)
+				compileBytecodeExpr(bb, nthExpr(exprs, i), dst, i + 1 == n ? loopStart : NO_LOOP);
+			return;
+		}
+		case IFEXPR_type: {
+			const IfExpr *i = (IfExpr*)e;
+			compileBytecodeExpr(bb, i->testExpr, dst, NO_LOOP);
+			size_t toElse = emit(bb, OP_JMPF, dst, 0, 0);
+			compileBytecodeExpr(bb, i->thenExpr, dst, loopStart);
+			size_t toEnd = emit(bb, OP_JMP, 0, 0, 0);
+			patchJump(bb, toElse);
+			compileBytecodeExpr(bb, i->elseExpr, dst, loopStart);
+			patchJump(bb, toEnd);
+			return;
+		}
+		case LETEXPR_type: {
+			const LetExpr *l = (LetExpr*)e;
+			if(l->frameSize > bb->localCount)
+				bb->localCount = l->frameSize;
+			size_t n = countExprs(l->bindingInits);
+			for(size_t i = 0; i < n; i++) {
+				const BindingInit *bi = (BindingInit*) l->bindingInits->obj.fns->IVectorFns->nth(l->bindingInits, i, NULL);
+				compileBytecodeExpr(bb, bi->Init, dst, NO_LOOP);
+				emit(bb, OP_SETLOCAL, dst, bi->binding->index, 0);
+			}
+			compileBytecodeExpr(bb, l->body, dst, l->isLoop ? bb->count : loopStart);
+			return;
+		}
+		case RECUREXPR_type: {
+			const RecurExpr *r = (RecurExpr*)e;
+			if(loopStart == NO_LOOP) {
+				exception e = {UnsupportedOperationException, "Can only recur from tail position"};
+				Raise(e);
+			}
+			size_t n = countExprs(r->args);
+			size_t base = allocRegisters(bb, n);
+			for(size_t i = 0; i < n; i++)
+				compileBytecodeExpr(bb, nthExpr(r->args, i), base + i, NO_LOOP);
+			for(size_t i = 0; i < n; i++) {
+				const LocalBinding *lb = (LocalBinding*) r->loopLocals->obj.fns->IVectorFns->nth(r->loopLocals, i, NULL);
+				emit(bb, OP_SETLOCAL, base + i, lb->index, 0);
+			}
+			bb->nextRegister = base;
+			size_t jump = emit(bb, OP_JMP, 0, 0, 0);
+			bb->code[jump].b = (int32_t)loopStart - (int32_t)jump;
+			return;
+		}
+		case INVOKEEXPR_type: {
+			const InvokeExpr *Invk = (InvokeExpr*)e;
+			compileBytecodeInvoke(bb, Invk->fexpr, Invk->args, dst, Invk->tailPosition);
+			return;
+		}
+		case KWINVOKEEXPR_type: {
+			const KeywordInvokeExpr *KWI = (KeywordInvokeExpr*)e;
+			const IVector *args = (IVector*) EmptyVector;
+			args = args->obj.fns->IVectorFns->cons(args, (lisp_object*)KWI->target);
+			compileBytecodeInvoke(bb, (Expr*)KWI->kw, args, dst, false);
+			return;
+		}
+		default:
+			bb->exprs = GC_REALLOC(bb->exprs, (bb->exprCount + 1) * sizeof(*bb->exprs));
+			bb->exprs[bb->exprCount] = (lisp_object*)e;
+			emit(bb, OP_EVAL, dst, bb->exprCount++, 0);
+			return;
+	}
+}
+
+// Lowers x with CONSTANTS bound, and snapshots the constants it refers to.  Recur with no enclosing loop jumps to
+// loopStart, which is the start of the Code for a method body.
+static const Code* compileBytecodeBody(const Expr *x, size_t loopStart) {
+	BytecodeBuilder bb = {NULL, 0, 0, NULL, 0, 0, 0, 0};
+	size_t dst = allocRegisters(&bb, 1);
+	compileBytecodeExpr(&bb, x, dst, loopStart);
+	emit(&bb, OP_RET, dst, 0, 0);
+
+	const IVector *constants = (IVector*) deref(CONSTANTS);
+	size_t constantCount = countExprs(constants);
+	const lisp_object **pool = GC_MALLOC(constantCount * sizeof(*pool));
+	for(size_t i = 0; i < constantCount; i++)
+		pool[i] = constants->obj.fns->IVectorFns->nth(constants, i, NULL);
+	return NewCode(bb.count, bb.code, constantCount, pool, bb.exprCount, bb.exprs, evalExprFallback, pendTailCall,
+			bb.registerCount, bb.localCount);
+}
+
+static const Code* CompileBytecode(const lisp_object *form) {
+	const Code *ret = NULL;
+	const lisp_object *mapArgs[] = {
+		(lisp_object*)CONSTANTS, (lisp_object*)EmptyVector,
+		(lisp_object*)CONSTANT_IDS, (lisp_object*)EmptyHashMap,
+		(lisp_object*)KEYWORDS, (lisp_object*)EmptyHashMap,
+		(lisp_object*)VARS, (lisp_object*)EmptyHashMap,
+	};
+	size_t mapArgc = sizeof(mapArgs)/sizeof(mapArgs[0]);
+	TRY
+		pushThreadBindings(CreateArrayMap(mapArgc, mapArgs));
+		ret = compileBytecodeBody(Analyze(EVAL, form, NULL), NO_LOOP);
+	FINALLY
+		popThreadBindings();
+	ENDTRY
+	return ret;
+}
+
+static const lisp_object* EvalBytecode(const Code *c) {
+	const lisp_object **outerSlots = LocalSlots;
+	const lisp_object *frame[c->localCount ? c->localCount : 1];
+	const lisp_object *ret = NULL;
+	TRY
+		memset(frame, '\0', sizeof(frame));
+		LocalSlots = frame;
+		ret = RunCode(c, frame);
+	FINALLY
+		LocalSlots = outerSlots;
+	ENDTRY
+	return ret;
+}
+
 // IParser
 typedef const Expr* (*IParser)(Expr_Context context, const lisp_object *form);
 typedef struct {	// Special
@@ -1913,11 +2596,11 @@ IParser isSpecial(const lisp_object *sym) {
 	if(sym == NULL)
 		return NULL;
 	printf("sym is not NULL.\n");
-	printf("sym->type = %s\n", object_type_string[sym->type]);
+	printf("sym->type = %s\n", object_type_string[objectType(sym)]);
 	fflush(stdout);
-	if(sym->type != SYMBOL_type)
+	if(objectType(sym) != SYMBOL_type)
 		return NULL;
-	bool (*Equals)(const struct lisp_object_struct *x, const struct lisp_object_struct *y) = ((lisp_object*)sym)->Equals;
+	bool (*Equals)(const struct lisp_object_struct *x, const struct lisp_object_struct *y) = ((lisp_object*)sym)->fns->Equals;
 	for(size_t i =0; i<special_count; i++) {
 		if(Equals((lisp_object*)sym, (lisp_object*)specials[i].sym)) {
 			return specials[i].parse;
@@ -1941,17 +2624,16 @@ static int registerConstant(const lisp_object *obj) {
 	if(!isBound(CONSTANTS))
 		return -1;
 	const IMap *ids = (IMap*) deref(CONSTANT_IDS);
-	const MapEntry *me = ids->obj.fns->IMapFns->entryAt(ids, obj);
-	const lisp_object *o = me ? me->val : NULL;
+	const lisp_object *o = ids->obj.fns->IMapFns->valAt(ids, obj, NULL);
 	if(o) {
-		assert(o->type == INTEGER_type);
+		assert(objectType(o) == INTEGER_type);
 		return IntegerValue((Integer*)o);
 	}
 
 	const IVector *v = (IVector*) deref(CONSTANTS);
-	setVar(CONSTANTS, (lisp_object*)v->obj.fns->IVectorFns->cons(v, o));
+	setVar(CONSTANTS, (lisp_object*)v->obj.fns->IVectorFns->cons(v, obj));
 	int i = v->obj.fns->ICollectionFns->count((ICollection*)v);
-	setVar(CONSTANT_IDS, (lisp_object*)ids->obj.fns->IMapFns->assoc(ids, o, (lisp_object*)NewInteger(i)));
+	setVar(CONSTANT_IDS, (lisp_object*)ids->obj.fns->IMapFns->assoc(ids, obj, (lisp_object*)NewInteger(i)));
 	return i;
 }
 
@@ -1959,8 +2641,7 @@ static const Expr* registerKeyword(const Keyword *kw) {
 	if(!isBound(KEYWORDS))
 		return NewKeywordExpr(kw);
 	const IMap *keywordsMap = (IMap*) deref(KEYWORDS);
-	const MapEntry *me = keywordsMap->obj.fns->IMapFns->entryAt(keywordsMap, (lisp_object*)kw);
-	const lisp_object *id = me ? me->val : NULL;
+	const lisp_object *id = keywordsMap->obj.fns->IMapFns->valAt(keywordsMap, (lisp_object*)kw, NULL);
 	if(id == NULL) {
 		setVar(KEYWORDS, (lisp_object*)keywordsMap->obj.fns->IMapFns->assoc(keywordsMap, (lisp_object*)kw, (lisp_object*)NewInteger(registerConstant((lisp_object*)kw))));
 	}
@@ -1983,11 +2664,11 @@ __attribute__((unused)) static bool namesStaticMember(const Symbol *sym) {
 }
 
 static void registerVar(const Var *v) {
-	if(!isBound(v))
+	if(!isBound(VARS))
 		return;
 	IMap *varsMap = (IMap*) deref(VARS);
 	const lisp_object *id = get((lisp_object*)varsMap, (lisp_object*)v, NULL);
-	if(id) {
+	if(id == NULL) {
 		setVar(VARS, (lisp_object*)varsMap->obj.fns->IMapFns->assoc(varsMap, (lisp_object*)v, (lisp_object*)NewInteger(registerConstant((lisp_object*)v))));
 	}
 }
@@ -2009,10 +2690,10 @@ static Var* LookupVar(const Symbol *sym, bool InternNew, bool RegisterMacro) {
 			ret = findInternedVar(ns, name);
 		}
 	}
-	else if(((lisp_object*)sym)->Equals((lisp_object*)sym, (lisp_object*)nsSymbol)) {
+	else if(((lisp_object*)sym)->fns->Equals((lisp_object*)sym, (lisp_object*)nsSymbol)) {
 		ret = NS_Var;
 	}
-	else if(((lisp_object*)sym)->Equals((lisp_object*)sym, (lisp_object*)inNamespaceSymbol)) {
+	else if(((lisp_object*)sym)->fns->Equals((lisp_object*)sym, (lisp_object*)inNamespaceSymbol)) {
 		ret = IN_NS_Var;
 	}
 	else {
@@ -2020,7 +2701,7 @@ static Var* LookupVar(const Symbol *sym, bool InternNew, bool RegisterMacro) {
 		if(o == NULL) {
 			if(InternNew)
 				ret = internNS(CurrentNS(), internSymbol1(getNameSymbol(sym)));
-		}else if(o->type == VAR_type) {
+		}else if(objectType(o) == VAR_type) {
 			ret = (Var*)o;
 		} else {
 			exception e = {RuntimeException, WriteString(AddString(AddString(AddString(AddString(NewStringWriter(), "Expecting var, but "),
@@ -2039,7 +2720,7 @@ static Var* isMacro(const lisp_object *obj) {
 	printf("obj = %s\n", toString(obj));
 	fflush(stdout);
 	Var *ret = NULL;
-	switch(obj->type) {
+	switch(objectType(obj)) {
 		case SYMBOL_type:
 			printf("obj is a symbol.\n");
 			fflush(stdout);
@@ -2069,7 +2750,7 @@ static const lisp_object* macroExpand1(const lisp_object *x) {
 	printf("In macroExpand1.\n");
 	printf("x = %p\n", (void*)x);
 	if(x)
-		printf("x = %s\n", object_type_string[x->type]);
+		printf("x = %s\n", object_type_string[objectType(x)]);
 	printf("x = %s\n", toString(x));
 	fflush(stdout);
 	if(!isISeq(x))
@@ -2125,10 +2806,10 @@ static const Expr* AnalyzeSeq(Expr_Context context, const ISeq *form, const char
 	// IFn *inlined = isInline(op, next->obj.fns->ICollectionFns->count((ICollection*)next));	// TODO isInline
 	// if(inlined != NULL)
 	// 	return Analyze(context, preserveTag(form, inlined->obj.fns->IFnFns->applyTo(inlined, next)), name);	// TODO preserveTag
-	if(((lisp_object*)FNSymbol)->Equals((lisp_object*)FNSymbol, op)) {
+	if(((lisp_object*)FNSymbol)->fns->Equals((lisp_object*)FNSymbol, op)) {
 		return parseFnExpr(context, form, name);
 	}
-	if(op->type == SYMBOL_type ) {
+	if(objectType(op) == SYMBOL_type ) {
 		IParser p = isSpecial(op);
 		if(p) return p(context, (lisp_object*)form);
 	}
@@ -2176,7 +2857,7 @@ static const Expr* analyzeSymbol(const Symbol *sym) {
 	if(o)
 		printf("o = %s\n", toString(o));
 	fflush(stdout);
-	switch(o->type) {
+	switch(objectType(o)) {
 		case VAR_type: {
 			const Var *v = (Var*)o;
 			if(isMacro((lisp_object*)v)) {
@@ -2212,16 +2893,16 @@ static const Expr* Analyze(Expr_Context context, const lisp_object *form, const
 	if(form == (void*)False) {
 		return FalseExpr;
 	}
-	if(form->type == SYMBOL_type) {
-		analyzeSymbol((Symbol*) form);
+	if(objectType(form) == SYMBOL_type) {
+		return analyzeSymbol((Symbol*) form);
 	}
-	if(form->type == KEYWORD_type) {
+	if(objectType(form) == KEYWORD_type) {
 		return registerKeyword((Keyword*)form);
 	}
 	if(isNumber(form)) {
 		return parseNumber((Number*)form);
 	}
-	if(form->type == STRING_type) {
+	if(objectType(form) == STRING_type) {
 		return NewStringExpr((String*)form);
 	}
 	if(isICollection(form) /* && not IRecord && not IType */ && form->fns->ICollectionFns->count((ICollection*)form) == 0) {
@@ -2242,7 +2923,9 @@ static const Expr* Analyze(Expr_Context context, const lisp_object *form, const
 	if(isIMap(form)) {
 		return parseMapExpr(context, (IMap*)form);
 	}
-	// TODO ISet
+	if(isISet(form)) {
+		return parseSetExpr(context, (ISet*)form);
+	}
 	return NewConstantExpr(form);
 }
 
@@ -2252,10 +2935,10 @@ static bool IsLiteralExpr(const Expr *e) {
 }
 
 static const Symbol* tagOf(const lisp_object *o) {
-	const lisp_object *tag = get((lisp_object*)o->meta, (lisp_object*)tagKW, NULL);
+	const lisp_object *tag = get((lisp_object*)objectMeta(o), (lisp_object*)tagKW, NULL);
 
 	if(tag) {
-		switch(tag->type) {
+		switch(objectType(tag)) {
 			case SYMBOL_type:
 				return (Symbol*) tag;
 			case STRING_type:
@@ -2295,7 +2978,7 @@ static object_type tagType(const lisp_object *tag) {
 	if(tag == NULL)
 		return LISPOBJECT_type;
 	object_type c = ERROR_type;
-	if(tag->type == SYMBOL_type)
+	if(objectType(tag) == SYMBOL_type)
 		c = primClass((Symbol*)tag);
 	if(c == ERROR_type)
 	 	c = tagToClass(tag);
@@ -2304,7 +2987,7 @@ static object_type tagType(const lisp_object *tag) {
 
 static object_type tagToClass(const lisp_object *tag) {
 	object_type c = ERROR_type;
-	if(tag->type == SYMBOL_type) {
+	if(objectType(tag) == SYMBOL_type) {
 		const Symbol *sym = (Symbol*)tag;
 		if(getNamespaceSymbol(sym))
 			c = maybeSpecialTag(sym);
@@ -2320,7 +3003,7 @@ static object_type tagToClass(const lisp_object *tag) {
 
 static object_type maybeClass(const lisp_object *form, bool stringOK) {
 	object_type c = ERROR_type;
-	if(form->type == SYMBOL_type) {
+	if(objectType(form) == SYMBOL_type) {
 		const Symbol *sym = (Symbol*)form;
 		if(getNamespaceSymbol(sym) == NULL) {
 			if(Equals((lisp_object*)sym, getVar(COMPILE_STUB_SYM)))
@@ -2330,10 +3013,10 @@ static object_type maybeClass(const lisp_object *form, bool stringOK) {
 				// c = classForName(name);	// TODO
 			} else {
 				const lisp_object *o = getMapping(CurrentNS(), sym);
-				if(o->type == INTEGER_type)
+				if(objectType(o) == INTEGER_type)
 					return IntegerValue((Integer*)o);
 				const IMap *localEnv = (IMap*)deref(LOCAL_ENV);
-				if(localEnv && localEnv->obj.fns->IMapFns->entryAt(localEnv, form)) {
+				if(localEnv && localEnv->obj.fns->IMapFns->containsKey(localEnv, form)) {
 					return ERROR_type;
 				}
 				TRY
@@ -2343,7 +3026,7 @@ static object_type maybeClass(const lisp_object *form, bool stringOK) {
 			}
 		}
 	}
-	else if(stringOK && form->type == STRING_type) {
+	else if(stringOK && objectType(form) == STRING_type) {
 		// c = classForName((String*)form);	// TODO
 	}
 	return c;
@@ -2420,7 +3103,7 @@ static const lisp_object* resolveIn(Namespace *n, const Symbol *sym, bool allowP
 
 void initCompiler(void) {
 	const lisp_object *mapArgs[] = {(lisp_object*)internKeyword2(NULL, "once"), (lisp_object*)True};
-	FnOnceSymbol = (Symbol*)withMeta((lisp_object*)FnOnceSymbol, (IMap*)CreateHashMap(2, mapArgs));
+	FnOnceSymbol = (Symbol*)withMeta((lisp_object*)FnOnceSymbol, CreateArrayMap(2, mapArgs));
 
 	Namespace *lispNS = findOrCreateNS(internSymbol1("lisp.core"));
 
@@ -2437,6 +3120,7 @@ void initCompiler(void) {
 	CONSTANT_IDS = setDynamic(createVar(NULL));
 	INSTANCE = internNS(lispNS, internSymbol1("instance?"));
 	IN_CATCH_FINALLY = setDynamic(createVar(NULL));
+	bindRoot(IN_CATCH_FINALLY, NULL);	// nil rather than unbound, since it is read outside of any catch or finally.
 	KEYWORD_CALLSITES = setDynamic(createVar(NULL));
 	KEYWORDS = setDynamic(createVar(NULL));
 	METHOD = setDynamic(createVar(NULL));
@@ -2451,6 +3135,7 @@ void initCompiler(void) {
 	PROTOCOL_CALLSITES = setDynamic(createVar(NULL));
 	SOURCE = setDynamic(internVar(lispNS, internSymbol1("*source-path*"), (lisp_object*)NewString("NO_SOURCE_FILE"), true));
 	SOURCE_PATH = setDynamic(internVar(lispNS, internSymbol1("*file*"), (lisp_object*)NewString("NO_SOURCE_PATH"), true));
+	USE_BYTECODE = setDynamic(internVar(lispNS, internSymbol1("*use-bytecode*"), (lisp_object*)False, true));
 	VARS = setDynamic(createVar(NULL));
 	VAR_CALLSITES = setDynamic(createVar(NULL));
 	WARN_ON_REFLECTION = setDynamic(internVar(lispNS, internSymbol1("*warn-on-reflection*"), (lisp_object*)False, true));
@@ -2468,7 +3153,7 @@ const lisp_object* Eval(const lisp_object *form) {
 	fflush(stdout);
 	form = macroExpand(form);
 	printf("form = %s\n", toString(form));
-	printf("form->type = %s\n", object_type_string[form->type]);
+	printf("form->type = %s\n", form ? object_type_string[objectType(form)] : "nil");
 	fflush(stdout);
 	if(isISeq(form)) {
 		const ISeq *s = (ISeq*)form;
@@ -2479,6 +3164,8 @@ const lisp_object* Eval(const lisp_object *form) {
 			return Eval(s->obj.fns->ISeqFns->first(s));
 		}
 	}
+	if(boolCast(deref(USE_BYTECODE)))
+		return EvalBytecode(CompileBytecode(form));
 	const Expr *x = Analyze(EVAL, form, NULL);
 	return x->Eval(x);
 }
@@ -2503,10 +3190,10 @@ const lisp_object* compilerLoad(LineNumberReader *reader, const char *path, cons
 		// DATA_READERS, deref(DATA_READERS),	// TODO
 	};
 	size_t mapArgc = sizeof(mapArgs)/sizeof(mapArgs[0]);
-	pushThreadBindings((IMap*)CreateHashMap(mapArgc, mapArgs));
+	pushThreadBindings(CreateArrayMap(mapArgc, mapArgs));
 	TRY
-		for(const lisp_object *r = read(reader, false, '\0'); r->type != EOF_type; r = read(reader, false, '\0')) {
-			if(r->type == ERROR_type) {
+		for(const lisp_object *r = read(reader, false, '\0'); objectType(r) != EOF_type; r = read(reader, false, '\0')) {
+			if(objectType(r) == ERROR_type) {
 				break;
 			}
 			setVar(LINE_AFTER, (lisp_object*)NewInteger(getLineNumber(reader)));
@@ -47,15 +47,17 @@ interfaces Cons_interfaces = {
 	NULL,						// IFnFns
 	NULL,						// IVectorFns
 	NULL,						// IMapFns
+	NULL,						// ISetFns
+	toString,					// toString
+	EqualsASeq,					// Equals
+	NULL,						// HashEq
 };
 
 const Cons *NewCons(const lisp_object *obj, const ISeq *s) {
-	assert(isISeq(&s->obj));
+	assert(s == NULL || isISeq(&s->obj));
 	Cons *ret = GC_MALLOC(sizeof(*ret));
 	ret->obj.type = CONS_type;
 	ret->obj.size = sizeof(Cons);
-	ret->obj.toString = toString;
-	ret->obj.Equals = EqualsASeq;
 	ret->obj.meta = NULL;	// TODO meta for Cons
 	ret->obj.fns = &Cons_interfaces;
 	ret->_first = obj;
@@ -71,6 +73,7 @@ static const lisp_object* firstCons(const ISeq *s) {
 
 static const ISeq* nextCons(const ISeq *s) {
 	assert(s->obj.type == CONS_type);
+	if(((const Cons*)s)->_more == NULL) return NULL;
 	const ISeq *s2 = s->obj.fns->ISeqFns->more(s);
 	return s2->obj.fns->SeqableFns->seq((const Seqable*)s2);
 }
@@ -85,5 +88,6 @@ static const ISeq* moreCons(const ISeq *s) {
 static size_t countCons(const ICollection *s) {
 	assert(s->obj.type == CONS_type);
 	const Cons *c = (const Cons*) s;
+	if(c->_more == NULL) return 1;
 	return 1 + c->_more->obj.fns->ICollectionFns->count((const ICollection*)c->_more);
 }
@@ -0,0 +1,15 @@
+#ifndef EDIT_TOKEN_H
+#define EDIT_TOKEN_H
+
+#include <stdbool.h>
+
+#include "lisp_pthread.h"
+
+// Marks the trie nodes a transient owns.  Each transient has a token of its own, and the nodes it creates point at it,
+// so a node carries one pointer rather than its own flag and thread.  Persistent nodes point at no token.
+typedef struct {	// EditToken
+	bool editable;			// Cleared when the transient is made persistent.
+	pthread_t thread_id;	// The thread the transient belongs to.
+} EditToken;
+
+#endif /* EDIT_TOKEN_H */
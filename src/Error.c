@@ -27,9 +27,10 @@ void Raise(exception e) {
 		}
 		if(found) break;
 	}
-	if(xb == NULL)
+	if(xb == NULL) {
 		fputs(e.msg, stderr);
 		exit(EUnhandledException);
+	}
 
 	context_block *cb;
 	for(cb = exceptionStack; cb != xb && !cb->finally; cb = cb->link);
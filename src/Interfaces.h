@@ -41,6 +41,10 @@ struct IMap_struct {
 	const lisp_object obj;
 };
 
+typedef struct {	// ISet
+	const lisp_object obj;
+} ISet;
+
 // Virtual Tables of functions for Interfaces.
 
 struct Seqable_vtable_struct {
@@ -97,9 +101,16 @@ struct IMap_vtable_struct {
 	const IMap* (*assoc)(const IMap*, const lisp_object*, const lisp_object*);
 	const IMap* (*without)(const IMap*, const lisp_object*);
 	const MapEntry* (*entryAt)(const IMap*, const lisp_object*);
+	const lisp_object* (*valAt)(const IMap*, const lisp_object*, const lisp_object*);	// Returns the last argument when key is absent.
 	const IMap* (*cons)(const IMap*, const lisp_object*);
 };
 
+struct ISet_vtable_struct {
+	const ISet* (*disjoin)(const ISet*, const lisp_object*);
+	bool (*contains)(const ISet*, const lisp_object*);
+	const lisp_object* (*get)(const ISet*, const lisp_object*);		// Returns the set's own copy of key, or NULL.
+};
+
 // Instance functions.
 // These functions are designed to check if a lisp_object satisfies an iterface.
 // They are here so that they can be inlined by the compiler.
@@ -108,19 +119,19 @@ struct IMap_vtable_struct {
 static inline bool isSeqable(const lisp_object *obj) {
 	if(obj == NULL)
 		return false;
-	return (bool)obj->fns->SeqableFns;
+	return (bool)objectFns(obj)->SeqableFns;
 }
 
 static inline bool isReversible(const lisp_object *obj) {
 	if(obj == NULL)
 		return false;
-	return (bool)obj->fns->ReversibleFns;
+	return (bool)objectFns(obj)->ReversibleFns;
 }
 
 static inline bool isICollection(const lisp_object *obj) {
 	if(obj == NULL)
 		return false;
-	bool ret = (bool)obj->fns->ICollectionFns;
+	bool ret = (bool)objectFns(obj)->ICollectionFns;
 	if(ret) {
 		assert(isSeqable(obj));
 	}
@@ -130,7 +141,7 @@ static inline bool isICollection(const lisp_object *obj) {
 static inline bool isIStack(const lisp_object *obj) {
 	if(obj == NULL)
 		return false;
-	bool ret = (bool)obj->fns->IStackFns;
+	bool ret = (bool)objectFns(obj)->IStackFns;
 	if(ret) {
 		assert(isICollection(obj));
 	}
@@ -140,7 +151,7 @@ static inline bool isIStack(const lisp_object *obj) {
 static inline bool isISeq(const lisp_object *obj) {
 	if(obj == NULL)
 		return false;
-	bool ret = (bool)obj->fns->ISeqFns;
+	bool ret = (bool)objectFns(obj)->ISeqFns;
 	if(ret) {
 		assert(isICollection(obj));
 	}
@@ -150,13 +161,13 @@ static inline bool isISeq(const lisp_object *obj) {
 static inline bool isIFn(const lisp_object *obj) {
 	if(obj == NULL)
 		return false;
-	return (bool)obj->fns->IFnFns;
+	return (bool)objectFns(obj)->IFnFns;
 }
 
 static inline bool isIVector(const lisp_object *obj) {
 	if(obj == NULL)
 		return false;
-	bool ret = (bool)obj->fns->IVectorFns;
+	bool ret = (bool)objectFns(obj)->IVectorFns;
 	if(ret) {
 		assert(isReversible(obj));
 		assert(isIStack(obj));
@@ -167,7 +178,17 @@ static inline bool isIVector(const lisp_object *obj) {
 static inline bool isIMap(const lisp_object *obj) {
 	if(obj == NULL)
 		return false;
-	bool ret = (bool)obj->fns->IMapFns;
+	bool ret = (bool)objectFns(obj)->IMapFns;
+	if(ret) {
+		assert(isICollection(obj));
+	}
+	return ret;
+}
+
+static inline bool isISet(const lisp_object *obj) {
+	if(obj == NULL)
+		return false;
+	bool ret = (bool)objectFns(obj)->ISetFns;
 	if(ret) {
 		assert(isICollection(obj));
 	}
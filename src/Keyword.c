@@ -38,32 +38,35 @@ interfaces Keyword_interfaces = {
 	&Keyword_IFn_vtable,	// IFnFns
 	NULL,					// IVectorFns
 	NULL,					// IMapFns
+	NULL,					// ISetFns
+	toStringKeyword,		// toString
+	EqualBase,				// Equals
+	NULL,					// HashEq
 };
 
-const Keyword _arglistsKW = {{KEYWORD_type, sizeof(Keyword), toStringKeyword, EqualBase, (IMap*) &_EmptyHashMap, &Keyword_interfaces}, &_arglistsSymbol};
+const Keyword _arglistsKW = {{KEYWORD_type, sizeof(Keyword), (IMap*) &_EmptyHashMap, &Keyword_interfaces}, &_arglistsSymbol};
 const Keyword *const arglistsKW = &_arglistsKW;
-const Keyword _ColumnKW = {{KEYWORD_type, sizeof(Keyword), toStringKeyword, EqualBase, (IMap*) &_EmptyHashMap, &Keyword_interfaces}, &_ColumnSymbol};
+const Keyword _ColumnKW = {{KEYWORD_type, sizeof(Keyword), (IMap*) &_EmptyHashMap, &Keyword_interfaces}, &_ColumnSymbol};
 const Keyword *const ColumnKW = &_ColumnKW;
-const Keyword _ConstKW = {{KEYWORD_type, sizeof(Keyword), toStringKeyword, EqualBase, (IMap*) &_EmptyHashMap, &Keyword_interfaces}, &_ConstSymbol};
+const Keyword _ConstKW = {{KEYWORD_type, sizeof(Keyword), (IMap*) &_EmptyHashMap, &Keyword_interfaces}, &_ConstSymbol};
 const Keyword *const ConstKW = &_ConstKW;
-const Keyword _DocKW = {{KEYWORD_type, sizeof(Keyword), toStringKeyword, EqualBase, (IMap*) &_EmptyHashMap, &Keyword_interfaces}, &_DocSymbol};
+const Keyword _DocKW = {{KEYWORD_type, sizeof(Keyword), (IMap*) &_EmptyHashMap, &Keyword_interfaces}, &_DocSymbol};
 const Keyword *const DocKW = &_DocKW;
-const Keyword _DynamicKW = {{KEYWORD_type, sizeof(Keyword), toStringKeyword, EqualBase, (IMap*) &_EmptyHashMap, &Keyword_interfaces}, &_DynamicSymbol};
+const Keyword _DynamicKW = {{KEYWORD_type, sizeof(Keyword), (IMap*) &_EmptyHashMap, &Keyword_interfaces}, &_DynamicSymbol};
 const Keyword *const DynamicKW = &_DynamicKW;
-const Keyword _FileKW = {{KEYWORD_type, sizeof(Keyword), toStringKeyword, EqualBase, (IMap*) &_EmptyHashMap, &Keyword_interfaces}, &_FileSymbol};
+const Keyword _FileKW = {{KEYWORD_type, sizeof(Keyword), (IMap*) &_EmptyHashMap, &Keyword_interfaces}, &_FileSymbol};
 const Keyword *const FileKW = &_FileKW;
-const Keyword _LineKW = {{KEYWORD_type, sizeof(Keyword), toStringKeyword, EqualBase, (IMap*) &_EmptyHashMap, &Keyword_interfaces}, &_LineSymbol};
+const Keyword _LineKW = {{KEYWORD_type, sizeof(Keyword), (IMap*) &_EmptyHashMap, &Keyword_interfaces}, &_LineSymbol};
 const Keyword *const LineKW = &_LineKW;
-const Keyword _macroKW = {{KEYWORD_type, sizeof(Keyword), toStringKeyword, EqualBase, (IMap*) &_EmptyHashMap, &Keyword_interfaces}, &_macroSymbol};
+const Keyword _macroKW = {{KEYWORD_type, sizeof(Keyword), (IMap*) &_EmptyHashMap, &Keyword_interfaces}, &_macroSymbol};
 const Keyword *const macroKW = &_macroKW;
-const Keyword _privateKW = {{KEYWORD_type, sizeof(Keyword), toStringKeyword, EqualBase, (IMap*) &_EmptyHashMap, &Keyword_interfaces}, &_privateSymbol};
+const Keyword _privateKW = {{KEYWORD_type, sizeof(Keyword), (IMap*) &_EmptyHashMap, &Keyword_interfaces}, &_privateSymbol};
 const Keyword *const privateKW = &_privateKW;
-const Keyword _tagKW = {{KEYWORD_type, sizeof(Keyword), toStringKeyword, EqualBase, (IMap*) &_EmptyHashMap, &Keyword_interfaces}, &_tagSymbol};
+const Keyword _tagKW = {{KEYWORD_type, sizeof(Keyword), (IMap*) &_EmptyHashMap, &Keyword_interfaces}, &_tagSymbol};
 const Keyword *const tagKW = &_tagKW;
 
 const Keyword *internKeyword(const Symbol *s) {
-	const MapEntry *me = Cache->obj.fns->IMapFns->entryAt(Cache, (lisp_object*) s);
-	const lisp_object *obj = me ? me->val : NULL;
+	const lisp_object *obj = Cache->obj.fns->IMapFns->valAt(Cache, (lisp_object*) s, NULL);
 	if(obj) {
 		assert(obj->type == KEYWORD_type);
 		return (const Keyword*) obj;
@@ -90,8 +93,7 @@ const char *getNamespaceKeyword(const Keyword *k) {
 }
 
 const Keyword *findKeyword(const Symbol *s) {
-	const MapEntry *me = Cache->obj.fns->IMapFns->entryAt(Cache, (const lisp_object*)s);
-	const lisp_object *ret = me ? me->val : NULL;
+	const lisp_object *ret = Cache->obj.fns->IMapFns->valAt(Cache, (const lisp_object*)s, NULL);
 	if(ret == NULL)
 		return NULL;
 	assert(ret->type == KEYWORD_type);
@@ -116,8 +118,6 @@ static const Keyword* NewKeyword(const Symbol* s) {
 	Keyword *ret = GC_MALLOC(sizeof(*ret));
 	ret->obj.type = KEYWORD_type;
 	ret->obj.size = sizeof(Keyword);
-	ret->obj.toString = toStringKeyword;
-	ret->obj.Equals = EqualBase;
 	ret->obj.fns = &Keyword_interfaces;
 	ret->sym = s;
 
@@ -140,6 +140,6 @@ static const char *toStringKeyword(const lisp_object *obj) {
 	StringWriter *sw = NewStringWriter();
 	AddChar(sw, ':');
 	const lisp_object *s = (lisp_object*)k->sym;
-	AddString(sw, s->toString(s));
+	AddString(sw, s->fns->toString(s));
 	return WriteString(sw);
 }
@@ -3,6 +3,7 @@
 
 #include <stdbool.h>
 #include <stddef.h>
+#include <stdint.h>
 
 // #include "llvm-c/Types.h"
 
@@ -28,12 +29,17 @@
 	TYPE(NAMESPACE_type) \
 	TYPE(UNBOUND_type) \
 	TYPE(VAR_type) \
+	TYPE(BOX_type) \
 	TYPE(IFN_type) \
 	TYPE(EXPR_type) \
 	TYPE(PATHNODE_type) \
 	TYPE(OBJMETHOD_type) \
 	TYPE(FNMETHOD_type) \
 	TYPE(BINDINGINIT_type) \
+	TYPE(LOCALBINDING_type) \
+	TYPE(CODE_type) \
+	TYPE(NATIVEFN_type) \
+	TYPE(FN_type) \
 	TYPE(RESTFN_type) \
 \
 	/* Map types. */ \
@@ -46,12 +52,33 @@
 	TYPE(HASHMAP_type) \
 	TYPE(TRANSIENTHASHMAP_type) \
 	TYPE(KEYSEQ_type) \
+	TYPE(CHAMP_NODE_type) \
+	TYPE(CHAMP_COLLISIONNODE_type) \
+	TYPE(CHAMPSEQ_type) \
+	TYPE(CHAMPMAP_type) \
+	TYPE(ARRAYMAP_type) \
+	TYPE(ARRAYMAPSEQ_type) \
+\
+	/* Set types. */ \
+	TYPE(SET_NODE_type) \
+	TYPE(SET_COLLISIONNODE_type) \
+	TYPE(SETSEQ_type) \
+	TYPE(HASHSET_type) \
+	TYPE(TRANSIENTHASHSET_type) \
+\
+	/* Sorted types. */ \
+	TYPE(TREE_NODE_type) \
+	TYPE(TREESEQ_type) \
+	TYPE(TREEMAP_type) \
+	TYPE(TREESET_type) \
 \
 	/* Vector types. */ \
 	TYPE(VECTOR_type) \
 	TYPE(NODE_type) \
 	TYPE(CHUNKEDSEQ_type) \
 	TYPE(RSEQ_type) \
+	TYPE(PRIMVECTOR_type) \
+	TYPE(PRIMVECTORSEQ_type) \
 \
 	/* Interfaces. */ \
 	TYPE(ISEQ_interface)
@@ -73,7 +100,12 @@ typedef struct ISeq_vtable_struct ISeq_vtable;
 typedef struct IFn_vtable_struct IFn_vtable;
 typedef struct IVector_vtable_struct IVector_vtable;
 typedef struct IMap_vtable_struct IMap_vtable;
+typedef struct ISet_vtable_struct ISet_vtable;
+
+typedef struct lisp_object_struct lisp_object;
+typedef struct IMap_struct IMap;
 
+// Behaviour shared by every object of a kind.  Objects point at it rather than carrying their own copy.
 typedef struct {
 	const Seqable_vtable *SeqableFns;
 	const Reversible_vtable *ReversibleFns;
@@ -83,19 +115,50 @@ typedef struct {
 	const IFn_vtable *IFnFns;
 	const IVector_vtable *IVectorFns;
 	const IMap_vtable *IMapFns;
+	const ISet_vtable *ISetFns;
+	const char *(*toString)(const lisp_object *obj);
+	bool (*Equals)(const lisp_object *x, const lisp_object *y);
+	uint32_t (*HashEq)(const lisp_object *obj);	// Hashes by value.  NULL for kinds HashEq handles itself.
 } interfaces;
 
-static const interfaces NullInterface = {NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL};
-
-typedef struct IMap_struct IMap;
+static const interfaces NullInterface = {NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL};
 
-typedef struct lisp_object_struct {
-    object_type type;
-	size_t size;
-	const char *(*toString)(const struct lisp_object_struct *);
-	bool (*Equals)(const struct lisp_object_struct *x, const struct lisp_object_struct *y);
+struct lisp_object_struct {
+	object_type type;
+	uint32_t size;		// Packs with type into one word.
 	const IMap *meta;
 	const interfaces *fns;
-} lisp_object;
+};
+
+// Small integers and characters are immediates, stored in the lisp_object pointer itself with a tag in the low bits.
+// Heap objects are word aligned, so their tag is always 0.  Use these accessors on any object that could be an
+// immediate, rather than dereferencing it.
+#define IMMEDIATE_BITS		2
+#define IMMEDIATE_MASK		((uintptr_t)3)
+#define FIXNUM_IMMEDIATE	((uintptr_t)1)
+#define CHAR_IMMEDIATE		((uintptr_t)2)
+
+static inline bool isImmediate(const lisp_object *obj) {
+	return ((uintptr_t)obj & IMMEDIATE_MASK) != 0;
+}
+
+static inline object_type objectType(const lisp_object *obj) {
+	switch((uintptr_t)obj & IMMEDIATE_MASK) {
+		case FIXNUM_IMMEDIATE:
+			return INTEGER_type;
+		case CHAR_IMMEDIATE:
+			return CHAR_type;
+		default:
+			return obj->type;
+	}
+}
+
+static inline const interfaces *objectFns(const lisp_object *obj) {
+	return isImmediate(obj) ? &NullInterface : obj->fns;
+}
+
+static inline const IMap *objectMeta(const lisp_object *obj) {
+	return isImmediate(obj) ? NULL : obj->meta;
+}
 
 #endif /* LISP_OBJECT_H */
@@ -6,12 +6,15 @@
 #include "ASeq.h"
 #include "gc.h"
 #include "Interfaces.h"
+#include "Murmur3.h"
 #include "Util.h"
 
 static const char *toStringEmptyList(const lisp_object *obj);
 static const lisp_object* firstList(const ISeq*);
 static const ISeq* nextList(const ISeq*);
 static size_t countList(const ICollection *ic);
+static uint32_t HashEqList(const lisp_object *obj);
+static uint32_t HashEqEmptyList(const lisp_object *obj);
 
 const Seqable_vtable List_Seqable_vtable = {
 	seqASeq // seq
@@ -40,6 +43,25 @@ interfaces List_interfaces = {
 	NULL,						// IFn_vtale
 	NULL,						// IVector_vtable
 	NULL,						// IMap_vtable
+	NULL,						// ISet_vtable
+	toString,					// toString
+	EqualBase,					// Equals
+	HashEqList,					// HashEq
+};
+
+interfaces EmptyList_interfaces = {
+	&List_Seqable_vtable,		// Seqable_vtable
+	NULL,						// Reversible_vtable
+	&List_ICollection_vtable,	// ICollection_vtable
+	NULL,						// IStack_vtable
+	&List_ISeq_vtable,			// ISeq_vtable
+	NULL,						// IFn_vtale
+	NULL,						// IVector_vtable
+	NULL,						// IMap_vtable
+	NULL,						// ISet_vtable
+	toStringEmptyList,			// toString
+	EqualBase,					// Equals
+	HashEqEmptyList,			// HashEq
 };
 
 struct List_struct {
@@ -47,9 +69,10 @@ struct List_struct {
     const lisp_object *const _first;
     const struct List_struct *const _rest;
     const size_t _count;
+    uint32_t _hash;     // HashEq, computed on first use.  0 until then.
 };
     
-const List _EmptyList = {{LIST_type, sizeof(List), toStringEmptyList, EqualBase, NULL, &List_interfaces}, NULL, NULL, 0};
+const List _EmptyList = {{LIST_type, sizeof(List), NULL, &EmptyList_interfaces}, NULL, NULL, 0, 0};
 const List *const EmptyList = &_EmptyList;
 
 static const char *toStringEmptyList(const lisp_object *obj) {
@@ -60,19 +83,20 @@ static const char *toStringEmptyList(const lisp_object *obj) {
 const List *NewList(const lisp_object *const first) {
     List *ret = GC_MALLOC(sizeof(*ret));
 
-    List _ret = {{LIST_type, sizeof(List), toString, EqualBase, NULL, &List_interfaces}, first, EmptyList, 1};
+    List _ret = {{LIST_type, sizeof(List), NULL, &List_interfaces}, first, EmptyList, 1, 0};
     memcpy(ret, &_ret, sizeof(*ret));
 
     return ret;
 }
 
-const List *CreateList(size_t count, const lisp_object **entries) {
+const List *CreateList(size_t count, const lisp_object *const *entries) {
     List *ret = (List*)EmptyList;
     for(size_t i = 1; i <= count; i++) {
-        List _ret = {{LIST_type, sizeof(List), toString, EqualBase, NULL, &List_interfaces},
+        List _ret = {{LIST_type, sizeof(List), NULL, &List_interfaces},
                      entries[count-i],
                      ret,
-                     i};
+                     i,
+                     0};
         ret = GC_MALLOC(sizeof(*ret));
         memcpy(ret, &_ret, sizeof(*ret));
     }
@@ -100,3 +124,17 @@ static size_t countList(const ICollection *ic) {
 
 	return l->_count;
 }
+
+static uint32_t HashEqList(const lisp_object *obj) {
+	assert(obj->type == LIST_type);
+	List *l = (List*) obj;
+
+	if(l->_hash == 0)
+		l->_hash = hashOrdered(obj);
+	return l->_hash;
+}
+
+static uint32_t HashEqEmptyList(const lisp_object *obj) {
+	assert((void*)obj == (void*)EmptyList);
+	return mixCollHash(1, 0);
+}
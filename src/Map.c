@@ -8,143 +8,155 @@
 #include "AFn.h"
 #include "ASeq.h"
 #include "Cons.h"
+#include "EditToken.h"
 #include "Error.h"
 #include "gc.h"
 #include "Interfaces.h"
 #include "intrinsics.h"
 #include "lisp_pthread.h"
 #include "MapEntry.h"
+#include "Murmur3.h"
 #include "nodes.h"
 #include "Numbers.h"
 #include "Util.h"
 
-// Support functions
-
-static uint32_t mask(uint32_t hash, size_t shift) {
-	return (hash >> shift) & NODE_BITMASK;
-}
-
-static uint32_t bitpos(uint32_t hash, size_t shift) {
-	return 1 << mask(hash, shift);
-}
-
-static size_t index(uint32_t mask, uint32_t bit) {
-	return popcount(mask & (bit - 1));
-}
-
 // Node interface definition.
 
 typedef struct INode_struct INode;
 
 typedef struct {	// INode_vtable
 	const INode* (*assoc)(const INode *node, size_t shift, uint32_t hash, const lisp_object *key, const lisp_object *val, bool *addedLeaf);
-	INode* (*assoc_thread)(INode *node, bool edit, pthread_t thread_id, size_t shift, uint32_t hash, lisp_object *key, lisp_object *val, bool *addedLeaf);
+	INode* (*assoc_thread)(INode *node, const EditToken *edit, size_t shift, uint32_t hash, const lisp_object *key, const lisp_object *val, bool *addedLeaf);
 	const INode* (*without)(const INode *node, size_t shift, uint32_t hash, const lisp_object *key);
-	INode* (*without_thread)(INode *node, bool edit, pthread_t thread_id, size_t shift, uint32_t hash, lisp_object *key);
+	INode* (*without_thread)(INode *node, const EditToken *edit, size_t shift, uint32_t hash, const lisp_object *key, bool *removedLeaf);
 	const MapEntry* (*find)(const INode *node, size_t shift, uint32_t hash, const lisp_object *key);
 	const ISeq* (*nodeSeq)(const INode *node);
-	// lisp_object* (*kvreduce)(lisp_object* (*f)(lisp_object*), lisp_object *init);
-	// lisp_object* (*fold)(...)
+	const lisp_object* (*kvreduce)(const INode *node, const IFn *f, const lisp_object *init);
+	const lisp_object* (*fold)(const INode *node, const IFn *combinef, const IFn *reducef);
 	// Interator (*iterator)(Ifn f)
 } INode_vtable;
 
+// Nodes are internal to a map, so in place of a lisp_object header they carry just their type, which shares a word
+// with a 32 bit field of their own, their functions and their owner's edit token.
 struct INode_struct {
-	lisp_object obj;
+	object_type type;
+	uint32_t bits;
 	const INode_vtable *fns;
+	const EditToken *edit;
 };
 
 // INode function declarations.
 
-static const INode* createNode(bool edit, pthread_t thread_id, size_t shift, const lisp_object *key1, const lisp_object *val1, uint32_t key2hash, const lisp_object *key2, const lisp_object *val2);
+static const lisp_object* foldNode(const INode *node, const IFn *combinef, const IFn *reducef);
+static const INode* createNode(const EditToken *edit, size_t shift, const lisp_object *key1, const lisp_object *val1, uint32_t key2hash, const lisp_object *key2, const lisp_object *val2);
 
 // BitmapIndexedNode
 
+// A node is owned by a transient when its edit points at that transient's EditToken.  Persistent nodes have a NULL edit.
+// The node holds a pair of slots for each bit set in bitmap.  It records neither count nor capacity: a transient finds
+// the room it has from the size of the allocation.
 typedef struct {
-	lisp_object obj;
-	const INode_vtable *fns;
+	object_type type;
 	uint32_t bitmap;
-	bool edit;
-	pthread_t thread_id;
-	size_t count;
+	const INode_vtable *fns;
+	const EditToken *edit;
 	const lisp_object *array[];
 } BitmapIndexedNode;
 
 // BitmapIndexedNode function declarations.
-BitmapIndexedNode *NewBMINode(bool edit, pthread_t thread_id, uint32_t bitmap, size_t count, const lisp_object **array);
+BitmapIndexedNode *NewBMINode(const EditToken *edit, uint32_t bitmap, const lisp_object **array);
+static BitmapIndexedNode *editableBMINode(BitmapIndexedNode *node, const EditToken *edit, size_t capacity);
 const INode* assocBitmapIndexed_Node(const INode *node, size_t shift, uint32_t hash, const lisp_object *key, const lisp_object *val, bool *addedLeaf);
+static INode* assocBMINodeThread(INode *node, const EditToken *edit, size_t shift, uint32_t hash, const lisp_object *key, const lisp_object *val, bool *addedLeaf);
 const INode* without_BitmapIndexed_Node(const INode *node, size_t shift, uint32_t hash, const lisp_object *key);
+static INode* withoutBMINodeThread(INode *node, const EditToken *edit, size_t shift, uint32_t hash, const lisp_object *key, bool *removedLeaf);
 const MapEntry* find_BitmapIndexed_Node(const INode *node, size_t shift, uint32_t hash, const lisp_object *key);
 const ISeq* nodeSeq_BitmapIndexed_Node(const INode *node);
+static const lisp_object* kvreduceBMINode(const INode *node, const IFn *f, const lisp_object *init);
 
 const INode_vtable BMINode_vtable = {
 	assocBitmapIndexed_Node,	// assoc
-	NULL,						// assoc_thread	// TODO
+	assocBMINodeThread,			// assoc_thread
 	without_BitmapIndexed_Node,	// without
-	NULL,						// without_thread	// TODO
+	withoutBMINodeThread,		// without_thread
 	find_BitmapIndexed_Node,	// find
-	nodeSeq_BitmapIndexed_Node	// nodeSeq
+	nodeSeq_BitmapIndexed_Node,	// nodeSeq
+	kvreduceBMINode,			// kvreduce
+	foldNode,					// fold
 };
 
-BitmapIndexedNode _EmptyBMINode = {{BMI_NODE_type, sizeof(BitmapIndexedNode), NULL, NULL, NULL, NULL}, &BMINode_vtable, 0, false, (pthread_t)NULL, 0, };
+BitmapIndexedNode _EmptyBMINode = {BMI_NODE_type, 0, &BMINode_vtable, NULL, };
 BitmapIndexedNode *EmptyBMINode = &_EmptyBMINode;
 
 // ArrayNode
 
 typedef struct {
-	lisp_object obj;
+	object_type type;
+	uint32_t bitmap;		// The children present.
 	const INode_vtable *fns;
-	bool edit;
-	pthread_t thread_id;
-	size_t count;
+	const EditToken *edit;
 	const INode *array[NODE_SIZE];
 } ArrayNode;
 
 // ArrayNode function declarations.
 
-ArrayNode *NewArrayNode(bool edit, pthread_t thread_id, size_t count, const INode **array);
+ArrayNode *NewArrayNode(const EditToken *edit, const INode **array);
+static ArrayNode *editableArrayNode(ArrayNode *node, const EditToken *edit);
 const INode* assocArrayNode(const INode *node, size_t shift, uint32_t hash, const lisp_object *key, const lisp_object *val, bool *addedLeaf);
-static INode* pack(ArrayNode *node, bool edit, pthread_t thread_id, size_t idx);
+static INode* assocArrayNodeThread(INode *node, const EditToken *edit, size_t shift, uint32_t hash, const lisp_object *key, const lisp_object *val, bool *addedLeaf);
+static INode* pack(ArrayNode *node, const EditToken *edit, size_t idx);
 const INode* withoutArrayNode(const INode *node, size_t shift, uint32_t hash, const lisp_object *key);
+static INode* withoutArrayNodeThread(INode *node, const EditToken *edit, size_t shift, uint32_t hash, const lisp_object *key, bool *removedLeaf);
 const MapEntry* findArrayNode(const INode *node, size_t shift, uint32_t hash, const lisp_object *key);
 const ISeq* nodeSeq_ArrayNode(const INode *node);
+static const lisp_object* kvreduceArrayNode(const INode *node, const IFn *f, const lisp_object *init);
+static const lisp_object* foldArrayNode(const INode *node, const IFn *combinef, const IFn *reducef);
 
 const INode_vtable ArrayNode_vtable = {
-	assocArrayNode,		// assoc
-	NULL,				// assoc_thread	// TODO
-	withoutArrayNode,	// without
-	NULL,				// without_thread	// TODO
-	findArrayNode,		// find
-	nodeSeq_ArrayNode	// nodeSeq
+	assocArrayNode,			// assoc
+	assocArrayNodeThread,	// assoc_thread
+	withoutArrayNode,		// without
+	withoutArrayNodeThread,	// without_thread
+	findArrayNode,			// find
+	nodeSeq_ArrayNode,		// nodeSeq
+	kvreduceArrayNode,		// kvreduce
+	foldArrayNode,			// fold
 };
 
 // CollisionNode
 
 typedef struct {	// CollisionNode
-	lisp_object obj;
-	const INode_vtable *fns;
+	object_type type;
 	uint32_t hash;
+	const INode_vtable *fns;
+	const EditToken *edit;
 	size_t count;
-	bool edit;
-	pthread_t thread_id;
+	size_t capacity;
 	const lisp_object *array[];
 } CollisionNode;
 
 // CollisionNode function declarations.
 
-static CollisionNode *NewCollisionNode(bool edit, pthread_t thread_id, uint32_t hash, size_t count, const lisp_object **array);
+static CollisionNode *NewCollisionNode(const EditToken *edit, uint32_t hash, size_t count, const lisp_object **array);
+static CollisionNode *editableCollisionNode(CollisionNode *node, const EditToken *edit, size_t capacity);
 static const INode* assocCollisionNode(const INode *node, size_t shift, uint32_t hash, const lisp_object *key, const lisp_object *val, bool *addedLeaf);
+static INode* assocCollisionNodeThread(INode *node, const EditToken *edit, size_t shift, uint32_t hash, const lisp_object *key, const lisp_object *val, bool *addedLeaf);
 static const INode* withoutCollisionNode(const INode *node, size_t shift, uint32_t hash, const lisp_object *key);
+static INode* withoutCollisionNodeThread(INode *node, const EditToken *edit, size_t shift, uint32_t hash, const lisp_object *key, bool *removedLeaf);
 static const MapEntry* findCollisionNode(const INode *node, size_t shift, uint32_t hash, const lisp_object *key);
 static const ISeq* nodeSeqCollisionNode(const INode *node);
+static const lisp_object* kvreduceCollisionNode(const INode *node, const IFn *f, const lisp_object *init);
 static int findIndex(const CollisionNode *cnode, const lisp_object *key);
 
 const INode_vtable CollisionNode_vtable = {
-	assocCollisionNode,		// assoc
-	NULL,					// assoc_thread	// TODO
-	withoutCollisionNode,	// without
-	NULL,					// without_thread	// TODO
-	findCollisionNode,		// find
-	nodeSeqCollisionNode	// nodeSeq
+	assocCollisionNode,			// assoc
+	assocCollisionNodeThread,	// assoc_thread
+	withoutCollisionNode,		// without
+	withoutCollisionNodeThread,	// without_thread
+	findCollisionNode,			// find
+	nodeSeqCollisionNode,		// nodeSeq
+	kvreduceCollisionNode,		// kvreduce
+	foldNode,					// fold
 };
 
 // NodeSeq
@@ -190,6 +202,10 @@ interfaces NodeSeq_interfaces = {
 	NULL,							// IFnFns
 	NULL,							// IVectorFns
 	NULL,							// IMapFns
+	NULL,							// ISetFns
+	toString,						// toString
+	NULL,							// Equals
+	NULL,							// HashEq
 };
 
 // ArrayNodeSeq
@@ -223,14 +239,17 @@ interfaces ArrayNodeSeq_interfaces = {
 	NULL,							// IFnFns
 	NULL,							// IVectorFns
 	NULL,							// IMapFns
+	NULL,							// ISetFns
+	toString,						// toString
+	NULL,							// Equals
+	NULL,							// HashEq
 };
 
 // TransientHashMap
 
 typedef struct {
 	lisp_object obj;
-	bool edit;
-	pthread_t thread_id;
+	EditToken edit;
 	INode *root;
 	size_t count;
 	bool hasNull;
@@ -246,6 +265,7 @@ struct HashMap_struct {
 	const INode *const root;
 	const bool hasNull;
 	const lisp_object *const nullValue;
+	uint32_t hash;		// HashEq, computed on first use.  0 until then.
 	// const IPersistentMap _meta;
 };
 
@@ -268,8 +288,10 @@ static bool containsKeyHashMap(const IMap*, const lisp_object*);
 static const IMap* assocHashMap(const IMap*, const lisp_object*, const lisp_object*);
 static const IMap* withoutHashMap(const IMap*, const lisp_object*);
 static const MapEntry* entryAtHashMap(const IMap*, const lisp_object*);
+static const lisp_object* valAtHashMap(const IMap*, const lisp_object*, const lisp_object*);
 static const IMap* consHashMap(const IMap*, const lisp_object*);
 static bool EqualsHashMap(const lisp_object *x, const lisp_object *y);
+static uint32_t HashEqHashMap(const lisp_object *obj);
 
 const Seqable_vtable HashMap_Seqable_vtable = {
 	seqHashMap // seq
@@ -297,6 +319,7 @@ const IMap_vtable HashMap_IMap_vtable = {
 	assocHashMap,		// assoc
 	withoutHashMap,		// without
 	entryAtHashMap,		// entryAt
+	valAtHashMap,		// valAt
 	consHashMap,		// cons	
 };
 
@@ -309,22 +332,31 @@ interfaces HashMap_interfaces = {
 	&HashMap_IFn_vtable,			// IFnFns
 	NULL,							// IVectorFns
 	&HashMap_IMap_vtable,			// IMapFns
+	NULL,							// ISetFns
+	toString,						// toString
+	EqualsHashMap,					// Equals
+	HashEqHashMap,					// HashEq
 };
 
-const HashMap _EmptyHashMap = {{HASHMAP_type, sizeof(HashMap), toString, EqualsHashMap, (IMap*)&_EmptyHashMap, &HashMap_interfaces}, 0, NULL, false, NULL};
+const HashMap _EmptyHashMap = {{HASHMAP_type, sizeof(HashMap), (IMap*)&_EmptyHashMap, &HashMap_interfaces}, 0, NULL, false, NULL, 0};
 const HashMap *const EmptyHashMap = &_EmptyHashMap;
 
 // INode Function Definitions
 
-static const INode* createNode(__attribute__((unused)) bool edit, __attribute__((unused)) pthread_t thread_id, size_t shift, const lisp_object *key1, const lisp_object *val1, uint32_t key2hash, const lisp_object *key2, const lisp_object *val2) {
-	// TODO make this respect threads, which requires assoc_thread.
+static const INode* createNode(const EditToken *edit, size_t shift, const lisp_object *key1, const lisp_object *val1, uint32_t key2hash, const lisp_object *key2, const lisp_object *val2) {
 	uint32_t key1hash = HashEq(key1);
 	if(key1hash == key2hash) {
 		const lisp_object *array[4] = {key1, val1, key2, val2};
-		return (INode*) NewCollisionNode(false, NULL, key1hash, 2, array);
+		return (INode*) NewCollisionNode(edit, key1hash, 2, array);
 	}
-	const INode *ret = (INode*) EmptyBMINode;
 	bool addedLeaf = false;
+	if(edit) {
+		INode *ret = (INode*) EmptyBMINode;
+		ret = ret->fns->assoc_thread(ret, edit, shift, key1hash, key1, val1, &addedLeaf);
+		ret = ret->fns->assoc_thread(ret, edit, shift, key2hash, key2, val2, &addedLeaf);
+		return ret;
+	}
+	const INode *ret = (INode*) EmptyBMINode;
 	ret = ret->fns->assoc(ret, shift, key1hash, key1, val1, &addedLeaf);
 	ret = ret->fns->assoc(ret, shift, key2hash, key2, val2, &addedLeaf);
 	return ret;
@@ -332,19 +364,44 @@ static const INode* createNode(__attribute__((unused)) bool edit, __attribute__(
 
 // BitmapIndexedNode Function Definitions
 
-BitmapIndexedNode *NewBMINode(bool edit, pthread_t thread_id, uint32_t bitmap, size_t count, const lisp_object **array) {
+// The slots in use, a pair for each bit.
+static size_t countBMINode(const BitmapIndexedNode *node) {
+	return 2 * popcount(node->bitmap);
+}
+
+// The slots allocated.  Only the GC knows, since the node does not record it.
+static size_t capacityBMINode(const BitmapIndexedNode *node) {
+	return (GC_size((void*)node) - sizeof(*node)) / sizeof(lisp_object*);
+}
+
+// array holds the slots for bitmap.
+BitmapIndexedNode *NewBMINode(const EditToken *edit, uint32_t bitmap, const lisp_object **array) {
+	size_t count = 2 * popcount(bitmap);
 	BitmapIndexedNode *node = GC_MALLOC(sizeof(*node) + count * sizeof(lisp_object*));
 	memcpy(node, EmptyBMINode, sizeof(*node));
 	node->edit = edit;
-	node->thread_id = thread_id;
 	node->bitmap = bitmap;
-	node->count = count;
 	memcpy(node->array, array, count * sizeof(*array));
 	return node;
 }
 
+// Returns node itself when edit owns it and it has room for capacity slots, otherwise an owned copy.
+static BitmapIndexedNode *editableBMINode(BitmapIndexedNode *node, const EditToken *edit, size_t capacity) {
+	if(node->edit == edit && capacityBMINode(node) >= capacity)
+		return node;
+	if(node->edit == edit)
+		capacity += 6;		// Grow by several pairs, since a transient is likely to keep adding.
+	if(capacity > 2*NODE_SIZE)
+		capacity = 2*NODE_SIZE;
+	BitmapIndexedNode *ret = GC_MALLOC(sizeof(*ret) + capacity * sizeof(lisp_object*));
+	memcpy(ret, node, sizeof(*ret));
+	ret->edit = edit;
+	memcpy(ret->array, node->array, countBMINode(node) * sizeof(lisp_object*));
+	return ret;
+}
+
 const INode* assocBitmapIndexed_Node(const INode *node, size_t shift, uint32_t hash, const lisp_object *key, const lisp_object *val, bool *addedLeaf) {
-	assert(node->obj.type == BMI_NODE_type);
+	assert(node->type == BMI_NODE_type);
 	BitmapIndexedNode *BMI_node = (BitmapIndexedNode*)node;
 	uint32_t bit = bitpos(hash, shift);
 	size_t idx = index(BMI_node->bitmap, bit);
@@ -358,21 +415,21 @@ const INode* assocBitmapIndexed_Node(const INode *node, size_t shift, uint32_t h
 			if((lisp_object*)n == lookup_val) {
 				return node;
 			}
-			BMI_node = NewBMINode(false, (pthread_t)NULL, BMI_node->bitmap, BMI_node->count, BMI_node->array);
+			BMI_node = NewBMINode(NULL, BMI_node->bitmap, BMI_node->array);
 			BMI_node->array[2*idx+1] = (lisp_object*)n;
 			return (INode*)BMI_node;
 		}
 		if(Equiv(key, lookup_key)) {
 			if(val == lookup_val)
 				return node;
-			BMI_node = NewBMINode(false, (pthread_t)NULL, BMI_node->bitmap, BMI_node->count, BMI_node->array);
+			BMI_node = NewBMINode(NULL, BMI_node->bitmap, BMI_node->array);
 			BMI_node->array[2*idx+1] = (lisp_object*)val;
 			return (INode*)BMI_node;
 		}
 		*addedLeaf = true;
-		BMI_node = NewBMINode(false, (pthread_t)NULL, BMI_node->bitmap, BMI_node->count, BMI_node->array);
+		BMI_node = NewBMINode(NULL, BMI_node->bitmap, BMI_node->array);
 		BMI_node->array[2*idx  ] = NULL;
-		BMI_node->array[2*idx+1] = (lisp_object*) createNode(true, pthread_self(), shift + NODE_LOG_SIZE, lookup_key, lookup_val, hash, key, val);
+		BMI_node->array[2*idx+1] = (lisp_object*) createNode(NULL, shift + NODE_LOG_SIZE, lookup_key, lookup_val, hash, key, val);
 		return (INode*)BMI_node;
 	} else {
 		size_t n = popcount(BMI_node->bitmap);
@@ -393,7 +450,7 @@ const INode* assocBitmapIndexed_Node(const INode *node, size_t shift, uint32_t h
 					j += 2;
 				}
 			}
-			return (const INode*)NewArrayNode(false, (pthread_t)NULL, n + 1, nodes);
+			return (const INode*)NewArrayNode(NULL, nodes);
 		}
 		else {
 			const lisp_object *array[2*(n+1)];
@@ -402,13 +459,73 @@ const INode* assocBitmapIndexed_Node(const INode *node, size_t shift, uint32_t h
 			array[2*idx+1] = val;
 			*addedLeaf = true;
 			memcpy(&array[2*(idx+1)], &(BMI_node->array[2*idx]), 2 * (n - idx) * sizeof(lisp_object*));		// Bug from mistranslating from Java
-			return (INode*)NewBMINode(false, (pthread_t)NULL, BMI_node->bitmap | bit, BMI_node->count + 2, array);
+			return (INode*)NewBMINode(NULL, BMI_node->bitmap | bit, array);
+		}
+	}
+}
+
+static INode* assocBMINodeThread(INode *node, const EditToken *edit, size_t shift, uint32_t hash, const lisp_object *key, const lisp_object *val, bool *addedLeaf) {
+	assert(node->type == BMI_NODE_type);
+	BitmapIndexedNode *BMI_node = (BitmapIndexedNode*)node;
+	uint32_t bit = bitpos(hash, shift);
+	size_t idx = index(BMI_node->bitmap, bit);
+
+	if(BMI_node->bitmap & bit) {
+		const lisp_object *lookup_key = BMI_node->array[2*idx];
+		const lisp_object *lookup_val = BMI_node->array[2*idx+1];
+		if(lookup_key == NULL) {
+			INode *n = (INode*)lookup_val;
+			n = n->fns->assoc_thread(n, edit, shift + NODE_LOG_SIZE, hash, key, val, addedLeaf);
+			if((lisp_object*)n == lookup_val)
+				return node;
+			BMI_node = editableBMINode(BMI_node, edit, countBMINode(BMI_node));
+			BMI_node->array[2*idx+1] = (lisp_object*)n;
+			return (INode*)BMI_node;
+		}
+		if(Equiv(key, lookup_key)) {
+			if(val == lookup_val)
+				return node;
+			BMI_node = editableBMINode(BMI_node, edit, countBMINode(BMI_node));
+			BMI_node->array[2*idx+1] = val;
+			return (INode*)BMI_node;
+		}
+		*addedLeaf = true;
+		const INode *n = createNode(edit, shift + NODE_LOG_SIZE, lookup_key, lookup_val, hash, key, val);
+		BMI_node = editableBMINode(BMI_node, edit, countBMINode(BMI_node));
+		BMI_node->array[2*idx  ] = NULL;
+		BMI_node->array[2*idx+1] = (lisp_object*)n;
+		return (INode*)BMI_node;
+	}
+	size_t n = popcount(BMI_node->bitmap);
+	if(n >= 16) {
+		const INode *nodes[NODE_SIZE];
+		memset(nodes, 0, sizeof(nodes));
+		INode *empty = (INode*)EmptyBMINode;
+		nodes[mask(hash, shift)] = assocBMINodeThread(empty, edit, shift + NODE_LOG_SIZE, hash, key, val, addedLeaf);
+		for(size_t i = 0, j = 0; i < NODE_SIZE; i++) {
+			if((BMI_node->bitmap >> i) & 1) {
+				if(BMI_node->array[j] == NULL) {
+					nodes[i] = (INode*)BMI_node->array[j+1];
+				} else {
+					nodes[i] = assocBMINodeThread(empty, edit, shift + NODE_LOG_SIZE, HashEq(BMI_node->array[j]),
+													BMI_node->array[j], BMI_node->array[j+1], addedLeaf);
+				}
+				j += 2;
+			}
 		}
+		return (INode*)NewArrayNode(edit, nodes);
 	}
+	*addedLeaf = true;
+	BMI_node = editableBMINode(BMI_node, edit, countBMINode(BMI_node) + 2);
+	memmove(&BMI_node->array[2*(idx+1)], &BMI_node->array[2*idx], (countBMINode(BMI_node) - 2*idx) * sizeof(lisp_object*));
+	BMI_node->array[2*idx  ] = key;
+	BMI_node->array[2*idx+1] = val;
+	BMI_node->bitmap |= bit;
+	return (INode*)BMI_node;
 }
 
 const INode* without_BitmapIndexed_Node(const INode *node, size_t shift, uint32_t hash, const lisp_object *key) {
-	assert(node->obj.type == BMI_NODE_type);
+	assert(node->type == BMI_NODE_type);
 	BitmapIndexedNode *BMI_node = (BitmapIndexedNode*)node;
 	uint32_t bit = bitpos(hash, shift);
 	if((BMI_node->bitmap & bit) == 0)
@@ -421,28 +538,66 @@ const INode* without_BitmapIndexed_Node(const INode *node, size_t shift, uint32_
 		if((INode*)lookup_val == n)
 			return node;
 		if(n) {
-			BMI_node = NewBMINode(false, (pthread_t)NULL, BMI_node->bitmap, BMI_node->count, BMI_node->array);
-			BMI_node->array[2*idx+1] = (lisp_object*)n;
-			return n;
+			BitmapIndexedNode *ret = NewBMINode(NULL, BMI_node->bitmap, BMI_node->array);
+			ret->array[2*idx+1] = (lisp_object*)n;
+			return (INode*)ret;
 		}
 		if(BMI_node->bitmap == bit)
 			return NULL;
-		const lisp_object *array[BMI_node->count-2];
-		memcpy(array,			&(BMI_node->array[0]),			2*idx);
-		memcpy(&(array[2*idx]),	&(BMI_node->array[2*(idx+1)]),	BMI_node->count - 2*(idx+1));
-		return (INode*)NewBMINode(false, (pthread_t)NULL, BMI_node->bitmap ^ bit, BMI_node->count-2, array);
+		const lisp_object *array[countBMINode(BMI_node)-2];
+		memcpy(array,			&(BMI_node->array[0]),			2*idx * sizeof(lisp_object*));
+		memcpy(&(array[2*idx]),	&(BMI_node->array[2*(idx+1)]),	(countBMINode(BMI_node) - 2*(idx+1)) * sizeof(lisp_object*));
+		return (INode*)NewBMINode(NULL, BMI_node->bitmap ^ bit, array);
 	}
 	if(Equiv(key, lookup_key)) {
-		const lisp_object *array[BMI_node->count-2];
-		memcpy(array, &(BMI_node->array[0]), 2*idx);
-		memcpy(&(array[2*idx]), &(BMI_node->array[2*(idx+1)]), BMI_node->count - 2*(idx+1));
-		return (INode*)NewBMINode(false, (pthread_t)NULL, BMI_node->bitmap ^ bit, BMI_node->count-2, array);
+		const lisp_object *array[countBMINode(BMI_node)-2];
+		memcpy(array, &(BMI_node->array[0]), 2*idx * sizeof(lisp_object*));
+		memcpy(&(array[2*idx]), &(BMI_node->array[2*(idx+1)]), (countBMINode(BMI_node) - 2*(idx+1)) * sizeof(lisp_object*));
+		return (INode*)NewBMINode(NULL, BMI_node->bitmap ^ bit, array);
+	}
+	return node;
+}
+
+static INode* removePairBMINode(BitmapIndexedNode *node, const EditToken *edit, uint32_t bit, size_t idx) {
+	if(node->bitmap == bit)
+		return NULL;
+	node = editableBMINode(node, edit, countBMINode(node));
+	memmove(&node->array[2*idx], &node->array[2*(idx+1)], (countBMINode(node) - 2*(idx+1)) * sizeof(lisp_object*));
+	node->bitmap ^= bit;
+	node->array[countBMINode(node)  ] = NULL;
+	node->array[countBMINode(node)+1] = NULL;
+	return (INode*)node;
+}
+
+static INode* withoutBMINodeThread(INode *node, const EditToken *edit, size_t shift, uint32_t hash, const lisp_object *key, bool *removedLeaf) {
+	assert(node->type == BMI_NODE_type);
+	BitmapIndexedNode *BMI_node = (BitmapIndexedNode*)node;
+	uint32_t bit = bitpos(hash, shift);
+	if((BMI_node->bitmap & bit) == 0)
+		return node;
+	size_t idx = index(BMI_node->bitmap, bit);
+	const lisp_object *lookup_key = BMI_node->array[2*idx];
+	const lisp_object *lookup_val = BMI_node->array[2*idx+1];
+	if(lookup_key == NULL) {
+		INode *n = (INode*)lookup_val;
+		n = n->fns->without_thread(n, edit, shift + NODE_LOG_SIZE, hash, key, removedLeaf);
+		if((lisp_object*)n == lookup_val)
+			return node;
+		if(n == NULL)
+			return removePairBMINode(BMI_node, edit, bit, idx);
+		BMI_node = editableBMINode(BMI_node, edit, countBMINode(BMI_node));
+		BMI_node->array[2*idx+1] = (lisp_object*)n;
+		return (INode*)BMI_node;
+	}
+	if(Equiv(key, lookup_key)) {
+		*removedLeaf = true;
+		return removePairBMINode(BMI_node, edit, bit, idx);
 	}
 	return node;
 }
 
 const MapEntry* find_BitmapIndexed_Node(const INode *node, size_t shift, uint32_t hash, const lisp_object *key) {
-	assert(node->obj.type == BMI_NODE_type);
+	assert(node->type == BMI_NODE_type);
 	BitmapIndexedNode *BMI_node = (BitmapIndexedNode*)node;
 	uint32_t bit = bitpos(hash, shift);
 	if((BMI_node->bitmap & bit) == 0)
@@ -453,36 +608,53 @@ const MapEntry* find_BitmapIndexed_Node(const INode *node, size_t shift, uint32_
 	if(lookup_key == NULL)
 		return ((INode*)lookup_val)->fns->find((INode*)lookup_val, shift + NODE_LOG_SIZE, hash, key);
 	if(Equiv(key, lookup_key)) {
-		MapEntry *ret = GC_MALLOC(sizeof(*ret));
-		ret->key = lookup_key;
-		ret->val = lookup_val;
-		return ret;
+		return NewMapEntry(lookup_key, lookup_val);
 	}
 	return NULL;
 }
 
 const ISeq* nodeSeq_BitmapIndexed_Node(const INode *node) {
-	assert(node->obj.type == BMI_NODE_type);
+	assert(node->type == BMI_NODE_type);
 	BitmapIndexedNode *BMI_node = (BitmapIndexedNode*)node;
-	return (const ISeq*) CreateNodeSeq(BMI_node->array, BMI_node->count, 0, NULL);
+	return (const ISeq*) CreateNodeSeq(BMI_node->array, countBMINode(BMI_node), 0, NULL);
+}
+
+static const lisp_object* kvreduceBMINode(const INode *node, const IFn *f, const lisp_object *init) {
+	assert(node->type == BMI_NODE_type);
+	const BitmapIndexedNode *BMI_node = (BitmapIndexedNode*)node;
+	const lisp_object *acc = init;
+	for(size_t i = 0; i < countBMINode(BMI_node); i += 2) {
+		const lisp_object *key = BMI_node->array[i];
+		const lisp_object *val = BMI_node->array[i+1];
+		if(key != NULL)
+			acc = f->obj.fns->IFnFns->invoke3(f, acc, key, val);
+		else if(val != NULL)
+			acc = ((INode*)val)->fns->kvreduce((INode*)val, f, acc);
+	}
+	return acc;
 }
 
 // ArrayNode function Definitions.
 
-ArrayNode *NewArrayNode(bool edit, pthread_t thread_id, size_t count, const INode **array) {
+// The children present.
+static size_t countArrayNode(const ArrayNode *node) {
+	return popcount(node->bitmap);
+}
+
+ArrayNode *NewArrayNode(const EditToken *edit, const INode **array) {
 	ArrayNode *node = GC_MALLOC(sizeof(*node));
-	node->obj.type = ARRAY_NODE_type;
-	node->obj.size = sizeof(ArrayNode);
+	node->type = ARRAY_NODE_type;
 	node->fns = &ArrayNode_vtable;
 	node->edit = edit;
-	node->thread_id = thread_id;
-	node->count = count;
+	for(size_t i = 0; i < NODE_SIZE; i++)
+		if(array[i] != NULL)
+			node->bitmap |= 1u << i;
 	memcpy(node->array, array, NODE_SIZE * sizeof(*array));
 	return node;
 }
 
 const INode* assocArrayNode(const INode *node, size_t shift, uint32_t hash, const lisp_object *key, const lisp_object *val, bool *addedLeaf) {
-	assert(node->obj.type == ARRAY_NODE_type);
+	assert(node->type == ARRAY_NODE_type);
 	ArrayNode *anode = (ArrayNode*)node;
 	uint32_t idx = mask(hash, shift);
 	assert(idx < NODE_SIZE);
@@ -491,7 +663,7 @@ const INode* assocArrayNode(const INode *node, size_t shift, uint32_t hash, cons
 		const INode *array[NODE_SIZE];
 		memcpy(&array[0], anode->array, NODE_SIZE * sizeof(INode*));
 		array[idx] = assocBitmapIndexed_Node((INode*)EmptyBMINode, shift + NODE_LOG_SIZE, hash, key, val, addedLeaf);
-		return (INode*)NewArrayNode(false, (pthread_t)NULL, anode->count+1, array);
+		return (INode*)NewArrayNode(NULL, array);
 	}
 	const INode *n2 = n->fns->assoc(n, shift + NODE_LOG_SIZE, hash, key, val, addedLeaf);
 	if(n == n2)
@@ -499,11 +671,37 @@ const INode* assocArrayNode(const INode *node, size_t shift, uint32_t hash, cons
 	const INode *array[NODE_SIZE];
 	memcpy(&array[0], anode->array, NODE_SIZE * sizeof(INode*));
 	array[idx] = n2;
-	return (INode*)NewArrayNode(false, (pthread_t)NULL, anode->count, array);
+	return (INode*)NewArrayNode(NULL, array);
+}
+
+static ArrayNode *editableArrayNode(ArrayNode *node, const EditToken *edit) {
+	if(node->edit == edit)
+		return node;
+	return NewArrayNode(edit, node->array);
 }
 
-static INode* pack(ArrayNode *node, bool edit, pthread_t thread_id, size_t idx) {
-	const lisp_object *array[2*(node->count - 1)];
+static INode* assocArrayNodeThread(INode *node, const EditToken *edit, size_t shift, uint32_t hash, const lisp_object *key, const lisp_object *val, bool *addedLeaf) {
+	assert(node->type == ARRAY_NODE_type);
+	ArrayNode *anode = (ArrayNode*)node;
+	uint32_t idx = mask(hash, shift);
+	assert(idx < NODE_SIZE);
+	INode *n = (INode*)anode->array[idx];
+	if(n == NULL) {
+		anode = editableArrayNode(anode, edit);
+		anode->array[idx] = assocBMINodeThread((INode*)EmptyBMINode, edit, shift + NODE_LOG_SIZE, hash, key, val, addedLeaf);
+		anode->bitmap |= 1u << idx;
+		return (INode*)anode;
+	}
+	INode *n2 = n->fns->assoc_thread(n, edit, shift + NODE_LOG_SIZE, hash, key, val, addedLeaf);
+	if(n2 == n)
+		return node;
+	anode = editableArrayNode(anode, edit);
+	anode->array[idx] = n2;
+	return (INode*)anode;
+}
+
+static INode* pack(ArrayNode *node, const EditToken *edit, size_t idx) {
+	const lisp_object *array[2*(countArrayNode(node) - 1)];
 	memset(&array[0], '\0', sizeof(array));
 	size_t j = 1;
 	uint32_t bitmap = 0;
@@ -521,11 +719,11 @@ static INode* pack(ArrayNode *node, bool edit, pthread_t thread_id, size_t idx)
 			j += 2;
 		}
 	}
-	return (INode*)NewBMINode(edit, thread_id, bitmap, 2*(node->count-1), array);
+	return (INode*)NewBMINode(edit, bitmap, array);
 }
 
 const INode* withoutArrayNode(const INode *node, size_t shift, uint32_t hash, const lisp_object *key) {
-	assert(node->obj.type == ARRAY_NODE_type);
+	assert(node->type == ARRAY_NODE_type);
 	ArrayNode *anode = (ArrayNode*)node;
 	uint32_t idx = mask(hash, shift);
 	assert(idx < NODE_SIZE);
@@ -536,21 +734,45 @@ const INode* withoutArrayNode(const INode *node, size_t shift, uint32_t hash, co
 	if(n2 == n)
 		return node;
 	if(n2 == NULL) {
-		if(anode->count <= 8)
-			return pack(anode, anode->edit, anode->thread_id, idx);
+		if(countArrayNode(anode) <= 8)
+			return pack(anode, NULL, idx);
 		const INode *array[NODE_SIZE];
 		memcpy(&array[0], anode->array, NODE_SIZE * sizeof(INode*));
 		array[idx] = n2;
-		return (INode*)NewArrayNode(false, (pthread_t)NULL, anode->count-1, array);
+		return (INode*)NewArrayNode(NULL, array);
 	}
 	const INode *array[NODE_SIZE];
 	memcpy(&array[0], anode->array, NODE_SIZE * sizeof(INode*));
 	array[idx] = n2;
-	return (INode*)NewArrayNode(false, (pthread_t)NULL, anode->count, array);
+	return (INode*)NewArrayNode(NULL, array);
+}
+
+static INode* withoutArrayNodeThread(INode *node, const EditToken *edit, size_t shift, uint32_t hash, const lisp_object *key, bool *removedLeaf) {
+	assert(node->type == ARRAY_NODE_type);
+	ArrayNode *anode = (ArrayNode*)node;
+	uint32_t idx = mask(hash, shift);
+	assert(idx < NODE_SIZE);
+	INode *n = (INode*)anode->array[idx];
+	if(n == NULL)
+		return node;
+	INode *n2 = n->fns->without_thread(n, edit, shift + NODE_LOG_SIZE, hash, key, removedLeaf);
+	if(n2 == n)
+		return node;
+	if(n2 == NULL) {
+		if(countArrayNode(anode) <= 8)
+			return pack(anode, edit, idx);
+		anode = editableArrayNode(anode, edit);
+		anode->array[idx] = NULL;
+		anode->bitmap &= ~(1u << idx);
+		return (INode*)anode;
+	}
+	anode = editableArrayNode(anode, edit);
+	anode->array[idx] = n2;
+	return (INode*)anode;
 }
 
 const MapEntry* findArrayNode(const INode *node, size_t shift, uint32_t hash, const lisp_object *key) {
-	assert(node->obj.type == ARRAY_NODE_type);
+	assert(node->type == ARRAY_NODE_type);
 	ArrayNode *anode = (ArrayNode*)node;
 	uint32_t idx = mask(hash, shift);
 	assert(idx < NODE_SIZE);
@@ -561,29 +783,192 @@ const MapEntry* findArrayNode(const INode *node, size_t shift, uint32_t hash, co
 }
 
 const ISeq* nodeSeq_ArrayNode(const INode *node) {
-	assert(node->obj.type == ARRAY_NODE_type);
+	assert(node->type == ARRAY_NODE_type);
 	ArrayNode *anode = (ArrayNode*)node;
 
 	return (const ISeq*) CreateArrayNodeSeq(&anode->array[0], 0, NULL);
 }
 
+static const lisp_object* kvreduceArrayNode(const INode *node, const IFn *f, const lisp_object *init) {
+	assert(node->type == ARRAY_NODE_type);
+	const ArrayNode *anode = (ArrayNode*)node;
+	const lisp_object *acc = init;
+	for(size_t i = 0; i < NODE_SIZE; i++) {
+		const INode *child = anode->array[i];
+		if(child)
+			acc = child->fns->kvreduce(child, f, acc);
+	}
+	return acc;
+}
+
+#define FOLD_WORKERS 8	// Most threads a single fold will use, counting the caller.
+
+typedef enum {	// FoldTaskState
+	TASK_QUEUED,
+	TASK_RUNNING,
+	TASK_DONE,
+} FoldTaskState;
+
+typedef struct FoldTask_struct {	// FoldTask
+	const INode *const *children;
+	size_t count;
+	const IFn *combinef;
+	const IFn *reducef;
+	const lisp_object *result;
+	FoldTaskState state;
+	struct FoldTask_struct *next;
+} FoldTask;
+
+static void runFoldTask(FoldTask *task) {
+	const lisp_object *acc = task->combinef->obj.fns->IFnFns->invoke0(task->combinef);
+	for(size_t i = 0; i < task->count; i++)
+		acc = task->children[i]->fns->kvreduce(task->children[i], task->reducef, acc);
+	task->result = acc;
+}
+
+#ifdef MULTITHREAD
+// A pool of FOLD_WORKERS - 1 threads, started by the first fold and kept for the life of the process.  The tasks live
+// on the stack of the fold that queued them, which is why a fold takes back any of its tasks that no worker has
+// started, rather than leave them in the queue.  That also means a fold run from inside a task never waits on a queue
+// that every worker is stuck behind.
+static struct {
+	pthread_mutex_t lock;
+	pthread_cond_t queued;	// Signalled when a task is queued.
+	pthread_cond_t done;	// Broadcast when a task is done.
+	FoldTask *head;
+	FoldTask **tail;
+} pool = {PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER, PTHREAD_COND_INITIALIZER, NULL, &pool.head};
+static pthread_once_t poolStarted = PTHREAD_ONCE_INIT;
+
+static void *runFoldWorker(__attribute__((unused)) void *arg) {
+	pthread_mutex_lock(&pool.lock);
+	for(;;) {
+		while(pool.head == NULL)
+			pthread_cond_wait(&pool.queued, &pool.lock);
+		FoldTask *task = pool.head;
+		pool.head = task->next;
+		if(pool.head == NULL)
+			pool.tail = &pool.head;
+		task->state = TASK_RUNNING;
+		pthread_mutex_unlock(&pool.lock);
+		runFoldTask(task);
+		pthread_mutex_lock(&pool.lock);
+		task->state = TASK_DONE;
+		pthread_cond_broadcast(&pool.done);
+	}
+	return NULL;
+}
+
+// Threads that fail to start are simply missing from the pool.  Folds still finish, since they run whatever is left.
+static void startFoldPool(void) {
+	for(size_t i = 1; i < FOLD_WORKERS; i++) {
+		pthread_t thread;
+		if(pthread_create(&thread, NULL, runFoldWorker, NULL) == 0)
+			pthread_detach(thread);
+	}
+}
+
+// Removes task from the queue, if it is still there.  Called with pool.lock held.
+static bool unqueueFoldTask(FoldTask *task) {
+	for(FoldTask **p = &pool.head; *p != NULL; p = &(*p)->next) {
+		if(*p == task) {
+			*p = task->next;
+			if(*p == NULL)
+				pool.tail = p;
+			return true;
+		}
+	}
+	return false;
+}
+#endif
+
+// Splits the children between FOLD_WORKERS tasks.  With MULTITHREAD, tasks after the first go to the pool of workers,
+// so the collector must be built with thread support and see GC_THREADS.  Otherwise the tasks run one after another,
+// and the result is the same.
+static const lisp_object* foldArrayNode(const INode *node, const IFn *combinef, const IFn *reducef) {
+	assert(node->type == ARRAY_NODE_type);
+	const ArrayNode *anode = (ArrayNode*)node;
+	const INode *children[NODE_SIZE];
+	size_t count = 0;
+	for(size_t i = 0; i < NODE_SIZE; i++) {
+		if(anode->array[i])
+			children[count++] = anode->array[i];
+	}
+	if(count == 0)
+		return combinef->obj.fns->IFnFns->invoke0(combinef);
+
+	size_t workers = count < FOLD_WORKERS ? count : FOLD_WORKERS;
+	FoldTask tasks[FOLD_WORKERS];
+	for(size_t w = 0; w < workers; w++) {
+		size_t start = w * count / workers;
+		size_t end = (w + 1) * count / workers;
+		tasks[w] = (FoldTask){&children[start], end - start, combinef, reducef, NULL, TASK_QUEUED, NULL};
+	}
+
+#ifdef MULTITHREAD
+	pthread_once(&poolStarted, startFoldPool);
+	pthread_mutex_lock(&pool.lock);
+	for(size_t w = 1; w < workers; w++) {
+		*pool.tail = &tasks[w];
+		pool.tail = &tasks[w].next;
+	}
+	pthread_cond_broadcast(&pool.queued);
+	pthread_mutex_unlock(&pool.lock);
+
+	runFoldTask(&tasks[0]);
+	pthread_mutex_lock(&pool.lock);
+	for(size_t w = 1; w < workers; w++) {
+		if(unqueueFoldTask(&tasks[w])) {
+			pthread_mutex_unlock(&pool.lock);
+			runFoldTask(&tasks[w]);
+			pthread_mutex_lock(&pool.lock);
+			tasks[w].state = TASK_DONE;
+		}
+		while(tasks[w].state != TASK_DONE)
+			pthread_cond_wait(&pool.done, &pool.lock);
+	}
+	pthread_mutex_unlock(&pool.lock);
+#else
+	for(size_t w = 0; w < workers; w++)
+		runFoldTask(&tasks[w]);
+#endif
+
+	const lisp_object *acc = tasks[0].result;
+	for(size_t w = 1; w < workers; w++)
+		acc = combinef->obj.fns->IFnFns->invoke2(combinef, acc, tasks[w].result);
+	return acc;
+}
+
 // CollisionNode Function Definitions
 
-static CollisionNode *NewCollisionNode(bool edit, pthread_t thread_id, uint32_t hash, size_t count, const lisp_object **array) {
+static CollisionNode *NewCollisionNode(const EditToken *edit, uint32_t hash, size_t count, const lisp_object **array) {
 	CollisionNode *node = GC_MALLOC(sizeof(*node) + 2 * count * sizeof(lisp_object*));
-	node->obj.type = COLLISIONNODE_type;
-	node->obj.size = sizeof(CollisionNode);
+	node->type = COLLISIONNODE_type;
 	node->fns = &CollisionNode_vtable;
 	node->edit = edit;
-	node->thread_id = thread_id;
 	node->hash = hash;
 	node->count = count;
+	node->capacity = count;
 	memcpy(node->array, array, 2 * count * sizeof(*array));
 	return node;
 }
 
+// Returns node itself when edit owns it and it has room for capacity entries, otherwise an owned copy.
+static CollisionNode *editableCollisionNode(CollisionNode *node, const EditToken *edit, size_t capacity) {
+	if(node->edit == edit && node->capacity >= capacity)
+		return node;
+	if(capacity < node->count + 1)
+		capacity = node->count + 1;
+	CollisionNode *ret = GC_MALLOC(sizeof(*ret) + 2 * capacity * sizeof(lisp_object*));
+	memcpy(ret, node, sizeof(*ret));
+	ret->edit = edit;
+	ret->capacity = capacity;
+	memcpy(ret->array, node->array, 2 * node->count * sizeof(lisp_object*));
+	return ret;
+}
+
 static const INode* assocCollisionNode(const INode *node, size_t shift, uint32_t hash, const lisp_object *key, const lisp_object *val, bool *addedLeaf) {
-	assert(node->obj.type == COLLISIONNODE_type);
+	assert(node->type == COLLISIONNODE_type);
 	CollisionNode *cnode = (CollisionNode*) node;
 
 	if(hash == cnode->hash) {
@@ -591,23 +976,49 @@ static const INode* assocCollisionNode(const INode *node, size_t shift, uint32_t
 		if(idx != -1) {
 			if(cnode->array[idx+1] == val)
 				return node;
-			CollisionNode *c = NewCollisionNode(false, NULL, hash, cnode->count, cnode->array);
+			CollisionNode *c = NewCollisionNode(NULL, hash, cnode->count, cnode->array);
 			c->array[idx+1] = val;
+			return (INode*)c;
 		}
 		const lisp_object *array[2*(cnode->count + 1)];
 		memcpy(&array[0], cnode->array, 2 * cnode->count * sizeof(lisp_object*));
 		array[2*cnode->count  ] = key;
 		array[2*cnode->count+1] = val;
 		*addedLeaf = true;
-		return (INode*) NewCollisionNode(cnode->edit, cnode->thread_id, hash, cnode->count+1, array);
+		return (INode*) NewCollisionNode(NULL, hash, cnode->count+1, array);
 	}
 	const lisp_object *array[2] = {NULL, (const lisp_object*)cnode};
-	INode *ret = (INode*) NewBMINode(false, NULL, hash, 2, array);
+	INode *ret = (INode*) NewBMINode(NULL, bitpos(cnode->hash, shift), array);
 	return ret->fns->assoc(ret, shift, hash, key, val, addedLeaf);
 }
 
+static INode* assocCollisionNodeThread(INode *node, const EditToken *edit, size_t shift, uint32_t hash, const lisp_object *key, const lisp_object *val, bool *addedLeaf) {
+	assert(node->type == COLLISIONNODE_type);
+	CollisionNode *cnode = (CollisionNode*) node;
+
+	if(hash == cnode->hash) {
+		int idx = findIndex(cnode, key);
+		if(idx != -1) {
+			if(cnode->array[idx+1] == val)
+				return node;
+			cnode = editableCollisionNode(cnode, edit, cnode->count);
+			cnode->array[idx+1] = val;
+			return (INode*)cnode;
+		}
+		*addedLeaf = true;
+		cnode = editableCollisionNode(cnode, edit, cnode->count + 1);
+		cnode->array[2*cnode->count  ] = key;
+		cnode->array[2*cnode->count+1] = val;
+		cnode->count++;
+		return (INode*)cnode;
+	}
+	const lisp_object *array[2] = {NULL, (const lisp_object*)cnode};
+	INode *ret = (INode*) NewBMINode(edit, bitpos(cnode->hash, shift), array);
+	return assocBMINodeThread(ret, edit, shift, hash, key, val, addedLeaf);
+}
+
 static const INode* withoutCollisionNode(const INode *node, __attribute__((unused)) size_t shift, uint32_t hash, const lisp_object *key) {
-	assert(node->obj.type == COLLISIONNODE_type);
+	assert(node->type == COLLISIONNODE_type);
 	CollisionNode *cnode = (CollisionNode*) node;
 
 	int i = findIndex(cnode, key);
@@ -616,32 +1027,62 @@ static const INode* withoutCollisionNode(const INode *node, __attribute__((unuse
 	if(cnode->count == 1)
 		return NULL;
 	const lisp_object *array[2*(cnode->count - 1)];
-	memcpy(array,		&(cnode->array[0]),		i);
-	memcpy(&(array[i]),	&(cnode->array[i+2]),	2*(cnode->count-1) - i);
-	return (INode*) NewCollisionNode(false, NULL, hash, cnode->count - 1, array);
+	memcpy(array,		&(cnode->array[0]),		i * sizeof(lisp_object*));
+	memcpy(&(array[i]),	&(cnode->array[i+2]),	(2*(cnode->count-1) - i) * sizeof(lisp_object*));
+	return (INode*) NewCollisionNode(NULL, hash, cnode->count - 1, array);
+}
+
+static INode* withoutCollisionNodeThread(INode *node, const EditToken *edit, __attribute__((unused)) size_t shift, __attribute__((unused)) uint32_t hash, const lisp_object *key, bool *removedLeaf) {
+	assert(node->type == COLLISIONNODE_type);
+	CollisionNode *cnode = (CollisionNode*) node;
+
+	int i = findIndex(cnode, key);
+	if(i == -1)
+		return node;
+	*removedLeaf = true;
+	if(cnode->count == 1)
+		return NULL;
+	cnode = editableCollisionNode(cnode, edit, cnode->count);
+	cnode->count--;
+	cnode->array[i  ] = cnode->array[2*cnode->count  ];
+	cnode->array[i+1] = cnode->array[2*cnode->count+1];
+	cnode->array[2*cnode->count  ] = NULL;
+	cnode->array[2*cnode->count+1] = NULL;
+	return (INode*)cnode;
 }
 
 static const MapEntry* findCollisionNode(const INode *node, __attribute__((unused)) size_t shift, __attribute__((unused)) uint32_t hash, const lisp_object *key) {
-	assert(node->obj.type == COLLISIONNODE_type);
+	assert(node->type == COLLISIONNODE_type);
 	CollisionNode *cnode = (CollisionNode*) node;
 
 	int i = findIndex(cnode, key);
 	if(i == -1)
 		return NULL;
 	if(Equiv(key, cnode->array[i])) {
-		MapEntry *ret = GC_MALLOC(sizeof(*ret));
-		ret->key = cnode->array[i];
-		ret->val = cnode->array[i+1];
-		return ret;
+		return NewMapEntry(cnode->array[i], cnode->array[i+1]);
 	}
 	return NULL;
 }
 
 static const ISeq* nodeSeqCollisionNode(const INode *node) {
-	assert(node->obj.type == COLLISIONNODE_type);
+	assert(node->type == COLLISIONNODE_type);
 	CollisionNode *cnode = (CollisionNode*) node;
 
-	return (ISeq*) CreateNodeSeq(cnode->array, cnode->count, 0, NULL);
+	return (ISeq*) CreateNodeSeq(cnode->array, 2 * cnode->count, 0, NULL);
+}
+
+static const lisp_object* kvreduceCollisionNode(const INode *node, const IFn *f, const lisp_object *init) {
+	assert(node->type == COLLISIONNODE_type);
+	const CollisionNode *cnode = (CollisionNode*) node;
+	const lisp_object *acc = init;
+	for(size_t i = 0; i < 2 * cnode->count; i += 2)
+		acc = f->obj.fns->IFnFns->invoke3(f, acc, cnode->array[i], cnode->array[i+1]);
+	return acc;
+}
+
+// Nodes that are not split reduce all their entries in one part.
+static const lisp_object* foldNode(const INode *node, const IFn *combinef, const IFn *reducef) {
+	return node->fns->kvreduce(node, reducef, combinef->obj.fns->IFnFns->invoke0(combinef));
 }
 
 static int findIndex(const CollisionNode *cnode, const lisp_object *key) {
@@ -652,6 +1093,42 @@ static int findIndex(const CollisionNode *cnode, const lisp_object *key) {
 	return -1;
 }
 
+// Returns the slot holding key in the node that holds it, so the value is the next slot.  Unlike find, it does not
+// allocate a MapEntry.
+static const lisp_object *const *findSlot(const INode *node, size_t shift, uint32_t hash, const lisp_object *key) {
+	while(node) {
+		switch(node->type) {
+			case BMI_NODE_type: {
+				const BitmapIndexedNode *BMI_node = (BitmapIndexedNode*)node;
+				uint32_t bit = bitpos(hash, shift);
+				if((BMI_node->bitmap & bit) == 0)
+					return NULL;
+				size_t idx = index(BMI_node->bitmap, bit);
+				const lisp_object *lookup_key = BMI_node->array[2*idx];
+				if(lookup_key == NULL) {
+					node = (INode*)BMI_node->array[2*idx+1];
+					shift += NODE_LOG_SIZE;
+					continue;
+				}
+				return Equiv(key, lookup_key) ? &(BMI_node->array[2*idx]) : NULL;
+			}
+			case ARRAY_NODE_type:
+				node = ((ArrayNode*)node)->array[mask(hash, shift)];
+				shift += NODE_LOG_SIZE;
+				continue;
+			case COLLISIONNODE_type: {
+				const CollisionNode *cnode = (CollisionNode*)node;
+				int i = findIndex(cnode, key);
+				return i == -1 ? NULL : &(cnode->array[i]);
+			}
+			default:
+				assert(false);
+				return NULL;
+		}
+	}
+	return NULL;
+}
+
 // NodeSeq Function Definitions.
 
 const NodeSeq *NewNodeSeq(const lisp_object **array, size_t count, size_t i, const ISeq *s) {
@@ -660,7 +1137,6 @@ const NodeSeq *NewNodeSeq(const lisp_object **array, size_t count, size_t i, con
 	NodeSeq *ret = GC_MALLOC(sizeof(*ret) + count * sizeof(lisp_object*));
 	ret->obj.type = NODESEQ_type;
 	ret->obj.size = sizeof(NodeSeq);
-	ret->obj.toString = toString;
 	ret->obj.fns = &NodeSeq_interfaces;
 
 	memcpy((void*)&(ret->i), &i, sizeof(i));
@@ -694,10 +1170,7 @@ const lisp_object* firstNodeSeq(const ISeq *o) {
 	if(ns->s)
 		return ns->s->obj.fns->ISeqFns->first(ns->s);
 
-	MapEntry *ret = GC_MALLOC(sizeof(*ret));
-	ret->key = ns->array[ns->i];
-	ret->val = ns->array[ns->i+1];
-	return (lisp_object*) ret;
+	return (lisp_object*) NewMapEntry(ns->array[ns->i], ns->array[ns->i+1]);
 }
 
 const ISeq* nextNodeSeq(const ISeq *o) {
@@ -717,7 +1190,6 @@ const ArrayNodeSeq *NewArrayNodeSeq(const INode **array, size_t i, const ISeq *s
 	ArrayNodeSeq *ret = GC_MALLOC(sizeof(*ret));
 	ret->obj.type = ARRAYNODESEQ_type;
 	ret->obj.size = sizeof(ArrayNodeSeq);
-	ret->obj.toString = toString;
 	ret->obj.fns = &ArrayNodeSeq_interfaces;
 
 	memcpy((void*)&(ret->i), &i, sizeof(i));
@@ -757,13 +1229,14 @@ const ISeq* nextArrayNodeSeq(const ISeq *o) {
 // TransientHashMap Function Definitions.
 
 static const HashMap *asPersistent(TransientHashMap *thm) {
-	assert(thm->edit);
-	thm->edit = false;
+	assert(thm->edit.editable);
+	thm->edit.editable = false;
 	return NewHashMap(thm->count, thm->root, thm->hasNull, thm->nullValue);
 }
 
 static TransientHashMap *assocTHM(TransientHashMap *thm, const lisp_object *key, const lisp_object *val) {
-	assert(thm->edit);
+	assert(thm->edit.editable);
+	assert(pthread_equal(thm->edit.thread_id, pthread_self()));
 	if(key == NULL) {
 		thm->nullValue = val;
 		if(!thm->hasNull) {
@@ -775,14 +1248,109 @@ static TransientHashMap *assocTHM(TransientHashMap *thm, const lisp_object *key,
 
 	bool leafFlag = false;
 	if(thm->root == NULL) thm->root = (INode*)EmptyBMINode;
-	const INode *n = thm->root->fns->assoc(thm->root, 0, HashEq(key), key, val, &leafFlag);
-	if(n != thm->root) thm->root = (INode*)n;
+	INode *n = thm->root->fns->assoc_thread(thm->root, &thm->edit, 0, HashEq(key), key, val, &leafFlag);
+	if(n != thm->root) thm->root = n;
 	if(leafFlag) thm->count++;
 	return thm;
 }
 
 // HashMap Function Definitions.
 
+// The number of entries under node.  Nodes do not record it, so this walks the whole subtree.
+static size_t countNode(const INode *node) {
+	size_t n = 0;
+	switch(node->type) {
+		case BMI_NODE_type: {
+			const BitmapIndexedNode *BMI_node = (BitmapIndexedNode*)node;
+			for(size_t i = 0; i < countBMINode(BMI_node); i += 2)
+				n += BMI_node->array[i] ? 1 : countNode((INode*)BMI_node->array[i+1]);
+			break;
+		}
+		case ARRAY_NODE_type: {
+			const ArrayNode *anode = (ArrayNode*)node;
+			for(size_t i = 0; i < NODE_SIZE; i++)
+				if(anode->array[i])
+					n += countNode(anode->array[i]);
+			break;
+		}
+		default:
+			assert(node->type == COLLISIONNODE_type);
+			n = ((CollisionNode*)node)->count;
+	}
+	return n;
+}
+
+static bool equalINodes(const INode *x, const INode *y, size_t shift, bool (*equal)(const lisp_object*, const lisp_object*));
+
+// Whether node, a sub-node at shift, holds key and val and nothing else.  without can leave a sub-node with one entry,
+// where a map built another way holds the entry inline.
+static bool equalEntryNode(const lisp_object *key, const lisp_object *val, const INode *node, size_t shift,
+		bool (*equal)(const lisp_object*, const lisp_object*)) {
+	const MapEntry *me = node->fns->find(node, shift, HashEq(key), key);
+	return me != NULL && equal(val, me->val) && countNode(node) == 1;
+}
+
+// Compares two BitmapIndexedNode slots for the same bit.  Each holds either a key and its value, or a NULL key and
+// the sub-node under the bit.
+static bool equalSlots(const lisp_object *xkey, const lisp_object *xval, const lisp_object *ykey, const lisp_object *yval,
+		size_t shift, bool (*equal)(const lisp_object*, const lisp_object*)) {
+	if(xkey != NULL && ykey != NULL)
+		return Equiv(xkey, ykey) && equal(xval, yval);
+	if(xkey == NULL && ykey == NULL)
+		return equalINodes((INode*)xval, (INode*)yval, shift + NODE_LOG_SIZE, equal);
+	if(xkey == NULL)
+		return equalEntryNode(ykey, yval, (INode*)xval, shift + NODE_LOG_SIZE, equal);
+	return equalEntryNode(xkey, xval, (INode*)yval, shift + NODE_LOG_SIZE, equal);
+}
+
+// Compares the entries under two nodes at the same shift.  Maps that share structure share whole subtrees, which are
+// equal without looking inside them.  Nodes with the same layout are compared slot by slot, and any others by looking
+// up each of x's entries in y.
+static bool equalINodes(const INode *x, const INode *y, size_t shift, bool (*equal)(const lisp_object*, const lisp_object*)) {
+	if(x == y)
+		return true;
+	if(x->type == BMI_NODE_type && y->type == BMI_NODE_type) {
+		const BitmapIndexedNode *bx = (BitmapIndexedNode*)x;
+		const BitmapIndexedNode *by = (BitmapIndexedNode*)y;
+		if(bx->bitmap == by->bitmap) {
+			for(size_t i = 0; i < countBMINode(bx); i += 2)
+				if(!equalSlots(bx->array[i], bx->array[i+1], by->array[i], by->array[i+1], shift, equal))
+					return false;
+			return true;
+		}
+	} else if(x->type == ARRAY_NODE_type && y->type == ARRAY_NODE_type) {
+		const ArrayNode *ax = (ArrayNode*)x;
+		const ArrayNode *ay = (ArrayNode*)y;
+		if(ax->bitmap == ay->bitmap) {
+			for(size_t i = 0; i < NODE_SIZE; i++)
+				if(ax->array[i] && !equalINodes(ax->array[i], ay->array[i], shift + NODE_LOG_SIZE, equal))
+					return false;
+			return true;
+		}
+	}
+
+	size_t n = 0;
+	for(const ISeq *s = x->fns->nodeSeq(x); s != NULL; s = s->obj.fns->ISeqFns->next(s), n++) {
+		const MapEntry *e = (MapEntry*) s->obj.fns->ISeqFns->first(s);
+		const MapEntry *me = y->fns->find(y, shift, HashEq(e->key), e->key);
+		if(me == NULL || !equal(e->val, me->val))
+			return false;
+	}
+	return n == countNode(y);
+}
+
+static bool equalHashMaps(const HashMap *x, const HashMap *y, bool (*equal)(const lisp_object*, const lisp_object*)) {
+	if(x->count != y->count || x->hasNull != y->hasNull)
+		return false;
+	if(x->hash != 0 && y->hash != 0 && x->hash != y->hash)
+		return false;
+	if(x->hasNull && !equal(x->nullValue, y->nullValue))
+		return false;
+	if(x->root == NULL || y->root == NULL)
+		return true;	// Equal counts leave both roots empty.
+	return equalINodes(x->root, y->root, 0, equal);
+}
+
 const HashMap *CreateHashMap(size_t count, const lisp_object **entries) {
 	TransientHashMap *ret = asTransient(EmptyHashMap);
 	for(size_t i=0; i<count; i+=2) {
@@ -796,7 +1364,6 @@ static const HashMap *NewHashMap(int count, const INode* root, bool hasNull, con
 	HashMap *ret = GC_MALLOC(sizeof(*ret));
 	ret->obj.type = HASHMAP_type;
 	ret->obj.size = sizeof(HashMap);
-	ret->obj.toString = toString;
 	ret->obj.fns = &HashMap_interfaces;
 	memcpy((void*) &(ret->count), &count, sizeof(count));
 	memcpy((void*) &(ret->root), &root, sizeof(root));
@@ -809,9 +1376,8 @@ static const HashMap *NewHashMap(int count, const INode* root, bool hasNull, con
 static TransientHashMap *asTransient(const HashMap *const hm) {
 	TransientHashMap *thm = GC_MALLOC(sizeof(*thm));
 	thm->obj.type = TRANSIENTHASHMAP_type;
-	thm->obj.toString = NULL;
-	thm->edit = true;
-	thm->thread_id = pthread_self();
+	thm->edit.editable = true;
+	thm->edit.thread_id = pthread_self();
 	thm->root = (INode*)(hm->root);
 	thm->count = hm->count;
 	thm->hasNull = hm->hasNull;
@@ -826,7 +1392,7 @@ const ISeq *seqHashMap(const Seqable *obj) {
 
 	const ISeq *s = (hm->root ? hm->root->fns->nodeSeq(hm->root) : NULL);
 
-	return hm->hasNull ? (const ISeq*) NewCons(hm->nullValue, s) : s;
+	return hm->hasNull ? (const ISeq*) NewCons((lisp_object*)NewMapEntry(NULL, hm->nullValue), s) : s;
 }
 
 static const ICollection* emptyHashMap(void) {
@@ -837,7 +1403,9 @@ static bool EquivHashMap(const ICollection *ic, const lisp_object *obj) {
 	assert(ic->obj.type == HASHMAP_type);
 	const HashMap *hm = (const HashMap*) ic;
 
+	if((lisp_object*)hm == obj) return true;
 	if(!isIMap(obj)) return false;
+	if(obj->type == HASHMAP_type) return equalHashMaps(hm, (HashMap*)obj, Equiv);
 
 	const IMap *im = (IMap*) obj;
 	if(im->obj.fns->ICollectionFns->count((const ICollection*)im) != hm->count) return false;
@@ -861,13 +1429,7 @@ static const lisp_object* invoke2HashMap(const IFn *f, const lisp_object *key, c
 	assert(f->obj.type == HASHMAP_type);
 	const HashMap *hm = (HashMap*) f;
 
-	if(key == NULL)
-		return hm->hasNull ? hm->nullValue : NotFound;
-	if(hm->root) {
-		const MapEntry *me = hm->root->fns->find(hm->root, 0, HashEq(key), key);
-		return me ? me->val : NotFound;
-	}
-	return NotFound;
+	return valAtHashMap((IMap*)hm, key, NotFound);
 }
 
 static size_t countHashMap(const ICollection *ic) {
@@ -882,7 +1444,7 @@ static bool containsKeyHashMap(const IMap *im, const lisp_object *key) {
 
 	if(key == NULL)
 		return hm->hasNull;
-	return hm->root ? hm->root->fns->find(hm->root, 0, HashEq(key), key) == NULL : false;
+	return findSlot(hm->root, 0, HashEq(key), key) != NULL;
 }
 
 static const IMap* assocHashMap(const IMap *im, const lisp_object *key, const lisp_object *val) {
@@ -899,7 +1461,7 @@ static const IMap* assocHashMap(const IMap *im, const lisp_object *key, const li
 	const INode *newRoot = hm->root ? hm->root : (INode*) EmptyBMINode;
 	newRoot = newRoot->fns->assoc(newRoot, 0, HashEq(key), key, val, &addedLeaf);
 	if(newRoot == hm->root) return im;
-	return (IMap*) NewHashMap(hm->count + (addedLeaf ? 0 :1), newRoot, hm->hasNull, hm->nullValue);
+	return (IMap*) NewHashMap(hm->count + (addedLeaf ? 1 : 0), newRoot, hm->hasNull, hm->nullValue);
 }
 
 static const IMap* withoutHashMap(const IMap *im, const lisp_object *key) {
@@ -913,6 +1475,8 @@ static const IMap* withoutHashMap(const IMap *im, const lisp_object *key) {
 
 	const INode *newRoot = hm->root;
 	newRoot = newRoot->fns->without(newRoot, 0, HashEq(key), key);
+	if(newRoot == hm->root)
+		return im;
 
 	return (IMap*) NewHashMap(hm->count - 1, newRoot, hm->hasNull, hm->nullValue);
 }
@@ -927,6 +1491,17 @@ static const MapEntry* entryAtHashMap(const IMap *im, const lisp_object *key) {
 	return hm->root ? hm->root->fns->find(hm->root, 0, HashEq(key), key) : NULL;
 }
 
+static const lisp_object* valAtHashMap(const IMap *im, const lisp_object *key, const lisp_object *NotFound) {
+	assert(im->obj.type == HASHMAP_type);
+	const HashMap *hm = (const HashMap*) im;
+
+	if(key == NULL)
+		return hm->hasNull ? hm->nullValue : NotFound;
+
+	const lisp_object *const *slot = findSlot(hm->root, 0, HashEq(key), key);
+	return slot ? slot[1] : NotFound;
+}
+
 static const IMap* consHashMap(const IMap *im, const lisp_object *obj) {
 	assert(im->obj.type == HASHMAP_type);
 	const HashMap *ret = (const HashMap*) im;
@@ -948,6 +1523,269 @@ static const IMap* consHashMap(const IMap *im, const lisp_object *obj) {
 	return (IMap*) ret;
 }
 
+const lisp_object* kvreduceHashMap(const HashMap *hm, const IFn *f, const lisp_object *init) {
+	assert(hm->obj.type == HASHMAP_type);
+	const lisp_object *acc = init;
+	if(hm->hasNull)
+		acc = f->obj.fns->IFnFns->invoke3(f, acc, NULL, hm->nullValue);
+	return hm->root ? hm->root->fns->kvreduce(hm->root, f, acc) : acc;
+}
+
+const lisp_object* foldHashMap(const HashMap *hm, size_t n, const IFn *combinef, const IFn *reducef) {
+	assert(hm->obj.type == HASHMAP_type);
+	if(hm->count <= n)
+		return kvreduceHashMap(hm, reducef, combinef->obj.fns->IFnFns->invoke0(combinef));
+
+	// A map holding only the nil key has no root.
+	const lisp_object *acc = hm->root ? hm->root->fns->fold(hm->root, combinef, reducef)
+	                                  : combinef->obj.fns->IFnFns->invoke0(combinef);
+	if(hm->hasNull) {
+		const lisp_object *nullPart = combinef->obj.fns->IFnFns->invoke0(combinef);
+		nullPart = reducef->obj.fns->IFnFns->invoke3(reducef, nullPart, NULL, hm->nullValue);
+		acc = combinef->obj.fns->IFnFns->invoke2(combinef, acc, nullPart);
+	}
+	return acc;
+}
+
+// Merging walks both tries together, so each subtree that only one map has is taken whole, and so is any subtree the
+// two maps share when y's values simply replace x's.  added counts the keys y brings that x lacks, which fixes the
+// count of the result.  Only subtrees of y that x has nothing under are counted, since all their keys are added, so a
+// merge costs in proportion to how much the maps differ rather than to their size.
+
+static const INode *mergeNodes(const INode *x, const INode *y, size_t shift, const IFn *f, size_t *added);
+
+// The value for a key in both maps: y's, or (f xval yval).
+static const lisp_object *mergeVal(const IFn *f, const lisp_object *xval, const lisp_object *yval) {
+	return f ? f->obj.fns->IFnFns->invoke2(f, xval, yval) : yval;
+}
+
+// Puts key and val, an entry of y, into x.
+static const INode *mergeEntry(const INode *x, size_t shift, const lisp_object *key, const lisp_object *val, const IFn *f,
+		size_t *added) {
+	uint32_t hash = HashEq(key);
+	const lisp_object *const *slot = findSlot(x, shift, hash, key);
+	if(slot)
+		val = mergeVal(f, slot[1], val);
+	else
+		(*added)++;
+	bool addedLeaf = false;
+	return x->fns->assoc(x, shift, hash, key, val, &addedLeaf);
+}
+
+// Puts x's entry into y's sub-node, keeping y's value, or (f xval yval), where y has the key too.  The caller adds the
+// keys under y to added first, and this takes back the ones x already had.
+static const INode *mergeIntoEntry(const lisp_object *key, const lisp_object *val, const INode *y, size_t shift,
+		const IFn *f, size_t *added) {
+	uint32_t hash = HashEq(key);
+	const lisp_object *const *slot = findSlot(y, shift, hash, key);
+	if(slot) {
+		(*added)--;
+		if(f == NULL)
+			return y;
+		val = mergeVal(f, val, slot[1]);
+	}
+	bool addedLeaf = false;
+	return y->fns->assoc(y, shift, hash, key, val, &addedLeaf);
+}
+
+// Merges two BitmapIndexedNode slots for the same bit into key and val.  Each slot holds either a key and its value, or
+// a NULL key and the sub-node under the bit.
+static void mergeSlots(const lisp_object *xkey, const lisp_object *xval, const lisp_object *ykey, const lisp_object *yval,
+		size_t shift, const IFn *f, size_t *added, const lisp_object **key, const lisp_object **val) {
+	*key = NULL;
+	if(xkey != NULL && ykey != NULL) {
+		if(Equiv(xkey, ykey)) {
+			*key = xkey;
+			*val = mergeVal(f, xval, yval);
+		} else {
+			(*added)++;
+			*val = (lisp_object*) createNode(NULL, shift + NODE_LOG_SIZE, xkey, xval, HashEq(ykey), ykey, yval);
+		}
+	} else if(xkey == NULL && ykey == NULL) {
+		*val = (lisp_object*) mergeNodes((INode*)xval, (INode*)yval, shift + NODE_LOG_SIZE, f, added);
+	} else if(xkey == NULL) {
+		*val = (lisp_object*) mergeEntry((INode*)xval, shift + NODE_LOG_SIZE, ykey, yval, f, added);
+	} else {
+		*added += countNode((INode*)yval);
+		*val = (lisp_object*) mergeIntoEntry(xkey, xval, (INode*)yval, shift + NODE_LOG_SIZE, f, added);
+	}
+}
+
+// The children of a node as an ArrayNode would hold them, each inline entry of a BitmapIndexedNode getting a node of
+// its own.
+static void nodeChildren(const INode *node, size_t shift, const INode **children) {
+	if(node->type == ARRAY_NODE_type) {
+		memcpy(children, ((ArrayNode*)node)->array, NODE_SIZE * sizeof(*children));
+		return;
+	}
+	assert(node->type == BMI_NODE_type);
+	const BitmapIndexedNode *BMI_node = (BitmapIndexedNode*)node;
+	for(size_t i = 0, j = 0; i < NODE_SIZE; i++) {
+		children[i] = NULL;
+		if((BMI_node->bitmap >> i) & 1) {
+			const lisp_object *key = BMI_node->array[j];
+			const lisp_object *val = BMI_node->array[j+1];
+			bool addedLeaf = false;
+			children[i] = key ? assocBitmapIndexed_Node((INode*)EmptyBMINode, shift + NODE_LOG_SIZE, HashEq(key), key, val, &addedLeaf)
+							  : (INode*)val;
+			j += 2;
+		}
+	}
+}
+
+// Merges y into x, two nodes at the same shift.  Returns x itself when y adds nothing to it.
+static const INode *mergeNodes(const INode *x, const INode *y, size_t shift, const IFn *f, size_t *added) {
+	if(x == y && f == NULL)
+		return x;	// Adds nothing, so is not walked.
+	if(y->type == COLLISIONNODE_type) {
+		const CollisionNode *cnode = (CollisionNode*)y;
+		for(size_t i = 0; i < 2*cnode->count; i += 2)
+			x = mergeEntry(x, shift, cnode->array[i], cnode->array[i+1], f, added);
+		return x;
+	}
+	if(x->type == COLLISIONNODE_type) {
+		const CollisionNode *cnode = (CollisionNode*)x;
+		*added += countNode(y);
+		for(size_t i = 0; i < 2*cnode->count; i += 2)
+			y = mergeIntoEntry(cnode->array[i], cnode->array[i+1], y, shift, f, added);
+		return y;
+	}
+
+	if(x->type == BMI_NODE_type && y->type == BMI_NODE_type) {
+		const BitmapIndexedNode *bx = (BitmapIndexedNode*)x;
+		const BitmapIndexedNode *by = (BitmapIndexedNode*)y;
+		uint32_t bitmap = bx->bitmap | by->bitmap;
+		if(popcount(bitmap) <= NODE_SIZE / 2) {		// Else too full for a BitmapIndexedNode, as in assoc.
+			const lisp_object *array[NODE_SIZE];
+			size_t n = 0;
+			for(size_t i = 0; i < NODE_SIZE; i++) {
+				uint32_t bit = 1u << i;
+				if(!(bitmap & bit))
+					continue;
+				const lisp_object *const *xslot = &bx->array[2*index(bx->bitmap, bit)];
+				const lisp_object *const *yslot = &by->array[2*index(by->bitmap, bit)];
+				if(!(by->bitmap & bit)) {
+					array[n] = xslot[0];
+					array[n+1] = xslot[1];
+				} else if(!(bx->bitmap & bit)) {
+					array[n] = yslot[0];
+					array[n+1] = yslot[1];
+					*added += yslot[0] ? 1 : countNode((INode*)yslot[1]);
+				} else {
+					mergeSlots(xslot[0], xslot[1], yslot[0], yslot[1], shift, f, added, &array[n], &array[n+1]);
+				}
+				n += 2;
+			}
+			if(bitmap == bx->bitmap && memcmp(array, bx->array, n * sizeof(*array)) == 0)
+				return x;
+			return (INode*) NewBMINode(NULL, bitmap, array);
+		}
+	}
+
+	const INode *xs[NODE_SIZE], *ys[NODE_SIZE], *array[NODE_SIZE];
+	nodeChildren(x, shift, xs);
+	nodeChildren(y, shift, ys);
+	for(size_t i = 0; i < NODE_SIZE; i++) {
+		if(xs[i] == NULL) {
+			array[i] = ys[i];
+			if(ys[i])
+				*added += countNode(ys[i]);
+		} else if(ys[i] == NULL) {
+			array[i] = xs[i];
+		} else {
+			array[i] = mergeNodes(xs[i], ys[i], shift + NODE_LOG_SIZE, f, added);
+		}
+	}
+	if(x->type == ARRAY_NODE_type && memcmp(array, xs, sizeof(array)) == 0)
+		return x;
+	return (INode*) NewArrayNode(NULL, array);
+}
+
+static const HashMap *mergeHashMaps(const HashMap *x, const HashMap *y, const IFn *f) {
+	assert(x->obj.type == HASHMAP_type && y->obj.type == HASHMAP_type);
+	if(y->count == 0)
+		return x;
+	if(x->count == 0 && f == NULL)
+		return y;
+
+	size_t added = 0;
+	const INode *root = x->root;
+	if(root == NULL) {
+		root = y->root;
+		added = y->count - y->hasNull;
+	} else if(y->root != NULL) {
+		root = mergeNodes(x->root, y->root, 0, f, &added);
+	}
+
+	bool hasNull = x->hasNull || y->hasNull;
+	const lisp_object *nullValue = x->nullValue;
+	if(y->hasNull) {
+		nullValue = x->hasNull ? mergeVal(f, x->nullValue, y->nullValue) : y->nullValue;
+		if(!x->hasNull)
+			added++;
+	}
+	if(root == x->root && hasNull == x->hasNull && nullValue == x->nullValue)
+		return x;
+	return NewHashMap(x->count + added, root, hasNull, nullValue);
+}
+
+const HashMap* mergeHashMap(const HashMap *x, const HashMap *y) {
+	return mergeHashMaps(x, y, NULL);
+}
+
+const HashMap* mergeWithHashMap(const IFn *f, const HashMap *x, const HashMap *y) {
+	return mergeHashMaps(x, y, f);
+}
+
+const HashMap* selectKeysHashMap(const HashMap *hm, const lisp_object *keys) {
+	assert(hm->obj.type == HASHMAP_type);
+	TransientHashMap *ret = asTransient(EmptyHashMap);
+	for(const ISeq *s = seq(keys); s != NULL; s = s->obj.fns->ISeqFns->next(s)) {
+		const lisp_object *key = s->obj.fns->ISeqFns->first(s);
+		if(key == NULL) {
+			if(hm->hasNull)
+				ret = assocTHM(ret, NULL, hm->nullValue);
+			continue;
+		}
+		const lisp_object *const *slot = findSlot(hm->root, 0, HashEq(key), key);
+		if(slot)
+			ret = assocTHM(ret, slot[0], slot[1]);
+	}
+	if(ret->count == hm->count)
+		return hm;		// Every key was selected.
+	return asPersistent(ret);
+}
+
+void initKeyLookupSite(KeyLookupSite *site, const lisp_object *key) {
+	site->key = key;
+	site->hash = HashEq(key);
+	site->map = NULL;
+	site->val = NULL;
+	site->found = false;
+	site->idx = 0;
+}
+
+const lisp_object* siteLookupHashMap(const HashMap *hm, KeyLookupSite *site, const lisp_object *NotFound) {
+	assert(hm->obj.type == HASHMAP_type);
+	if(site->map != (lisp_object*)hm) {
+		const lisp_object *const *slot = findSlot(hm->root, 0, site->hash, site->key);
+		site->map = (lisp_object*)hm;
+		site->found = slot != NULL;
+		site->val = slot ? slot[1] : NULL;
+	}
+	return site->found ? site->val : NotFound;
+}
+
+static uint32_t HashEqHashMap(const lisp_object *obj) {
+	assert(obj->type == HASHMAP_type);
+	HashMap *hm = (HashMap*)obj;
+	if(hm->count == 0)
+		return mixCollHash(0, 0);
+	if(hm->hash == 0)
+		hm->hash = hashUnordered(obj);
+	return hm->hash;
+}
+
 static bool EqualsHashMap(const lisp_object *x, const lisp_object *y) {
 	assert(x->type == HASHMAP_type);
 	const HashMap *hm = (HashMap*)x;
@@ -955,6 +1793,8 @@ static bool EqualsHashMap(const lisp_object *x, const lisp_object *y) {
 		return true;
 	if(!isIMap(y))
 		return false;
+	if(y->type == HASHMAP_type)
+		return equalHashMaps(hm, (HashMap*)y, Equals);
 	const IMap *im = (IMap*) y;
 
 	if(countHashMap((ICollection*)hm) != im->obj.fns->ICollectionFns->count((ICollection*)im))
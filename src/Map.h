@@ -1,11 +1,42 @@
 #ifndef MAP_H
 #define MAP_H
 
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "Interfaces.h"
 #include "LispObject.h"
 
 typedef struct HashMap_struct HashMap;
 
+// Per call site state for looking up a constant key, e.g. (:k m).  It remembers the key's hash, and the last map looked
+// up with what the key maps to there.  Maps never change, so looking up the same map again is one compare, at the cost
+// of keeping that map alive.  Any other HashMap is searched with the cached hash.  For an ArrayMap it also remembers
+// the entry index, where maps built the same way hold the key too.
+typedef struct {	// KeyLookupSite
+	const lisp_object *key;
+	uint32_t hash;
+	const lisp_object *map;	// The map last looked up.  NULL if there is none.
+	const lisp_object *val;	// key's value in map.
+	bool found;				// Whether map holds key.
+	size_t idx;				// Of key's entry in the last ArrayMap that held it.
+} KeyLookupSite;
+
 const HashMap *CreateHashMap(size_t count, const lisp_object **entries);
+// Calls (f acc key val) on each entry in turn, starting from init, and returns the last result.
+const lisp_object* kvreduceHashMap(const HashMap *hm, const IFn *f, const lisp_object *init);
+// Reduces parts of the map with reducef, each part starting from (combinef), and joins the parts with
+// (combinef left right).  The parts may be reduced in parallel.  A map of at most n entries is reduced as one part.
+const lisp_object* foldHashMap(const HashMap *hm, size_t n, const IFn *combinef, const IFn *reducef);
+// Bulk operations walk the tries of both maps together, reusing every subtree that the result shares with either map
+// rather than adding entries one at a time.  mergeHashMap takes y's value for a key in both maps, and mergeWithHashMap
+// takes (f xval yval).
+const HashMap* mergeHashMap(const HashMap *x, const HashMap *y);
+const HashMap* mergeWithHashMap(const IFn *f, const HashMap *x, const HashMap *y);
+// The entries of hm whose keys are in the seqable keys.
+const HashMap* selectKeysHashMap(const HashMap *hm, const lisp_object *keys);
+void initKeyLookupSite(KeyLookupSite *site, const lisp_object *key);
+const lisp_object* siteLookupHashMap(const HashMap *hm, KeyLookupSite *site, const lisp_object *NotFound);
 
 extern const HashMap _EmptyHashMap;
 const HashMap *const EmptyHashMap;
@@ -1,10 +1,13 @@
 #include "MapEntry.h"
 
+#include <assert.h>
+
 #include "AFn.h"
 #include "AVector.h"
 #include "Error.h"
 #include "gc.h"
 #include "Interfaces.h"
+#include "Murmur3.h"
 #include "Util.h"
 #include "Vector.h"
 
@@ -16,6 +19,7 @@ static size_t lengthMapEntry(const IVector*);
 static const IVector* assocNMapEntry(const IVector*, size_t, const lisp_object*);
 static const IVector* consMapEntry(const IVector*, const lisp_object*);
 static const lisp_object* nthMapEntry(const IVector*, size_t n, const lisp_object *NotFound);
+static uint32_t HashEqMapEntry(const lisp_object *obj);
 
 const Seqable_vtable MapEntry_Seqable_vtable = {
 	seqMapEntry, // seq
@@ -65,14 +69,16 @@ interfaces MapEntry_interfaces = {
 	&MapEntry_IFn_vtable,			// IFnFns
 	&MapEntry_IVector_vtable,		// IVectorFns
 	NULL,							// IMapFns
+	NULL,							// ISetFns
+	toString,						// toString
+	EqualsAVector,					// Equals
+	HashEqMapEntry,					// HashEq
 };
 
 const MapEntry* NewMapEntry(const lisp_object *key, const lisp_object *val) {
 	MapEntry *ret = GC_MALLOC(sizeof(*ret));
 	ret->obj.type = MAPENTRY_type;
 	ret->obj.size = sizeof(*ret);
-	ret->obj.toString = toString;
-	ret->obj.Equals = EqualsAVector;
 	ret->obj.fns = &MapEntry_interfaces;
 
 	ret->key = key;
@@ -137,3 +143,10 @@ static const lisp_object* nthMapEntry(const IVector *iv, size_t n, __attribute__
 	Raise(e);
 	__builtin_unreachable();
 }
+
+// Hashes as the vector [key val], without building it.
+static uint32_t HashEqMapEntry(const lisp_object *obj) {
+	assert(obj->type == MAPENTRY_type);
+	const MapEntry *e = (MapEntry*)obj;
+	return mixCollHash(31 * (31 + HashEq(e->key)) + HashEq(e->val), 2);
+}
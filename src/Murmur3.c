@@ -14,24 +14,32 @@ static inline uint32_t fmix(uint32_t h) {
 	return h;
 }
 
+static const uint32_t c1 = 0xcc9e2d51;
+static const uint32_t c2 = 0x1b873593;
+static const uint32_t c3 = 0xe6546b64;
+
+static inline uint32_t mixK1(uint32_t k1) {
+	k1 *= c1;
+	k1 = rotl(k1, 15);
+	k1 *= c2;
+	return k1;
+}
+
+static inline uint32_t mixH1(uint32_t h1, uint32_t k1) {
+	h1 ^= k1;
+	h1 = rotl(h1, 13);
+	h1 = h1 *5 + c3;
+	return h1;
+}
+
 uint32_t hash32(const void *key, size_t len) {
 	const uint8_t *data = (uint8_t*) key;
 	const size_t nblocks = len / 4;
 	uint32_t h1 = 0;
-	const uint32_t c1 = 0xcc9e2d51;
-	const uint32_t c2 = 0x1b873593;
-	const uint32_t c3 = 0xe6546b64;
 
 	const uint32_t *block = (uint32_t*)data;
 	for(size_t i = 0; i<nblocks; i++) {
-		uint32_t k1 = *(block++);
-		k1 *= c1;
-		k1 = rotl(k1, 15);
-		k1 *= c2;
-
-		h1 ^= k1;
-		h1 = rotl(h1, 13);
-		h1 = h1 *5 + c3;
+		h1 = mixH1(h1, mixK1(*(block++)));
 	}
 
 	const uint8_t *tail = data + 4*nblocks;
@@ -41,12 +49,13 @@ uint32_t hash32(const void *key, size_t len) {
 		case 2: k1 ^= tail[1] << 8;
 		case 1: k1 ^= tail[0];
 
-		k1 *= c1;
-		k1 = rotl(k1, 15);
-		k1 *= c2;
-		h1 ^= k1;
+		h1 ^= mixK1(k1);
 	}
 
 	h1 ^= (uint32_t)len;
 	return fmix(h1);
 }
+
+uint32_t mixCollHash(uint32_t hash, size_t count) {
+	return fmix(mixH1(0, mixK1(hash)) ^ (uint32_t)count);
+}
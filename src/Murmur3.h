@@ -2,3 +2,5 @@
 #include <stddef.h>
 
 uint32_t hash32(const void *key, size_t len);
+// Finishes the hash of a collection of count elements, where hash combines the elements' hashes.
+uint32_t mixCollHash(uint32_t hash, size_t count);
@@ -21,17 +21,15 @@ static Namespace *NewNamespace(const Symbol *s);
 static const char *toStringNamespace(const lisp_object *);
 
 Namespace *findNS(const Symbol *s) {
-	const MapEntry *me = namespaces->obj.fns->IMapFns->entryAt(namespaces, (lisp_object*)s);
-	if(me == NULL)
+	const lisp_object *ret = namespaces->obj.fns->IMapFns->valAt(namespaces, (lisp_object*)s, NULL);
+	if(ret == NULL)
 		return NULL;
-	const lisp_object *ret = me->val;
 	assert(ret->type == NAMESPACE_type);
 	return (Namespace*)ret;
 }
 
 Namespace *findOrCreateNS(const Symbol *s) {
-	const MapEntry *me = namespaces->obj.fns->IMapFns->entryAt(namespaces, (const lisp_object*)s);
-	const lisp_object *obj = me ? me->val: NULL;
+	const lisp_object *obj = namespaces->obj.fns->IMapFns->valAt(namespaces, (const lisp_object*)s, NULL);
 	if(obj != NULL) {
 		assert(obj->type == NAMESPACE_type);
 		return (Namespace*) obj;
@@ -43,8 +41,7 @@ Namespace *findOrCreateNS(const Symbol *s) {
 
 Namespace *lookupAlias(Namespace *ns, const Symbol *alias) {
 	const IMap *map = ns->aliases;
-	const MapEntry *me = map->obj.fns->IMapFns->entryAt(map, (lisp_object*)alias);
-	const lisp_object *ret = me ? me->val : NULL;
+	const lisp_object *ret = map->obj.fns->IMapFns->valAt(map, (lisp_object*)alias, NULL);
 	assert(ret->type == NAMESPACE_type);
 	return (Namespace*)ret;
 }
@@ -83,9 +80,9 @@ Var *internNS(Namespace *ns, const Symbol *s) {
 		Raise(e);
 	}
 	const IMap *map = ns->mappings;
-	const MapEntry *me = map->obj.fns->IMapFns->entryAt(map, (const lisp_object*)s);
-	if(me && me->val)
-		return (Var*) me->val;
+	const lisp_object *obj = map->obj.fns->IMapFns->valAt(map, (const lisp_object*)s, NULL);
+	if(obj)
+		return (Var*) obj;
 	Var *v = NewVar(ns, s, NULL);
 	ns->mappings = map->obj.fns->IMapFns->assoc(map, (const lisp_object*)s, (const lisp_object*)v);
 	return v;
@@ -93,9 +90,8 @@ Var *internNS(Namespace *ns, const Symbol *s) {
 
 Var *findInternedVar(const Namespace *ns, const Symbol *s) {
 	const IMap *map = ns->mappings;
-	const MapEntry *me = map->obj.fns->IMapFns->entryAt(map, (lisp_object*)s);
-	const lisp_object *obj = me ? me->val : NULL;
-	if(obj && (obj->type == VAR_type)) {
+	const lisp_object *obj = map->obj.fns->IMapFns->valAt(map, (lisp_object*)s, NULL);
+	if(obj && (objectType(obj) == VAR_type)) {
 		Var *ret = (Var*)obj;
 	   	if(getNamespaceVar(ret) == ns)
 			return ret;
@@ -105,15 +101,28 @@ Var *findInternedVar(const Namespace *ns, const Symbol *s) {
 
 const lisp_object* getMapping(const Namespace *ns, const Symbol *s) {
 	const IMap *m = ns->mappings;
-	const MapEntry *me = m->obj.fns->IMapFns->entryAt(m, (lisp_object*)s);
-	return me ? me->val : NULL;
+	return m->obj.fns->IMapFns->valAt(m, (lisp_object*)s, NULL);
 }
 
+static const interfaces Namespace_interfaces = {
+	NULL,				// SeqableFns
+	NULL,				// ReversibleFns
+	NULL,				// ICollectionFns
+	NULL,				// IStackFns
+	NULL,				// ISeqFns
+	NULL,				// IFnFns
+	NULL,				// IVectorFns
+	NULL,				// IMapFns
+	NULL,				// ISetFns
+	toStringNamespace,	// toString
+	NULL,				// Equals
+	NULL,				// HashEq
+};
+
 static Namespace *NewNamespace(const Symbol *s) {
 	Namespace *ret = GC_MALLOC(sizeof(*ret));
 	ret->obj.type = NAMESPACE_type;
-	ret->obj.toString = toStringNamespace;
-	ret->obj.fns = &NullInterface;
+	ret->obj.fns = &Namespace_interfaces;
 	ret->name = s;
 	ret->mappings = (IMap*) EmptyHashMap;	// TODO This should be DEFAULT_IMPORTS.
 	ret->aliases = (IMap*) EmptyHashMap;
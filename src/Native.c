@@ -0,0 +1,1297 @@
+#define _DEFAULT_SOURCE	// MAP_ANONYMOUS
+
+#include "Native.h"
+
+#include <assert.h>
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+
+#include "AFn.h"
+#include "Bool.h"
+#include "Error.h"
+#include "gc.h"
+#include "Interfaces.h"
+#include "LineNumberReader.h"
+#include "List.h"
+#include "Numbers.h"
+#include "Reader.h"
+#include "Strings.h"
+#include "Symbol.h"
+#include "Util.h"
+#include "Var.h"
+#include "Vector.h"
+
+// Native x86-64 back end, following the incremental compiler in references/paper.pdf.
+// Every value is a 64 bit word.  The low bits carry the type:
+//		fixnum		xxxxxx00
+//		cons		xxxxx001
+//		closure		xxxxx110
+//		char		cccccccc 00001111
+//		false		00101111
+//		true		01101111
+//		nil			00111111
+//		()			01001111
+// %rax holds the current value, %rdi the current closure, and %r12 the heap pointer.  Stack slots are addressed
+// downwards from %rsp.  A callee finds its return address at 0(%rsp) and its arguments at -8(%rsp), -16(%rsp), ...
+//
+// The same code generator either writes assembly for the system assembler, or, as a template JIT, copies machine code
+// into executable pages.  The JIT has no heap, so it accepts fns that neither cons nor create closures.
+
+#define FX_SHIFT		2
+#define FX_MASK			3
+#define CHAR_SHIFT		8
+#define CHAR_MASK		0xFF
+#define CHAR_TAG		0x0F
+#define FALSE_VALUE		0x2F
+#define TRUE_VALUE		0x6F
+#define NIL_VALUE		0x3F
+#define EMPTY_VALUE		0x4F
+#define CONS_TAG		1
+#define CLOSURE_TAG		6
+#define WORD_SIZE		8
+#define RED_ZONE		128
+
+#define FX_MAX			((1L << (8 * WORD_SIZE - FX_SHIFT - 1)) - 1)
+#define FX_MIN			(-FX_MAX - 1)
+
+typedef enum {	// NativeBindingType
+	STACK_BINDING,
+	FREE_BINDING,
+	SELF_BINDING,
+} NativeBindingType;
+
+typedef struct NativeEnv_struct {	// NativeEnv
+	const char *name;
+	NativeBindingType type;
+	long index;
+	const struct NativeEnv_struct *next;
+} NativeEnv;
+
+typedef struct {	// LoopTarget
+	size_t label;
+	size_t count;
+	const long *slots;
+} LoopTarget;
+
+typedef struct Lambda_struct {	// Lambda
+	size_t label;
+	const char *self;
+	const lisp_object *params;
+	const ISeq *body;
+	size_t freeCount;
+	const char **free;
+	struct Lambda_struct *next;
+} Lambda;
+
+typedef struct {	// Fixup
+	size_t offset;
+	size_t label;
+} Fixup;
+
+typedef struct {	// Emitter
+	StringWriter *sw;
+	size_t labelCount;
+	Lambda *pending;
+	Lambda **pendingTail;
+	const IMap *ops;	// Maps operator symbols to the values they resolve to.  If NULL, primitives are found by name.
+	long frameSize;		// Bytes below %rbp that the current function stores to.
+	size_t frameLabel;
+
+	// Only used by the JIT.
+	bool jit;
+	uint8_t *code;
+	size_t size;
+	size_t capacity;
+	size_t *labels;
+	size_t labelCapacity;
+	Fixup *fixups;
+	size_t fixupCount;
+	size_t fixupCapacity;
+	size_t *frameFixups;	// Where the current function's frame size is patched in.
+	size_t frameFixupCount;
+	size_t frameFixupCapacity;
+} Emitter;
+
+#define MACHINE_CODE(bytes)	bytes, sizeof(bytes) - 1
+
+typedef struct {	// Primitive
+	const char *name;
+	size_t argc;
+	const char *code;		// Unary primitives work on %rax.  Binary primitives work on %rax and %rcx.
+	const char *machineCode;
+	size_t machineCodeSize;
+	const char *condition;	// If set, code only sets the flags, and the result is a boolean.
+	bool heap;
+} Primitive;
+
+static const Primitive primitives[] = {
+	{"fxadd1",		1, "addq $4, %rax",						MACHINE_CODE("\x48\x83\xC0\x04"), NULL, false},
+	{"inc",			1, "addq $4, %rax",						MACHINE_CODE("\x48\x83\xC0\x04"), NULL, false},
+	{"fxsub1",		1, "subq $4, %rax",						MACHINE_CODE("\x48\x83\xE8\x04"), NULL, false},
+	{"dec",			1, "subq $4, %rax",						MACHINE_CODE("\x48\x83\xE8\x04"), NULL, false},
+	{"fixnum->char",1, "shlq $6, %rax\n\torq $15, %rax",	MACHINE_CODE("\x48\xC1\xE0\x06\x48\x83\xC8\x0F"), NULL, false},
+	{"char->fixnum",1, "shrq $6, %rax",						MACHINE_CODE("\x48\xC1\xE8\x06"), NULL, false},
+	{"fxlognot",	1, "xorq $-4, %rax",					MACHINE_CODE("\x48\x83\xF0\xFC"), NULL, false},
+	{"car",			1, "movq -1(%rax), %rax",				MACHINE_CODE("\x48\x8B\x40\xFF"), NULL, true},
+	{"cdr",			1, "movq 7(%rax), %rax",				MACHINE_CODE("\x48\x8B\x40\x07"), NULL, true},
+	{"fixnum?",		1, "testq $3, %rax",					MACHINE_CODE("\x48\xA9\x03\x00\x00\x00"), "e", false},
+	{"fxzero?",		1, "cmpq $0, %rax",						MACHINE_CODE("\x48\x83\xF8\x00"), "e", false},
+	{"zero?",		1, "cmpq $0, %rax",						MACHINE_CODE("\x48\x83\xF8\x00"), "e", false},
+	{"nil?",		1, "cmpq $63, %rax",					MACHINE_CODE("\x48\x83\xF8\x3F"), "e", false},
+	{"null?",		1, "cmpq $79, %rax",					MACHINE_CODE("\x48\x83\xF8\x4F"), "e", false},
+	{"not",			1, "orq $16, %rax\n\tcmpq $63, %rax",	MACHINE_CODE("\x48\x83\xC8\x10\x48\x83\xF8\x3F"), "e", false},
+	{"boolean?",	1, "andq $191, %rax\n\tcmpq $47, %rax",	MACHINE_CODE("\x48\x25\xBF\x00\x00\x00\x48\x83\xF8\x2F"), "e", false},
+	{"char?",		1, "andq $255, %rax\n\tcmpq $15, %rax",	MACHINE_CODE("\x48\x25\xFF\x00\x00\x00\x48\x83\xF8\x0F"), "e", false},
+	{"pair?",		1, "andq $7, %rax\n\tcmpq $1, %rax",	MACHINE_CODE("\x48\x83\xE0\x07\x48\x83\xF8\x01"), "e", false},
+	{"fn?",			1, "andq $7, %rax\n\tcmpq $6, %rax",	MACHINE_CODE("\x48\x83\xE0\x07\x48\x83\xF8\x06"), "e", false},
+	{"procedure?",	1, "andq $7, %rax\n\tcmpq $6, %rax",	MACHINE_CODE("\x48\x83\xE0\x07\x48\x83\xF8\x06"), "e", false},
+	{"fx+",			2, "addq %rcx, %rax",					MACHINE_CODE("\x48\x01\xC8"), NULL, false},
+	{"+",			2, "addq %rcx, %rax",					MACHINE_CODE("\x48\x01\xC8"), NULL, false},
+	{"fx-",			2, "subq %rcx, %rax",					MACHINE_CODE("\x48\x29\xC8"), NULL, false},
+	{"-",			2, "subq %rcx, %rax",					MACHINE_CODE("\x48\x29\xC8"), NULL, false},
+	{"fx*",			2, "sarq $2, %rax\n\timulq %rcx, %rax",	MACHINE_CODE("\x48\xC1\xF8\x02\x48\x0F\xAF\xC1"), NULL, false},
+	{"*",			2, "sarq $2, %rax\n\timulq %rcx, %rax",	MACHINE_CODE("\x48\xC1\xF8\x02\x48\x0F\xAF\xC1"), NULL, false},
+	{"fxlogand",	2, "andq %rcx, %rax",					MACHINE_CODE("\x48\x21\xC8"), NULL, false},
+	{"fxlogor",		2, "orq %rcx, %rax",					MACHINE_CODE("\x48\x09\xC8"), NULL, false},
+	{"cons",		2, "movq %rax, 0(%r12)\n\tmovq %rcx, 8(%r12)\n\tleaq 1(%r12), %rax\n\taddq $16, %r12",
+		MACHINE_CODE("\x49\x89\x04\x24\x49\x89\x4C\x24\x08\x49\x8D\x44\x24\x01\x49\x83\xC4\x10"), NULL, true},
+	{"set-car!",	2, "movq %rcx, -1(%rax)",				MACHINE_CODE("\x48\x89\x48\xFF"), NULL, true},
+	{"set-cdr!",	2, "movq %rcx, 7(%rax)",				MACHINE_CODE("\x48\x89\x48\x07"), NULL, true},
+	{"fx=",			2, "cmpq %rcx, %rax",					MACHINE_CODE("\x48\x39\xC8"), "e", false},
+	{"=",			2, "cmpq %rcx, %rax",					MACHINE_CODE("\x48\x39\xC8"), "e", false},
+	{"fx<",			2, "cmpq %rcx, %rax",					MACHINE_CODE("\x48\x39\xC8"), "l", false},
+	{"<",			2, "cmpq %rcx, %rax",					MACHINE_CODE("\x48\x39\xC8"), "l", false},
+	{"fx<=",		2, "cmpq %rcx, %rax",					MACHINE_CODE("\x48\x39\xC8"), "le", false},
+	{"<=",			2, "cmpq %rcx, %rax",					MACHINE_CODE("\x48\x39\xC8"), "le", false},
+	{"fx>",			2, "cmpq %rcx, %rax",					MACHINE_CODE("\x48\x39\xC8"), "g", false},
+	{">",			2, "cmpq %rcx, %rax",					MACHINE_CODE("\x48\x39\xC8"), "g", false},
+	{"fx>=",		2, "cmpq %rcx, %rax",					MACHINE_CODE("\x48\x39\xC8"), "ge", false},
+	{">=",			2, "cmpq %rcx, %rax",					MACHINE_CODE("\x48\x39\xC8"), "ge", false},
+	{"char=",		2, "cmpq %rcx, %rax",					MACHINE_CODE("\x48\x39\xC8"), "e", false},
+	{"char<",		2, "cmpq %rcx, %rax",					MACHINE_CODE("\x48\x39\xC8"), "l", false},
+	{"char<=",		2, "cmpq %rcx, %rax",					MACHINE_CODE("\x48\x39\xC8"), "le", false},
+	{"char>",		2, "cmpq %rcx, %rax",					MACHINE_CODE("\x48\x39\xC8"), "g", false},
+	{"char>=",		2, "cmpq %rcx, %rax",					MACHINE_CODE("\x48\x39\xC8"), "ge", false},
+};
+
+static const char *const startup =
+	"#include <stdio.h>\n"
+	"#include <stdlib.h>\n"
+	"\n"
+	"long lisp_entry(char *heap);\n"
+	"\n"
+	"static void print(long x) {\n"
+	"	if((x & 3) == 0) {\n"
+	"		printf(\"%ld\", x >> 2);\n"
+	"	} else if((x & 0xFF) == 0x0F) {\n"
+	"		char c = (char)(x >> 8);\n"
+	"		switch(c) {\n"
+	"			case ' ': printf(\"\\\\space\"); break;\n"
+	"			case '\\n': printf(\"\\\\newline\"); break;\n"
+	"			case '\\t': printf(\"\\\\tab\"); break;\n"
+	"			case '\\r': printf(\"\\\\return\"); break;\n"
+	"			default: printf(\"\\\\%c\", c);\n"
+	"		}\n"
+	"	} else if(x == 0x2F) {\n"
+	"		printf(\"false\");\n"
+	"	} else if(x == 0x6F) {\n"
+	"		printf(\"true\");\n"
+	"	} else if(x == 0x3F) {\n"
+	"		printf(\"nil\");\n"
+	"	} else if(x == 0x4F) {\n"
+	"		printf(\"()\");\n"
+	"	} else if((x & 7) == 1) {\n"
+	"		printf(\"(\");\n"
+	"		for(;;) {\n"
+	"			print(*(long*)(x - 1));\n"
+	"			x = *(long*)(x + 7);\n"
+	"			if(x == 0x4F || x == 0x3F) break;\n"
+	"			if((x & 7) != 1) {\n"
+	"				printf(\" . \");\n"
+	"				print(x);\n"
+	"				break;\n"
+	"			}\n"
+	"			printf(\" \");\n"
+	"		}\n"
+	"		printf(\")\");\n"
+	"	} else if((x & 7) == 6) {\n"
+	"		printf(\"#<fn>\");\n"
+	"	} else {\n"
+	"		printf(\"#<unknown 0x%08lx>\", x);\n"
+	"	}\n"
+	"}\n"
+	"\n"
+	"int main(void) {\n"
+	"	char *heap = calloc(1 << 24, 1);\n"
+	"	if(heap == NULL) return 1;\n"
+	"	print(lisp_entry(heap));\n"
+	"	printf(\"\\n\");\n"
+	"	return 0;\n"
+	"}\n";
+
+static void emit(Emitter *em, const char *format, ...) {
+	char buf[256];
+	va_list argp;
+	va_start(argp, format);
+	vsnprintf(buf, sizeof(buf), format, argp);
+	va_end(argp);
+	AddString(em->sw, buf);
+	AddChar(em->sw, '\n');
+}
+
+static size_t uniqueLabel(Emitter *em) {
+	if(em->jit && em->labelCount == em->labelCapacity) {
+		em->labelCapacity = em->labelCapacity ? 2 * em->labelCapacity : 16;
+		em->labels = GC_REALLOC(em->labels, em->labelCapacity * sizeof(*em->labels));
+	}
+	return em->labelCount++;
+}
+
+static void nativeError(const char *msg, const lisp_object *form) {
+	const char *str = form ? toString(form) : "nil";
+	size_t len = snprintf(NULL, 0, "%s: %s", msg, str);
+	char *buf = GC_MALLOC_ATOMIC((len + 1) * sizeof(*buf));
+	snprintf(buf, len + 1, "%s: %s", msg, str);
+	exception e = {CompilerException, buf};
+	Raise(e);
+}
+
+// Assembler
+// Each instruction is either written out as text, or encoded into em->code.
+
+typedef enum {	// Register
+	RAX = 0,
+	RCX = 1,
+	RSP = 4,
+	RBP = 5,
+	RSI = 6,
+	RDI = 7,
+	R12 = 12,
+} Register;
+
+static const char *const registerNames[] = {
+	[RAX] = "%rax",
+	[RCX] = "%rcx",
+	[RSP] = "%rsp",
+	[RBP] = "%rbp",
+	[RSI] = "%rsi",
+	[RDI] = "%rdi",
+	[R12] = "%r12",
+};
+
+typedef enum {	// AluOp
+	ALU_ADD = 0,
+	ALU_OR = 1,
+	ALU_AND = 4,
+	ALU_SUB = 5,
+	ALU_XOR = 6,
+	ALU_CMP = 7,
+} AluOp;
+
+static const char *const aluNames[] = {
+	[ALU_ADD] = "addq",
+	[ALU_OR] = "orq",
+	[ALU_AND] = "andq",
+	[ALU_SUB] = "subq",
+	[ALU_XOR] = "xorq",
+	[ALU_CMP] = "cmpq",
+};
+
+static void emitBytes(Emitter *em, const void *bytes, size_t n) {
+	if(em->size + n > em->capacity) {
+		while(em->size + n > em->capacity)
+			em->capacity = em->capacity ? 2 * em->capacity : 256;
+		em->code = GC_REALLOC(em->code, em->capacity * sizeof(*em->code));
+	}
+	memcpy(em->code + em->size, bytes, n);
+	em->size += n;
+}
+
+static void emitByte(Emitter *em, uint8_t b) {
+	emitBytes(em, &b, 1);
+}
+
+static void emitInt32(Emitter *em, int32_t x) {
+	uint8_t bytes[4] = {x & 0xFF, (x >> 8) & 0xFF, (x >> 16) & 0xFF, (x >> 24) & 0xFF};
+	emitBytes(em, bytes, sizeof(bytes));
+}
+
+static void emitRel32(Emitter *em, size_t label) {
+	if(em->fixupCount == em->fixupCapacity) {
+		em->fixupCapacity = em->fixupCapacity ? 2 * em->fixupCapacity : 16;
+		em->fixups = GC_REALLOC(em->fixups, em->fixupCapacity * sizeof(*em->fixups));
+	}
+	em->fixups[em->fixupCount++] = (Fixup){em->size, label};
+	emitInt32(em, 0);
+}
+
+// REX.W opcode ModRM for reg and disp(base).
+static void emitMemoryOperand(Emitter *em, uint8_t opcode, int reg, Register base, long disp) {
+	bool small = disp >= INT8_MIN && disp <= INT8_MAX;
+	emitByte(em, 0x48 | ((reg & 8) ? 4 : 0) | ((base & 8) ? 1 : 0));
+	emitByte(em, opcode);
+	emitByte(em, (small ? 0x40 : 0x80) | ((reg & 7) << 3) | (base & 7));
+	if((base & 7) == RSP)
+		emitByte(em, 0x24);
+	if(small)
+		emitByte(em, (uint8_t)disp);
+	else
+		emitInt32(em, (int32_t)disp);
+}
+
+static void asmLabel(Emitter *em, size_t label) {
+	if(em->jit)
+		em->labels[label] = em->size;
+	else
+		emit(em, "L_%zu:", label);
+}
+
+static void asmLoadImmediate(Emitter *em, long x) {
+	bool small = x >= INT32_MIN && x <= INT32_MAX;
+	if(!em->jit) {
+		emit(em, small ? "\tmovq $%ld, %%rax" : "\tmovabsq $%ld, %%rax", x);
+	} else if(small) {
+		emitBytes(em, "\x48\xC7\xC0", 3);
+		emitInt32(em, (int32_t)x);
+	} else {
+		emitBytes(em, "\x48\xB8", 2);
+		for(size_t i = 0; i < 8; i++)
+			emitByte(em, ((unsigned long)x >> (8 * i)) & 0xFF);
+	}
+}
+
+static void asmLoad(Emitter *em, Register dst, Register base, long disp) {
+	if(em->jit)
+		emitMemoryOperand(em, 0x8B, dst, base, disp);
+	else
+		emit(em, "\tmovq %ld(%s), %s", disp, registerNames[base], registerNames[dst]);
+}
+
+static void asmStore(Emitter *em, Register src, Register base, long disp) {
+	if(base == RBP && -disp > em->frameSize)
+		em->frameSize = -disp;
+	if(em->jit)
+		emitMemoryOperand(em, 0x89, src, base, disp);
+	else
+		emit(em, "\tmovq %s, %ld(%s)", registerNames[src], disp, registerNames[base]);
+}
+
+static void asmLea(Emitter *em, Register dst, Register base, long disp) {
+	if(em->jit)
+		emitMemoryOperand(em, 0x8D, dst, base, disp);
+	else
+		emit(em, "\tleaq %ld(%s), %s", disp, registerNames[base], registerNames[dst]);
+}
+
+static void asmMove(Emitter *em, Register dst, Register src) {
+	if(em->jit) {
+		emitByte(em, 0x48 | ((src & 8) ? 4 : 0) | ((dst & 8) ? 1 : 0));
+		emitByte(em, 0x89);
+		emitByte(em, 0xC0 | ((src & 7) << 3) | (dst & 7));
+	} else {
+		emit(em, "\tmovq %s, %s", registerNames[src], registerNames[dst]);
+	}
+}
+
+static void asmPush(Emitter *em, Register reg) {
+	assert(reg < 8);
+	if(em->jit)
+		emitByte(em, 0x50 | reg);
+	else
+		emit(em, "\tpushq %s", registerNames[reg]);
+}
+
+static void asmPop(Emitter *em, Register reg) {
+	assert(reg < 8);
+	if(em->jit)
+		emitByte(em, 0x58 | reg);
+	else
+		emit(em, "\tpopq %s", registerNames[reg]);
+}
+
+// Points %rsp at the bottom of the current function's frame.  The frame size is only known once the whole function
+// has been emitted, so it is patched in, or left to the assembler, afterwards.
+static void asmFrameBottom(Emitter *em) {
+	if(!em->jit) {
+		emit(em, "\tleaq -F_%zu(%%rbp), %%rsp", em->frameLabel);
+		return;
+	}
+	if(em->frameFixupCount == em->frameFixupCapacity) {
+		em->frameFixupCapacity = em->frameFixupCapacity ? 2 * em->frameFixupCapacity : 8;
+		em->frameFixups = GC_REALLOC(em->frameFixups, em->frameFixupCapacity * sizeof(*em->frameFixups));
+	}
+	emitBytes(em, "\x48\x8D\xA5", 3);
+	em->frameFixups[em->frameFixupCount++] = em->size;
+	emitInt32(em, 0);
+}
+
+static void asmAluImmediate(Emitter *em, AluOp op, long imm, Register reg) {
+	if(!em->jit) {
+		emit(em, "\t%s $%ld, %s", aluNames[op], imm, registerNames[reg]);
+		return;
+	}
+	bool small = imm >= INT8_MIN && imm <= INT8_MAX;
+	emitByte(em, 0x48 | ((reg & 8) ? 1 : 0));
+	emitByte(em, small ? 0x83 : 0x81);
+	emitByte(em, 0xC0 | (op << 3) | (reg & 7));
+	if(small)
+		emitByte(em, (uint8_t)imm);
+	else
+		emitInt32(em, (int32_t)imm);
+}
+
+static uint8_t conditionCode(const char *condition) {
+	if(strcmp(condition, "e") == 0)
+		return 0x4;
+	if(strcmp(condition, "l") == 0)
+		return 0xC;
+	if(strcmp(condition, "ge") == 0)
+		return 0xD;
+	if(strcmp(condition, "le") == 0)
+		return 0xE;
+	assert(strcmp(condition, "g") == 0);
+	return 0xF;
+}
+
+// Jumps to label, if condition is set, and always if it is NULL.
+static void asmJump(Emitter *em, const char *condition, size_t label) {
+	if(!em->jit) {
+		emit(em, "\tj%s L_%zu", condition ? condition : "mp", label);
+		return;
+	}
+	if(condition) {
+		emitByte(em, 0x0F);
+		emitByte(em, 0x80 | conditionCode(condition));
+	} else {
+		emitByte(em, 0xE9);
+	}
+	emitRel32(em, label);
+}
+
+static void asmLeaLabel(Emitter *em, size_t label) {
+	if(em->jit) {
+		emitBytes(em, "\x48\x8D\x05", 3);
+		emitRel32(em, label);
+	} else {
+		emit(em, "\tleaq L_%zu(%%rip), %%rax", label);
+	}
+}
+
+// Converts the flags into a boolean in %rax.
+static void asmSetBoolean(Emitter *em, const char *condition) {
+	if(em->jit) {
+		emitByte(em, 0x0F);
+		emitByte(em, 0x90 | conditionCode(condition));
+		emitByte(em, 0xC0);
+		emitBytes(em, "\x48\x0F\xB6\xC0\x48\xC1\xE0\x06", 8);
+	} else {
+		emit(em, "\tset%s %%al", condition);
+		emit(em, "\tmovzbq %%al, %%rax");
+		emit(em, "\tshlq $6, %%rax");
+	}
+	asmAluImmediate(em, ALU_OR, FALSE_VALUE, RAX);
+}
+
+// Calls, or jumps to, the code of the closure in %rdi.
+static void asmCallClosure(Emitter *em, bool tail) {
+	if(em->jit) {
+		emitByte(em, 0xFF);
+		emitByte(em, tail ? 0x67 : 0x57);
+		emitByte(em, (uint8_t)-CLOSURE_TAG);
+	} else {
+		emit(em, "\t%s *%d(%%rdi)", tail ? "jmp" : "call", -CLOSURE_TAG);
+	}
+}
+
+static void asmRet(Emitter *em) {
+	if(em->jit)
+		emitByte(em, 0xC3);
+	else
+		emit(em, "\tret");
+}
+
+static void asmPrimitive(Emitter *em, const Primitive *p) {
+	if(em->jit)
+		emitBytes(em, p->machineCode, p->machineCodeSize);
+	else
+		emit(em, "\t%s", p->code);
+}
+
+// Forms
+
+static bool isSymbol(const lisp_object *form) {
+	return form != NULL && objectType(form) == SYMBOL_type && getNamespaceSymbol((Symbol*)form) == NULL;
+}
+
+static const char *symbolName(const lisp_object *form) {
+	if(!isSymbol(form))
+		nativeError("Expected a symbol", form);
+	return getNameSymbol((Symbol*)form);
+}
+
+static bool isList(const lisp_object *form) {
+	return form != NULL && (objectType(form) == LIST_type || objectType(form) == CONS_type) && count(form) > 0;
+}
+
+static bool isForm(const lisp_object *form, const char *name) {
+	if(!isList(form))
+		return false;
+	const lisp_object *op = first(form);
+	return isSymbol(op) && strcmp(getNameSymbol((Symbol*)op), name) == 0;
+}
+
+static bool isLetForm(const lisp_object *form) {
+	return isForm(form, "let") || isForm(form, "let*") || isForm(form, "loop");
+}
+
+static bool isFnForm(const lisp_object *form) {
+	return isForm(form, "fn") || isForm(form, "fn*");
+}
+
+static const lisp_object *fnName(const lisp_object *form) {
+	const lisp_object *x = second(form);
+	return isSymbol(x) ? x : NULL;
+}
+
+static const lisp_object *fnParams(const lisp_object *form) {
+	const lisp_object *params = fnName(form) ? third(form) : second(form);
+	if(params == NULL || !isIVector(params))
+		nativeError("Only single arity fns with a parameter vector are supported", form);
+	return params;
+}
+
+static const ISeq *fnBody(const lisp_object *form) {
+	const ISeq *ret = next(form);
+	if(fnName(form))
+		ret = next((lisp_object*)ret);
+	return next((lisp_object*)ret);
+}
+
+static const lisp_object *letBindings(const lisp_object *form) {
+	const lisp_object *bindings = second(form);
+	if(bindings == NULL || !isIVector(bindings) || count(bindings) % 2 != 0)
+		nativeError("Bad binding form, expected a vector with an even number of forms", form);
+	return bindings;
+}
+
+static const lisp_object *nthForm(const lisp_object *vector, size_t i) {
+	const IVector *v = (IVector*)vector;
+	return v->obj.fns->IVectorFns->nth(v, i, NULL);
+}
+
+static const Primitive *findPrimitive(const Emitter *em, const lisp_object *op, const NativeEnv *env);
+static const Primitive *nativePrimitive(const lisp_object *obj);
+
+// Environments
+
+static const NativeEnv *extendEnv(const char *name, NativeBindingType type, long index, const NativeEnv *next) {
+	NativeEnv *ret = GC_MALLOC(sizeof(*ret));
+	ret->name = name;
+	ret->type = type;
+	ret->index = index;
+	ret->next = next;
+	return ret;
+}
+
+static const NativeEnv *lookupEnv(const char *name, const NativeEnv *env) {
+	for(; env != NULL; env = env->next) {
+		if(strcmp(env->name, name) == 0)
+			return env;
+	}
+	return NULL;
+}
+
+// Closure conversion.  Collects, in order of first use, the names that form uses from outer, but does not bind itself.
+
+typedef struct {	// FreeVars
+	size_t count;
+	size_t capacity;
+	const char **names;
+} FreeVars;
+
+static void addFreeVar(FreeVars *fv, const char *name) {
+	for(size_t i = 0; i < fv->count; i++) {
+		if(strcmp(fv->names[i], name) == 0)
+			return;
+	}
+	if(fv->count == fv->capacity) {
+		fv->capacity = fv->capacity ? 2 * fv->capacity : 4;
+		fv->names = GC_REALLOC(fv->names, fv->capacity * sizeof(*fv->names));
+	}
+	fv->names[fv->count++] = name;
+}
+
+static void collectFreeVars(const Emitter *em, FreeVars *fv, const lisp_object *form, const NativeEnv *bound, const NativeEnv *outer) {
+	if(isSymbol(form)) {
+		const char *name = getNameSymbol((Symbol*)form);
+		if(lookupEnv(name, bound) == NULL && lookupEnv(name, outer) != NULL)
+			addFreeVar(fv, name);
+		return;
+	}
+	if(!isList(form) || isForm(form, "quote"))
+		return;
+	if(isLetForm(form)) {
+		const lisp_object *bindings = letBindings(form);
+		for(size_t i = 0; i < count(bindings); i += 2) {
+			collectFreeVars(em, fv, nthForm(bindings, i + 1), bound, outer);
+			bound = extendEnv(symbolName(nthForm(bindings, i)), STACK_BINDING, 0, bound);
+		}
+		for(const ISeq *s = next((lisp_object*)next(form)); s != NULL; s = next((lisp_object*)s))
+			collectFreeVars(em, fv, first((lisp_object*)s), bound, outer);
+		return;
+	}
+	if(isFnForm(form)) {
+		const lisp_object *name = fnName(form);
+		if(name)
+			bound = extendEnv(symbolName(name), SELF_BINDING, 0, bound);
+		const lisp_object *params = fnParams(form);
+		for(size_t i = 0; i < count(params); i++)
+			bound = extendEnv(symbolName(nthForm(params, i)), STACK_BINDING, 0, bound);
+		for(const ISeq *s = fnBody(form); s != NULL; s = next((lisp_object*)s))
+			collectFreeVars(em, fv, first((lisp_object*)s), bound, outer);
+		return;
+	}
+	const ISeq *s = (ISeq*)form;
+	if(findPrimitive(em, first(form), bound) && lookupEnv(getNameSymbol((Symbol*)first(form)), outer) == NULL)
+		s = next(form);
+	for(; s != NULL; s = next((lisp_object*)s))
+		collectFreeVars(em, fv, first((lisp_object*)s), bound, outer);
+}
+
+// Code generation
+
+// loop is the target of a recur in this position, and is NULL where recur is not allowed.  A form in tail position
+// returns from the enclosing function itself.
+static void emitForm(Emitter *em, const lisp_object *form, long si, const NativeEnv *env, const LoopTarget *loop, bool tail);
+static void emitExpr(Emitter *em, const lisp_object *form, long si, const NativeEnv *env);
+
+// With em->ops, an operator is only inlined if it resolves to a NativeFn, and then as that NativeFn's own primitive,
+// whatever the operator is called.
+static const Primitive *findPrimitive(const Emitter *em, const lisp_object *op, const NativeEnv *env) {
+	if(!isSymbol(op))
+		return NULL;
+	const char *name = getNameSymbol((Symbol*)op);
+	if(lookupEnv(name, env))
+		return NULL;
+	if(em->ops) {
+		const lisp_object *val = em->ops->obj.fns->IMapFns->valAt(em->ops, (lisp_object*)internSymbol1(name), NULL);
+		return nativePrimitive(val);
+	}
+	if(name[0] == '$')
+		name++;
+	for(size_t i = 0; i < sizeof(primitives) / sizeof(primitives[0]); i++) {
+		if(strcmp(primitives[i].name, name) == 0)
+			return &primitives[i];
+	}
+	return NULL;
+}
+
+// Returns an error message if form has no immediate representation.
+static const char *immediateRep(const lisp_object *form, long *x) {
+	if(form == NULL) {
+		*x = NIL_VALUE;
+	} else if(form == (lisp_object*)EmptyList) {
+		*x = EMPTY_VALUE;
+	} else if(form == (lisp_object*)True) {
+		*x = TRUE_VALUE;
+	} else if(form == (lisp_object*)False) {
+		*x = FALSE_VALUE;
+	} else if(objectType(form) == INTEGER_type) {
+		long i = IntegerValue((Integer*)form);
+		if(i < FX_MIN || i > FX_MAX)
+			return "Integer does not fit in a fixnum";
+		*x = (long)((unsigned long)i << FX_SHIFT);
+	} else if(objectType(form) == CHAR_type) {
+		unsigned char c = (unsigned char)CharValue((Char*)form);
+		*x = ((long)c << CHAR_SHIFT) | CHAR_TAG;
+	} else if(objectType(form) == LIST_type && count(form) == 0) {
+		*x = EMPTY_VALUE;
+	} else {
+		return "Unsupported constant";
+	}
+	return NULL;
+}
+
+static void emitConstant(Emitter *em, const lisp_object *form) {
+	long x = 0;
+	const char *err = immediateRep(form, &x);
+	if(err)
+		nativeError(err, form);
+	asmLoadImmediate(em, x);
+}
+
+static void emitVariable(Emitter *em, const lisp_object *form, const NativeEnv *env) {
+	const NativeEnv *b = lookupEnv(getNameSymbol((Symbol*)form), env);
+	if(b == NULL)
+		nativeError("Unable to resolve symbol", form);
+	switch(b->type) {
+		case STACK_BINDING:
+			asmLoad(em, RAX, RBP, b->index);
+			return;
+		case FREE_BINDING:
+			asmLoad(em, RAX, RDI, WORD_SIZE * (b->index + 1) - CLOSURE_TAG);
+			return;
+		case SELF_BINDING:
+			asmMove(em, RAX, RDI);
+			return;
+	}
+}
+
+static void emitIsFalsy(Emitter *em) {
+	asmAluImmediate(em, ALU_OR, FALSE_VALUE ^ NIL_VALUE, RAX);
+	asmAluImmediate(em, ALU_CMP, NIL_VALUE, RAX);
+}
+
+static void emitPrimitive(Emitter *em, const Primitive *p, const lisp_object *form, long si, const NativeEnv *env) {
+	if(count(form) - 1 != p->argc)
+		nativeError("Wrong number of args passed to primitive", form);
+	if(em->jit && p->heap)
+		nativeError("Heap primitives are not supported by the JIT", form);
+	if(p->argc == 1) {
+		emitExpr(em, second(form), si, env);
+	} else {
+		emitExpr(em, second(form), si, env);
+		asmStore(em, RAX, RBP, si);
+		emitExpr(em, third(form), si - WORD_SIZE, env);
+		asmMove(em, RCX, RAX);
+		asmLoad(em, RAX, RBP, si);
+	}
+	asmPrimitive(em, p);
+	if(p->condition)
+		asmSetBoolean(em, p->condition);
+}
+
+// Evaluates the arguments of a call or recur into the slots si, si - 8, ...
+static size_t emitArgs(Emitter *em, const ISeq *args, long si, const NativeEnv *env) {
+	size_t argc = 0;
+	for(; args != NULL; args = next((lisp_object*)args), argc++) {
+		emitExpr(em, first((lisp_object*)args), si - WORD_SIZE * argc, env);
+		asmStore(em, RAX, RBP, si - WORD_SIZE * argc);
+	}
+	return argc;
+}
+
+// A callee's args are below %rsp from the call until its prologue has run, so they have to fit in the red zone, which
+// a signal handler leaves alone.
+static void checkArgCount(size_t argc, const lisp_object *form) {
+	if(WORD_SIZE * (argc + 1) > RED_ZONE)
+		nativeError("Too many args for a native call", form);
+}
+
+// The callee returns with %rsp at si(%rbp), which gives back the frame pointer.
+static void emitCall(Emitter *em, const lisp_object *form, long si, const NativeEnv *env) {
+	asmStore(em, RDI, RBP, si);
+	size_t argc = emitArgs(em, next(form), si - 2 * WORD_SIZE, env);
+	checkArgCount(argc, form);
+	emitExpr(em, first(form), si - 2 * WORD_SIZE - WORD_SIZE * argc, env);
+	asmMove(em, RDI, RAX);
+	asmLea(em, RSP, RBP, si);
+	asmCallClosure(em, false);
+	asmLea(em, RBP, RSP, -si);
+	asmFrameBottom(em);
+	asmLoad(em, RDI, RBP, si);
+}
+
+static void emitTailCall(Emitter *em, const lisp_object *form, long si, const NativeEnv *env) {
+	size_t argc = emitArgs(em, next(form), si, env);
+	checkArgCount(argc, form);
+	emitExpr(em, first(form), si - WORD_SIZE * argc, env);
+	for(size_t i = 0; i < argc; i++) {
+		asmLoad(em, RCX, RBP, si - WORD_SIZE * (long)i);
+		asmStore(em, RCX, RBP, -WORD_SIZE * (long)(i + 1));
+	}
+	asmMove(em, RDI, RAX);
+	asmMove(em, RSP, RBP);
+	asmCallClosure(em, true);
+}
+
+static void emitRecur(Emitter *em, const lisp_object *form, long si, const NativeEnv *env, const LoopTarget *loop) {
+	if(loop == NULL)
+		nativeError("Can only recur from tail position", form);
+	size_t argc = emitArgs(em, next(form), si, env);
+	if(argc != loop->count)
+		nativeError("Mismatched argument count to recur", form);
+	for(size_t i = 0; i < argc; i++) {
+		asmLoad(em, RAX, RBP, si - WORD_SIZE * (long)i);
+		asmStore(em, RAX, RBP, loop->slots[i]);
+	}
+	asmJump(em, NULL, loop->label);
+}
+
+static void emitIf(Emitter *em, const lisp_object *form, long si, const NativeEnv *env, const LoopTarget *loop, bool tail) {
+	size_t n = count(form);
+	if(n < 3 || n > 4)
+		nativeError(n < 3 ? "Too few arguments to if" : "Too many arguments to if", form);
+	size_t altLabel = uniqueLabel(em);
+	size_t endLabel = uniqueLabel(em);
+	emitExpr(em, second(form), si, env);
+	emitIsFalsy(em);
+	asmJump(em, "e", altLabel);
+	emitForm(em, third(form), si, env, loop, tail);
+	if(!tail)
+		asmJump(em, NULL, endLabel);
+	asmLabel(em, altLabel);
+	emitForm(em, fourth(form), si, env, loop, tail);
+	asmLabel(em, endLabel);
+}
+
+static void emitBody(Emitter *em, const ISeq *body, long si, const NativeEnv *env, const LoopTarget *loop, bool tail) {
+	if(body == NULL) {
+		emitForm(em, NULL, si, env, loop, tail);
+		return;
+	}
+	for(; next((lisp_object*)body) != NULL; body = next((lisp_object*)body))
+		emitExpr(em, first((lisp_object*)body), si, env);
+	emitForm(em, first((lisp_object*)body), si, env, loop, tail);
+}
+
+static void emitLet(Emitter *em, const lisp_object *form, long si, const NativeEnv *env, const LoopTarget *loop, bool tail) {
+	const lisp_object *bindings = letBindings(form);
+	size_t n = count(bindings) / 2;
+	long *slots = GC_MALLOC_ATOMIC((n ? n : 1) * sizeof(*slots));
+	for(size_t i = 0; i < n; i++) {
+		const char *name = symbolName(nthForm(bindings, 2 * i));
+		emitExpr(em, nthForm(bindings, 2 * i + 1), si, env);
+		asmStore(em, RAX, RBP, si);
+		slots[i] = si;
+		env = extendEnv(name, STACK_BINDING, si, env);
+		si -= WORD_SIZE;
+	}
+	if(isForm(form, "loop")) {
+		LoopTarget *target = GC_MALLOC(sizeof(*target));
+		target->label = uniqueLabel(em);
+		target->count = n;
+		target->slots = slots;
+		asmLabel(em, target->label);
+		emitBody(em, next((lisp_object*)next(form)), si, env, target, tail);
+		return;
+	}
+	emitBody(em, next((lisp_object*)next(form)), si, env, loop, tail);
+}
+
+// Queues the code of a fn form, to be emitted after the current function.
+static const Lambda *queueLambda(Emitter *em, const lisp_object *form, const NativeEnv *env) {
+	const lisp_object *name = fnName(form);
+	const NativeEnv *bound = name ? extendEnv(symbolName(name), SELF_BINDING, 0, NULL) : NULL;
+	const lisp_object *params = fnParams(form);
+	for(size_t i = 0; i < count(params); i++) {
+		const lisp_object *param = nthForm(params, i);
+		if(isSymbol(param) && strcmp(getNameSymbol((Symbol*)param), "&") == 0)
+			nativeError("Variadic fns are not supported", form);
+		bound = extendEnv(symbolName(param), STACK_BINDING, 0, bound);
+	}
+	checkArgCount(count(params), form);
+	FreeVars fv = {0, 0, NULL};
+	for(const ISeq *s = fnBody(form); s != NULL; s = next((lisp_object*)s))
+		collectFreeVars(em, &fv, first((lisp_object*)s), bound, env);
+
+	Lambda *l = GC_MALLOC(sizeof(*l));
+	l->label = uniqueLabel(em);
+	l->self = name ? symbolName(name) : NULL;
+	l->params = params;
+	l->body = fnBody(form);
+	l->freeCount = fv.count;
+	l->free = fv.names;
+	l->next = NULL;
+	*(em->pendingTail) = l;
+	em->pendingTail = &l->next;
+	return l;
+}
+
+static void emitClosure(Emitter *em, const lisp_object *form, const NativeEnv *env) {
+	if(em->jit)
+		nativeError("Closures are not supported by the JIT", form);
+	const Lambda *l = queueLambda(em, form, env);
+	long size = WORD_SIZE * (long)(l->freeCount + 1);
+	size = (size + 15) & ~15L;
+	asmLeaLabel(em, l->label);
+	asmStore(em, RAX, R12, 0);
+	for(size_t i = 0; i < l->freeCount; i++) {
+		emitVariable(em, (lisp_object*)internSymbol1(l->free[i]), env);
+		asmStore(em, RAX, R12, WORD_SIZE * (long)(i + 1));
+	}
+	asmLea(em, RAX, R12, CLOSURE_TAG);
+	asmAluImmediate(em, ALU_ADD, size, R12);
+}
+
+static void emitForm(Emitter *em, const lisp_object *form, long si, const NativeEnv *env, const LoopTarget *loop, bool tail) {
+	if(isSymbol(form)) {
+		emitVariable(em, form, env);
+	} else if(!isList(form)) {
+		emitConstant(em, form);
+	} else if(isForm(form, "quote")) {
+		emitConstant(em, second(form));
+	} else if(isForm(form, "if")) {
+		emitIf(em, form, si, env, loop, tail);
+		return;
+	} else if(isForm(form, "do")) {
+		emitBody(em, next(form), si, env, loop, tail);
+		return;
+	} else if(isLetForm(form)) {
+		emitLet(em, form, si, env, loop, tail);
+		return;
+	} else if(isForm(form, "recur")) {
+		emitRecur(em, form, si, env, loop);
+		return;
+	} else if(isFnForm(form)) {
+		emitClosure(em, form, env);
+	} else {
+		const Primitive *p = findPrimitive(em, first(form), env);
+		if(p) {
+			emitPrimitive(em, p, form, si, env);
+		} else if(tail) {
+			emitTailCall(em, form, si, env);
+			return;
+		} else {
+			emitCall(em, form, si, env);
+		}
+	}
+	if(tail) {
+		asmMove(em, RSP, RBP);
+		asmRet(em);
+	}
+}
+
+static void emitExpr(Emitter *em, const lisp_object *form, long si, const NativeEnv *env) {
+	emitForm(em, form, si, env, NULL, false);
+}
+
+// A function's frame starts where %rsp was on entry, which is kept in %rbp, and its slots are addressed from there.
+// %rsp stays below the deepest slot, so nothing in the frame can be overwritten by a signal handler.
+static void emitPrologue(Emitter *em, size_t label, size_t argc) {
+	em->frameLabel = label;
+	em->frameSize = WORD_SIZE * (long)argc;
+	em->frameFixupCount = 0;
+	asmMove(em, RBP, RSP);
+	asmFrameBottom(em);
+}
+
+static void emitEpilogue(Emitter *em) {
+	if(!em->jit) {
+		emit(em, "\t.set F_%zu, %ld", em->frameLabel, em->frameSize);
+		return;
+	}
+	int32_t disp = (int32_t)-em->frameSize;
+	for(size_t i = 0; i < em->frameFixupCount; i++)
+		memcpy(em->code + em->frameFixups[i], &disp, sizeof(disp));
+}
+
+static void emitLambda(Emitter *em, const Lambda *l) {
+	const NativeEnv *env = NULL;
+	for(size_t i = 0; i < l->freeCount; i++)
+		env = extendEnv(l->free[i], FREE_BINDING, (long)i, env);
+	if(l->self)
+		env = extendEnv(l->self, SELF_BINDING, 0, env);
+	size_t argc = count(l->params);
+	long *slots = GC_MALLOC_ATOMIC((argc ? argc : 1) * sizeof(*slots));
+	for(size_t i = 0; i < argc; i++) {
+		slots[i] = -WORD_SIZE * (long)(i + 1);
+		env = extendEnv(symbolName(nthForm(l->params, i)), STACK_BINDING, slots[i], env);
+	}
+	LoopTarget target = {uniqueLabel(em), argc, slots};
+
+	if(!em->jit)
+		emit(em, "\t.type L_%zu, @function", l->label);
+	asmLabel(em, l->label);
+	emitPrologue(em, l->label, argc);
+	asmLabel(em, target.label);
+	emitBody(em, l->body, -WORD_SIZE * (long)(argc + 1), env, &target, true);
+	emitEpilogue(em);
+}
+
+void EmitProgram(StringWriter *sw, const lisp_object *form) {
+	Emitter em = {sw, 0, NULL, NULL, NULL, 0, 0, false, NULL, 0, 0, NULL, 0, NULL, 0, 0, NULL, 0, 0};
+	em.pendingTail = &em.pending;
+
+	emit(&em, "\t.text");
+	emit(&em, "\t.globl lisp_entry");
+	emit(&em, "\t.type lisp_entry, @function");
+	emit(&em, "lisp_entry:");
+	emit(&em, "\tpushq %%r12");
+	emit(&em, "\tpushq %%rbp");
+	emit(&em, "\tmovq %%rdi, %%r12");
+	emit(&em, "\txorl %%edi, %%edi");
+	emit(&em, "\tcall lisp_main");
+	emit(&em, "\tpopq %%rbp");
+	emit(&em, "\tpopq %%r12");
+	emit(&em, "\tret");
+	emit(&em, "\t.type lisp_main, @function");
+	emit(&em, "lisp_main:");
+	emitPrologue(&em, uniqueLabel(&em), 0);
+	emitForm(&em, form, -WORD_SIZE, NULL, NULL, true);
+	emitEpilogue(&em);
+	for(const Lambda *l = em.pending; l != NULL; l = l->next)
+		emitLambda(&em, l);
+	emit(&em, "\t.section .note.GNU-stack,\"\",@progbits");
+}
+
+static char *writeTemp(const char *contents) {
+	char *name = GC_MALLOC_ATOMIC(32 * sizeof(*name));
+	strcpy(name, "/tmp/lispXXXXXX");
+	int fd = mkstemp(name);
+	if(fd < 0)
+		return NULL;
+	FILE *f = fdopen(fd, "w");
+	if(f == NULL) {
+		remove(name);
+		return NULL;
+	}
+	fputs(contents, f);
+	fclose(f);
+	return name;
+}
+
+bool CompileProgram(const lisp_object *form, const char *out_file) {
+	StringWriter *sw = NewStringWriter();
+	EmitProgram(sw, form);
+
+	char *asmFile = writeTemp(WriteString(sw));
+	char *startFile = writeTemp(startup);
+	bool ret = false;
+	if(asmFile && startFile) {
+		const char *cc = getenv("CC");
+		if(cc == NULL || *cc == '\0')
+			cc = "cc";
+		const char *format = "%s -o '%s' -x assembler '%s' -x c '%s'";
+		size_t len = snprintf(NULL, 0, format, cc, out_file, asmFile, startFile);
+		char *cmd = GC_MALLOC_ATOMIC((len + 1) * sizeof(*cmd));
+		snprintf(cmd, len + 1, format, cc, out_file, asmFile, startFile);
+		ret = system(cmd) == 0;
+	}
+	if(asmFile)
+		remove(asmFile);
+	if(startFile)
+		remove(startFile);
+	return ret;
+}
+
+bool CompileFile(const char *pathname, const char *out_file) {
+	init_reader();
+	LineNumberReader *input = NewLineNumberReader(pathname);
+	if(input == NULL)
+		return false;
+	const ISeq *reversed = NULL;
+	for(const lisp_object *form = read(input, false, '\0'); form == NULL || objectType(form) != EOF_type; form = read(input, false, '\0'))
+		reversed = cons(form, (lisp_object*)reversed);
+	closeLineNumberReader(input);
+
+	const ISeq *forms = NULL;
+	for(; reversed != NULL; reversed = next((lisp_object*)reversed))
+		forms = cons(first((lisp_object*)reversed), (lisp_object*)forms);
+	return CompileProgram((lisp_object*)cons((lisp_object*)DoSymbol, (lisp_object*)forms), out_file);
+}
+
+// JIT
+
+typedef long (*NativeEntry)(const long *args, long closure);
+
+struct NativeFn_struct {
+	lisp_object obj;
+	const char *name;
+	size_t argc;
+	NativeEntry entry;
+	const Primitive *primitive;
+	long closure[2];	// A closure with no free variables.  Only closure[0], the code pointer, is used.
+};
+
+static const lisp_object* fromNative(const NativeFn *fn, long x) {
+	if((x & FX_MASK) == 0)
+		return (lisp_object*)NewInteger(x >> FX_SHIFT);
+	if((x & CHAR_MASK) == CHAR_TAG)
+		return (lisp_object*)NewChar((char)(x >> CHAR_SHIFT));
+	switch(x) {
+		case FALSE_VALUE:
+			return (lisp_object*)False;
+		case TRUE_VALUE:
+			return (lisp_object*)True;
+		case NIL_VALUE:
+			return NULL;
+		case EMPTY_VALUE:
+			return (lisp_object*)EmptyList;
+	}
+	assert(x == ((long)fn->closure | CLOSURE_TAG));
+	return (lisp_object*)fn;
+}
+
+static const lisp_object* invokeNative(const NativeFn *fn, size_t argc, const lisp_object *const *argv) {
+	if(argc != fn->argc)
+		NewArityError(argc, fn->name);
+	long args[argc ? argc : 1];
+	for(size_t i = 0; i < argc; i++) {
+		const char *err = immediateRep(argv[i], &args[i]);
+		if(err) {
+			exception e = {IllegalArgumentException, err};
+			Raise(e);
+		}
+	}
+	return fromNative(fn, fn->entry(args, (long)fn->closure | CLOSURE_TAG));
+}
+
+static const lisp_object* invoke0NativeFn(const IFn *self) {
+	return invokeNative((NativeFn*)self, 0, NULL);
+}
+
+static const lisp_object* invoke1NativeFn(const IFn *self, const lisp_object *arg1) {
+	const lisp_object *argv[] = {arg1};
+	return invokeNative((NativeFn*)self, 1, argv);
+}
+
+static const lisp_object* invoke2NativeFn(const IFn *self, const lisp_object *arg1, const lisp_object *arg2) {
+	const lisp_object *argv[] = {arg1, arg2};
+	return invokeNative((NativeFn*)self, 2, argv);
+}
+
+static const lisp_object* invoke3NativeFn(const IFn *self, const lisp_object *arg1, const lisp_object *arg2, const lisp_object *arg3) {
+	const lisp_object *argv[] = {arg1, arg2, arg3};
+	return invokeNative((NativeFn*)self, 3, argv);
+}
+
+static const lisp_object* invoke4NativeFn(const IFn *self, const lisp_object *arg1, const lisp_object *arg2, const lisp_object *arg3,
+		const lisp_object *arg4) {
+	const lisp_object *argv[] = {arg1, arg2, arg3, arg4};
+	return invokeNative((NativeFn*)self, 4, argv);
+}
+
+static const lisp_object* invoke5NativeFn(const IFn *self, const lisp_object *arg1, const lisp_object *arg2, const lisp_object *arg3,
+		const lisp_object *arg4, const lisp_object *arg5) {
+	const lisp_object *argv[] = {arg1, arg2, arg3, arg4, arg5};
+	return invokeNative((NativeFn*)self, 5, argv);
+}
+
+static const lisp_object* applyToNativeFn(const IFn *self, const ISeq *args) {
+	size_t argc = count((lisp_object*)args);
+	const lisp_object *argv[argc ? argc : 1];
+	for(size_t i = 0; i < argc; i++, args = next((lisp_object*)args))
+		argv[i] = first((lisp_object*)args);
+	return invokeNative((NativeFn*)self, argc, argv);
+}
+
+static const char* toStringNativeFn(const lisp_object *obj) {
+	assert(obj->type == NATIVEFN_type);
+	return ((NativeFn*)obj)->name;
+}
+
+const IFn_vtable NativeFn_IFn_vtable = {
+	invoke0NativeFn,	// invoke0
+	invoke1NativeFn,	// invoke1
+	invoke2NativeFn,	// invoke2
+	invoke3NativeFn,	// invoke3
+	invoke4NativeFn,	// invoke4
+	invoke5NativeFn,	// invoke5
+	applyToNativeFn,	// applyTo
+};
+
+interfaces NativeFn_interfaces = {
+	NULL,					// SeqableFns
+	NULL,					// ReversibleFns
+	NULL,					// ICollectionFns
+	NULL,					// IStackFns
+	NULL,					// ISeqFns
+	&NativeFn_IFn_vtable,	// IFnFns
+	NULL,					// IVectorFns
+	NULL,					// IMapFns
+	NULL,					// ISetFns
+	toStringNativeFn,		// toString
+	NULL,					// Equals
+	NULL,					// HashEq
+};
+
+// Copies the machine code into fresh pages, which are executable but no longer writable.
+static void *loadCode(const Emitter *em) {
+	size_t size = em->size;
+	void *ret = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if(ret == MAP_FAILED)
+		return NULL;
+	memcpy(ret, em->code, em->size);
+	if(mprotect(ret, size, PROT_READ | PROT_EXEC) != 0) {
+		munmap(ret, size);
+		return NULL;
+	}
+	return ret;
+}
+
+const IFn *JitFn(const lisp_object *form, const IMap *ops) {
+	NativeFn *ret = NULL;
+	TRY
+		if(!isFnForm(form))
+			nativeError("Expected a fn form", form);
+		Emitter em = {NULL, 0, NULL, NULL, ops, 0, 0, true, NULL, 0, 0, NULL, 0, NULL, 0, 0, NULL, 0, 0};
+		em.pendingTail = &em.pending;
+		const Lambda *l = queueLambda(&em, form, NULL);
+		size_t argc = count(l->params);
+		size_t label = l->label;
+
+		// Entry from C.  Copies the args to where the fn expects them, and calls the closure.  %rbp belongs to C.
+		asmPush(&em, RBP);
+		for(size_t i = 0; i < argc; i++) {
+			asmLoad(&em, RAX, RDI, WORD_SIZE * (long)i);
+			asmStore(&em, RAX, RSP, -WORD_SIZE * (long)(i + 2));
+		}
+		asmMove(&em, RDI, RSI);
+		asmCallClosure(&em, false);
+		asmPop(&em, RBP);
+		asmRet(&em);
+		for(; l != NULL; l = l->next)
+			emitLambda(&em, l);
+		for(size_t i = 0; i < em.fixupCount; i++) {
+			const Fixup *f = &em.fixups[i];
+			int32_t rel = (int32_t)(em.labels[f->label] - (f->offset + 4));
+			memcpy(em.code + f->offset, &rel, sizeof(rel));
+		}
+
+		void *code = loadCode(&em);
+		if(code) {
+			ret = GC_MALLOC(sizeof(*ret));
+			ret->obj.type = NATIVEFN_type;
+			ret->obj.size = sizeof(*ret);
+			ret->obj.fns = &NativeFn_interfaces;
+			ret->name = fnName(form) ? symbolName(fnName(form)) : "fn";
+			ret->argc = argc;
+			memcpy(&ret->entry, &code, sizeof(ret->entry));
+			ret->primitive = NULL;
+			ret->closure[0] = (long)((uintptr_t)code + em.labels[label]);
+			ret->closure[1] = 0;
+		}
+	EXCEPT(CompilerExcp)
+		ret = NULL;
+	ENDTRY
+	return (IFn*)ret;
+}
+
+// Returns the primitive that obj wraps, or NULL if obj is not a NativeFn made by initNative.
+static const Primitive *nativePrimitive(const lisp_object *obj) {
+	return obj != NULL && obj->type == NATIVEFN_type ? ((NativeFn*)obj)->primitive : NULL;
+}
+
+bool isNativePrimitive(const lisp_object *obj) {
+	return nativePrimitive(obj) != NULL;
+}
+
+// The generic names, like + and not, are left to lisp.core, since they also work on values that are not immediates.
+static bool isFixnumPrimitive(const Primitive *p) {
+	return strncmp(p->name, "fx", 2) == 0 || strncmp(p->name, "fixnum", 6) == 0 || strncmp(p->name, "char", 4) == 0;
+}
+
+void initNative(Namespace *ns) {
+	const Symbol *x = internSymbol1("x");
+	const Symbol *y = internSymbol1("y");
+	for(size_t i = 0; i < sizeof(primitives) / sizeof(primitives[0]); i++) {
+		const Primitive *p = &primitives[i];
+		if(p->heap || !isFixnumPrimitive(p))
+			continue;
+		const Symbol *name = internSymbol1(p->name);
+		const lisp_object *params[] = {(lisp_object*)x, (lisp_object*)y};
+		const lisp_object *call[] = {(lisp_object*)name, (lisp_object*)x, (lisp_object*)y};
+		const lisp_object *fn[] = {(lisp_object*)FNSymbol, (lisp_object*)CreateVector(p->argc, params), (lisp_object*)CreateList(p->argc + 1, call)};
+		NativeFn *f = (NativeFn*)JitFn((lisp_object*)CreateList(3, fn), NULL);
+		if(f == NULL)
+			continue;
+		f->name = p->name;
+		f->primitive = p;
+		internVar(ns, name, (lisp_object*)f, true);
+	}
+}
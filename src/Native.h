@@ -0,0 +1,24 @@
+#ifndef NATIVE_H
+#define NATIVE_H
+
+#include <stdbool.h>
+
+#include "Interfaces.h"
+#include "LispObject.h"
+#include "Namespace.h"
+#include "StringWriter.h"
+
+typedef struct NativeFn_struct NativeFn;
+
+void EmitProgram(StringWriter *sw, const lisp_object *form);
+bool CompileProgram(const lisp_object *form, const char *out_file);
+bool CompileFile(const char *pathname, const char *out_file);
+
+// Compiles a fn form to machine code in memory.  Returns NULL if form is outside of what the JIT supports.  ops maps
+// each operator symbol to what it resolves to, and only those bound to native primitives are inlined.  If ops is NULL,
+// operators are taken to be the primitives they are named after.
+const IFn *JitFn(const lisp_object *form, const IMap *ops);
+bool isNativePrimitive(const lisp_object *obj);
+void initNative(Namespace *ns);
+
+#endif /* NATIVE_H */
@@ -1,6 +1,7 @@
 #include "Numbers.h"
 
 #include <assert.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <string.h>
 
@@ -12,8 +13,19 @@ struct Integer_struct {
     char *str;
 };
 
-static const char *IntegerToString(const lisp_object *obj) {
-    assert(obj->type == INTEGER_type);
+static bool EqualsInteger(const lisp_object *x, const lisp_object *y) {
+    return y != NULL && objectType(y) == INTEGER_type && IntegerValue((Integer*)x) == IntegerValue((Integer*)y);
+}
+
+const char *IntegerToString(const lisp_object *obj) {
+    assert(objectType(obj) == INTEGER_type);
+    if(isImmediate(obj)) {
+        long i = IntegerValue((Integer*)obj);
+        int size = snprintf(NULL, 0, "%ld", i);
+        char *str = GC_MALLOC_ATOMIC((size + 1) * sizeof(*str));
+        snprintf(str, size+1, "%ld", i);
+        return str;
+    }
     Integer *IntObj = (Integer*)obj;
     if(IntObj->str == NULL) {
         int size = snprintf(NULL, 0, "%ld", IntObj->val);
@@ -25,13 +37,30 @@ static const char *IntegerToString(const lisp_object *obj) {
     return IntObj->str;
 }
 
+static const interfaces Integer_interfaces = {
+	NULL,				// SeqableFns
+	NULL,				// ReversibleFns
+	NULL,				// ICollectionFns
+	NULL,				// IStackFns
+	NULL,				// ISeqFns
+	NULL,				// IFnFns
+	NULL,				// IVectorFns
+	NULL,				// IMapFns
+	NULL,				// ISetFns
+	IntegerToString,	// toString
+	EqualsInteger,		// Equals
+	NULL,				// HashEq
+};
+
 Integer *NewInteger(long i) {
+    if(i >= FIXNUM_MIN && i <= FIXNUM_MAX)
+        return (Integer*)(((uintptr_t)i << IMMEDIATE_BITS) | FIXNUM_IMMEDIATE);
+
     Integer *ret = GC_MALLOC(sizeof(*ret));
     memset(ret, 0, sizeof(*ret));
 
     ret->obj.type = INTEGER_type;
-	ret->obj.toString = IntegerToString;
-	ret->obj.fns = &NullInterface;
+	ret->obj.fns = &Integer_interfaces;
 
     ret->val = i;
 
@@ -39,6 +68,8 @@ Integer *NewInteger(long i) {
 }
 
 long IntegerValue(const Integer *I) {
+    if(isImmediate((lisp_object*)I))
+        return (intptr_t)I >> IMMEDIATE_BITS;
     return I->val;
 }
 
@@ -48,8 +79,12 @@ struct Float_struct {
     char *str;
 };
 
+static bool EqualsFloat(const lisp_object *x, const lisp_object *y) {
+    return y != NULL && objectType(y) == FLOAT_type && FloatValue((Float*)x) == FloatValue((Float*)y);
+}
+
 static const char *FloatToString(const lisp_object *obj) {
-    assert(obj->type == FLOAT_type);
+    assert(objectType(obj) == FLOAT_type);
     Float *FltObj = (Float*)obj;
     if(FltObj->str == NULL) {
         int size = snprintf(NULL,0, "%g", FltObj->val);
@@ -61,13 +96,27 @@ static const char *FloatToString(const lisp_object *obj) {
     return FltObj->str;
 }
 
+static const interfaces Float_interfaces = {
+	NULL,			// SeqableFns
+	NULL,			// ReversibleFns
+	NULL,			// ICollectionFns
+	NULL,			// IStackFns
+	NULL,			// ISeqFns
+	NULL,			// IFnFns
+	NULL,			// IVectorFns
+	NULL,			// IMapFns
+	NULL,			// ISetFns
+	FloatToString,	// toString
+	EqualsFloat,	// Equals
+	NULL,			// HashEq
+};
+
 Float *NewFloat(double x) {
     Float *ret = GC_MALLOC(sizeof(*ret));
     memset(ret, 0, sizeof(*ret));
 
     ret->obj.type = FLOAT_type;
-	ret->obj.toString = FloatToString;
-	ret->obj.fns = &NullInterface;
+	ret->obj.fns = &Float_interfaces;
 
     ret->val = x;
 
@@ -1,14 +1,21 @@
 #ifndef NUMBERS_H
 #define NUMBERS_H
 
+#include <limits.h>
+
 #include "LispObject.h"
 
 typedef struct Integer_struct Integer;
 typedef struct Float_struct Float;
 
+// Integers in [FIXNUM_MIN, FIXNUM_MAX] are immediates, and never allocate.
+#define FIXNUM_MIN	(LONG_MIN >> IMMEDIATE_BITS)
+#define FIXNUM_MAX	(LONG_MAX >> IMMEDIATE_BITS)
+
 // Integer Functions
 Integer *NewInteger(long i);
 long IntegerValue(const Integer *I);
+const char *IntegerToString(const lisp_object *obj);
 
 // Float Functions
 Float *NewFloat(double x);
@@ -19,7 +26,8 @@ typedef struct {	// Number
 } Number;
 
 static inline bool isNumber(const lisp_object *obj) {
-	return obj->type == INTEGER_type || obj->type == FLOAT_type;
+	object_type t = objectType(obj);
+	return t == INTEGER_type || t == FLOAT_type;
 }
 
 #endif /* NUMBERS_H */
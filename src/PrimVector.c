@@ -0,0 +1,948 @@
+#include "PrimVector.h"
+
+#include <assert.h>
+#include <limits.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "AFn.h"
+#include "ASeq.h"
+#include "AVector.h"
+#include "Error.h"
+#include "gc.h"
+#include "Interfaces.h"
+#include "intrinsics.h"
+#include "Map.h"
+#include "Murmur3.h"
+#include "nodes.h"
+#include "Numbers.h"
+#include "Util.h"
+
+
+// The AVX2 kernels are compiled for AVX2 whatever the build's flags, and only called when the processor has it.
+#if defined(__x86_64__) || defined(__i386__)
+#define AVX2_KERNELS
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
+// PrimNode
+
+// The children of a node on the level above the leaves are leaves, and of any other node are PrimNodes.  A leaf is
+// an array of NODE_SIZE unboxed values, allocated atomic so the collector never scans it.  Leaves and nodes are never
+// written once they are in a vector, so vectors share them freely.
+typedef struct {
+	const void *array[NODE_SIZE];
+} PrimNode;
+
+static const PrimNode EmptyPrimNode = {{NULL}};
+
+// PrimVectorSeq
+
+typedef struct {
+	lisp_object obj;
+	const PrimVector *vec;
+	const void *leaf;	// The leaf holding element i.
+	size_t i;
+} PrimVectorSeq;
+
+// PrimVectorSeq Function Declarations.
+
+static PrimVectorSeq *NewPrimVectorSeq(const IMap *meta, const PrimVector *v, const void *leaf, size_t i);
+static size_t countPrimVectorSeq(const ICollection*);
+static const lisp_object* firstPrimVectorSeq(const ISeq*);
+static const ISeq* nextPrimVectorSeq(const ISeq*);
+
+const Seqable_vtable PrimVectorSeq_Seqable_vtable = {
+	seqASeq,	// seq
+};
+
+const ICollection_vtable PrimVectorSeq_ICollection_vtable = {
+	countPrimVectorSeq,			// count
+	(ICollectionFn1)consASeq,	// cons
+	emptyASeq,					// empty
+	EquivASeq					// Equiv
+};
+
+const ISeq_vtable PrimVectorSeq_ISeq_vtable = {
+	firstPrimVectorSeq,	// first
+	nextPrimVectorSeq,	// next
+	moreASeq,			// more
+	consASeq,			// cons
+};
+
+interfaces PrimVectorSeq_interfaces = {
+	&PrimVectorSeq_Seqable_vtable,		// SeqableFns
+	NULL,								// ReversibleFns
+	&PrimVectorSeq_ICollection_vtable,	// ICollectionFns
+	NULL,								// IStackFns
+	&PrimVectorSeq_ISeq_vtable,			// ISeqFns
+	NULL,								// IFnFns
+	NULL,								// IVectorFns
+	NULL,								// IMapFns
+	NULL,								// ISetFns
+	toString,							// toString
+	EqualsASeq,							// Equals
+	NULL,								// HashEq
+};
+
+// PrimVector
+
+struct PrimVector_struct {
+	lisp_object obj;
+	size_t count;
+	size_t shift;
+	const PrimNode *root;
+	const void *tail;	// The leaf holding the elements from tailoffPV.  Vectors popped from this one share it.
+	uint32_t hash;		// HashEq, computed on first use.  0 until then.
+	PrimType type;
+};
+
+// PrimVector Function Declarations.
+
+static const PrimVector *NewPrimVector(PrimType type, size_t count, size_t shift, const PrimNode *root, const void *tail);
+static const ISeq* seqPrimVector(const Seqable*);
+static size_t countPrimVector(const ICollection*);
+static const IStack* popPrimVector(const IStack*);
+static const IVector* assocNPrimVector(const IVector*, size_t, const lisp_object*);
+static const IVector* consPrimVector(const IVector*, const lisp_object*);
+static const lisp_object *nthPrimVector(const IVector *iv, size_t n, const lisp_object *notFound);
+static const void *leafFor(const PrimVector *v, size_t i);
+static size_t tailoffPV(const PrimVector *v);
+static uint32_t HashEqPrimVector(const lisp_object *obj);
+
+const Seqable_vtable PrimVector_Seqable_vtable = {
+	seqPrimVector,	// seq
+};
+
+const Reversible_vtable PrimVector_Reversible_vtable = {
+	rseq	// rseq
+};
+
+const ICollection_vtable PrimVector_ICollection_vtable = {
+	countPrimVector,					// count
+	(ICollectionFn1) consPrimVector,	// cons
+	emptyAVector,						// empty
+	EquivAVector,						// Equiv
+};
+
+const IStack_vtable PrimVector_IStack_vtable = {
+	peekAVector,	// peek
+	popPrimVector,	// pop
+};
+
+const IFn_vtable PrimVector_IFn_vtable = {
+	invoke0AFn,		// invoke0
+	invoke1AVector,	// invoke1
+	invoke2AFn,		// invoke2
+	invoke3AFn,		// invoke3
+	invoke4AFn,		// invoke4
+	invoke5AFn,		// invoke5
+	applyToAFn,		// applyTo
+};
+
+const IVector_vtable PrimVector_IVector_vtable = {
+	lengthAVector,		// length
+	assocNPrimVector,	// assocN
+	consPrimVector,		// cons
+	assocAVector,		// assoc
+	entryAtAVector,		// entryAt
+	nthPrimVector,		// nth
+};
+
+const interfaces PrimVector_interfaces = {
+	&PrimVector_Seqable_vtable,		// SeqableFns
+	&PrimVector_Reversible_vtable,	// ReversibleFns
+	&PrimVector_ICollection_vtable,	// ICollectionFns
+	&PrimVector_IStack_vtable,		// IStackFns
+	NULL,							// ISeqFns
+	&PrimVector_IFn_vtable,			// IFnFns
+	&PrimVector_IVector_vtable,		// IVectorFns
+	NULL,							// IMapFns
+	NULL,							// ISetFns
+	toString,						// toString
+	EqualsAVector,					// Equals
+	HashEqPrimVector,				// HashEq
+};
+
+const PrimVector _EmptyLongVector = {{PRIMVECTOR_type, sizeof(PrimVector), NULL, &PrimVector_interfaces},
+                   0, NODE_LOG_SIZE, &EmptyPrimNode, NULL, 0, PRIM_LONG};
+const PrimVector _EmptyDoubleVector = {{PRIMVECTOR_type, sizeof(PrimVector), NULL, &PrimVector_interfaces},
+                   0, NODE_LOG_SIZE, &EmptyPrimNode, NULL, 0, PRIM_DOUBLE};
+const PrimVector _EmptyByteVector = {{PRIMVECTOR_type, sizeof(PrimVector), NULL, &PrimVector_interfaces},
+                   0, NODE_LOG_SIZE, &EmptyPrimNode, NULL, 0, PRIM_BYTE};
+
+// Elements
+
+static size_t elementSize(PrimType type) {
+	switch(type) {
+		case PRIM_LONG:
+			return sizeof(long);
+		case PRIM_DOUBLE:
+			return sizeof(double);
+		case PRIM_BYTE:
+			return sizeof(signed char);
+	}
+	__builtin_unreachable();
+}
+
+static void checkNumber(const lisp_object *x) {
+	if(x == NULL || !isNumber(x)) {
+		exception e = {IllegalArgumentException, "Vector of primitives can only hold numbers"};
+		Raise(e);
+	}
+}
+
+static double toDouble(const lisp_object *x) {
+	checkNumber(x);
+	return objectType(x) == INTEGER_type ? IntegerValue((Integer*)x) : FloatValue((Float*)x);
+}
+
+// A Float is truncated toward zero.
+static long toLong(const lisp_object *x) {
+	checkNumber(x);
+	if(objectType(x) == INTEGER_type)
+		return IntegerValue((Integer*)x);
+	double d = FloatValue((Float*)x);
+	if(!(d >= (double)LONG_MIN && d < -(double)LONG_MIN)) {
+		exception e = {IllegalArgumentException, "Value out of range for long"};
+		Raise(e);
+	}
+	return (long)d;
+}
+
+static signed char toByte(const lisp_object *x) {
+	long l = toLong(x);
+	if(l < SCHAR_MIN || l > SCHAR_MAX) {
+		exception e = {IllegalArgumentException, "Value out of range for byte"};
+		Raise(e);
+	}
+	return (signed char)l;
+}
+
+// Stores x, converted to the element type, at leaf[i].
+static void storeElement(PrimType type, void *leaf, size_t i, const lisp_object *x) {
+	switch(type) {
+		case PRIM_LONG:
+			((long*)leaf)[i] = toLong(x);
+			return;
+		case PRIM_DOUBLE:
+			((double*)leaf)[i] = toDouble(x);
+			return;
+		case PRIM_BYTE:
+			((signed char*)leaf)[i] = toByte(x);
+			return;
+	}
+}
+
+static const lisp_object *boxElement(PrimType type, const void *leaf, size_t i) {
+	switch(type) {
+		case PRIM_LONG:
+			return (lisp_object*)NewInteger(((const long*)leaf)[i]);
+		case PRIM_DOUBLE:
+			return (lisp_object*)NewFloat(((const double*)leaf)[i]);
+		case PRIM_BYTE:
+			return (lisp_object*)NewInteger(((const signed char*)leaf)[i]);
+	}
+	__builtin_unreachable();
+}
+
+// HashEq of the boxed element, without boxing it.
+static uint32_t hashElement(PrimType type, const void *leaf, size_t i) {
+	switch(type) {
+		case PRIM_LONG: {
+			long l = ((const long*)leaf)[i];
+			return hash32(&l, sizeof(l));
+		}
+		case PRIM_DOUBLE: {
+			double d = ((const double*)leaf)[i];
+			return hash32(&d, sizeof(d));
+		}
+		case PRIM_BYTE: {
+			long l = ((const signed char*)leaf)[i];
+			return hash32(&l, sizeof(l));
+		}
+	}
+	__builtin_unreachable();
+}
+
+static void *NewLeaf(PrimType type) {
+	return GC_MALLOC_ATOMIC(NODE_SIZE * elementSize(type));
+}
+
+// A new leaf holding the first count elements of leaf.
+static void *copyLeaf(PrimType type, const void *leaf, size_t count) {
+	void *ret = NewLeaf(type);
+	if(count > 0)
+		memcpy(ret, leaf, count * elementSize(type));
+	return ret;
+}
+
+// PrimNode Function Definitions.
+
+static PrimNode *NewPrimNode(size_t count, const void *const *array) {
+	PrimNode *ret = GC_MALLOC(sizeof(*ret));
+	if(count > 0)
+		memcpy(ret->array, array, count * sizeof(*array));
+	return ret;
+}
+
+// A chain of nodes down to leaf, for a tree of the given level.
+static const void *newPath(size_t level, const void *leaf) {
+	if(level == 0)
+		return leaf;
+	PrimNode *ret = NewPrimNode(0, NULL);
+	ret->array[0] = newPath(level - NODE_LOG_SIZE, leaf);
+	return ret;
+}
+
+// PrimVectorSeq Function Definitions.
+
+static PrimVectorSeq *NewPrimVectorSeq(const IMap *meta, const PrimVector *v, const void *leaf, size_t i) {
+	PrimVectorSeq *ret = GC_MALLOC(sizeof(*ret));
+	ret->obj.type = PRIMVECTORSEQ_type;
+	ret->obj.size = sizeof(*ret);
+	ret->obj.meta = meta ? meta : (IMap*) EmptyHashMap;
+	ret->obj.fns = &PrimVectorSeq_interfaces;
+
+	ret->vec = v;
+	ret->leaf = leaf ? leaf : leafFor(v, i);
+	ret->i = i;
+
+	return ret;
+}
+
+static size_t countPrimVectorSeq(const ICollection *ic) {
+	assert(ic->obj.type == PRIMVECTORSEQ_type);
+	const PrimVectorSeq *s = (PrimVectorSeq*)ic;
+	return s->vec->count - s->i;
+}
+
+static const lisp_object* firstPrimVectorSeq(const ISeq *is) {
+	assert(is->obj.type == PRIMVECTORSEQ_type);
+	const PrimVectorSeq *s = (PrimVectorSeq*)is;
+	return boxElement(s->vec->type, s->leaf, s->i & NODE_BITMASK);
+}
+
+static const ISeq* nextPrimVectorSeq(const ISeq *is) {
+	assert(is->obj.type == PRIMVECTORSEQ_type);
+	const PrimVectorSeq *s = (PrimVectorSeq*)is;
+	size_t i = s->i + 1;
+	if(i < s->vec->count)
+		return (ISeq*) NewPrimVectorSeq(NULL, s->vec, (i & NODE_BITMASK) ? s->leaf : NULL, i);
+	return NULL;
+}
+
+// PrimVector Function Definitions.
+
+static const PrimVector *NewPrimVector(PrimType type, size_t count, size_t shift, const PrimNode *root, const void *tail) {
+	PrimVector *ret = GC_MALLOC(sizeof(*ret));
+	memcpy(ret, EmptyPrimVector(type), sizeof(*ret));
+	ret->count = count;
+	ret->shift = shift;
+	ret->root = root;
+	ret->tail = tail;
+	return ret;
+}
+
+// Builds the trie from the bottom up, as CreateVector does.  leaves holds the full leaves before the tail, in order.
+// count is not 0.
+static const PrimVector *fromLeaves(PrimType type, size_t count, const void **leaves, const void *tail) {
+	size_t n = (count - 1) >> NODE_LOG_SIZE;
+	if(n == 0)
+		return NewPrimVector(type, count, NODE_LOG_SIZE, &EmptyPrimNode, tail);
+	size_t shift = NODE_LOG_SIZE;
+	while(n > NODE_SIZE) {
+		// Each parent is made from children already read, so the level is overwritten in place.
+		size_t parents = (n + NODE_BITMASK) >> NODE_LOG_SIZE;
+		for(size_t i = 0; i < parents; i++) {
+			size_t first = i << NODE_LOG_SIZE;
+			size_t width = n - first < NODE_SIZE ? n - first : NODE_SIZE;
+			leaves[i] = NewPrimNode(width, leaves + first);
+		}
+		n = parents;
+		shift += NODE_LOG_SIZE;
+	}
+
+	return NewPrimVector(type, count, shift, NewPrimNode(n, leaves), tail);
+}
+
+const PrimVector *CreatePrimVector(PrimType type, size_t count, lisp_object const* const* entries) {
+	if(count == 0) return EmptyPrimVector(type);
+	size_t tailoff = (count - 1) & ~(size_t)NODE_BITMASK;
+	const void **leaves = GC_MALLOC((tailoff >> NODE_LOG_SIZE) * sizeof(*leaves));
+	void *leaf = NULL;
+	for(size_t i = 0; i < count; i += NODE_SIZE) {
+		leaf = NewLeaf(type);
+		for(size_t j = 0; j < NODE_SIZE && i + j < count; j++)
+			storeElement(type, leaf, j, entries[i + j]);
+		if(i < tailoff)
+			leaves[i >> NODE_LOG_SIZE] = leaf;
+	}
+	return fromLeaves(type, count, leaves, leaf);
+}
+
+const PrimVector *CreatePrimVectorFromArray(PrimType type, size_t count, const void *values) {
+	if(count == 0) return EmptyPrimVector(type);
+	size_t tailoff = (count - 1) & ~(size_t)NODE_BITMASK;
+	size_t size = elementSize(type);
+	const void **leaves = GC_MALLOC((tailoff >> NODE_LOG_SIZE) * sizeof(*leaves));
+	void *leaf = NULL;
+	for(size_t i = 0; i < count; i += NODE_SIZE) {
+		leaf = copyLeaf(type, (const char*)values + i * size, count - i < NODE_SIZE ? count - i : NODE_SIZE);
+		if(i < tailoff)
+			leaves[i >> NODE_LOG_SIZE] = leaf;
+	}
+	return fromLeaves(type, count, leaves, leaf);
+}
+
+const PrimVector *EmptyPrimVector(PrimType type) {
+	switch(type) {
+		case PRIM_LONG:
+			return &_EmptyLongVector;
+		case PRIM_DOUBLE:
+			return &_EmptyDoubleVector;
+		case PRIM_BYTE:
+			return &_EmptyByteVector;
+	}
+	__builtin_unreachable();
+}
+
+PrimType primVectorType(const PrimVector *v) {
+	assert(v->obj.type == PRIMVECTOR_type);
+	return v->type;
+}
+
+static const ISeq* seqPrimVector(const Seqable *self) {
+	assert(self->obj.type == PRIMVECTOR_type);
+	const PrimVector *v = (const PrimVector*) self;
+	if(v->count == 0)
+		return NULL;
+	return (ISeq*)NewPrimVectorSeq(NULL, v, NULL, 0);
+}
+
+static size_t countPrimVector(const ICollection *ic) {
+	assert(ic->obj.type == PRIMVECTOR_type);
+	return ((const PrimVector*) ic)->count;
+}
+
+static PrimNode *pushTail(const PrimVector *v, size_t level, const PrimNode *parent, const void *leaf) {
+	size_t idx = ((v->count - 1) >> level) & NODE_BITMASK;
+	PrimNode *ret = NewPrimNode(NODE_SIZE, parent->array);
+	if(level == NODE_LOG_SIZE) {
+		ret->array[idx] = leaf;
+	} else {
+		const PrimNode *child = parent->array[idx];
+		ret->array[idx] = child ? pushTail(v, level - NODE_LOG_SIZE, child, leaf)
+								: newPath(level - NODE_LOG_SIZE, leaf);
+	}
+	return ret;
+}
+
+static const IVector* consPrimVector(const IVector *iv, const lisp_object *x) {
+	assert(iv->obj.type == PRIMVECTOR_type);
+	const PrimVector *v = (const PrimVector*) iv;
+	size_t tailCount = v->count - tailoffPV(v);
+	if(tailCount < NODE_SIZE) {
+		void *tail = copyLeaf(v->type, v->tail, tailCount);
+		storeElement(v->type, tail, tailCount, x);
+		return (IVector*) NewPrimVector(v->type, v->count + 1, v->shift, v->root, tail);
+	}
+	// The full tail goes into the trie as it is.
+	void *tail = NewLeaf(v->type);
+	storeElement(v->type, tail, 0, x);
+	const PrimNode *root = NULL;
+	size_t shift = v->shift;
+	if((v->count >> NODE_LOG_SIZE) > ((size_t)1 << v->shift)) {
+		PrimNode *newRoot = NewPrimNode(0, NULL);
+		newRoot->array[0] = v->root;
+		newRoot->array[1] = newPath(v->shift, v->tail);
+		root = newRoot;
+		shift += NODE_LOG_SIZE;
+	} else {
+		root = pushTail(v, v->shift, v->root, v->tail);
+	}
+	return (IVector*) NewPrimVector(v->type, v->count + 1, shift, root, tail);
+}
+
+static const PrimNode *popTail(const PrimVector *v, size_t level, const PrimNode *node) {
+	size_t subindex = ((v->count - 2) >> level) & NODE_BITMASK;
+	if(level > NODE_LOG_SIZE) {
+		const PrimNode *newChild = popTail(v, level - NODE_LOG_SIZE, node->array[subindex]);
+		if(newChild == NULL && subindex == 0)
+			return NULL;
+		PrimNode *ret = NewPrimNode(NODE_SIZE, node->array);
+		ret->array[subindex] = newChild;
+		return ret;
+	}
+	if(subindex == 0)
+		return NULL;
+	PrimNode *ret = NewPrimNode(NODE_SIZE, node->array);
+	ret->array[subindex] = NULL;
+	return ret;
+}
+
+static const IStack* popPrimVector(const IStack *is) {
+	assert(is->obj.type == PRIMVECTOR_type);
+	const PrimVector *v = (const PrimVector*) is;
+	if(v->count == 0) {
+		exception e = {IllegalStateException, "Can't pop empty vector"};
+		Raise(e);
+	}
+	if(v->count == 1)
+		return (IStack*) withMeta((lisp_object*) EmptyPrimVector(v->type), v->obj.meta);
+	if(v->count - tailoffPV(v) > 1)
+		return (IStack*) NewPrimVector(v->type, v->count - 1, v->shift, v->root, v->tail);
+
+	const void *tail = leafFor(v, v->count - 2);
+	const PrimNode *root = popTail(v, v->shift, v->root);
+	size_t shift = v->shift;
+	if(root == NULL)
+		root = &EmptyPrimNode;
+	if(shift > NODE_LOG_SIZE && root->array[1] == NULL) {
+		root = root->array[0];
+		shift -= NODE_LOG_SIZE;
+	}
+	return (IStack*) NewPrimVector(v->type, v->count - 1, shift, root, tail);
+}
+
+static const PrimNode *doAssoc(const PrimVector *v, size_t level, const PrimNode *node, size_t n, const lisp_object *val) {
+	PrimNode *ret = NewPrimNode(NODE_SIZE, node->array);
+	size_t subindex = (n >> level) & NODE_BITMASK;
+	if(level == NODE_LOG_SIZE) {
+		void *leaf = copyLeaf(v->type, node->array[subindex], NODE_SIZE);
+		storeElement(v->type, leaf, n & NODE_BITMASK, val);
+		ret->array[subindex] = leaf;
+	} else {
+		ret->array[subindex] = doAssoc(v, level - NODE_LOG_SIZE, node->array[subindex], n, val);
+	}
+	return ret;
+}
+
+static const IVector* assocNPrimVector(const IVector *iv, size_t n, const lisp_object *val) {
+	assert(iv->obj.type == PRIMVECTOR_type);
+	const PrimVector *v = (const PrimVector*) iv;
+	if(n < v->count) {
+		size_t tailoff = tailoffPV(v);
+		if(n >= tailoff) {
+			void *tail = copyLeaf(v->type, v->tail, v->count - tailoff);
+			storeElement(v->type, tail, n - tailoff, val);
+			return (IVector*) NewPrimVector(v->type, v->count, v->shift, v->root, tail);
+		}
+		return (IVector*) NewPrimVector(v->type, v->count, v->shift, doAssoc(v, v->shift, v->root, n, val), v->tail);
+	}
+
+	if(n == v->count)
+		return consPrimVector(iv, val);
+	exception e = {IndexOutOfBoundException, ""};
+	Raise(e);
+	__builtin_unreachable();
+}
+
+static const lisp_object *nthPrimVector(const IVector *iv, size_t n, const lisp_object *notFound) {
+	assert(iv->obj.type == PRIMVECTOR_type);
+	const PrimVector *v = (const PrimVector*) iv;
+	if(n < v->count)
+		return boxElement(v->type, leafFor(v, n), n & NODE_BITMASK);
+	return notFound;
+}
+
+static const void *leafFor(const PrimVector *v, size_t i) {
+	assert(i < v->count);
+	if(i >= tailoffPV(v))
+		return v->tail;
+	const void *node = v->root;
+	for(size_t level = v->shift; level > 0; level -= NODE_LOG_SIZE)
+		node = ((const PrimNode*) node)->array[(i >> level) & NODE_BITMASK];
+	return node;
+}
+
+static size_t tailoffPV(const PrimVector *v) {
+	if(v->count == 0)
+		return 0;
+	return (v->count - 1) & ~(size_t)NODE_BITMASK;
+}
+
+// The number of elements in the leaf starting at i.
+static size_t leafCount(const PrimVector *v, size_t i) {
+	return v->count - i < NODE_SIZE ? v->count - i : NODE_SIZE;
+}
+
+// Matches the HashEq of a Vector of the boxed elements.
+static uint32_t HashEqPrimVector(const lisp_object *obj) {
+	assert(obj->type == PRIMVECTOR_type);
+	const PrimVector *v = (const PrimVector*) obj;
+	if(v->count == 0)
+		return mixCollHash(1, 0);
+	if(v->hash == 0) {
+		uint32_t hash = 1;
+		for(size_t i = 0; i < v->count; i += NODE_SIZE) {
+			const void *leaf = leafFor(v, i);
+			for(size_t j = 0; j < leafCount(v, i); j++)
+				hash = 31 * hash + hashElement(v->type, leaf, j);
+		}
+		((PrimVector*)v)->hash = mixCollHash(hash, v->count);
+	}
+	return v->hash;
+}
+
+// Kernels
+
+// Each kernel runs over one leaf of n elements.  The scalar kernels take the same steps as the AVX2 ones, so a double
+// result does not depend on which ran.
+typedef struct {	// Kernels
+	unsigned long (*sumLongs)(const long *x, size_t n);
+	unsigned long (*dotLongs)(const long *x, const long *y, size_t n);
+	double (*sumDoubles)(const double *x, size_t n);
+	long (*sumBytes)(const signed char *x, size_t n);
+	double (*dotDoubles)(const double *x, const double *y, size_t n);
+	long (*dotBytes)(const signed char *x, const signed char *y, size_t n);
+	void (*mulAddLongs)(long *out, const long *x, size_t n, long a, long b);
+	void (*mulAddDoubles)(double *out, const double *x, size_t n, double a, double b);
+	void (*mulAddBytes)(signed char *out, const signed char *x, size_t n, signed char a, signed char b);
+} Kernels;
+
+static unsigned long sumLongs(const long *x, size_t n) {
+	unsigned long sum = 0;
+	for(size_t i = 0; i < n; i++)
+		sum += (unsigned long)x[i];
+	return sum;
+}
+
+// Four lanes, folded as ((lane 0 + lane 2) + (lane 1 + lane 3)), then the elements left over.
+static double sumDoubles(const double *x, size_t n) {
+	double lane[4] = {0, 0, 0, 0};
+	size_t i = 0;
+	for(; i + 4 <= n; i += 4)
+		for(size_t j = 0; j < 4; j++)
+			lane[j] += x[i + j];
+	double sum = (lane[0] + lane[2]) + (lane[1] + lane[3]);
+	for(; i < n; i++)
+		sum += x[i];
+	return sum;
+}
+
+static long sumBytes(const signed char *x, size_t n) {
+	long sum = 0;
+	for(size_t i = 0; i < n; i++)
+		sum += x[i];
+	return sum;
+}
+
+static unsigned long dotLongs(const long *x, const long *y, size_t n) {
+	unsigned long sum = 0;
+	for(size_t i = 0; i < n; i++)
+		sum += (unsigned long)x[i] * (unsigned long)y[i];
+	return sum;
+}
+
+static double dotDoubles(const double *x, const double *y, size_t n) {
+	double lane[4] = {0, 0, 0, 0};
+	size_t i = 0;
+	for(; i + 4 <= n; i += 4)
+		for(size_t j = 0; j < 4; j++)
+			lane[j] += x[i + j] * y[i + j];
+	double sum = (lane[0] + lane[2]) + (lane[1] + lane[3]);
+	for(; i < n; i++)
+		sum += x[i] * y[i];
+	return sum;
+}
+
+static long dotBytes(const signed char *x, const signed char *y, size_t n) {
+	long sum = 0;
+	for(size_t i = 0; i < n; i++)
+		sum += x[i] * y[i];
+	return sum;
+}
+
+static void mulAddLongs(long *out, const long *x, size_t n, long a, long b) {
+	for(size_t i = 0; i < n; i++)
+		out[i] = (long)((unsigned long)a * (unsigned long)x[i] + (unsigned long)b);
+}
+
+static void mulAddDoubles(double *out, const double *x, size_t n, double a, double b) {
+	for(size_t i = 0; i < n; i++)
+		out[i] = a * x[i] + b;
+}
+
+static void mulAddBytes(signed char *out, const signed char *x, size_t n, signed char a, signed char b) {
+	for(size_t i = 0; i < n; i++)
+		out[i] = (signed char)(a * x[i] + b);
+}
+
+static const Kernels ScalarKernels = {
+	sumLongs,		// sumLongs
+	dotLongs,		// dotLongs
+	sumDoubles,		// sumDoubles
+	sumBytes,		// sumBytes
+	dotDoubles,		// dotDoubles
+	dotBytes,		// dotBytes
+	mulAddLongs,	// mulAddLongs
+	mulAddDoubles,	// mulAddDoubles
+	mulAddBytes,	// mulAddBytes
+};
+
+#ifdef AVX2_KERNELS
+
+TARGET_AVX2 static unsigned long sumLongsAVX2(const long *x, size_t n) {
+	__m256i acc = _mm256_setzero_si256();
+	size_t i = 0;
+	for(; i + 4 <= n; i += 4)
+		acc = _mm256_add_epi64(acc, _mm256_loadu_si256((const __m256i*)(x + i)));
+	unsigned long lane[4];
+	_mm256_storeu_si256((__m256i*)lane, acc);
+	unsigned long sum = lane[0] + lane[1] + lane[2] + lane[3];
+	for(; i < n; i++)
+		sum += (unsigned long)x[i];
+	return sum;
+}
+
+// AVX2 has no 64 bit multiply, so the low 64 bits of each product are built from 32 bit ones: a * b is
+// alo * blo + ((ahi * blo + alo * bhi) << 32), modulo 2^64, which is how the scalar kernels wrap.
+TARGET_AVX2 static __m256i mulLongs(__m256i a, __m256i b) {
+	__m256i lo = _mm256_mul_epu32(a, b);
+	__m256i cross = _mm256_add_epi64(_mm256_mul_epu32(_mm256_srli_epi64(a, 32), b), _mm256_mul_epu32(a, _mm256_srli_epi64(b, 32)));
+	return _mm256_add_epi64(lo, _mm256_slli_epi64(cross, 32));
+}
+
+TARGET_AVX2 static unsigned long dotLongsAVX2(const long *x, const long *y, size_t n) {
+	__m256i acc = _mm256_setzero_si256();
+	size_t i = 0;
+	for(; i + 4 <= n; i += 4)
+		acc = _mm256_add_epi64(acc, mulLongs(_mm256_loadu_si256((const __m256i*)(x + i)), _mm256_loadu_si256((const __m256i*)(y + i))));
+	unsigned long lane[4];
+	_mm256_storeu_si256((__m256i*)lane, acc);
+	unsigned long sum = lane[0] + lane[1] + lane[2] + lane[3];
+	for(; i < n; i++)
+		sum += (unsigned long)x[i] * (unsigned long)y[i];
+	return sum;
+}
+
+TARGET_AVX2 static void mulAddLongsAVX2(long *out, const long *x, size_t n, long a, long b) {
+	const __m256i va = _mm256_set1_epi64x(a);
+	const __m256i vb = _mm256_set1_epi64x(b);
+	size_t i = 0;
+	for(; i + 4 <= n; i += 4)
+		_mm256_storeu_si256((__m256i*)(out + i), _mm256_add_epi64(mulLongs(va, _mm256_loadu_si256((const __m256i*)(x + i))), vb));
+	for(; i < n; i++)
+		out[i] = (long)((unsigned long)a * (unsigned long)x[i] + (unsigned long)b);
+}
+
+// Adds the high half of acc to the low half, then the two lanes left, as sumDoubles folds its lanes.
+TARGET_AVX2 static double foldDoubles(__m256d acc) {
+	__m128d half = _mm_add_pd(_mm256_castpd256_pd128(acc), _mm256_extractf128_pd(acc, 1));
+	return _mm_cvtsd_f64(_mm_add_sd(half, _mm_unpackhi_pd(half, half)));
+}
+
+TARGET_AVX2 static double sumDoublesAVX2(const double *x, size_t n) {
+	__m256d acc = _mm256_setzero_pd();
+	size_t i = 0;
+	for(; i + 4 <= n; i += 4)
+		acc = _mm256_add_pd(acc, _mm256_loadu_pd(x + i));
+	double sum = foldDoubles(acc);
+	for(; i < n; i++)
+		sum += x[i];
+	return sum;
+}
+
+// Flipping the sign bit makes each byte x + 128 unsigned, which sad_epu8 sums in groups of 8.
+TARGET_AVX2 static long sumBytesAVX2(const signed char *x, size_t n) {
+	const __m256i bias = _mm256_set1_epi8((char)0x80);
+	__m256i acc = _mm256_setzero_si256();
+	size_t i = 0;
+	for(; i + 32 <= n; i += 32) {
+		__m256i u = _mm256_xor_si256(_mm256_loadu_si256((const __m256i*)(x + i)), bias);
+		acc = _mm256_add_epi64(acc, _mm256_sad_epu8(u, _mm256_setzero_si256()));
+	}
+	long lane[4];
+	_mm256_storeu_si256((__m256i*)lane, acc);
+	long sum = lane[0] + lane[1] + lane[2] + lane[3] - 128 * (long)i;
+	for(; i < n; i++)
+		sum += x[i];
+	return sum;
+}
+
+TARGET_AVX2 static double dotDoublesAVX2(const double *x, const double *y, size_t n) {
+	__m256d acc = _mm256_setzero_pd();
+	size_t i = 0;
+	for(; i + 4 <= n; i += 4)
+		acc = _mm256_add_pd(acc, _mm256_mul_pd(_mm256_loadu_pd(x + i), _mm256_loadu_pd(y + i)));
+	double sum = foldDoubles(acc);
+	for(; i < n; i++)
+		sum += x[i] * y[i];
+	return sum;
+}
+
+// Widens 16 bytes at a time to 16 bits.  madd_epi16 multiplies them and adds neighbouring products into 32 bit lanes,
+// which cannot overflow within a leaf.
+TARGET_AVX2 static long dotBytesAVX2(const signed char *x, const signed char *y, size_t n) {
+	__m256i acc = _mm256_setzero_si256();
+	size_t i = 0;
+	for(; i + 16 <= n; i += 16) {
+		__m256i a = _mm256_cvtepi8_epi16(_mm_loadu_si128((const __m128i*)(x + i)));
+		__m256i b = _mm256_cvtepi8_epi16(_mm_loadu_si128((const __m128i*)(y + i)));
+		acc = _mm256_add_epi32(acc, _mm256_madd_epi16(a, b));
+	}
+	int lane[8];
+	_mm256_storeu_si256((__m256i*)lane, acc);
+	long sum = 0;
+	for(size_t j = 0; j < 8; j++)
+		sum += lane[j];
+	for(; i < n; i++)
+		sum += x[i] * y[i];
+	return sum;
+}
+
+TARGET_AVX2 static void mulAddDoublesAVX2(double *out, const double *x, size_t n, double a, double b) {
+	const __m256d va = _mm256_set1_pd(a);
+	const __m256d vb = _mm256_set1_pd(b);
+	size_t i = 0;
+	for(; i + 4 <= n; i += 4)
+		_mm256_storeu_pd(out + i, _mm256_add_pd(_mm256_mul_pd(va, _mm256_loadu_pd(x + i)), vb));
+	for(; i < n; i++)
+		out[i] = a * x[i] + b;
+}
+
+// Works in 16 bits, then keeps the low byte of each result, which is the byte the scalar kernel wraps to.
+TARGET_AVX2 static void mulAddBytesAVX2(signed char *out, const signed char *x, size_t n, signed char a, signed char b) {
+	const __m256i va = _mm256_set1_epi16(a);
+	const __m256i vb = _mm256_set1_epi16(b);
+	const __m256i low = _mm256_set1_epi16(0xFF);
+	size_t i = 0;
+	for(; i + 16 <= n; i += 16) {
+		__m256i w = _mm256_cvtepi8_epi16(_mm_loadu_si128((const __m128i*)(x + i)));
+		w = _mm256_and_si256(_mm256_add_epi16(_mm256_mullo_epi16(w, va), vb), low);
+		_mm_storeu_si128((__m128i*)(out + i), _mm_packus_epi16(_mm256_castsi256_si128(w), _mm256_extracti128_si256(w, 1)));
+	}
+	for(; i < n; i++)
+		out[i] = (signed char)(a * x[i] + b);
+}
+
+static const Kernels AVX2Kernels = {
+	sumLongsAVX2,		// sumLongs
+	dotLongsAVX2,		// dotLongs
+	sumDoublesAVX2,		// sumDoubles
+	sumBytesAVX2,		// sumBytes
+	dotDoublesAVX2,		// dotDoubles
+	dotBytesAVX2,		// dotBytes
+	mulAddLongsAVX2,	// mulAddLongs
+	mulAddDoublesAVX2,	// mulAddDoubles
+	mulAddBytesAVX2,	// mulAddBytes
+};
+
+#endif
+
+static const Kernels *kernels(void) {
+#ifdef AVX2_KERNELS
+	if(__builtin_cpu_supports("avx2"))
+		return &AVX2Kernels;
+#endif
+	return &ScalarKernels;
+}
+
+const lisp_object *reducePrimVector(const PrimVector *v, const IFn *f, const lisp_object *init) {
+	assert(v->obj.type == PRIMVECTOR_type);
+	const lisp_object *acc = init;
+	for(size_t i = 0; i < v->count; i += NODE_SIZE) {
+		const void *leaf = leafFor(v, i);
+		for(size_t j = 0; j < leafCount(v, i); j++)
+			acc = f->obj.fns->IFnFns->invoke2(f, acc, boxElement(v->type, leaf, j));
+	}
+	return acc;
+}
+
+const lisp_object *sumPrimVector(const PrimVector *v) {
+	assert(v->obj.type == PRIMVECTOR_type);
+	const Kernels *k = kernels();
+	unsigned long lsum = 0;
+	double dsum = 0;
+	for(size_t i = 0; i < v->count; i += NODE_SIZE) {
+		const void *leaf = leafFor(v, i);
+		switch(v->type) {
+			case PRIM_LONG:
+				lsum += k->sumLongs(leaf, leafCount(v, i));
+				break;
+			case PRIM_DOUBLE:
+				dsum += k->sumDoubles(leaf, leafCount(v, i));
+				break;
+			case PRIM_BYTE:
+				lsum += (unsigned long)k->sumBytes(leaf, leafCount(v, i));
+				break;
+		}
+	}
+	if(v->type == PRIM_DOUBLE)
+		return (lisp_object*)NewFloat(dsum);
+	return (lisp_object*)NewInteger((long)lsum);
+}
+
+const lisp_object *dotPrimVector(const PrimVector *x, const PrimVector *y) {
+	assert(x->obj.type == PRIMVECTOR_type);
+	assert(y->obj.type == PRIMVECTOR_type);
+	if(x->type != y->type || x->count != y->count) {
+		exception e = {IllegalArgumentException, "Dot product needs vectors of the same type and length"};
+		Raise(e);
+	}
+	// Vectors of the same count have tries of the same shape, so their leaves line up.
+	const Kernels *k = kernels();
+	unsigned long lsum = 0;
+	double dsum = 0;
+	for(size_t i = 0; i < x->count; i += NODE_SIZE) {
+		const void *xleaf = leafFor(x, i);
+		const void *yleaf = leafFor(y, i);
+		switch(x->type) {
+			case PRIM_LONG:
+				lsum += k->dotLongs(xleaf, yleaf, leafCount(x, i));
+				break;
+			case PRIM_DOUBLE:
+				dsum += k->dotDoubles(xleaf, yleaf, leafCount(x, i));
+				break;
+			case PRIM_BYTE:
+				lsum += (unsigned long)k->dotBytes(xleaf, yleaf, leafCount(x, i));
+				break;
+		}
+	}
+	if(x->type == PRIM_DOUBLE)
+		return (lisp_object*)NewFloat(dsum);
+	return (lisp_object*)NewInteger((long)lsum);
+}
+
+const PrimVector *mulAddPrimVector(const PrimVector *v, const lisp_object *a, const lisp_object *b) {
+	assert(v->obj.type == PRIMVECTOR_type);
+	// Converting a and b first raises on a bad argument even when v is empty.
+	double da = 0, db = 0;
+	long la = 0, lb = 0;
+	if(v->type == PRIM_DOUBLE) {
+		da = toDouble(a);
+		db = toDouble(b);
+	} else if(v->type == PRIM_LONG) {
+		la = toLong(a);
+		lb = toLong(b);
+	} else {
+		la = toByte(a);
+		lb = toByte(b);
+	}
+	if(v->count == 0)
+		return v;
+
+	const Kernels *k = kernels();
+	size_t tailoff = tailoffPV(v);
+	const void **leaves = GC_MALLOC((tailoff >> NODE_LOG_SIZE) * sizeof(*leaves));
+	void *out = NULL;
+	for(size_t i = 0; i < v->count; i += NODE_SIZE) {
+		const void *leaf = leafFor(v, i);
+		out = NewLeaf(v->type);
+		switch(v->type) {
+			case PRIM_LONG:
+				k->mulAddLongs(out, leaf, leafCount(v, i), la, lb);
+				break;
+			case PRIM_DOUBLE:
+				k->mulAddDoubles(out, leaf, leafCount(v, i), da, db);
+				break;
+			case PRIM_BYTE:
+				k->mulAddBytes(out, leaf, leafCount(v, i), (signed char)la, (signed char)lb);
+				break;
+		}
+		if(i < tailoff)
+			leaves[i >> NODE_LOG_SIZE] = out;
+	}
+	return fromLeaves(v->type, v->count, leaves, out);
+}
@@ -0,0 +1,36 @@
+#ifndef PRIM_VECTOR_H
+#define PRIM_VECTOR_H
+
+#include "Interfaces.h"
+#include "LispObject.h"
+
+// Vectors of one primitive type, like Clojure's vector-of.  The trie is a Vector's, but its leaves hold the values
+// unboxed, so a vector of longs or doubles takes 8 bytes an element and a vector of bytes 1.  nth boxes the value it
+// returns, and cons and assocN convert any number to the element type.  A byte must be in [-128, 127].
+typedef struct PrimVector_struct PrimVector;
+
+typedef enum {	// PrimType
+	PRIM_LONG,
+	PRIM_DOUBLE,
+	PRIM_BYTE,
+} PrimType;
+
+const PrimVector *CreatePrimVector(PrimType type, size_t count, lisp_object const* const* entries);
+// Copies count values of the element type from values, a long, double or signed char array.
+const PrimVector *CreatePrimVectorFromArray(PrimType type, size_t count, const void *values);
+const PrimVector *EmptyPrimVector(PrimType type);
+PrimType primVectorType(const PrimVector *v);
+
+// Kernels that run over the unboxed leaves, with AVX2 when the processor has it.  Long and byte arithmetic wraps, as
+// it does in the element type.  Double sums are kept in four lanes whatever the processor, so they round the same way
+// with or without AVX2, though not as a left to right sum would.
+// Calls (f acc x) on each element in turn, starting from init, and returns the last result.
+const lisp_object *reducePrimVector(const PrimVector *v, const IFn *f, const lisp_object *init);
+// An Integer for long and byte vectors, a Float for double vectors.
+const lisp_object *sumPrimVector(const PrimVector *v);
+// x and y must have the same type and count.
+const lisp_object *dotPrimVector(const PrimVector *x, const PrimVector *y);
+// v with each element x replaced by a*x + b.  a and b are converted to the element type.
+const PrimVector *mulAddPrimVector(const PrimVector *v, const lisp_object *a, const lisp_object *b);
+
+#endif /* PRIM_VECTOR_H */
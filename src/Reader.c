@@ -9,6 +9,7 @@
 
 #include <stdio.h>	// For Debugging.
 
+#include "ArrayMap.h"
 #include "Bool.h"
 #include "Compiler.h"
 #include "Error.h"
@@ -18,19 +19,21 @@
 #include "Map.h"
 #include "Namespace.h"
 #include "Numbers.h"
+#include "Set.h"
 #include "Strings.h"
 #include "StringWriter.h"
 #include "Symbol.h"
 #include "Util.h"
 #include "Vector.h"
 
-const lisp_object DONE_lisp_object = {DONE_type, sizeof(lisp_object), NULL, NULL, NULL, NULL};
-const lisp_object NOOP_lisp_object = {NOOP_type, sizeof(lisp_object), NULL, NULL, NULL, NULL};
-const lisp_object EOF_lisp_object  = {EOF_type, sizeof(lisp_object), NULL, NULL, NULL, NULL};
+const lisp_object DONE_lisp_object = {DONE_type, sizeof(lisp_object), NULL, NULL};
+const lisp_object NOOP_lisp_object = {NOOP_type, sizeof(lisp_object), NULL, NULL};
+const lisp_object EOF_lisp_object  = {EOF_type, sizeof(lisp_object), NULL, NULL};
 regex_t symbol_regex;
 
 typedef const lisp_object* (*MacroFn)(LineNumberReader*, char /* *lisp_object opts, *lisp_object pendingForms */);
 static MacroFn macros[128];
+static MacroFn dispatchMacros[128];
 
 // Static Function Declarations.
 static MacroFn get_macro(int ch);
@@ -51,6 +54,10 @@ static const lisp_object *UnmatchedParenReader(LineNumberReader* input, char ch
 static const lisp_object *WrappingReader(LineNumberReader* input, char ch /* *lisp_object opts, *lisp_object pendingForms */);
 static const lisp_object *CommentReader(LineNumberReader* input, char ch /* *lisp_object opts, *lisp_object pendingForms */);
 static const lisp_object *MetaReader(LineNumberReader* input, char ch /* *lisp_object opts, *lisp_object pendingForms */);
+static const lisp_object *DispatchReader(LineNumberReader* input, char ch /* *lisp_object opts, *lisp_object pendingForms */);
+
+// Dispatch Macros
+static const lisp_object *SetReader(LineNumberReader* input, char ch /* *lisp_object opts, *lisp_object pendingForms */);
 
 void init_reader() {
 	printf("In init_reader\n");
@@ -72,7 +79,9 @@ void init_reader() {
 	// macros['`'] = new SyntaxQuoteReader();
 	// macros['~'] = new UnquoteReader();
 	// macros['%'] = new ArgReader();
-	// macros['#'] = new DispatchReader();
+	macros['#'] = DispatchReader;
+
+	dispatchMacros['{'] = SetReader;
 
 	const char *const pattern = ":?\\([^[:digit:]/].*/\\)?\\(/|[^[:digit:]/][^/]*\\)";		// [:]?([\\D&&[^/]].*/)?(/|[\\D&&[^/]][^/]*)
 	int i = regcomp(&symbol_regex, pattern, 0);
@@ -106,7 +115,7 @@ const lisp_object *read(LineNumberReader *input, bool EOF_is_error, char return_
 		MacroFn macro = get_macro(ch);
 		if(macro) {
 			const lisp_object *ret = macro(input, (char) ch);
-			if(ret->type == NOOP_type) {
+			if(objectType(ret) == NOOP_type) {
 				continue;
 			}
 			return ret;
@@ -369,7 +378,7 @@ static const lisp_object **ReadDelimitedList(LineNumberReader *input, char delim
 
 	while(true) {
 		const lisp_object *form = read(input, true, delim);
-		if(form->type == EOF_type) {
+		if(form != NULL && objectType(form) == EOF_type) {
 			exception e = {RuntimeException, firstLine > 0 ?
 				"EOF while reading" :
 				WriteString(AddInt(AddString(NewStringWriter(), "EOF while reading, starting at line "), firstLine))};
@@ -401,7 +410,7 @@ static const lisp_object *ListReader(LineNumberReader* input, __attribute__((unu
 			(lisp_object*) ColumnKW, (lisp_object*) NewInteger(column),
 		};
 		size_t margc = sizeof(margs) / sizeof(margs[0]);
-		return withMeta(s, (IMap*) CreateHashMap(margc, margs));
+		return withMeta(s, CreateArrayMap(margc, margs));
 	}
 	return s;
 }
@@ -419,7 +428,32 @@ static const lisp_object *MapReader(LineNumberReader* input, __attribute__((unus
 		exception e = {RuntimeException, "Map literal must contain an even number of forms"};
 		Raise(e);
 	}
-	return (lisp_object*)CreateHashMap(count, list);
+	return (lisp_object*)CreateArrayMap(count, list);
+}
+
+static const lisp_object *SetReader(LineNumberReader* input, __attribute__((unused)) char ch /* *lisp_object opts, *lisp_object pendingForms */) {
+	size_t count;
+	const lisp_object **list = ReadDelimitedList(input, '}', &count);
+	const HashSet *ret = CreateHashSet(count, list);
+	if(((ICollection*)ret)->obj.fns->ICollectionFns->count((ICollection*)ret) != count) {
+		exception e = {IllegalArgumentException, "Duplicate key in set literal"};
+		Raise(e);
+	}
+	return (lisp_object*)ret;
+}
+
+static const lisp_object *DispatchReader(LineNumberReader* input, __attribute__((unused)) char ch /* *lisp_object opts, *lisp_object pendingForms */) {
+	int ch2 = getcr(input);
+	if(ch2 == EOF) {
+		exception e = {RuntimeException, "EOF while reading character"};
+		Raise(e);
+	}
+	MacroFn fn = (size_t)ch2 < sizeof(dispatchMacros)/sizeof(*dispatchMacros) ? dispatchMacros[ch2] : NULL;
+	if(fn == NULL) {
+		exception e = {RuntimeException, WriteString(AddChar(AddString(NewStringWriter(), "No dispatch macro for: "), ch2))};
+		Raise(e);
+	}
+	return fn(input, (char) ch2);
 }
 
 static const lisp_object *UnmatchedParenReader(__attribute__((unused)) LineNumberReader* input, char ch /* *lisp_object opts, *lisp_object pendingForms */) {
@@ -444,8 +478,8 @@ static const lisp_object *MetaReader(LineNumberReader* input, __attribute__((unu
 	size_t line = getLineNumber(input);
 	size_t column = line ? getColumnNumber(input) - 1 : 0;
 	const lisp_object *o = read(input, true, '\0');
-	const IMap *meta = (IMap*) EmptyHashMap;
-	switch(o->type) {
+	const IMap *meta = (IMap*) EmptyArrayMap;
+	switch(objectType(o)) {
 		case SYMBOL_type:
 		case STRING_type:
 			meta = meta->obj.fns->IMapFns->assoc(meta, (lisp_object*)tagKW, o);
@@ -453,6 +487,7 @@ static const lisp_object *MetaReader(LineNumberReader* input, __attribute__((unu
 		case KEYWORD_type:
 			meta = meta->obj.fns->IMapFns->assoc(meta, o, (lisp_object*)True);
 			break;
+		case ARRAYMAP_type:
 		case HASHMAP_type:
 			break;
 		default: {
@@ -467,7 +502,7 @@ static const lisp_object *MetaReader(LineNumberReader* input, __attribute__((unu
 		meta = meta->obj.fns->IMapFns->assoc(meta, (lisp_object*)ColumnKW, (lisp_object*)NewInteger(column));
 	}
 
-	const IMap *ometa = o->meta;
+	const IMap *ometa = objectMeta(o);
 	for(const ISeq *s = seq((lisp_object*)meta); s != NULL; s = s->obj.fns->ISeqFns->next(s)) {
 		const MapEntry *kv = (MapEntry*) s->obj.fns->ISeqFns->first(s);
 		ometa = ometa->obj.fns->IMapFns->assoc(ometa, kv->key, kv->val);
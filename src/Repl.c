@@ -6,6 +6,7 @@
 #include "LispObject.h"
 #include "Compiler.h"
 #include "Reader.h"
+#include "Util.h"
 
 static void HandleTopLevelExpression(const lisp_object *const current);
 
@@ -14,7 +15,7 @@ void repl(LineNumberReader *input) {
         printf("Lisp>");
         const lisp_object *current = read(input, false, '\0');
 		assert(current);
-		switch(current->type) {
+		switch(objectType(current)) {
             case EOF_type:
 			case ERROR_type:
                 printf("\n");
@@ -29,6 +30,6 @@ void repl(LineNumberReader *input) {
 static void HandleTopLevelExpression(const lisp_object *const current) {
     if(current) {
 		const lisp_object *result = Eval(current);
-		printf("%s\n", result->toString(result));
+		printf("%s\n", toString(result));
     }
 }
@@ -22,7 +22,7 @@ const lisp_object* invoke0RestFn(const IFn *f) {
 		case 0:
 			return fn->doInvoke0(NULL);
 		default:
-			return NewArityError(0, fn->obj.toString((lisp_object*)fn));
+			return NewArityError(0, fn->obj.fns->toString((lisp_object*)fn));
 	}
 }
 
@@ -38,7 +38,7 @@ const lisp_object* invoke1RestFn(const IFn *f, const lisp_object *arg1) {
 		case 1:
 			return fn->doInvoke1(arg1, NULL);
 		default:
-			return NewArityError(0, fn->obj.toString((lisp_object*)fn));
+			return NewArityError(0, fn->obj.fns->toString((lisp_object*)fn));
 	}
 }
 
@@ -59,7 +59,7 @@ const lisp_object* invoke2RestFn(const IFn *f, const lisp_object *arg1, const li
 		case 2:
 			return fn->doInvoke2(arg1, arg2, NULL);
 		default:
-			return NewArityError(0, fn->obj.toString((lisp_object*)fn));
+			return NewArityError(0, fn->obj.fns->toString((lisp_object*)fn));
 	}
 }
 
@@ -85,7 +85,7 @@ const lisp_object* invoke3RestFn(const IFn *f, const lisp_object *arg1, const li
 		case 3:
 			return fn->doInvoke3(arg1, arg2, arg3, NULL);
 		default:
-			return NewArityError(0, fn->obj.toString((lisp_object*)fn));
+			return NewArityError(0, fn->obj.fns->toString((lisp_object*)fn));
 	}
 }
 
@@ -116,7 +116,7 @@ const lisp_object* invoke4RestFn(const IFn *f, const lisp_object *arg1, const li
 		case 4:
 			return fn->doInvoke4(arg1, arg2, arg3, arg4, NULL);
 		default:
-			return NewArityError(0, fn->obj.toString((lisp_object*)fn));
+			return NewArityError(0, fn->obj.fns->toString((lisp_object*)fn));
 	}
 }
 
@@ -152,7 +152,7 @@ const lisp_object* invoke5RestFn(const IFn *f, const lisp_object *arg1, const li
 		case 5:
 			return fn->doInvoke5(arg1, arg2, arg3, arg4, arg5, NULL);
 		default:
-			return NewArityError(0, fn->obj.toString((lisp_object*)fn));
+			return NewArityError(0, fn->obj.fns->toString((lisp_object*)fn));
 	}
 }
 
@@ -177,6 +177,10 @@ const interfaces _RestFnInterfaces = {
 	&RestFnIFn_vtable,
 	NULL,
 	NULL,
+	NULL,
+	NULL,
+	NULL,
+	NULL,
 };
 
 const interfaces *const RestFnInterfaces = &_RestFnInterfaces;
@@ -198,8 +202,6 @@ const RestFn _creator = {
 	{
 		RESTFN_type,			// type
 		sizeof(_creator),		// size
-		NULL,					// toString
-		NULL,					// Equals
 		(IMap*) &_EmptyHashMap,	// meta
 		&_RestFnInterfaces		// fns
 	},							// obj
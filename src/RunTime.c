@@ -4,6 +4,7 @@
 #include <stdio.h>	// For Debugging.
 
 #include "AFn.h"
+#include "ArrayMap.h"
 #include "Compiler.h"
 #include "Error.h"
 #include "gc.h"
@@ -12,6 +13,7 @@
 #include "LineNumberReader.h"
 #include "lisp_pthread.h"
 #include "Map.h"
+#include "Native.h"
 #include "Reader.h"
 #include "Strings.h"
 #include "StringWriter.h"
@@ -47,8 +49,12 @@ interfaces bootNS_interfaces = {
 	&bootNS_IFn_vtable,	// IFnFns
 	NULL,				// IVectorFns
 	NULL,				// IMapFns
+	NULL,				// ISetFns
+	NULL,				// toString
+	NULL,				// Equals
+	NULL,				// HashEq
 };
-const IFn bootNS = {{IFN_type, sizeof(IFn), NULL, NULL, (IMap*)&_EmptyHashMap, &bootNS_interfaces}};
+const IFn bootNS = {{IFN_type, sizeof(IFn), (IMap*)&_EmptyHashMap, &bootNS_interfaces}};
 
 static const lisp_object *invokeInNS(const IFn *self, const lisp_object *arg1);
 const IFn_vtable InNS_IFn_vtable = {
@@ -69,8 +75,12 @@ interfaces InNS_interfaces = {
 	&bootNS_IFn_vtable,	// IFnFns
 	NULL,				// IVectorFns
 	NULL,				// IMapFns
+	NULL,				// ISetFns
+	NULL,				// toString
+	NULL,				// Equals
+	NULL,				// HashEq
 };
-const IFn InNS = {{IFN_type, sizeof(IFn), NULL, NULL, (IMap*)&_EmptyHashMap, &InNS_interfaces}};
+const IFn InNS = {{IFN_type, sizeof(IFn), (IMap*)&_EmptyHashMap, &InNS_interfaces}};
 
 static const lisp_object *invokeLoadFile(const IFn *self, const lisp_object *arg1);
 const IFn_vtable LoadFile_IFn_vtable = {
@@ -91,8 +101,12 @@ interfaces LoadFile_interfaces = {
 	&LoadFile_IFn_vtable,	// IFnFns
 	NULL,					// IVectorFns
 	NULL,					// IMapFns
+	NULL,					// ISetFns
+	NULL,					// toString
+	NULL,					// Equals
+	NULL,					// HashEq
 };
-const IFn LoadFile = {{IFN_type, sizeof(IFn), NULL, NULL, (IMap*)&_EmptyHashMap, &LoadFile_interfaces}};
+const IFn LoadFile = {{IFN_type, sizeof(IFn), (IMap*)&_EmptyHashMap, &LoadFile_interfaces}};
 
 const Var* RTVar(const char *ns, const char *name) {
 	return internVar(findOrCreateNS(internSymbol2(NULL, ns)), internSymbol2(NULL, name), NULL, true);
@@ -108,7 +122,7 @@ void initRT(void) {
 
 	args[1] = (lisp_object*)NewString("The agent currently running an action on this thread, else nil");
 	AGENT = setDynamic(internVar(LISP_ns, internSymbol1("*agent*"), NULL, true));
-	setMeta(AGENT, (IMap*)CreateHashMap(2, args));
+	setMeta(AGENT, CreateArrayMap(2, args));
 
 	// MATH_CONTEXT			// TODO
 	NS_Var = internVar(LISP_ns, namespaceSymbol, (lisp_object*)&bootNS, true);
@@ -121,12 +135,13 @@ void initRT(void) {
 	const Vector *vec = CreateVector(1, (const lisp_object**)&nameSym);
 	args[3] = (lisp_object*) CreateList(1, (const lisp_object**)&vec);
 	IN_NS_Var = internVar(LISP_ns, inNamespaceSymbol, (lisp_object*)&InNS, true);
-	setMeta(IN_NS_Var, (IMap*)CreateHashMap(4, args));
+	setMeta(IN_NS_Var, CreateArrayMap(4, args));
 
 	args[1] = (lisp_object*)NewString("Sequentially read and evaluate the set of forms contained in the file.");
 	Var *v = internVar(LISP_ns, loadFileSymbol, (lisp_object*)&LoadFile, true);
-	setMeta(v, (IMap*)CreateHashMap(4, args));
+	setMeta(v, CreateArrayMap(4, args));
 	initCompiler();
+	initNative(LISP_ns);
 
 	printf("About to load.\n");
 	fflush(stdout);
@@ -0,0 +1,1002 @@
+#include <assert.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "Set.h"
+
+#include "AFn.h"
+#include "ASeq.h"
+#include "Cons.h"
+#include "EditToken.h"
+#include "gc.h"
+#include "Interfaces.h"
+#include "Murmur3.h"
+#include "nodes.h"
+#include "Util.h"
+
+// One level per NODE_LOG_SIZE bits of the hash, and a collision node below that.
+#define SET_MAX_DEPTH ((32 + NODE_LOG_SIZE - 1) / NODE_LOG_SIZE + 1)
+
+// SetNode
+
+// A node is owned by a transient when its edit points at that transient's EditToken.  Persistent nodes have a NULL edit.
+typedef struct {	// SetNode
+	lisp_object obj;
+	uint32_t datamap;				// Slots holding a key inline.
+	uint32_t nodemap;				// Slots holding a sub-node.
+	const EditToken *edit;
+	size_t capacity;
+	const lisp_object *array[];		// Keys in datamap order, then sub-nodes in nodemap order.
+} SetNode;
+
+// SetCollisionNode
+
+typedef struct {	// SetCollisionNode
+	lisp_object obj;
+	uint32_t hash;
+	size_t count;
+	const lisp_object *array[];		// count keys, in no particular order.
+} SetCollisionNode;
+
+// Node function declarations.
+
+static SetNode *NewSetNode(const EditToken *edit, uint32_t datamap, uint32_t nodemap, size_t capacity);
+static SetCollisionNode *NewSetCollisionNode(uint32_t hash, size_t count);
+static const lisp_object* conjSetNode(const lisp_object *node, const EditToken *edit, size_t shift, uint32_t hash, const lisp_object *key, bool *addedLeaf);
+static const lisp_object* disjSetNode(const lisp_object *node, const EditToken *edit, size_t shift, uint32_t hash, const lisp_object *key, bool *removedLeaf);
+static const lisp_object* findSetNode(const lisp_object *node, size_t shift, uint32_t hash, const lisp_object *key);
+static bool EquivSetNode(const lisp_object *x, const lisp_object *y);
+
+static const SetNode EmptySetNode = {{SET_NODE_type, sizeof(SetNode), NULL, &NullInterface}, 0, 0, NULL, 0};
+
+// SetSeq
+
+typedef struct {	// SetFrame
+	const lisp_object *node;
+	size_t pos;		// Keys are visited first, then sub-nodes.
+} SetFrame;
+
+typedef struct {	// SetSeq
+	lisp_object obj;
+	size_t depth;
+	SetFrame frames[];		// The path from the root to the node holding the current key.
+} SetSeq;
+
+// SetSeq function declarations.
+
+static const SetSeq *CreateSetSeq(SetFrame *frames, size_t depth);
+static const lisp_object* firstSetSeq(const ISeq*);
+static const ISeq* nextSetSeq(const ISeq*);
+
+const Seqable_vtable SetSeq_Seqable_vtable = {
+	seqASeq,	//seq
+};
+
+const ICollection_vtable SetSeq_ICollection_vtable = {
+	countASeq,					// count
+	(ICollectionFn1)consASeq,	// cons
+	emptyASeq,					// empty
+	EquivASeq					// Equiv
+};
+
+const ISeq_vtable SetSeq_ISeq_vtable = {
+	firstSetSeq,	// first
+	nextSetSeq,		// next
+	moreASeq,		// more
+	consASeq,		// cons
+};
+
+interfaces SetSeq_interfaces = {
+	&SetSeq_Seqable_vtable,			// SeqableFns
+	NULL,							// ReversibleFns
+	&SetSeq_ICollection_vtable,		// ICollectionFns
+	NULL,							// IStackFns
+	&SetSeq_ISeq_vtable,			// ISeqFns
+	NULL,							// IFnFns
+	NULL,							// IVectorFns
+	NULL,							// IMapFns
+	NULL,							// ISetFns
+	toString,						// toString
+	EqualsASeq,						// Equals
+	NULL,							// HashEq
+};
+
+// TransientHashSet
+
+struct TransientHashSet_struct {
+	lisp_object obj;
+	EditToken edit;
+	const SetNode *root;
+	size_t count;
+	bool hasNull;
+};
+
+// HashSet
+
+struct HashSet_struct {
+	lisp_object obj;
+	const size_t count;
+	const SetNode *const root;
+	const bool hasNull;
+	uint32_t hash;		// HashEq, computed on first use.  0 until then.
+};
+
+// HashSet Function declarations.
+
+static const HashSet *NewHashSet(size_t count, const SetNode *root, bool hasNull);
+static const ISeq *seqHashSet(const Seqable *obj);
+static size_t countHashSet(const ICollection *ic);
+static const ICollection* consHashSet(const ICollection*, const lisp_object*);
+static const ICollection* emptyHashSet(void);
+static bool EquivHashSet(const ICollection*, const lisp_object*);
+static const lisp_object* invoke1HashSet(const IFn*, const lisp_object*);
+static const lisp_object* invoke2HashSet(const IFn*, const lisp_object*, const lisp_object*);
+static const ISet* disjoinHashSet(const ISet*, const lisp_object*);
+static bool containsHashSet(const ISet*, const lisp_object*);
+static const lisp_object* getHashSet(const ISet*, const lisp_object*);
+static bool EqualsHashSet(const lisp_object *x, const lisp_object *y);
+static uint32_t HashEqHashSet(const lisp_object *obj);
+
+const Seqable_vtable HashSet_Seqable_vtable = {
+	seqHashSet // seq
+};
+
+const ICollection_vtable HashSet_ICollection_vtable = {
+	countHashSet,	// count
+	consHashSet,	// cons
+	emptyHashSet,	// empty
+	EquivHashSet,	// Equiv
+};
+
+const IFn_vtable HashSet_IFn_vtable = {
+	invoke0AFn,		// invoke0
+	invoke1HashSet,	// invoke1
+	invoke2HashSet,	// invoke2
+	invoke3AFn,		// invoke3
+	invoke4AFn,		// invoke4
+	invoke5AFn,		// invoke5
+	applyToAFn,		// applyTo
+};
+
+const ISet_vtable HashSet_ISet_vtable = {
+	disjoinHashSet,		// disjoin
+	containsHashSet,	// contains
+	getHashSet,			// get
+};
+
+interfaces HashSet_interfaces = {
+	&HashSet_Seqable_vtable,		// SeqableFns
+	NULL,							// ReversibleFns
+	&HashSet_ICollection_vtable,	// ICollectionFns
+	NULL,							// IStackFns
+	NULL,							// ISeqFns
+	&HashSet_IFn_vtable,			// IFnFns
+	NULL,							// IVectorFns
+	NULL,							// IMapFns
+	&HashSet_ISet_vtable,			// ISetFns
+	toString,						// toString
+	EqualsHashSet,					// Equals
+	HashEqHashSet,					// HashEq
+};
+
+const HashSet _EmptyHashSet = {{HASHSET_type, sizeof(HashSet), NULL, &HashSet_interfaces}, 0, NULL, false, 0};
+const HashSet *const EmptyHashSet = &_EmptyHashSet;
+
+// Node Function Definitions.
+
+static size_t payloadArity(const SetNode *node) {
+	return popcount(node->datamap);
+}
+
+static size_t nodeArity(const SetNode *node) {
+	return popcount(node->nodemap);
+}
+
+static size_t lengthSetNode(const SetNode *node) {
+	return payloadArity(node) + nodeArity(node);
+}
+
+// Keys of either kind of node.
+static const lisp_object *const *keysSetNode(const lisp_object *node) {
+	if(node->type == SET_COLLISIONNODE_type)
+		return ((SetCollisionNode*)node)->array;
+	assert(node->type == SET_NODE_type);
+	return ((SetNode*)node)->array;
+}
+
+// A node left holding one key and no sub-nodes after a removal.  Its parent takes the key inline.
+static bool isSingletonSetNode(const lisp_object *node) {
+	if(node->type != SET_NODE_type)
+		return false;
+	const SetNode *n = (SetNode*)node;
+	return n->nodemap == 0 && payloadArity(n) == 1;
+}
+
+static SetNode *NewSetNode(const EditToken *edit, uint32_t datamap, uint32_t nodemap, size_t capacity) {
+	SetNode *node = GC_MALLOC(sizeof(*node) + capacity * sizeof(lisp_object*));
+	node->obj.type = SET_NODE_type;
+	node->obj.size = sizeof(SetNode);
+	node->obj.fns = &NullInterface;
+	node->datamap = datamap;
+	node->nodemap = nodemap;
+	node->edit = edit;
+	node->capacity = capacity;
+	return node;
+}
+
+// Returns node itself when edit owns it and it has room for capacity slots, otherwise an owned copy.  Persistent
+// callers pass a NULL edit, so they always get a copy.
+static SetNode *editableSetNode(const SetNode *node, const EditToken *edit, size_t capacity) {
+	if(edit != NULL && node->edit == edit && node->capacity >= capacity)
+		return (SetNode*)node;
+	if(edit != NULL)
+		capacity += 4;		// Leave room for a few more, since a transient is likely to keep adding.
+	if(capacity > NODE_SIZE)
+		capacity = NODE_SIZE;
+	SetNode *ret = NewSetNode(edit, node->datamap, node->nodemap, capacity);
+	memcpy(ret->array, node->array, lengthSetNode(node) * sizeof(lisp_object*));
+	return ret;
+}
+
+static const lisp_object* insertKeySetNode(const SetNode *node, const EditToken *edit, uint32_t bit, const lisp_object *key) {
+	size_t idx = index(node->datamap, bit);
+	size_t length = lengthSetNode(node);
+	SetNode *ret = editableSetNode(node, edit, length + 1);
+	memmove(&ret->array[idx+1], &ret->array[idx], (length - idx) * sizeof(lisp_object*));
+	ret->array[idx] = key;
+	ret->datamap |= bit;
+	return (lisp_object*)ret;
+}
+
+static const lisp_object* removeKeySetNode(const SetNode *node, const EditToken *edit, uint32_t bit) {
+	size_t idx = index(node->datamap, bit);
+	size_t length = lengthSetNode(node);
+	SetNode *ret = editableSetNode(node, edit, length);
+	memmove(&ret->array[idx], &ret->array[idx+1], (length - idx - 1) * sizeof(lisp_object*));
+	ret->array[length-1] = NULL;
+	ret->datamap ^= bit;
+	return (lisp_object*)ret;
+}
+
+// Replaces the key at bit with sub, which holds that key and a new one.
+static const lisp_object* keyToNodeSetNode(const SetNode *node, const EditToken *edit, uint32_t bit, const lisp_object *sub) {
+	size_t idx = index(node->datamap, bit);
+	size_t nodeIdx = index(node->nodemap, bit);
+	size_t payload = payloadArity(node);
+	SetNode *ret = editableSetNode(node, edit, lengthSetNode(node));
+	memmove(&ret->array[idx], &ret->array[idx+1], (payload - idx - 1) * sizeof(lisp_object*));
+	memmove(&ret->array[payload-1], &ret->array[payload], nodeIdx * sizeof(lisp_object*));
+	ret->array[payload-1+nodeIdx] = sub;
+	ret->datamap ^= bit;
+	ret->nodemap |= bit;
+	return (lisp_object*)ret;
+}
+
+// Replaces the sub-node at bit with the one key it has left.
+static const lisp_object* nodeToKeySetNode(const SetNode *node, const EditToken *edit, uint32_t bit, const lisp_object *key) {
+	size_t idx = index(node->datamap, bit);
+	size_t nodeIdx = index(node->nodemap, bit);
+	size_t payload = payloadArity(node);
+	SetNode *ret = editableSetNode(node, edit, lengthSetNode(node));
+	memmove(&ret->array[payload+1], &ret->array[payload], nodeIdx * sizeof(lisp_object*));
+	memmove(&ret->array[idx+1], &ret->array[idx], (payload - idx) * sizeof(lisp_object*));
+	ret->array[idx] = key;
+	ret->datamap |= bit;
+	ret->nodemap ^= bit;
+	return (lisp_object*)ret;
+}
+
+// Builds the sub-tree holding two keys whose hashes agree below shift.
+static const lisp_object* mergeTwoSetNode(const EditToken *edit, size_t shift, const lisp_object *key1, uint32_t hash1,
+		const lisp_object *key2, uint32_t hash2) {
+	if(hash1 == hash2) {
+		SetCollisionNode *ret = NewSetCollisionNode(hash1, 2);
+		ret->array[0] = key1;
+		ret->array[1] = key2;
+		return (lisp_object*)ret;
+	}
+	uint32_t mask1 = mask(hash1, shift);
+	uint32_t mask2 = mask(hash2, shift);
+	if(mask1 == mask2) {
+		SetNode *ret = NewSetNode(edit, 0, bitpos(hash1, shift), 1);
+		ret->array[0] = mergeTwoSetNode(edit, shift + NODE_LOG_SIZE, key1, hash1, key2, hash2);
+		return (lisp_object*)ret;
+	}
+	SetNode *ret = NewSetNode(edit, bitpos(hash1, shift) | bitpos(hash2, shift), 0, 2);
+	ret->array[mask1 < mask2 ? 0 : 1] = key1;
+	ret->array[mask1 < mask2 ? 1 : 0] = key2;
+	return (lisp_object*)ret;
+}
+
+static int findIndexSetCollisionNode(const SetCollisionNode *cnode, const lisp_object *key) {
+	for(size_t i = 0; i < cnode->count; i++) {
+		if(Equiv(key, cnode->array[i]))
+			return i;
+	}
+	return -1;
+}
+
+// Collisions are rare enough that their nodes are always copied, even by a transient.
+static SetCollisionNode *NewSetCollisionNode(uint32_t hash, size_t count) {
+	SetCollisionNode *node = GC_MALLOC(sizeof(*node) + count * sizeof(lisp_object*));
+	node->obj.type = SET_COLLISIONNODE_type;
+	node->obj.size = sizeof(SetCollisionNode);
+	node->obj.fns = &NullInterface;
+	node->hash = hash;
+	node->count = count;
+	return node;
+}
+
+static const lisp_object* conjSetCollisionNode(const SetCollisionNode *cnode, const EditToken *edit, size_t shift, uint32_t hash, const lisp_object *key, bool *addedLeaf) {
+	if(hash != cnode->hash) {
+		// key agrees with the colliding hash down to here, so push the collision node down a level.
+		SetNode *ret = NewSetNode(edit, 0, bitpos(cnode->hash, shift), 2);
+		ret->array[0] = (lisp_object*)cnode;
+		return conjSetNode((lisp_object*)ret, edit, shift, hash, key, addedLeaf);
+	}
+	if(findIndexSetCollisionNode(cnode, key) != -1)
+		return (lisp_object*)cnode;
+	*addedLeaf = true;
+	SetCollisionNode *ret = NewSetCollisionNode(hash, cnode->count + 1);
+	memcpy(ret->array, cnode->array, cnode->count * sizeof(lisp_object*));
+	ret->array[cnode->count] = key;
+	return (lisp_object*)ret;
+}
+
+static const lisp_object* conjSetNode(const lisp_object *node, const EditToken *edit, size_t shift, uint32_t hash, const lisp_object *key, bool *addedLeaf) {
+	if(node->type == SET_COLLISIONNODE_type)
+		return conjSetCollisionNode((SetCollisionNode*)node, edit, shift, hash, key, addedLeaf);
+	assert(node->type == SET_NODE_type);
+	const SetNode *snode = (SetNode*)node;
+	uint32_t bit = bitpos(hash, shift);
+
+	if(snode->datamap & bit) {
+		const lisp_object *lookup_key = snode->array[index(snode->datamap, bit)];
+		if(Equiv(key, lookup_key))
+			return node;
+		*addedLeaf = true;
+		const lisp_object *sub = mergeTwoSetNode(edit, shift + NODE_LOG_SIZE, lookup_key, HashEq(lookup_key), key, hash);
+		return keyToNodeSetNode(snode, edit, bit, sub);
+	}
+	if(snode->nodemap & bit) {
+		size_t j = payloadArity(snode) + index(snode->nodemap, bit);
+		const lisp_object *sub = snode->array[j];
+		const lisp_object *sub2 = conjSetNode(sub, edit, shift + NODE_LOG_SIZE, hash, key, addedLeaf);
+		if(sub2 == sub)
+			return node;
+		SetNode *ret = editableSetNode(snode, edit, lengthSetNode(snode));
+		ret->array[j] = sub2;
+		return (lisp_object*)ret;
+	}
+	*addedLeaf = true;
+	return insertKeySetNode(snode, edit, bit, key);
+}
+
+static const lisp_object* disjSetCollisionNode(const SetCollisionNode *cnode, const EditToken *edit, const lisp_object *key, bool *removedLeaf) {
+	int i = findIndexSetCollisionNode(cnode, key);
+	if(i == -1)
+		return (lisp_object*)cnode;
+	*removedLeaf = true;
+	if(cnode->count == 2) {
+		// The parent takes the remaining key inline, so the bit is only a placeholder.
+		SetNode *ret = NewSetNode(edit, bitpos(cnode->hash, 0), 0, 1);
+		ret->array[0] = cnode->array[1-i];
+		return (lisp_object*)ret;
+	}
+	SetCollisionNode *ret = NewSetCollisionNode(cnode->hash, cnode->count - 1);
+	memcpy(ret->array, cnode->array, i * sizeof(lisp_object*));
+	memcpy(&ret->array[i], &cnode->array[i+1], (cnode->count - i - 1) * sizeof(lisp_object*));
+	return (lisp_object*)ret;
+}
+
+// Keeps the trie in the shape insertion alone would have built.  Below the root, a node with a single key left is
+// folded into its parent, and a collision node is hoisted out of nodes that hold nothing else.
+static const lisp_object* disjSetNode(const lisp_object *node, const EditToken *edit, size_t shift, uint32_t hash, const lisp_object *key, bool *removedLeaf) {
+	if(node->type == SET_COLLISIONNODE_type)
+		return disjSetCollisionNode((SetCollisionNode*)node, edit, key, removedLeaf);
+	assert(node->type == SET_NODE_type);
+	const SetNode *snode = (SetNode*)node;
+	uint32_t bit = bitpos(hash, shift);
+
+	if(snode->datamap & bit) {
+		if(!Equiv(key, snode->array[index(snode->datamap, bit)]))
+			return node;
+		*removedLeaf = true;
+		if(shift > 0 && payloadArity(snode) == 1 && nodeArity(snode) == 1 && snode->array[1]->type == SET_COLLISIONNODE_type)
+			return snode->array[1];
+		return removeKeySetNode(snode, edit, bit);
+	}
+	if(snode->nodemap & bit) {
+		size_t j = payloadArity(snode) + index(snode->nodemap, bit);
+		const lisp_object *sub = snode->array[j];
+		const lisp_object *sub2 = disjSetNode(sub, edit, shift + NODE_LOG_SIZE, hash, key, removedLeaf);
+		if(!*removedLeaf)
+			return node;
+		if(shift > 0 && snode->datamap == 0 && nodeArity(snode) == 1 && (isSingletonSetNode(sub2) || sub2->type == SET_COLLISIONNODE_type))
+			return sub2;
+		if(isSingletonSetNode(sub2))
+			return nodeToKeySetNode(snode, edit, bit, ((SetNode*)sub2)->array[0]);
+		SetNode *ret = editableSetNode(snode, edit, lengthSetNode(snode));
+		ret->array[j] = sub2;
+		return (lisp_object*)ret;
+	}
+	return node;
+}
+
+// Returns the set's copy of key, or NULL.  node is at shift.
+static const lisp_object* findSetNode(const lisp_object *node, size_t shift, uint32_t hash, const lisp_object *key) {
+	for(; node != NULL; shift += NODE_LOG_SIZE) {
+		if(node->type == SET_COLLISIONNODE_type) {
+			const SetCollisionNode *cnode = (SetCollisionNode*)node;
+			int i = findIndexSetCollisionNode(cnode, key);
+			return i == -1 ? NULL : cnode->array[i];
+		}
+		assert(node->type == SET_NODE_type);
+		const SetNode *snode = (SetNode*)node;
+		uint32_t bit = bitpos(hash, shift);
+		if(snode->datamap & bit) {
+			const lisp_object *k = snode->array[index(snode->datamap, bit)];
+			return Equiv(key, k) ? k : NULL;
+		}
+		if((snode->nodemap & bit) == 0)
+			return NULL;
+		node = snode->array[payloadArity(snode) + index(snode->nodemap, bit)];
+	}
+	return NULL;
+}
+
+// Since the trie is canonical, equal sets have the same shape and can be compared node by node without lookups.
+static bool EquivSetNode(const lisp_object *x, const lisp_object *y) {
+	if(x == y)
+		return true;
+	if(x->type != y->type)
+		return false;
+
+	if(x->type == SET_COLLISIONNODE_type) {
+		const SetCollisionNode *cx = (SetCollisionNode*)x;
+		const SetCollisionNode *cy = (SetCollisionNode*)y;
+		if(cx->hash != cy->hash || cx->count != cy->count)
+			return false;
+		for(size_t i = 0; i < cx->count; i++) {
+			if(findIndexSetCollisionNode(cy, cx->array[i]) == -1)
+				return false;
+		}
+		return true;
+	}
+
+	const SetNode *nx = (SetNode*)x;
+	const SetNode *ny = (SetNode*)y;
+	if(nx->datamap != ny->datamap || nx->nodemap != ny->nodemap)
+		return false;
+	size_t payload = payloadArity(nx);
+	for(size_t i = 0; i < payload; i++) {
+		if(!Equiv(nx->array[i], ny->array[i]))
+			return false;
+	}
+	size_t length = lengthSetNode(nx);
+	for(size_t i = payload; i < length; i++) {
+		if(!EquivSetNode(nx->array[i], ny->array[i]))
+			return false;
+	}
+	return true;
+}
+
+// Set algebra walks the tries of both sets together.  A subtree of x that y has nothing under is kept whole, as is,
+// for a union, a subtree of y that x has nothing under.  Results keep the shape conj would have built, so that
+// EquivSetNode holds for them.  changed counts the keys op adds to x, for a union, or takes from it, for the others,
+// which fixes the count of the result.  Subtrees are only counted when all their keys are added or taken, so the cost
+// follows how much the result differs from x rather than the size of the sets.
+
+typedef enum {	// SetOp
+	SET_UNION,
+	SET_INTERSECTION,
+	SET_DIFFERENCE,
+} SetOp;
+
+static const lisp_object* algebraSetNodes(SetOp op, const lisp_object *x, const lisp_object *y, size_t shift, size_t *changed);
+
+static size_t countSetNode(const lisp_object *node) {
+	if(node->type == SET_COLLISIONNODE_type)
+		return ((SetCollisionNode*)node)->count;
+	assert(node->type == SET_NODE_type);
+	const SetNode *snode = (SetNode*)node;
+	size_t payload = payloadArity(snode);
+	size_t length = lengthSetNode(snode);
+	size_t n = payload;
+	for(size_t i = payload; i < length; i++)
+		n += countSetNode(snode->array[i]);
+	return n;
+}
+
+// The key or the sub-node at bit, or neither.
+static void slotSetNode(const SetNode *node, uint32_t bit, const lisp_object **key, const lisp_object **sub) {
+	*key = *sub = NULL;
+	if(node->datamap & bit)
+		*key = node->array[index(node->datamap, bit)];
+	else if(node->nodemap & bit)
+		*sub = node->array[payloadArity(node) + index(node->nodemap, bit)];
+}
+
+// Puts a collision node in a node of its own at shift, to be walked alongside a node there.
+static const lisp_object* wrapSetCollisionNode(const SetCollisionNode *cnode, size_t shift) {
+	SetNode *ret = NewSetNode(NULL, 0, bitpos(cnode->hash, shift), 1);
+	ret->array[0] = (lisp_object*)cnode;
+	return (lisp_object*)ret;
+}
+
+static const lisp_object* algebraSetCollisionNodes(SetOp op, const SetCollisionNode *x, const SetCollisionNode *y, size_t *changed) {
+	SetCollisionNode *ret = NewSetCollisionNode(x->hash, x->count + y->count);
+	size_t n = 0;
+	for(size_t i = 0; i < x->count; i++) {
+		bool in = findIndexSetCollisionNode(y, x->array[i]) != -1;
+		if(op == SET_UNION || in == (op == SET_INTERSECTION))
+			ret->array[n++] = x->array[i];
+	}
+	if(op == SET_UNION) {
+		for(size_t i = 0; i < y->count; i++)
+			if(findIndexSetCollisionNode(x, y->array[i]) == -1)
+				ret->array[n++] = y->array[i];
+	}
+	*changed += n > x->count ? n - x->count : x->count - n;
+	if(n == x->count)
+		return (lisp_object*)x;
+	if(n == 0)
+		return NULL;
+	if(n == 1) {
+		// The parent takes the remaining key inline, as in disjSetCollisionNode.
+		SetNode *key = NewSetNode(NULL, bitpos(x->hash, 0), 0, 1);
+		key->array[0] = ret->array[0];
+		return (lisp_object*)key;
+	}
+	ret->count = n;
+	return (lisp_object*)ret;
+}
+
+// Applies op to the slots for the same bit of two nodes at shift, giving a key, a sub-node or neither.
+static void algebraSlots(SetOp op, const lisp_object *xkey, const lisp_object *xsub, const lisp_object *ykey,
+		const lisp_object *ysub, size_t shift, size_t *changed, const lisp_object **key, const lisp_object **sub) {
+	*key = *sub = NULL;
+	shift += NODE_LOG_SIZE;
+	if(xkey != NULL && ykey != NULL) {
+		bool in = Equiv(xkey, ykey);
+		if(in == (op == SET_DIFFERENCE))
+			(*changed)++;
+		if(op == SET_UNION && !in)
+			*sub = mergeTwoSetNode(NULL, shift, xkey, HashEq(xkey), ykey, HashEq(ykey));
+		else if(op == SET_UNION || in == (op == SET_INTERSECTION))
+			*key = xkey;
+	} else if(xkey != NULL) {
+		uint32_t hash = HashEq(xkey);
+		bool in = findSetNode(ysub, shift, hash, xkey) != NULL;
+		bool addedLeaf = false;
+		if(op == SET_UNION)
+			*changed += countSetNode(ysub) - in;
+		else if(in == (op == SET_DIFFERENCE))
+			(*changed)++;
+		if(op == SET_UNION)
+			*sub = in ? ysub : conjSetNode(ysub, NULL, shift, hash, xkey, &addedLeaf);
+		else if(in == (op == SET_INTERSECTION))
+			*key = xkey;
+	} else if(ykey != NULL) {
+		uint32_t hash = HashEq(ykey);
+		bool addedLeaf = false, removedLeaf = false;
+		switch(op) {
+			case SET_UNION:
+				*sub = conjSetNode(xsub, NULL, shift, hash, ykey, &addedLeaf);
+				if(addedLeaf)
+					(*changed)++;
+				break;
+			case SET_INTERSECTION:
+				*key = findSetNode(xsub, shift, hash, ykey);
+				*changed += countSetNode(xsub) - (*key != NULL);
+				break;
+			case SET_DIFFERENCE:
+				*sub = disjSetNode(xsub, NULL, shift, hash, ykey, &removedLeaf);
+				if(removedLeaf)
+					(*changed)++;
+				break;
+		}
+	} else {
+		*sub = algebraSetNodes(op, xsub, ysub, shift, changed);
+	}
+}
+
+// Applies op to two nodes at shift.  Returns NULL for an empty result, and x itself when the result is x.
+static const lisp_object* algebraSetNodes(SetOp op, const lisp_object *x, const lisp_object *y, size_t shift, size_t *changed) {
+	if(x == y) {
+		// A union or intersection keeps x without walking it.
+		if(op != SET_DIFFERENCE)
+			return x;
+		*changed += countSetNode(x);
+		return NULL;
+	}
+	if(x->type == SET_COLLISIONNODE_type && y->type == SET_COLLISIONNODE_type
+			&& ((SetCollisionNode*)x)->hash == ((SetCollisionNode*)y)->hash)
+		return algebraSetCollisionNodes(op, (SetCollisionNode*)x, (SetCollisionNode*)y, changed);
+	if(x->type == SET_COLLISIONNODE_type)
+		x = wrapSetCollisionNode((SetCollisionNode*)x, shift);
+	if(y->type == SET_COLLISIONNODE_type)
+		y = wrapSetCollisionNode((SetCollisionNode*)y, shift);
+
+	const SetNode *nx = (SetNode*)x;
+	const SetNode *ny = (SetNode*)y;
+	uint32_t xmap = nx->datamap | nx->nodemap;
+	uint32_t ymap = ny->datamap | ny->nodemap;
+	const lisp_object *keys[NODE_SIZE], *subs[NODE_SIZE];
+	uint32_t datamap = 0, nodemap = 0;
+	size_t nkeys = 0, nsubs = 0;
+	for(size_t i = 0; i < NODE_SIZE; i++) {
+		uint32_t bit = 1u << i;
+		const lisp_object *key, *sub;
+		if((xmap & bit) && (ymap & bit)) {
+			const lisp_object *xkey, *xsub, *ykey, *ysub;
+			slotSetNode(nx, bit, &xkey, &xsub);
+			slotSetNode(ny, bit, &ykey, &ysub);
+			algebraSlots(op, xkey, xsub, ykey, ysub, shift, changed, &key, &sub);
+		} else if(xmap & bit) {
+			slotSetNode(nx, bit, &key, &sub);
+			if(op == SET_INTERSECTION) {
+				*changed += key ? 1 : countSetNode(sub);
+				continue;
+			}
+		} else if(op == SET_UNION && (ymap & bit)) {
+			slotSetNode(ny, bit, &key, &sub);
+			*changed += key ? 1 : countSetNode(sub);
+		} else {
+			continue;
+		}
+		if(sub != NULL && isSingletonSetNode(sub)) {
+			key = ((SetNode*)sub)->array[0];
+			sub = NULL;
+		}
+		if(key != NULL) {
+			datamap |= bit;
+			keys[nkeys++] = key;
+		} else if(sub != NULL) {
+			nodemap |= bit;
+			subs[nsubs++] = sub;
+		}
+	}
+
+	if(datamap == 0 && nodemap == 0)
+		return NULL;
+	if(shift > 0 && datamap == 0 && nsubs == 1 && subs[0]->type == SET_COLLISIONNODE_type)
+		return subs[0];		// Hoisted, as in disjSetNode.
+	if(datamap == nx->datamap && nodemap == nx->nodemap && memcmp(keys, nx->array, nkeys * sizeof(lisp_object*)) == 0
+			&& memcmp(subs, &nx->array[nkeys], nsubs * sizeof(lisp_object*)) == 0)
+		return x;
+	SetNode *ret = NewSetNode(NULL, datamap, nodemap, nkeys + nsubs);
+	memcpy(ret->array, keys, nkeys * sizeof(lisp_object*));
+	memcpy(&ret->array[nkeys], subs, nsubs * sizeof(lisp_object*));
+	return (lisp_object*)ret;
+}
+
+// SetSeq Function Definitions.
+
+// Moves frames forward to the first key at or after the top frame's position.  Returns the new depth, 0 at the end.
+static size_t advanceSetFrames(SetFrame *frames, size_t depth) {
+	while(depth > 0) {
+		SetFrame *top = &frames[depth-1];
+		if(top->node->type == SET_COLLISIONNODE_type) {
+			if(top->pos < ((SetCollisionNode*)top->node)->count)
+				return depth;
+			depth--;
+			continue;
+		}
+		const SetNode *node = (SetNode*)top->node;
+		size_t payload = payloadArity(node);
+		if(top->pos < payload)
+			return depth;
+		size_t j = top->pos - payload;
+		if(j < nodeArity(node)) {
+			assert(depth < SET_MAX_DEPTH);
+			top->pos++;
+			frames[depth].node = node->array[payload + j];
+			frames[depth].pos = 0;
+			depth++;
+			continue;
+		}
+		depth--;
+	}
+	return 0;
+}
+
+static const SetSeq *CreateSetSeq(SetFrame *frames, size_t depth) {
+	depth = advanceSetFrames(frames, depth);
+	if(depth == 0)
+		return NULL;
+
+	SetSeq *ret = GC_MALLOC(sizeof(*ret) + depth * sizeof(SetFrame));
+	ret->obj.type = SETSEQ_type;
+	ret->obj.size = sizeof(SetSeq);
+	ret->obj.fns = &SetSeq_interfaces;
+	ret->depth = depth;
+	memcpy(ret->frames, frames, depth * sizeof(SetFrame));
+	return ret;
+}
+
+static const lisp_object* firstSetSeq(const ISeq *o) {
+	assert(o->obj.type == SETSEQ_type);
+	const SetSeq *ss = (SetSeq*) o;
+	const SetFrame *top = &ss->frames[ss->depth-1];
+
+	return keysSetNode(top->node)[top->pos];
+}
+
+static const ISeq* nextSetSeq(const ISeq *o) {
+	assert(o->obj.type == SETSEQ_type);
+	const SetSeq *ss = (SetSeq*) o;
+	SetFrame frames[SET_MAX_DEPTH];
+
+	memcpy(frames, ss->frames, ss->depth * sizeof(SetFrame));
+	frames[ss->depth-1].pos++;
+	return (ISeq*) CreateSetSeq(frames, ss->depth);
+}
+
+// TransientHashSet Function Definitions.
+
+TransientHashSet *asTransientHashSet(const HashSet *hs) {
+	TransientHashSet *ths = GC_MALLOC(sizeof(*ths));
+	ths->obj.type = TRANSIENTHASHSET_type;
+	ths->obj.size = sizeof(TransientHashSet);
+	ths->obj.fns = &NullInterface;
+	ths->edit.editable = true;
+	ths->edit.thread_id = pthread_self();
+	ths->root = hs->root;
+	ths->count = hs->count;
+	ths->hasNull = hs->hasNull;
+	return ths;
+}
+
+TransientHashSet *conjTHS(TransientHashSet *ths, const lisp_object *key) {
+	assert(ths->edit.editable);
+	assert(pthread_equal(ths->edit.thread_id, pthread_self()));
+	if(key == NULL) {
+		if(!ths->hasNull) {
+			ths->hasNull = true;
+			ths->count++;
+		}
+		return ths;
+	}
+
+	bool addedLeaf = false;
+	const lisp_object *root = ths->root ? (lisp_object*)ths->root : (lisp_object*)&EmptySetNode;
+	ths->root = (SetNode*)conjSetNode(root, &ths->edit, 0, HashEq(key), key, &addedLeaf);
+	if(addedLeaf) ths->count++;
+	return ths;
+}
+
+TransientHashSet *disjTHS(TransientHashSet *ths, const lisp_object *key) {
+	assert(ths->edit.editable);
+	assert(pthread_equal(ths->edit.thread_id, pthread_self()));
+	if(key == NULL) {
+		if(ths->hasNull) {
+			ths->hasNull = false;
+			ths->count--;
+		}
+		return ths;
+	}
+	if(ths->root == NULL)
+		return ths;
+
+	bool removedLeaf = false;
+	ths->root = (SetNode*)disjSetNode((lisp_object*)ths->root, &ths->edit, 0, HashEq(key), key, &removedLeaf);
+	if(removedLeaf) ths->count--;
+	if(ths->root->datamap == 0 && ths->root->nodemap == 0)
+		ths->root = NULL;
+	return ths;
+}
+
+const HashSet *asPersistentHashSet(TransientHashSet *ths) {
+	assert(ths->edit.editable);
+	ths->edit.editable = false;	// Releases every node the transient owns.
+	if(ths->count == 0)
+		return EmptyHashSet;
+	return NewHashSet(ths->count, ths->root, ths->hasNull);
+}
+
+// HashSet Function Definitions.
+
+const HashSet *CreateHashSet(size_t count, const lisp_object **keys) {
+	TransientHashSet *ret = asTransientHashSet(EmptyHashSet);
+	for(size_t i = 0; i < count; i++) {
+		ret = conjTHS(ret, keys[i]);
+	}
+	return asPersistentHashSet(ret);
+}
+
+static const HashSet *NewHashSet(size_t count, const SetNode *root, bool hasNull) {
+	HashSet *ret = GC_MALLOC(sizeof(*ret));
+	ret->obj.type = HASHSET_type;
+	ret->obj.size = sizeof(HashSet);
+	ret->obj.fns = &HashSet_interfaces;
+	memcpy((void*) &(ret->count), &count, sizeof(count));
+	memcpy((void*) &(ret->root), &root, sizeof(root));
+	memcpy((void*) &(ret->hasNull), &hasNull, sizeof(hasNull));
+
+	return ret;
+}
+
+static const ISeq *seqHashSet(const Seqable *obj) {
+	assert(obj->obj.type == HASHSET_type);
+	const HashSet *hs = (HashSet*) obj;
+
+	const ISeq *s = NULL;
+	if(hs->root) {
+		SetFrame frames[SET_MAX_DEPTH] = {{(lisp_object*)hs->root, 0}};
+		s = (ISeq*) CreateSetSeq(frames, 1);
+	}
+
+	return hs->hasNull ? (const ISeq*) NewCons(NULL, s) : s;
+}
+
+static size_t countHashSet(const ICollection *ic) {
+	assert(ic->obj.type == HASHSET_type);
+	return ((HashSet*)ic)->count;
+}
+
+static const ICollection* consHashSet(const ICollection *ic, const lisp_object *key) {
+	assert(ic->obj.type == HASHSET_type);
+	const HashSet *hs = (HashSet*) ic;
+
+	if(key == NULL)
+		return hs->hasNull ? ic : (ICollection*) NewHashSet(hs->count + 1, hs->root, true);
+
+	bool addedLeaf = false;
+	const lisp_object *root = hs->root ? (lisp_object*)hs->root : (lisp_object*)&EmptySetNode;
+	const lisp_object *newRoot = conjSetNode(root, NULL, 0, HashEq(key), key, &addedLeaf);
+	if(!addedLeaf)
+		return ic;
+	return (ICollection*) NewHashSet(hs->count + 1, (SetNode*)newRoot, hs->hasNull);
+}
+
+static const ICollection* emptyHashSet(void) {
+	return (ICollection*) EmptyHashSet;
+}
+
+static bool EquivHashSet(const ICollection *ic, const lisp_object *obj) {
+	assert(ic->obj.type == HASHSET_type);
+	const HashSet *hs = (HashSet*) ic;
+
+	if((lisp_object*)hs == obj)
+		return true;
+	if(!isISet(obj))
+		return false;
+	const ISet *other = (ISet*) obj;
+	if(other->obj.fns->ICollectionFns->count((const ICollection*)other) != hs->count)
+		return false;
+
+	if(obj->type == HASHSET_type) {
+		const HashSet *ohs = (HashSet*) obj;
+		if(hs->hash != 0 && ohs->hash != 0 && hs->hash != ohs->hash)
+			return false;
+		if(hs->hasNull != ohs->hasNull)
+			return false;
+		if(hs->root == NULL || ohs->root == NULL)
+			return true;	// Equal counts leave both roots empty.
+		return EquivSetNode((lisp_object*)hs->root, (lisp_object*)ohs->root);
+	}
+
+	for(const ISeq *s = seqHashSet((const Seqable*)hs); s != NULL; s = s->obj.fns->ISeqFns->next(s)) {
+		if(!other->obj.fns->ISetFns->contains(other, s->obj.fns->ISeqFns->first(s)))
+			return false;
+	}
+	return true;
+}
+
+static bool EqualsHashSet(const lisp_object *x, const lisp_object *y) {
+	assert(x->type == HASHSET_type);
+	return EquivHashSet((ICollection*)x, y);
+}
+
+static uint32_t HashEqHashSet(const lisp_object *obj) {
+	assert(obj->type == HASHSET_type);
+	HashSet *hs = (HashSet*)obj;
+	if(hs->count == 0)
+		return mixCollHash(0, 0);
+	if(hs->hash == 0)
+		hs->hash = hashUnordered(obj);
+	return hs->hash;
+}
+
+static const lisp_object* invoke1HashSet(const IFn *f, const lisp_object *key) {
+	assert(f->obj.type == HASHSET_type);
+	return getHashSet((ISet*)f, key);
+}
+
+static const lisp_object* invoke2HashSet(const IFn *f, const lisp_object *key, const lisp_object *NotFound) {
+	assert(f->obj.type == HASHSET_type);
+	return containsHashSet((ISet*)f, key) ? getHashSet((ISet*)f, key) : NotFound;
+}
+
+static const ISet* disjoinHashSet(const ISet *is, const lisp_object *key) {
+	assert(is->obj.type == HASHSET_type);
+	const HashSet *hs = (HashSet*) is;
+
+	if(key == NULL)
+		return hs->hasNull ? (ISet*) NewHashSet(hs->count - 1, hs->root, false) : is;
+	if(hs->root == NULL)
+		return is;
+
+	bool removedLeaf = false;
+	const SetNode *root = (SetNode*)disjSetNode((lisp_object*)hs->root, NULL, 0, HashEq(key), key, &removedLeaf);
+	if(!removedLeaf)
+		return is;
+	if(hs->count == 1)
+		return (ISet*) EmptyHashSet;
+	if(root->datamap == 0 && root->nodemap == 0)
+		root = NULL;
+	return (ISet*) NewHashSet(hs->count - 1, root, hs->hasNull);
+}
+
+static bool containsHashSet(const ISet *is, const lisp_object *key) {
+	assert(is->obj.type == HASHSET_type);
+	const HashSet *hs = (HashSet*) is;
+
+	if(key == NULL)
+		return hs->hasNull;
+	return findSetNode((lisp_object*)hs->root, 0, HashEq(key), key) != NULL;
+}
+
+static const lisp_object* getHashSet(const ISet *is, const lisp_object *key) {
+	assert(is->obj.type == HASHSET_type);
+	const HashSet *hs = (HashSet*) is;
+
+	if(key == NULL)
+		return NULL;
+	return findSetNode((lisp_object*)hs->root, 0, HashEq(key), key);
+}
+
+static const HashSet *algebraHashSets(SetOp op, const HashSet *x, const HashSet *y) {
+	assert(x->obj.type == HASHSET_type && y->obj.type == HASHSET_type);
+	// The keys in each trie, leaving out nil.
+	size_t xkeys = x->count - x->hasNull;
+	size_t ykeys = y->count - y->hasNull;
+	size_t changed = 0;
+	const lisp_object *root;
+	if(x->root != NULL && y->root != NULL) {
+		root = algebraSetNodes(op, (lisp_object*)x->root, (lisp_object*)y->root, 0, &changed);
+	} else if(op == SET_UNION) {
+		root = (lisp_object*)(x->root ? x->root : y->root);
+		changed = x->root ? 0 : ykeys;
+	} else if(op == SET_INTERSECTION) {
+		root = NULL;
+		changed = xkeys;
+	} else {
+		root = (lisp_object*)x->root;
+	}
+
+	bool hasNull;
+	switch(op) {
+		case SET_UNION:
+			hasNull = x->hasNull || y->hasNull;
+			break;
+		case SET_INTERSECTION:
+			hasNull = x->hasNull && y->hasNull;
+			break;
+		default:
+			hasNull = x->hasNull && !y->hasNull;
+	}
+	size_t count = (op == SET_UNION ? xkeys + changed : xkeys - changed) + hasNull;
+
+	if(count == 0)
+		return EmptyHashSet;
+	if(root == (lisp_object*)x->root && hasNull == x->hasNull)
+		return x;
+	if(root == (lisp_object*)y->root && hasNull == y->hasNull && count == y->count)
+		return y;
+	return NewHashSet(count, (SetNode*)root, hasNull);
+}
+
+const HashSet *unionHashSet(const HashSet *x, const HashSet *y) {
+	return algebraHashSets(SET_UNION, x, y);
+}
+
+const HashSet *intersectionHashSet(const HashSet *x, const HashSet *y) {
+	return algebraHashSets(SET_INTERSECTION, x, y);
+}
+
+const HashSet *differenceHashSet(const HashSet *x, const HashSet *y) {
+	return algebraHashSets(SET_DIFFERENCE, x, y);
+}
@@ -0,0 +1,29 @@
+#ifndef SET_H
+#define SET_H
+
+#include "LispObject.h"
+
+// A persistent hash set.  Its trie follows the HashMap's hashing and bitmap indexing, but nodes hold keys alone: each
+// node has one bitmap for inline keys and one for sub-nodes, with the keys packed ahead of the sub-nodes.
+typedef struct HashSet_struct HashSet;
+typedef struct TransientHashSet_struct TransientHashSet;
+
+const HashSet *CreateHashSet(size_t count, const lisp_object **keys);
+
+// A transient edits the nodes it owns in place, so a set can be built without copying a path for every key.  The
+// transient may not be used after asPersistentHashSet.
+TransientHashSet *asTransientHashSet(const HashSet *hs);
+TransientHashSet *conjTHS(TransientHashSet *ths, const lisp_object *key);
+TransientHashSet *disjTHS(TransientHashSet *ths, const lisp_object *key);
+const HashSet *asPersistentHashSet(TransientHashSet *ths);
+
+// Set algebra walks the tries of both sets together, reusing every subtree that the result shares with either set
+// rather than adding or removing keys one at a time.  differenceHashSet gives the keys of x that are not in y.
+const HashSet *unionHashSet(const HashSet *x, const HashSet *y);
+const HashSet *intersectionHashSet(const HashSet *x, const HashSet *y);
+const HashSet *differenceHashSet(const HashSet *x, const HashSet *y);
+
+extern const HashSet _EmptyHashSet;
+extern const HashSet *const EmptyHashSet;
+
+#endif /* SET_H */
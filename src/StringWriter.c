@@ -28,7 +28,7 @@ static void AddStringLen(StringWriter *sw, const char *const str, size_t len) {
 	    sw->buffer_size *= growth;
 	    sw->buffer = GC_REALLOC(sw->buffer, sw->buffer_size * sizeof(*(sw->buffer)));
 	}
-	strncpy(sw->buffer + sw->len, str, len+1);
+	memcpy(sw->buffer + sw->len, str, len);
 	sw->len += len;
 	sw->buffer[sw->len] = '\0';
 }
@@ -47,7 +47,7 @@ StringWriter *AddChar(StringWriter *sw, char c) {
 StringWriter *AddInt(StringWriter *sw, int i) {
 	size_t len = snprintf(NULL, 0, "%d", i);
 	char *s = GC_MALLOC_ATOMIC((len+1)*sizeof(*s));
-	snprintf(s, len, "%d", i);
+	snprintf(s, len + 1, "%d", i);
 	s[len] = '\0';
 	AddStringLen(sw, s, len);
 	return sw;
@@ -56,7 +56,7 @@ StringWriter *AddInt(StringWriter *sw, int i) {
 StringWriter *AddFloat(StringWriter *sw, double x) {
 	size_t len = snprintf(NULL, 0, "%f", x);
 	char *s = GC_MALLOC_ATOMIC((len+1)*sizeof(*s));
-	snprintf(s, len, "%f", x);
+	snprintf(s, len + 1, "%f", x);
 	s[len] = '\0';
 	AddStringLen(sw, s, len);
 	return sw;
@@ -1,34 +1,26 @@
 #include "Strings.h"
 
 #include <assert.h>
+#include <stdint.h>
 #include <string.h>
 
 #include "gc.h"
 
-struct char_struct {
-    lisp_object obj;
-    char val[2];
-};
-
-static const char *CharToString(const lisp_object *obj) {
-	assert(obj->type == CHAR_type);
-    Char *ch = (Char*)obj;
-    return ch->val;
+const char *CharToString(const lisp_object *obj) {
+	assert(objectType(obj) == CHAR_type);
+	static char strs[256][2];
+	unsigned char ch = (unsigned char)CharValue((Char*)obj);
+	strs[ch][0] = (char)ch;
+	return strs[ch];
 }
 
 Char *NewChar(char ch) {
-    Char *ret = GC_MALLOC(sizeof(*ret));
-    memset(ret, 0, sizeof(*ret));
-
-    ret->obj.type = CHAR_type;
-    // ret->obj.codegen = Char_codegen;
-    ret->obj.toString = CharToString;
-	ret->obj.fns = &NullInterface;
-
-    ret->val[0] = ch;
-    ret->val[1] = '\0';
+    return (Char*)(((uintptr_t)(unsigned char)ch << IMMEDIATE_BITS) | CHAR_IMMEDIATE);
+}
 
-    return ret;
+char CharValue(const Char *c) {
+	assert(objectType((lisp_object*)c) == CHAR_type);
+	return (char)((uintptr_t)c >> IMMEDIATE_BITS);
 }
 
 struct string_struct {
@@ -42,13 +34,27 @@ static const char *StringToString(const lisp_object *obj) {
     return str->str;
 }
 
+static const interfaces String_interfaces = {
+	NULL,			// SeqableFns
+	NULL,			// ReversibleFns
+	NULL,			// ICollectionFns
+	NULL,			// IStackFns
+	NULL,			// ISeqFns
+	NULL,			// IFnFns
+	NULL,			// IVectorFns
+	NULL,			// IMapFns
+	NULL,			// ISetFns
+	StringToString,	// toString
+	NULL,			// Equals
+	NULL,			// HashEq
+};
+
 String *NewString(const char *str) {
     String *ret = GC_MALLOC(sizeof(*ret));
     memset(ret, 0, sizeof(*ret));
 
     ret->obj.type = STRING_type;
-    ret->obj.toString = StringToString;
-	ret->obj.fns = &NullInterface;
+	ret->obj.fns = &String_interfaces;
 
 	size_t len = strlen(str);
 	ret->str = GC_MALLOC_ATOMIC((len+1) * sizeof(*str));
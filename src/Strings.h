@@ -6,7 +6,10 @@
 typedef struct char_struct Char;
 typedef struct string_struct String;
 
+// Chars are immediates, and never allocate.
 Char *NewChar(char ch);
+char CharValue(const Char *c);
+const char *CharToString(const lisp_object *obj);
 String *NewString(const char *str);
 
 #endif /* LISP_STRINGS_H */
@@ -0,0 +1,865 @@
+#include <assert.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+
+#include "TreeMap.h"
+
+#include "AFn.h"
+#include "ASeq.h"
+#include "Error.h"
+#include "gc.h"
+#include "Interfaces.h"
+#include "MapEntry.h"
+#include "Murmur3.h"
+#include "Numbers.h"
+#include "Util.h"
+
+// Balance parameters from Hirai and Yamamoto, "Balancing Weight-Balanced Trees".  A subtree's weight is its size plus
+// one.  No sibling may be more than DELTA times heavier than the other, and GAMMA picks a single or double rotation.
+#define DELTA 3
+#define GAMMA 2
+
+// TreeNode
+
+typedef struct TreeNode_struct {	// TreeNode
+	lisp_object obj;
+	const lisp_object *key;
+	const lisp_object *val;
+	const struct TreeNode_struct *left;
+	const struct TreeNode_struct *right;
+	size_t size;		// Entries in this subtree.
+} TreeNode;
+
+// Node function declarations.
+
+static const TreeNode *NewTreeNode(const lisp_object *key, const lisp_object *val, const TreeNode *left, const TreeNode *right);
+static const TreeNode *balanceTreeNode(const lisp_object *key, const lisp_object *val, const TreeNode *left, const TreeNode *right);
+static const TreeNode *assocTreeNode(const TreeNode *node, const IFn *comparator, const lisp_object *key, const lisp_object *val, bool *addedLeaf);
+static const TreeNode *withoutTreeNode(const TreeNode *node, const IFn *comparator, const lisp_object *key, bool *removedLeaf);
+static const TreeNode *findTreeNode(const TreeNode *node, const IFn *comparator, const lisp_object *key);
+
+// TreeSeq
+
+typedef struct TreeStack_struct {	// TreeStack
+	const TreeNode *node;
+	const struct TreeStack_struct *next;
+} TreeStack;
+
+typedef struct {	// TreeSeq
+	lisp_object obj;
+	const TreeStack *stack;		// The current node, then the ancestors still to be visited.
+	bool ascending;
+	bool keysOnly;				// Sets see keys, maps see MapEntries.
+	const IFn *comparator;
+	bool hasEnd;				// Whether the seq stops at endKey.
+	bool endInclusive;
+	const lisp_object *endKey;
+} TreeSeq;
+
+// TreeSeq function declarations.
+
+static const ISeq *CreateTreeSeq(const TreeStack *stack, const TreeSeq *params);
+static const lisp_object* firstTreeSeq(const ISeq*);
+static const ISeq* nextTreeSeq(const ISeq*);
+
+const Seqable_vtable TreeSeq_Seqable_vtable = {
+	seqASeq,	//seq
+};
+
+const ICollection_vtable TreeSeq_ICollection_vtable = {
+	countASeq,					// count
+	(ICollectionFn1)consASeq,	// cons
+	emptyASeq,					// empty
+	EquivASeq					// Equiv
+};
+
+const ISeq_vtable TreeSeq_ISeq_vtable = {
+	firstTreeSeq,	// first
+	nextTreeSeq,	// next
+	moreASeq,		// more
+	consASeq,		// cons
+};
+
+interfaces TreeSeq_interfaces = {
+	&TreeSeq_Seqable_vtable,		// SeqableFns
+	NULL,							// ReversibleFns
+	&TreeSeq_ICollection_vtable,	// ICollectionFns
+	NULL,							// IStackFns
+	&TreeSeq_ISeq_vtable,			// ISeqFns
+	NULL,							// IFnFns
+	NULL,							// IVectorFns
+	NULL,							// IMapFns
+	NULL,							// ISetFns
+	toString,						// toString
+	EqualsASeq,						// Equals
+	NULL,							// HashEq
+};
+
+// TreeMap
+
+struct TreeMap_struct {
+	lisp_object obj;
+	const IFn *const comparator;
+	const size_t count;
+	const TreeNode *const root;
+	uint32_t hash;		// HashEq, computed on first use.  0 until then.
+};
+
+// TreeMap Function declarations.
+
+static const TreeMap *NewTreeMap(const IFn *comparator, size_t count, const TreeNode *root);
+static const ISeq *seqTreeMap(const Seqable *obj);
+static const ISeq *rseqTreeMap(const Seqable *obj);
+static size_t countTreeMap(const ICollection *ic);
+static const ICollection* emptyTreeMap(void);
+static bool EquivTreeMap(const ICollection*, const lisp_object*);
+static const lisp_object* invoke1TreeMap(const IFn*, const lisp_object*);
+static const lisp_object* invoke2TreeMap(const IFn*, const lisp_object*, const lisp_object*);
+static bool containsKeyTreeMap(const IMap*, const lisp_object*);
+static const IMap* assocTreeMap(const IMap*, const lisp_object*, const lisp_object*);
+static const IMap* withoutTreeMap(const IMap*, const lisp_object*);
+static const MapEntry* entryAtTreeMap(const IMap*, const lisp_object*);
+static const lisp_object* valAtTreeMap(const IMap*, const lisp_object*, const lisp_object*);
+static const IMap* consTreeMap(const IMap*, const lisp_object*);
+static bool EqualsTreeMap(const lisp_object *x, const lisp_object *y);
+static uint32_t HashEqTreeMap(const lisp_object *obj);
+
+const Seqable_vtable TreeMap_Seqable_vtable = {
+	seqTreeMap // seq
+};
+
+const Reversible_vtable TreeMap_Reversible_vtable = {
+	rseqTreeMap // rseq
+};
+
+const ICollection_vtable TreeMap_ICollection_vtable = {
+	countTreeMap,					// count
+	(ICollectionFn1)consTreeMap,	// cons
+	emptyTreeMap,					// empty
+	EquivTreeMap,					// Equiv
+};
+
+const IFn_vtable TreeMap_IFn_vtable = {
+	invoke0AFn,		// invoke0
+	invoke1TreeMap,	// invoke1
+	invoke2TreeMap,	// invoke2
+	invoke3AFn,		// invoke3
+	invoke4AFn,		// invoke4
+	invoke5AFn,		// invoke5
+	applyToAFn,		// applyTo
+};
+
+const IMap_vtable TreeMap_IMap_vtable = {
+	containsKeyTreeMap,	// containsKey
+	assocTreeMap,		// assoc
+	withoutTreeMap,		// without
+	entryAtTreeMap,		// entryAt
+	valAtTreeMap,		// valAt
+	consTreeMap,		// cons
+};
+
+interfaces TreeMap_interfaces = {
+	&TreeMap_Seqable_vtable,		// SeqableFns
+	&TreeMap_Reversible_vtable,		// ReversibleFns
+	&TreeMap_ICollection_vtable,	// ICollectionFns
+	NULL,							// IStackFns
+	NULL,							// ISeqFns
+	&TreeMap_IFn_vtable,			// IFnFns
+	NULL,							// IVectorFns
+	&TreeMap_IMap_vtable,			// IMapFns
+	NULL,							// ISetFns
+	toString,						// toString
+	EqualsTreeMap,					// Equals
+	HashEqTreeMap,					// HashEq
+};
+
+const TreeMap _EmptyTreeMap = {{TREEMAP_type, sizeof(TreeMap), NULL, &TreeMap_interfaces}, NULL, 0, NULL, 0};
+const TreeMap *const EmptyTreeMap = &_EmptyTreeMap;
+
+// TreeSet
+
+// A TreeMap from each key to itself.
+struct TreeSet_struct {
+	lisp_object obj;
+	const TreeMap *const impl;
+	uint32_t hash;		// HashEq, computed on first use.  0 until then.
+};
+
+// TreeSet Function declarations.
+
+static const TreeSet *NewTreeSet(const TreeMap *impl);
+static const ISeq *seqTreeSet(const Seqable *obj);
+static const ISeq *rseqTreeSet(const Seqable *obj);
+static size_t countTreeSet(const ICollection *ic);
+static const ICollection* consTreeSet(const ICollection*, const lisp_object*);
+static const ICollection* emptyTreeSet(void);
+static bool EquivTreeSet(const ICollection*, const lisp_object*);
+static const lisp_object* invoke1TreeSet(const IFn*, const lisp_object*);
+static const lisp_object* invoke2TreeSet(const IFn*, const lisp_object*, const lisp_object*);
+static const ISet* disjoinTreeSet(const ISet*, const lisp_object*);
+static bool containsTreeSet(const ISet*, const lisp_object*);
+static const lisp_object* getTreeSet(const ISet*, const lisp_object*);
+static bool EqualsTreeSet(const lisp_object *x, const lisp_object *y);
+static uint32_t HashEqTreeSet(const lisp_object *obj);
+
+const Seqable_vtable TreeSet_Seqable_vtable = {
+	seqTreeSet // seq
+};
+
+const Reversible_vtable TreeSet_Reversible_vtable = {
+	rseqTreeSet // rseq
+};
+
+const ICollection_vtable TreeSet_ICollection_vtable = {
+	countTreeSet,	// count
+	consTreeSet,	// cons
+	emptyTreeSet,	// empty
+	EquivTreeSet,	// Equiv
+};
+
+const IFn_vtable TreeSet_IFn_vtable = {
+	invoke0AFn,		// invoke0
+	invoke1TreeSet,	// invoke1
+	invoke2TreeSet,	// invoke2
+	invoke3AFn,		// invoke3
+	invoke4AFn,		// invoke4
+	invoke5AFn,		// invoke5
+	applyToAFn,		// applyTo
+};
+
+const ISet_vtable TreeSet_ISet_vtable = {
+	disjoinTreeSet,		// disjoin
+	containsTreeSet,	// contains
+	getTreeSet,			// get
+};
+
+interfaces TreeSet_interfaces = {
+	&TreeSet_Seqable_vtable,		// SeqableFns
+	&TreeSet_Reversible_vtable,		// ReversibleFns
+	&TreeSet_ICollection_vtable,	// ICollectionFns
+	NULL,							// IStackFns
+	NULL,							// ISeqFns
+	&TreeSet_IFn_vtable,			// IFnFns
+	NULL,							// IVectorFns
+	NULL,							// IMapFns
+	&TreeSet_ISet_vtable,			// ISetFns
+	toString,						// toString
+	EqualsTreeSet,					// Equals
+	HashEqTreeSet,					// HashEq
+};
+
+const TreeSet _EmptyTreeSet = {{TREESET_type, sizeof(TreeSet), NULL, &TreeSet_interfaces}, &_EmptyTreeMap, 0};
+const TreeSet *const EmptyTreeSet = &_EmptyTreeSet;
+
+// Node Function Definitions.
+
+static int compareKeys(const IFn *comparator, const lisp_object *x, const lisp_object *y) {
+	if(comparator == NULL)
+		return Compare(x, y);
+	long c = IntegerValue((Integer*)comparator->obj.fns->IFnFns->invoke2(comparator, x, y));
+	return c < 0 ? -1 : c > 0;
+}
+
+static size_t sizeTreeNode(const TreeNode *node) {
+	return node ? node->size : 0;
+}
+
+static const TreeNode *NewTreeNode(const lisp_object *key, const lisp_object *val, const TreeNode *left, const TreeNode *right) {
+	TreeNode *node = GC_MALLOC(sizeof(*node));
+	node->obj.type = TREE_NODE_type;
+	node->obj.size = sizeof(TreeNode);
+	node->obj.fns = &NullInterface;
+	node->key = key;
+	node->val = val;
+	node->left = left;
+	node->right = right;
+	node->size = sizeTreeNode(left) + sizeTreeNode(right) + 1;
+	return node;
+}
+
+static const TreeNode *rotateLeft(const lisp_object *key, const lisp_object *val, const TreeNode *left, const TreeNode *right) {
+	const TreeNode *rl = right->left;
+	if(sizeTreeNode(rl) + 1 < GAMMA * (sizeTreeNode(right->right) + 1))
+		return NewTreeNode(right->key, right->val, NewTreeNode(key, val, left, rl), right->right);
+	return NewTreeNode(rl->key, rl->val, NewTreeNode(key, val, left, rl->left), NewTreeNode(right->key, right->val, rl->right, right->right));
+}
+
+static const TreeNode *rotateRight(const lisp_object *key, const lisp_object *val, const TreeNode *left, const TreeNode *right) {
+	const TreeNode *lr = left->right;
+	if(sizeTreeNode(lr) + 1 < GAMMA * (sizeTreeNode(left->left) + 1))
+		return NewTreeNode(left->key, left->val, left->left, NewTreeNode(key, val, lr, right));
+	return NewTreeNode(lr->key, lr->val, NewTreeNode(left->key, left->val, left->left, lr->left), NewTreeNode(key, val, lr->right, right));
+}
+
+// Builds a node from subtrees that were in balance before one of them gained or lost an entry.
+static const TreeNode *balanceTreeNode(const lisp_object *key, const lisp_object *val, const TreeNode *left, const TreeNode *right) {
+	size_t wl = sizeTreeNode(left) + 1;
+	size_t wr = sizeTreeNode(right) + 1;
+	if(wr > DELTA * wl)
+		return rotateLeft(key, val, left, right);
+	if(wl > DELTA * wr)
+		return rotateRight(key, val, left, right);
+	return NewTreeNode(key, val, left, right);
+}
+
+static const TreeNode *assocTreeNode(const TreeNode *node, const IFn *comparator, const lisp_object *key, const lisp_object *val, bool *addedLeaf) {
+	if(node == NULL) {
+		*addedLeaf = true;
+		return NewTreeNode(key, val, NULL, NULL);
+	}
+	int c = compareKeys(comparator, key, node->key);
+	if(c == 0)
+		return node->val == val ? node : NewTreeNode(node->key, val, node->left, node->right);
+	if(c < 0) {
+		const TreeNode *left = assocTreeNode(node->left, comparator, key, val, addedLeaf);
+		if(left == node->left)
+			return node;
+		return *addedLeaf ? balanceTreeNode(node->key, node->val, left, node->right) : NewTreeNode(node->key, node->val, left, node->right);
+	}
+	const TreeNode *right = assocTreeNode(node->right, comparator, key, val, addedLeaf);
+	if(right == node->right)
+		return node;
+	return *addedLeaf ? balanceTreeNode(node->key, node->val, node->left, right) : NewTreeNode(node->key, node->val, node->left, right);
+}
+
+// Removes the least entry of node, and returns it in *min.
+static const TreeNode *withoutMinTreeNode(const TreeNode *node, const TreeNode **min) {
+	if(node->left == NULL) {
+		*min = node;
+		return node->right;
+	}
+	return balanceTreeNode(node->key, node->val, withoutMinTreeNode(node->left, min), node->right);
+}
+
+// Removes the greatest entry of node, and returns it in *max.
+static const TreeNode *withoutMaxTreeNode(const TreeNode *node, const TreeNode **max) {
+	if(node->right == NULL) {
+		*max = node;
+		return node->left;
+	}
+	return balanceTreeNode(node->key, node->val, node->left, withoutMaxTreeNode(node->right, max));
+}
+
+// Joins the subtrees of a removed node, taking its replacement from the heavier side.
+static const TreeNode *glueTreeNode(const TreeNode *left, const TreeNode *right) {
+	if(left == NULL)
+		return right;
+	if(right == NULL)
+		return left;
+	const TreeNode *n;
+	if(left->size > right->size) {
+		left = withoutMaxTreeNode(left, &n);
+	} else {
+		right = withoutMinTreeNode(right, &n);
+	}
+	return balanceTreeNode(n->key, n->val, left, right);
+}
+
+static const TreeNode *withoutTreeNode(const TreeNode *node, const IFn *comparator, const lisp_object *key, bool *removedLeaf) {
+	if(node == NULL)
+		return NULL;
+	int c = compareKeys(comparator, key, node->key);
+	if(c == 0) {
+		*removedLeaf = true;
+		return glueTreeNode(node->left, node->right);
+	}
+	if(c < 0) {
+		const TreeNode *left = withoutTreeNode(node->left, comparator, key, removedLeaf);
+		return *removedLeaf ? balanceTreeNode(node->key, node->val, left, node->right) : node;
+	}
+	const TreeNode *right = withoutTreeNode(node->right, comparator, key, removedLeaf);
+	return *removedLeaf ? balanceTreeNode(node->key, node->val, node->left, right) : node;
+}
+
+static const TreeNode *findTreeNode(const TreeNode *node, const IFn *comparator, const lisp_object *key) {
+	while(node) {
+		int c = compareKeys(comparator, key, node->key);
+		if(c == 0)
+			return node;
+		node = c < 0 ? node->left : node->right;
+	}
+	return NULL;
+}
+
+// TreeSeq Function Definitions.
+
+static const TreeStack *pushTreeStack(const TreeNode *node, const TreeStack *stack) {
+	TreeStack *ret = GC_MALLOC(sizeof(*ret));
+	ret->node = node;
+	ret->next = stack;
+	return ret;
+}
+
+// Pushes node and the path to its first entry in the order of the seq.
+static const TreeStack *pushPathTreeStack(const TreeNode *node, const TreeStack *stack, bool ascending) {
+	for(; node != NULL; node = ascending ? node->left : node->right)
+		stack = pushTreeStack(node, stack);
+	return stack;
+}
+
+// The path to the first entry at or after key in the order of the seq.
+static const TreeStack *seekTreeStack(const TreeNode *node, const IFn *comparator, const lisp_object *key, bool ascending) {
+	const TreeStack *stack = NULL;
+	while(node) {
+		int c = compareKeys(comparator, key, node->key);
+		if(c == 0)
+			return pushTreeStack(node, stack);
+		if(ascending ? c < 0 : c > 0) {
+			stack = pushTreeStack(node, stack);
+			node = ascending ? node->left : node->right;
+		} else {
+			node = ascending ? node->right : node->left;
+		}
+	}
+	return stack;
+}
+
+static const TreeStack *nextTreeStack(const TreeStack *stack, bool ascending) {
+	const TreeNode *node = stack->node;
+	return pushPathTreeStack(ascending ? node->right : node->left, stack->next, ascending);
+}
+
+// Takes all but the stack from params.  Returns NULL once the stack is empty or has passed the end key.
+static const ISeq *CreateTreeSeq(const TreeStack *stack, const TreeSeq *params) {
+	if(stack == NULL)
+		return NULL;
+	if(params->hasEnd) {
+		int c = compareKeys(params->comparator, stack->node->key, params->endKey);
+		if(params->ascending ? c > 0 : c < 0)
+			return NULL;
+		if(c == 0 && !params->endInclusive)
+			return NULL;
+	}
+
+	TreeSeq *ret = GC_MALLOC(sizeof(*ret));
+	memcpy(ret, params, sizeof(*ret));
+	ret->obj.type = TREESEQ_type;
+	ret->obj.size = sizeof(TreeSeq);
+	ret->obj.meta = NULL;
+	ret->obj.fns = &TreeSeq_interfaces;
+	ret->stack = stack;
+	return (ISeq*)ret;
+}
+
+static const lisp_object* firstTreeSeq(const ISeq *o) {
+	assert(o->obj.type == TREESEQ_type);
+	const TreeSeq *ts = (TreeSeq*) o;
+	const TreeNode *node = ts->stack->node;
+
+	return ts->keysOnly ? node->key : (lisp_object*) NewMapEntry(node->key, node->val);
+}
+
+static const ISeq* nextTreeSeq(const ISeq *o) {
+	assert(o->obj.type == TREESEQ_type);
+	const TreeSeq *ts = (TreeSeq*) o;
+
+	return CreateTreeSeq(nextTreeStack(ts->stack, ts->ascending), ts);
+}
+
+// A scan of tm's entries, or of its keys when keysOnly, optionally starting at startKey and ending at endKey.
+static const ISeq *rangeTreeMap(const TreeMap *tm, bool keysOnly, bool ascending,
+		bool hasStart, const lisp_object *startKey, bool startInclusive,
+		bool hasEnd, const lisp_object *endKey, bool endInclusive) {
+	TreeSeq params = {{TREESEQ_type, sizeof(TreeSeq), NULL, &TreeSeq_interfaces},
+		NULL, ascending, keysOnly, tm->comparator, hasEnd, endInclusive, endKey};
+	const TreeStack *stack;
+	if(hasStart) {
+		stack = seekTreeStack(tm->root, tm->comparator, startKey, ascending);
+		if(stack && !startInclusive && compareKeys(tm->comparator, stack->node->key, startKey) == 0)
+			stack = nextTreeStack(stack, ascending);
+	} else {
+		stack = pushPathTreeStack(tm->root, NULL, ascending);
+	}
+	return CreateTreeSeq(stack, &params);
+}
+
+// Range function definitions.
+
+static const TreeMap *sortedImpl(const lisp_object *sc, bool *keysOnly) {
+	switch(objectType(sc)) {
+		case TREEMAP_type:
+			*keysOnly = false;
+			return (TreeMap*)sc;
+		case TREESET_type:
+			*keysOnly = true;
+			return ((TreeSet*)sc)->impl;
+		default: {
+			exception e = {IllegalArgumentException, "Expected a sorted collection"};
+			Raise(e);
+			__builtin_unreachable();
+		}
+	}
+}
+
+static bool isLowerTest(RangeTest test) {
+	return test == RANGE_GT || test == RANGE_GE;
+}
+
+static void checkRangeTests(RangeTest startTest, RangeTest endTest, bool ascending) {
+	if(isLowerTest(startTest) != ascending || isLowerTest(endTest) == ascending) {
+		exception e = {IllegalArgumentException, "Range tests do not bound the scan in its order"};
+		Raise(e);
+	}
+}
+
+const ISeq *subseq1(const lisp_object *sc, RangeTest test, const lisp_object *key) {
+	bool keysOnly;
+	const TreeMap *tm = sortedImpl(sc, &keysOnly);
+	bool inclusive = test == RANGE_LE || test == RANGE_GE;
+	if(isLowerTest(test))
+		return rangeTreeMap(tm, keysOnly, true, true, key, inclusive, false, NULL, false);
+	return rangeTreeMap(tm, keysOnly, true, false, NULL, false, true, key, inclusive);
+}
+
+const ISeq *subseq2(const lisp_object *sc, RangeTest startTest, const lisp_object *startKey, RangeTest endTest, const lisp_object *endKey) {
+	bool keysOnly;
+	const TreeMap *tm = sortedImpl(sc, &keysOnly);
+	checkRangeTests(startTest, endTest, true);
+	return rangeTreeMap(tm, keysOnly, true, true, startKey, startTest == RANGE_GE, true, endKey, endTest == RANGE_LE);
+}
+
+const ISeq *rsubseq1(const lisp_object *sc, RangeTest test, const lisp_object *key) {
+	bool keysOnly;
+	const TreeMap *tm = sortedImpl(sc, &keysOnly);
+	bool inclusive = test == RANGE_LE || test == RANGE_GE;
+	if(!isLowerTest(test))
+		return rangeTreeMap(tm, keysOnly, false, true, key, inclusive, false, NULL, false);
+	return rangeTreeMap(tm, keysOnly, false, false, NULL, false, true, key, inclusive);
+}
+
+const ISeq *rsubseq2(const lisp_object *sc, RangeTest startTest, const lisp_object *startKey, RangeTest endTest, const lisp_object *endKey) {
+	bool keysOnly;
+	const TreeMap *tm = sortedImpl(sc, &keysOnly);
+	checkRangeTests(startTest, endTest, false);
+	return rangeTreeMap(tm, keysOnly, false, true, startKey, startTest == RANGE_LE, true, endKey, endTest == RANGE_GE);
+}
+
+size_t rankSorted(const lisp_object *sc, const lisp_object *key) {
+	bool keysOnly;
+	const TreeMap *tm = sortedImpl(sc, &keysOnly);
+	size_t rank = 0;
+	for(const TreeNode *node = tm->root; node != NULL; ) {
+		int c = compareKeys(tm->comparator, key, node->key);
+		if(c <= 0) {
+			node = node->left;
+		} else {
+			rank += sizeTreeNode(node->left) + 1;
+			node = node->right;
+		}
+	}
+	return rank;
+}
+
+const lisp_object *nthSorted(const lisp_object *sc, size_t n, const lisp_object *NotFound) {
+	bool keysOnly;
+	const TreeMap *tm = sortedImpl(sc, &keysOnly);
+	if(n >= tm->count)
+		return NotFound;
+	const TreeNode *node = tm->root;
+	while(true) {
+		size_t left = sizeTreeNode(node->left);
+		if(n == left)
+			return keysOnly ? node->key : (lisp_object*) NewMapEntry(node->key, node->val);
+		if(n < left) {
+			node = node->left;
+		} else {
+			n -= left + 1;
+			node = node->right;
+		}
+	}
+}
+
+// TreeMap Function Definitions.
+
+const TreeMap *CreateTreeMap(const IFn *comparator, size_t count, const lisp_object **entries) {
+	const TreeNode *root = NULL;
+	size_t n = 0;
+	for(size_t i = 0; i < count; i += 2) {
+		bool addedLeaf = false;
+		root = assocTreeNode(root, comparator, entries[i], entries[i+1], &addedLeaf);
+		if(addedLeaf)
+			n++;
+	}
+	if(n == 0 && comparator == NULL)
+		return EmptyTreeMap;
+	return NewTreeMap(comparator, n, root);
+}
+
+static const TreeMap *NewTreeMap(const IFn *comparator, size_t count, const TreeNode *root) {
+	TreeMap *ret = GC_MALLOC(sizeof(*ret));
+	ret->obj.type = TREEMAP_type;
+	ret->obj.size = sizeof(TreeMap);
+	ret->obj.fns = &TreeMap_interfaces;
+	memcpy((void*) &(ret->comparator), &comparator, sizeof(comparator));
+	memcpy((void*) &(ret->count), &count, sizeof(count));
+	memcpy((void*) &(ret->root), &root, sizeof(root));
+
+	return ret;
+}
+
+static const ISeq *seqTreeMap(const Seqable *obj) {
+	assert(obj->obj.type == TREEMAP_type);
+	return rangeTreeMap((TreeMap*)obj, false, true, false, NULL, false, false, NULL, false);
+}
+
+static const ISeq *rseqTreeMap(const Seqable *obj) {
+	assert(obj->obj.type == TREEMAP_type);
+	return rangeTreeMap((TreeMap*)obj, false, false, false, NULL, false, false, NULL, false);
+}
+
+static size_t countTreeMap(const ICollection *ic) {
+	assert(ic->obj.type == TREEMAP_type);
+	return ((TreeMap*)ic)->count;
+}
+
+// empty takes no argument, so the comparator is lost.  Use CreateTreeMap to keep it.
+static const ICollection* emptyTreeMap(void) {
+	return (ICollection*) EmptyTreeMap;
+}
+
+static bool EquivTreeMapWith(const TreeMap *tm, const lisp_object *obj, bool (*valEquiv)(const lisp_object*, const lisp_object*)) {
+	if((lisp_object*)tm == obj)
+		return true;
+	if(!isIMap(obj))
+		return false;
+	const IMap *im = (IMap*) obj;
+	if(im->obj.fns->ICollectionFns->count((const ICollection*)im) != tm->count)
+		return false;
+	if(obj->type == TREEMAP_type) {
+		const TreeMap *other = (TreeMap*) obj;
+		if(tm->root == other->root)
+			return true;
+		if(tm->hash != 0 && other->hash != 0 && tm->hash != other->hash)
+			return false;
+	}
+
+	for(const ISeq *s = seqTreeMap((const Seqable*)tm); s != NULL; s = s->obj.fns->ISeqFns->next(s)) {
+		const MapEntry *me = (const MapEntry*) s->obj.fns->ISeqFns->first(s);
+		if(!im->obj.fns->IMapFns->containsKey(im, me->key))
+			return false;
+		if(!valEquiv(im->obj.fns->IMapFns->valAt(im, me->key, NULL), me->val))
+			return false;
+	}
+	return true;
+}
+
+static bool EquivTreeMap(const ICollection *ic, const lisp_object *obj) {
+	assert(ic->obj.type == TREEMAP_type);
+	return EquivTreeMapWith((TreeMap*)ic, obj, Equiv);
+}
+
+static bool EqualsTreeMap(const lisp_object *x, const lisp_object *y) {
+	assert(x->type == TREEMAP_type);
+	return EquivTreeMapWith((TreeMap*)x, y, Equals);
+}
+
+static uint32_t HashEqTreeMap(const lisp_object *obj) {
+	assert(obj->type == TREEMAP_type);
+	TreeMap *tm = (TreeMap*)obj;
+	if(tm->count == 0)
+		return mixCollHash(0, 0);
+	if(tm->hash == 0)
+		tm->hash = hashUnordered(obj);
+	return tm->hash;
+}
+
+static const lisp_object* invoke1TreeMap(const IFn *f, const lisp_object *key) {
+	assert(f->obj.type == TREEMAP_type);
+	return valAtTreeMap((IMap*)f, key, NULL);
+}
+
+static const lisp_object* invoke2TreeMap(const IFn *f, const lisp_object *key, const lisp_object *NotFound) {
+	assert(f->obj.type == TREEMAP_type);
+	return valAtTreeMap((IMap*)f, key, NotFound);
+}
+
+static bool containsKeyTreeMap(const IMap *im, const lisp_object *key) {
+	assert(im->obj.type == TREEMAP_type);
+	const TreeMap *tm = (TreeMap*) im;
+	return findTreeNode(tm->root, tm->comparator, key) != NULL;
+}
+
+static const IMap* assocTreeMap(const IMap *im, const lisp_object *key, const lisp_object *val) {
+	assert(im->obj.type == TREEMAP_type);
+	const TreeMap *tm = (TreeMap*) im;
+
+	bool addedLeaf = false;
+	const TreeNode *root = assocTreeNode(tm->root, tm->comparator, key, val, &addedLeaf);
+	if(root == tm->root)
+		return im;
+	return (IMap*) NewTreeMap(tm->comparator, addedLeaf ? tm->count + 1 : tm->count, root);
+}
+
+static const IMap* withoutTreeMap(const IMap *im, const lisp_object *key) {
+	assert(im->obj.type == TREEMAP_type);
+	const TreeMap *tm = (TreeMap*) im;
+
+	bool removedLeaf = false;
+	const TreeNode *root = withoutTreeNode(tm->root, tm->comparator, key, &removedLeaf);
+	if(!removedLeaf)
+		return im;
+	return (IMap*) NewTreeMap(tm->comparator, tm->count - 1, root);
+}
+
+static const MapEntry* entryAtTreeMap(const IMap *im, const lisp_object *key) {
+	assert(im->obj.type == TREEMAP_type);
+	const TreeMap *tm = (TreeMap*) im;
+
+	const TreeNode *node = findTreeNode(tm->root, tm->comparator, key);
+	return node ? NewMapEntry(node->key, node->val) : NULL;
+}
+
+static const lisp_object* valAtTreeMap(const IMap *im, const lisp_object *key, const lisp_object *NotFound) {
+	assert(im->obj.type == TREEMAP_type);
+	const TreeMap *tm = (TreeMap*) im;
+
+	const TreeNode *node = findTreeNode(tm->root, tm->comparator, key);
+	return node ? node->val : NotFound;
+}
+
+static const IMap* consTreeMap(const IMap *im, const lisp_object *obj) {
+	assert(im->obj.type == TREEMAP_type);
+
+	if(isIVector(obj)) {
+		const IVector* v = (const IVector*) obj;
+		if(v->obj.fns->ICollectionFns->count((ICollection*)v) != 2) {
+			exception e = {IllegalArgumentException, "Vector arg to map conj must be a pair"};
+			Raise(e);
+		}
+		return assocTreeMap(im, v->obj.fns->IVectorFns->nth(v, 0, NULL), v->obj.fns->IVectorFns->nth(v, 1, NULL));
+	}
+
+	const IMap *ret = im;
+	for(const ISeq *s = seq(obj); s != NULL; s = s->obj.fns->ISeqFns->next(s)) {
+		const MapEntry *me = (MapEntry*) s->obj.fns->ISeqFns->first(s);
+		ret = assocTreeMap(ret, me->key, me->val);
+	}
+	return ret;
+}
+
+// TreeSet Function Definitions.
+
+const TreeSet *CreateTreeSet(const IFn *comparator, size_t count, const lisp_object **keys) {
+	const TreeNode *root = NULL;
+	size_t n = 0;
+	for(size_t i = 0; i < count; i++) {
+		bool addedLeaf = false;
+		root = assocTreeNode(root, comparator, keys[i], keys[i], &addedLeaf);
+		if(addedLeaf)
+			n++;
+	}
+	if(n == 0 && comparator == NULL)
+		return EmptyTreeSet;
+	return NewTreeSet(NewTreeMap(comparator, n, root));
+}
+
+static const TreeSet *NewTreeSet(const TreeMap *impl) {
+	TreeSet *ret = GC_MALLOC(sizeof(*ret));
+	ret->obj.type = TREESET_type;
+	ret->obj.size = sizeof(TreeSet);
+	ret->obj.fns = &TreeSet_interfaces;
+	memcpy((void*) &(ret->impl), &impl, sizeof(impl));
+
+	return ret;
+}
+
+static const ISeq *seqTreeSet(const Seqable *obj) {
+	assert(obj->obj.type == TREESET_type);
+	return rangeTreeMap(((TreeSet*)obj)->impl, true, true, false, NULL, false, false, NULL, false);
+}
+
+static const ISeq *rseqTreeSet(const Seqable *obj) {
+	assert(obj->obj.type == TREESET_type);
+	return rangeTreeMap(((TreeSet*)obj)->impl, true, false, false, NULL, false, false, NULL, false);
+}
+
+static size_t countTreeSet(const ICollection *ic) {
+	assert(ic->obj.type == TREESET_type);
+	return ((TreeSet*)ic)->impl->count;
+}
+
+static const ICollection* consTreeSet(const ICollection *ic, const lisp_object *key) {
+	assert(ic->obj.type == TREESET_type);
+	const TreeSet *ts = (TreeSet*) ic;
+
+	if(containsKeyTreeMap((IMap*)ts->impl, key))
+		return ic;
+	return (ICollection*) NewTreeSet((TreeMap*)assocTreeMap((IMap*)ts->impl, key, key));
+}
+
+// empty takes no argument, so the comparator is lost.  Use CreateTreeSet to keep it.
+static const ICollection* emptyTreeSet(void) {
+	return (ICollection*) EmptyTreeSet;
+}
+
+static bool EquivTreeSet(const ICollection *ic, const lisp_object *obj) {
+	assert(ic->obj.type == TREESET_type);
+	const TreeSet *ts = (TreeSet*) ic;
+
+	if((lisp_object*)ts == obj)
+		return true;
+	if(!isISet(obj))
+		return false;
+	const ISet *other = (ISet*) obj;
+	if(other->obj.fns->ICollectionFns->count((const ICollection*)other) != ts->impl->count)
+		return false;
+	if(obj->type == TREESET_type) {
+		const TreeSet *ots = (TreeSet*) obj;
+		if(ts->impl->root == ots->impl->root)
+			return true;
+		if(ts->hash != 0 && ots->hash != 0 && ts->hash != ots->hash)
+			return false;
+	}
+
+	for(const ISeq *s = seqTreeSet((const Seqable*)ts); s != NULL; s = s->obj.fns->ISeqFns->next(s)) {
+		if(!other->obj.fns->ISetFns->contains(other, s->obj.fns->ISeqFns->first(s)))
+			return false;
+	}
+	return true;
+}
+
+static bool EqualsTreeSet(const lisp_object *x, const lisp_object *y) {
+	assert(x->type == TREESET_type);
+	return EquivTreeSet((ICollection*)x, y);
+}
+
+static uint32_t HashEqTreeSet(const lisp_object *obj) {
+	assert(obj->type == TREESET_type);
+	TreeSet *ts = (TreeSet*)obj;
+	if(ts->impl->count == 0)
+		return mixCollHash(0, 0);
+	if(ts->hash == 0)
+		ts->hash = hashUnordered(obj);
+	return ts->hash;
+}
+
+static const lisp_object* invoke1TreeSet(const IFn *f, const lisp_object *key) {
+	assert(f->obj.type == TREESET_type);
+	return getTreeSet((ISet*)f, key);
+}
+
+static const lisp_object* invoke2TreeSet(const IFn *f, const lisp_object *key, const lisp_object *NotFound) {
+	assert(f->obj.type == TREESET_type);
+	return valAtTreeMap((IMap*)((TreeSet*)f)->impl, key, NotFound);
+}
+
+static const ISet* disjoinTreeSet(const ISet *is, const lisp_object *key) {
+	assert(is->obj.type == TREESET_type);
+	const TreeSet *ts = (TreeSet*) is;
+
+	const IMap *impl = withoutTreeMap((IMap*)ts->impl, key);
+	if(impl == (IMap*)ts->impl)
+		return is;
+	return (ISet*) NewTreeSet((TreeMap*)impl);
+}
+
+static bool containsTreeSet(const ISet *is, const lisp_object *key) {
+	assert(is->obj.type == TREESET_type);
+	return containsKeyTreeMap((IMap*)((TreeSet*)is)->impl, key);
+}
+
+static const lisp_object* getTreeSet(const ISet *is, const lisp_object *key) {
+	assert(is->obj.type == TREESET_type);
+	return valAtTreeMap((IMap*)((TreeSet*)is)->impl, key, NULL);
+}
@@ -0,0 +1,41 @@
+#ifndef TREE_MAP_H
+#define TREE_MAP_H
+
+#include "Interfaces.h"
+#include "LispObject.h"
+
+// Persistent sorted collections, kept in a weight balanced binary tree.  Each node records the size of its subtree,
+// so the rank of a key and the entry at a rank are found in O(log n).  Keys are ordered by comparator, an IFn taking
+// two keys and returning a negative, zero or positive Integer.  A NULL comparator uses Compare.
+typedef struct TreeMap_struct TreeMap;
+typedef struct TreeSet_struct TreeSet;
+
+const TreeMap *CreateTreeMap(const IFn *comparator, size_t count, const lisp_object **entries);
+const TreeSet *CreateTreeSet(const IFn *comparator, size_t count, const lisp_object **keys);
+
+// The bound on a range of keys, as the test each key in the range passes against the bound's key.
+typedef enum {	// RangeTest
+	RANGE_LT,
+	RANGE_LE,
+	RANGE_GT,
+	RANGE_GE,
+} RangeTest;
+
+// Range scans over a TreeMap, which yield MapEntries, or a TreeSet, which yields keys.  subseq runs in ascending order
+// and rsubseq in descending order.  The two bound forms take the bound nearest the start of the scan first.
+const ISeq *subseq1(const lisp_object *sc, RangeTest test, const lisp_object *key);
+const ISeq *subseq2(const lisp_object *sc, RangeTest startTest, const lisp_object *startKey, RangeTest endTest, const lisp_object *endKey);
+const ISeq *rsubseq1(const lisp_object *sc, RangeTest test, const lisp_object *key);
+const ISeq *rsubseq2(const lisp_object *sc, RangeTest startTest, const lisp_object *startKey, RangeTest endTest, const lisp_object *endKey);
+
+// The number of keys in sc less than key, whether or not key is present.
+size_t rankSorted(const lisp_object *sc, const lisp_object *key);
+// The MapEntry or key of rank n, or NotFound when n is out of range.
+const lisp_object *nthSorted(const lisp_object *sc, size_t n, const lisp_object *NotFound);
+
+extern const TreeMap _EmptyTreeMap;
+extern const TreeMap *const EmptyTreeMap;
+extern const TreeSet _EmptyTreeSet;
+extern const TreeSet *const EmptyTreeSet;
+
+#endif /* TREE_MAP_H */
@@ -5,16 +5,20 @@
 #include <string.h>
 
 #include "AMap.h"
+#include "ArrayMap.h"
 #include "Bool.h"
 #include "Cons.h"
 #include "Error.h"
 #include "gc.h"
 #include "Interfaces.h"
+#include "Keyword.h"
 #include "List.h"
 #include "Map.h"
 #include "Numbers.h"
 #include "Murmur3.h"
+#include "Set.h"
 #include "StringWriter.h"
+#include "Strings.h"
 #include "Symbol.h"
 #include "Vector.h"
 
@@ -25,8 +29,10 @@ bool EqualBase(const lisp_object *x, const lisp_object *y) {
 bool Equals(const lisp_object *x, const lisp_object *y) {
 	if(x == y)
 		return true;
-	assert(x->Equals);
-	return x && x->Equals(x, y);
+	if(x == NULL || isImmediate(x))
+		return false;
+	assert(x->fns->Equals);
+	return x->fns->Equals(x, y);
 }
 
 bool Equiv(const lisp_object *x, const lisp_object *y) {
@@ -42,16 +48,92 @@ bool Equiv(const lisp_object *x, const lisp_object *y) {
 		if(x && isICollection(y)) {
 			return y->fns->ICollectionFns->Equiv((const ICollection*)y, x);
 		}
-		// return x.equals(y)
+		if(objectFns(x)->Equals)
+			return objectFns(x)->Equals(x, y);
 	}
 	return false;
 }
 
+static int compareStrings(const char *x, const char *y) {
+	if(x == y) return 0;
+	if(x == NULL) return -1;
+	if(y == NULL) return 1;
+	return strcmp(x, y);
+}
+
+// The default order for sorted collections.  nil sorts first, numbers compare by value, symbols and keywords by
+// namespace and then name, and vectors by length and then element by element.  Other mixes of types are an error.
+int Compare(const lisp_object *x, const lisp_object *y) {
+	if(x == y) return 0;
+	if(x == NULL) return -1;
+	if(y == NULL) return 1;
+
+	if(isNumber(x) && isNumber(y)) {
+		if(objectType(x) == INTEGER_type && objectType(y) == INTEGER_type) {
+			long i = IntegerValue((Integer*)x);
+			long j = IntegerValue((Integer*)y);
+			return i < j ? -1 : i > j;
+		}
+		double a = objectType(x) == INTEGER_type ? IntegerValue((Integer*)x) : FloatValue((Float*)x);
+		double b = objectType(y) == INTEGER_type ? IntegerValue((Integer*)y) : FloatValue((Float*)y);
+		return a < b ? -1 : a > b;
+	}
+	if(isIVector(x) && isIVector(y)) {
+		const IVector *v = (IVector*)x;
+		const IVector *w = (IVector*)y;
+		size_t n = count(x);
+		size_t m = count(y);
+		if(n != m)
+			return n < m ? -1 : 1;
+		for(size_t i = 0; i < n; i++) {
+			int c = Compare(v->obj.fns->IVectorFns->nth(v, i, NULL), w->obj.fns->IVectorFns->nth(w, i, NULL));
+			if(c != 0)
+				return c;
+		}
+		return 0;
+	}
+
+	object_type type = objectType(x);
+	if(type == objectType(y)) {
+		switch(type) {
+			case CHAR_type: {
+				char a = CharValue((Char*)x);
+				char b = CharValue((Char*)y);
+				return a < b ? -1 : a > b;
+			}
+			case STRING_type:
+				return strcmp(toString(x), toString(y));
+			case BOOL_type:
+				return x == (lisp_object*)False ? -1 : 1;
+			case SYMBOL_type: {
+				int c = compareStrings(getNamespaceSymbol((Symbol*)x), getNamespaceSymbol((Symbol*)y));
+				return c ? c : compareStrings(getNameSymbol((Symbol*)x), getNameSymbol((Symbol*)y));
+			}
+			case KEYWORD_type: {
+				int c = compareStrings(getNamespaceKeyword((Keyword*)x), getNamespaceKeyword((Keyword*)y));
+				return c ? c : compareStrings(getNameKeyword((Keyword*)x), getNameKeyword((Keyword*)y));
+			}
+			default:
+				break;
+		}
+	}
+
+	exception e = {IllegalArgumentException, WriteString(AddString(AddString(AddString(AddString(NewStringWriter(), "Cannot compare "),
+				object_type_string[objectType(x)]), " to "), object_type_string[objectType(y)]))};
+	Raise(e);
+	__builtin_unreachable();
+}
+
 uint32_t HashEq(const lisp_object *x) {
 	if(x == NULL) return 0;
+	if(objectFns(x)->HashEq)
+		return objectFns(x)->HashEq(x);
 
-	switch(x->type) {
-		case CHAR_type:
+	switch(objectType(x)) {
+		case CHAR_type: {
+			char c = CharValue((Char*)x);
+			return hash32(&c, sizeof(c));
+		}
 		case STRING_type: {
 			const char *s = toString(x);
 			return hash32(s, strlen(s));
@@ -70,23 +152,51 @@ uint32_t HashEq(const lisp_object *x) {
 			const char *ns = getNamespaceSymbol(s);
 			return hashCombine(hash32(name, strlen(name)), hash32(ns, ns ? strlen(ns) : 0));
 		}
-		case LIST_type:			// TODO HashEq
-		case CONS_type:			// TODO HashEq
-		case NODESEQ_type:		// TODO HashEq
-		case ARRAYNODESEQ_type:	// TODO HashEq
-		case HASHMAP_type:		// TODO HashEq
-		case VECTOR_type:		// TODO HashEq
 		default:
+			// Collections that cache their hash provide HashEq.  Seqs and the rest are hashed afresh.
+			if(isIMap(x) || isISet(x))
+				return hashUnordered(x);
+			if(isIVector(x) || isISeq(x))
+				return hashOrdered(x);
 			return hash32(&x, sizeof(x));
 	}
 }
 
+// Sequential collections that are Equiv hash alike, whatever their type.
+uint32_t hashOrdered(const lisp_object *coll) {
+	uint32_t hash = 1;
+	size_t n = 0;
+	const ISeq *s = seq(coll);
+	for(; isChunkedSeq(s); s = chunkRest(s)) {
+		size_t count;
+		const lisp_object *const *chunk = chunkFirst(s, &count);
+		for(size_t i = 0; i < count; i++, n++)
+			hash = 31 * hash + HashEq(chunk[i]);
+	}
+	for(; s != NULL; s = s->obj.fns->ISeqFns->next(s), n++)
+		hash = 31 * hash + HashEq(s->obj.fns->ISeqFns->first(s));
+	return mixCollHash(hash, n);
+}
+
+// Maps hash their MapEntries, and sets their keys, without regard to order.
+uint32_t hashUnordered(const lisp_object *coll) {
+	uint32_t hash = 0;
+	size_t n = 0;
+	for(const ISeq *s = seq(coll); s != NULL; s = s->obj.fns->ISeqFns->next(s), n++)
+		hash += HashEq(s->obj.fns->ISeqFns->first(s));
+	return mixCollHash(hash, n);
+}
+
 uint32_t hashCombine(uint32_t x, uint32_t y) {
 	return x ^ (y + HASH_MIXER + (x << 6) + (x >> 2));
 }
 
 static void PrintObject(StringWriter *sw, const lisp_object *obj) {
 	assert(sw);
+	if(obj == NULL) {
+		AddString(sw, "nil");
+		return;
+	}
 	if((void*) obj == (void*) EmptyList) {
 		AddString(sw, "()");
 		return;
@@ -126,8 +236,23 @@ static void PrintObject(StringWriter *sw, const lisp_object *obj) {
 		AddChar(sw, '}');
 		return;
 	}
+	if(isISet(obj)) {
+		if(obj->fns->ICollectionFns->count((const ICollection*)obj) == 0) {
+			AddString(sw, "#{}");
+			return;
+		}
+
+		AddString(sw, "#{");
+		for(const ISeq *s = obj->fns->SeqableFns->seq((Seqable*)obj); s != NULL; s = s->obj.fns->ISeqFns->next(s)) {
+			PrintObject(sw, s->obj.fns->ISeqFns->first(s));
+			AddChar(sw, ' ');
+		}
+		Shrink(sw, 1);
+		AddChar(sw, '}');
+		return;
+	}
 	if(isIVector(obj)) {
-		if(obj == (const lisp_object*) EmptyVector) {
+		if(obj->fns->ICollectionFns->count((const ICollection*)obj) == 0) {
 			AddString(sw, "[]");
 			return;
 		}
@@ -140,7 +265,16 @@ static void PrintObject(StringWriter *sw, const lisp_object *obj) {
 		AddChar(sw, ']');
 		return;
 	}
-	AddString(sw, obj->toString(obj));
+	switch(objectType(obj)) {
+		case INTEGER_type:
+			AddString(sw, IntegerToString(obj));
+			return;
+		case CHAR_type:
+			AddString(sw, CharToString(obj));
+			return;
+		default:
+			AddString(sw, obj->fns->toString(obj));
+	}
 }
 
 const char *toString(const lisp_object *obj) {
@@ -150,6 +284,8 @@ const char *toString(const lisp_object *obj) {
 }
 
 const lisp_object* copy(const lisp_object *obj) {
+	if(isImmediate(obj))
+		return obj;
 	lisp_object *ret = GC_MALLOC(obj->size);
 	memcpy(ret, obj, obj->size);
 
@@ -161,11 +297,12 @@ const lisp_object *get(const lisp_object *coll, const lisp_object *key, const li
 
 	const lisp_object *ret = NULL;
 	if(isIMap(coll)) {
-		const MapEntry *me = coll->fns->IMapFns->entryAt((IMap*)coll, key);
-		ret = me ? me->val : NULL;
+		ret = coll->fns->IMapFns->valAt((IMap*)coll, key, NULL);
 	} else if(isIVector(coll)) {
 		const MapEntry *me = coll->fns->IVectorFns->entryAt((IVector*)coll, key);
 		ret = me ? me->val : NULL;
+	} else if(isISet(coll)) {
+		ret = coll->fns->ISetFns->get((ISet*)coll, key);
 	}
 	return ret ? ret : NotFound;
 }
@@ -177,7 +314,7 @@ const ISeq *seq(const lisp_object *obj) {
 		return obj->fns->SeqableFns->seq((const Seqable*) obj);
 
 	exception e = {IllegalArgumentException, WriteString(AddString(AddString(NewStringWriter(), "Don't know how to create ISeq from: "),
-				object_type_string[obj->type]))};
+				object_type_string[objectType(obj)]))};
 	Raise(e);
 	__builtin_unreachable();
 }
@@ -239,18 +376,20 @@ const lisp_object* assoc(const lisp_object *coll, const lisp_object *key, const
 		exception e = {UnsupportedOperationException, "Cannot use assoc on coll"};
 		Raise(e);
 	}
-	return (lisp_object*)((IMap*)EmptyHashMap)->obj.fns->IMapFns->assoc((IMap*)EmptyHashMap, key, val);
+	return (lisp_object*)((IMap*)EmptyArrayMap)->obj.fns->IMapFns->assoc((IMap*)EmptyArrayMap, key, val);
 }
 
 bool boolCast(const lisp_object *obj) {
 	if(obj == NULL)
-		return (lisp_object*)False;
-	if(obj->type == BOOL_type)
+		return false;
+	if(objectType(obj) == BOOL_type)
 		return obj == (lisp_object*)True;
 	return obj != NULL;
 }
 
 const lisp_object *withMeta(const lisp_object *obj, const IMap *meta) {
+	if(isImmediate(obj))
+		return obj;
 	lisp_object *ret = GC_MALLOC(obj->size);
 	memcpy(ret, obj, obj->size);
 	ret->meta = meta;
@@ -12,8 +12,11 @@
 bool EqualBase(const lisp_object *x, const lisp_object *y);
 bool Equals(const lisp_object *x, const lisp_object *y);
 bool Equiv(const lisp_object *x, const lisp_object *y);
+int Compare(const lisp_object *x, const lisp_object *y);	// Negative, zero or positive, as x sorts before, with or after y.
 
 uint32_t HashEq(const lisp_object *x);
+uint32_t hashOrdered(const lisp_object *coll);		// The HashEq of a vector, list or seq with coll's elements.
+uint32_t hashUnordered(const lisp_object *coll);	// The HashEq of a map or set with coll's entries or keys.
 uint32_t hashCombine(uint32_t x, uint32_t y);
 const char *toString(const lisp_object *obj);
 const lisp_object* copy(const lisp_object *obj);
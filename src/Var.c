@@ -4,6 +4,7 @@
 
 #include "AFn.h"
 #include "ARef.h"
+#include "ArrayMap.h"
 #include "Bool.h"
 #include "Error.h"
 #include "gc.h"
@@ -46,8 +47,23 @@ interfaces Unbound_interfaces = {
 	&Unbound_IFn_vtable,	// IFnFns
 	NULL,					// IVectorFns
 	NULL,					// IMapFns
+	NULL,					// ISetFns
+	toStringUnbound,		// toString
+	NULL,					// Equals
+	NULL,					// HashEq
 };
 
+// Box
+// Holds a thread binding.  Frames pushed on top of the one that made the binding share its Box, so a setVar is seen
+// by all of them and outlives the inner frames being popped.
+
+typedef struct {	// Box
+	lisp_object obj;
+	const lisp_object *val;
+} Box;
+
+static Box *NewBox(const lisp_object *val);
+
 // Frame
 
 typedef struct Frame_struct {
@@ -60,7 +76,7 @@ typedef struct Frame_struct {
 static const Frame *NewFrame(const IMap *bindings, const Frame *prev);
 // static const Frame *cloneFrame(Frame *f);
 
-static const Frame _TopFrame = {(const IMap*)&_EmptyHashMap, NULL};
+static const Frame _TopFrame = {(const IMap*)&_EmptyArrayMap, NULL};
 static const Frame *const TopFrame = &_TopFrame;
 static __thread const Frame *dval = &_TopFrame;
 
@@ -69,6 +85,7 @@ static __thread const Frame *dval = &_TopFrame;
 struct Var_struct{
 	lisp_object obj;
 	const lisp_object *root;
+	size_t rev;		// Bumped whenever the value seen through deref may have changed.
 	bool dynamic;
 	bool threadBound;
 	const Symbol *sym;
@@ -108,6 +125,10 @@ interfaces Var_interfaces = {
 	&Var_IFn_vtable,	// IFnFns
 	NULL,				// IVectorFns
 	NULL,				// IMapFns
+	NULL,				// ISetFns
+	toStringVar,		// toString
+	EqualBase,			// Equals
+	NULL,				// HashEq
 };
 
 // Unbound Function Definitions.
@@ -115,7 +136,6 @@ interfaces Var_interfaces = {
 static const Unbound *NewUnbound(const Var *v) {
 	Unbound *ret = GC_MALLOC(sizeof(*ret));
 	ret->obj.type = UNBOUND_type;
-	ret->obj.toString = toStringUnbound;
 	ret->obj.fns = &Unbound_interfaces;
 
 	ret->v = v;
@@ -133,10 +153,23 @@ static const char *toStringUnbound(const lisp_object *obj) {
 	return WriteString(sw);
 }
 
+// Box Function Definitions.
+
+static Box *NewBox(const lisp_object *val) {
+	Box *ret = GC_MALLOC(sizeof(*ret));
+	ret->obj.type = BOX_type;
+	ret->obj.size = sizeof(*ret);
+	ret->obj.fns = &NullInterface;
+	ret->val = val;
+	return ret;
+}
+
 // Frame Function Definitions.
 
+// The collector does not scan thread-local storage, so dval alone would not keep a frame or its bindings alive.
+// Frames are uncollectable instead, and popThreadBindings frees them.
 static const Frame *NewFrame(const IMap *bindings, const Frame *prev) {
-	Frame *ret = GC_MALLOC(sizeof(*ret));
+	Frame *ret = GC_MALLOC_UNCOLLECTABLE(sizeof(*ret));
 
 	ret->bindings = bindings;
 	ret->prev = prev;
@@ -148,16 +181,25 @@ static const Frame *NewFrame(const IMap *bindings, const Frame *prev) {
 
 // Var Function Definitions.
 
+// Every binding is a Box, so NULL from valAt can only mean the Var has none.  valAt does not allocate a MapEntry the
+// way entryAt does, and deref comes through here on every read of a thread-bound Var.
+static Box *getThreadBinding(const Var *v) {
+	if(!v->threadBound)
+		return NULL;
+	const IMap *bmap = dval->bindings;
+	return (Box*)bmap->obj.fns->IMapFns->valAt(bmap, (lisp_object*)v, NULL);
+}
+
 Var* NewVar(const Namespace *ns, const Symbol *sym, const lisp_object *root) {
 	Var *ret = GC_MALLOC(sizeof(*ret));
 
 	ret->obj.type = VAR_type;
-	ret->obj.toString = toStringVar;
-	ret->obj.meta = (IMap*) EmptyHashMap;
+	ret->obj.meta = (IMap*) EmptyArrayMap;
 	ret->obj.fns = &Var_interfaces;
 
 	ret->ns = ns;
 	ret->sym = sym;
+	ret->rev = 0;
 	ret->dynamic = false;
 	ret->threadBound = false;
 	ret->validator = NULL;
@@ -184,12 +226,11 @@ Var* createVar(const lisp_object* root) {
 
 const lisp_object *getTag(const Var *v) {
 	const IMap *m = v->obj.meta;
-	const MapEntry *me = m->obj.fns->IMapFns->entryAt(m, (lisp_object*)tagKW);
-	return me ? me->val : NULL;
+	return m->obj.fns->IMapFns->valAt(m, (lisp_object*)tagKW, NULL);
 }
 
 const lisp_object *getVar(const Var *v) {
-	if(v->threadBound)
+	if(!v->threadBound)
 		return v->root;
 	return deref(v);
 }
@@ -210,13 +251,15 @@ void setMacro(Var *v) {
 
 void setVar(Var *v, const lisp_object *val) {
 	printf("In setVar\n");
+	Box *b = getThreadBinding(v);
+	if(b == NULL) {
+		exception e = {IllegalStateException, WriteString(AddString(AddString(NewStringWriter(),
+						"Can't change/establish root binding of: "), toString((lisp_object*)v)))};
+		Raise(e);
+	}
 	Validate(v->validator, val);
-	const IMap *m = dval->bindings;
-	dval = NewFrame(m->obj.fns->IMapFns->assoc(m, (lisp_object*)v, val), dval->prev);
-	printf("dval = %p\n", (void*)dval);
-	if(dval)
-		printf("dval->bindings = %p\n", (void*)dval->bindings);
-	fflush(stdout);
+	b->val = val;
+	v->rev++;
 }
 
 bool isMacroVar(Var *v) {
@@ -225,11 +268,13 @@ bool isMacroVar(Var *v) {
 
 Var *setDynamic(Var *v) {
 	v->dynamic = true;
+	v->rev++;
 	return v;
 }
 
 Var *setDynamic1(Var *v, bool b) {
 	v->dynamic = b;
+	v->rev++;
 	return v;
 }
 
@@ -254,20 +299,23 @@ bool isBound(const Var *v) {
 	fflush(stdout);
 	printf("bmap->obj.type = %s\n", object_type_string[bmap->obj.type]);
 	fflush(stdout);
-	return hasRoot(v) || (v->threadBound && bmap->obj.fns->IMapFns->entryAt(bmap, (lisp_object*)v));
+	return hasRoot(v) || (v->threadBound && bmap->obj.fns->IMapFns->containsKey(bmap, (lisp_object*)v));
 }
 
 bool isPublic(const Var *v) {
 	return boolCast(get((lisp_object*)v->obj.meta, (lisp_object*)privateKW, NULL));
 }
 
+// A thread binding hides the root, even when its value is nil.
 const lisp_object* deref(const Var *v) {
-	return v->root;
+	const Box *b = getThreadBinding(v);
+	return b ? b->val : v->root;
 }
 
 void bindRoot(Var *v, const lisp_object *obj) {
 	Validate(v->validator, obj);
 	v->root = obj;
+	v->rev++;
 	// TODO Handle meta.
 	// TODO Handle Watches.
 }
@@ -280,6 +328,10 @@ const Symbol *getSymbolVar(const Var *v) {
 	return v->sym;
 }
 
+size_t getRevVar(const Var *v) {
+	return v->rev;
+}
+
 void pushThreadBindings(const IMap *bindings) {
 	printf("In pushThreadBindings.\n");
 	const Frame *f = dval;
@@ -296,7 +348,7 @@ void pushThreadBindings(const IMap *bindings) {
 		}
 		Validate(v->validator, e->val);
 		v->threadBound = true;
-		bmap = bmap->obj.fns->IMapFns->assoc(bmap, (const lisp_object*)v, e->val);
+		bmap = bmap->obj.fns->IMapFns->assoc(bmap, (const lisp_object*)v, (lisp_object*)NewBox(e->val));
 		printf("bmap = %p\n", (void*)bmap);
 		if(bmap)
 			printf("bmap->type = %d\n", bmap->obj.type);
@@ -319,6 +371,7 @@ void popThreadBindings(void) {
 		exception e = {IllegalStateException, "Pop without matching push"};
 		Raise(e);
 	}
+	GC_FREE((void*)dval);
 	dval = f;
 	printf("dval = %p\n", (void*)dval);
 	if(dval)
@@ -327,7 +380,7 @@ void popThreadBindings(void) {
 }
 
 static bool hasRoot(const Var *v) {
-	return v->root->type != UNBOUND_type;
+	return objectType(v->root) != UNBOUND_type;
 }
 
 static const IFn* fn(const Var *v) {
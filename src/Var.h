@@ -31,6 +31,7 @@ void bindRoot(Var *v, const lisp_object *obj);
 
 const Namespace *getNamespaceVar(const Var *v);
 const Symbol *getSymbolVar(const Var *v);
+size_t getRevVar(const Var *v);
 
 void pushThreadBindings(const IMap *bindings);
 void popThreadBindings(void);
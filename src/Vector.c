@@ -7,49 +7,74 @@
 #include "AFn.h"
 #include "ASeq.h"
 #include "AVector.h"
+#include "EditToken.h"
 #include "Error.h"
 #include "gc.h"
 #include "Interfaces.h"
 #include "lisp_pthread.h"
 #include "Map.h"
+#include "Murmur3.h"
+#include "nodes.h"
 #include "Util.h"
 
-#define LOG_NODE_SIZE 5
-#define NODE_SIZE (1 << LOG_NODE_SIZE)
-#define BITMASK (NODE_SIZE - 1)
 
 // Node
 
+// Nodes are internal to a vector, so they carry no lisp_object header.  A node is owned by a transient when its edit
+// points at the transient's EditToken.  Persistent nodes have a NULL edit.
+// Every child of a regular node but the last is full, so the child holding an element follows from its index.  subvec
+// and catvec also make relaxed nodes, whose children may hold fewer, and which find a child through sizes.
 typedef struct {
-    lisp_object obj;
-    bool editable;
-    pthread_t thread_id;
+    const EditToken *edit;
     const lisp_object *array[NODE_SIZE];
 } Node;
 
-// Node Function Declarations.
+typedef struct {
+	Node node;
+	size_t sizes[NODE_SIZE];	// The number of elements under children 0 to i.
+} RelaxedNode;
+
+// Relaxed nodes are never owned by a transient, so their edit marks them instead.
+static const EditToken RelaxedEdit = {false};
+
+// A node and the number of elements under it, which a node does not record for itself.  A leaf is a subtree at level 0.
+typedef struct {
+	const Node *node;
+	size_t count;
+} Subtree;
 
-static Node *NewNode(bool editable, pthread_t thread_id, size_t count, const lisp_object* const* array);
-static Node *editableRoot(const Node *const root);
-static Node *newPath(bool editable, pthread_t thread_id, size_t level, Node *node);
+// Node Function Declarations.
 
-const Node _EmptyNode = {{NODE_type, sizeof(Node), NULL, NULL, NULL, NULL}, false, 0, {NULL}};
+static Node *NewNode(const EditToken *edit, size_t count, const lisp_object* const* array);
+static Node *newPath(const EditToken *edit, size_t level, Node *node);
+static const size_t *nodeSizes(const Node *node);
+static size_t childIndex(const Node *node, size_t level, size_t *i, size_t *count);
+static size_t children(const Node *node, size_t level, size_t count, Subtree *out);
+static Node *packNode(size_t level, size_t n, const Subtree *subtrees);
+static Subtree sliceLeft(Subtree t, size_t level, size_t start);
+static Subtree sliceRight(Subtree t, size_t level, size_t end);
+static Subtree trimRoot(Subtree t, size_t *shift);
+static size_t concatSubtrees(Subtree x, size_t xlevel, Subtree y, size_t ylevel, Subtree *out);
+static Subtree concatTrees(Subtree x, size_t xlevel, Subtree y, size_t ylevel, size_t *level);
+
+const Node _EmptyNode = {NULL, {NULL}};
 const Node *const EmptyNode = &_EmptyNode;
 
 // ChunkedSeq
 
+// Points into the vector's own leaf array, so stepping along a chunk copies nothing.
 typedef struct {
 	lisp_object obj;
 	const Vector *vec;
-	size_t count;
-	const lisp_object *node[NODE_SIZE];
-	size_t i;
-	size_t offset;
+	const lisp_object *const *node;	// The array of the leaf or tail holding element i.
+	size_t i;						// The index in vec of node[0].
+	uint32_t count;					// The length of node, which is short for the tail and in relaxed tries.
+	uint32_t offset;
 } ChunkedSeq;
 
 // ChunkedSeq Function Declarations.
 
-static ChunkedSeq* NewChunkedSeq(const IMap *meta, const Vector *v, size_t count, const lisp_object* const* node, size_t i, size_t offset);
+static ChunkedSeq* NewChunkedSeq(const IMap *meta, const Vector *v, const lisp_object* const* node, size_t i, size_t count, size_t offset);
 static size_t countChunkedSeq(const ICollection*);
 static const lisp_object* firstChunkedSeq(const ISeq*);
 static const ISeq* nextChunkedSeq(const ISeq*);
@@ -82,16 +107,22 @@ interfaces ChunkSeq_interfaces = {
 	NULL,							// IFnFns
 	NULL,							// IVectorFns
 	NULL,							// IMapFns
+	NULL,							// ISetFns
+	toString,						// toString
+	EqualsASeq,						// Equals
+	NULL,							// HashEq
 };
 
 
 // TransientVector
 
+// Shares the persistent vector's root until the first write below it, and copies each node it writes to once.
 typedef struct {
     lisp_object obj;
     size_t count;
     size_t shift;
-    Node *root;
+    const Node *root;
+    EditToken edit;
     const lisp_object *tail[NODE_SIZE];
 } TransientVector;
 
@@ -102,6 +133,9 @@ struct Vector_struct {
     const size_t count;
     const size_t shift;
     const Node *const root;
+    uint32_t hash;		// HashEq, computed on first use.  0 until then.
+    uint8_t tailCount;	// The number of elements in tail.
+    bool relaxed;		// Made by subvec or catvec, so the trie may hold relaxed nodes and short leaves.
     const lisp_object *tail[NODE_SIZE];
 };
 
@@ -115,7 +149,7 @@ static const Vector *asPersistent(TransientVector *v);
 
 // Vector Function Declarations.
 
-static const Vector *NewVector(size_t cnt, size_t shift, const Node *root, size_t count, const lisp_object* const* array);
+static const Vector *NewVector(size_t cnt, size_t shift, const Node *root, size_t count, const lisp_object* const* array, bool relaxed);
 static TransientVector *asTransient(const Vector *v);
 static const ISeq* seqVector(const Seqable*);
 static size_t countVector(const ICollection *o);
@@ -124,8 +158,12 @@ static const IVector* assocNVector(const IVector*, size_t, const lisp_object*);
 static const IVector* consVector(const IVector*, const lisp_object*);
 static const lisp_object *nthVector(const IVector *iv, size_t n, const lisp_object *notFound);
 static const lisp_object *const *arrayForV(const Vector *v, size_t i);
+static const lisp_object *const *leafFor(const Vector *v, size_t i, size_t *start, size_t *count);
 static size_t tailoffV(const Vector *v);
 static Node *pushTailV(const Vector *v, size_t level, const Node *parent, Node *tail);
+static bool EquivVector(const ICollection *ic, const lisp_object *obj);
+static bool EqualsVector(const lisp_object *x, const lisp_object *y);
+static uint32_t HashEqVector(const lisp_object *obj);
 
 const Seqable_vtable Vector_Seqable_vtable = {
 	seqVector, // seq
@@ -139,7 +177,7 @@ const ICollection_vtable Vector_ICollection_vtable = {
 	countVector,					// count
 	(ICollectionFn1) consVector,	// cons
 	emptyAVector,					// empty
-	EquivAVector,					// Equiv
+	EquivVector,					// Equiv
 };
 
 const IStack_vtable Vector_IStack_vtable = {
@@ -175,73 +213,230 @@ const interfaces Vector_interfaces = {
 	&Vector_IFn_vtable,			// IFnFns
 	&Vector_IVector_vtable,		// IVectorFns
 	NULL,						// IMapFns
+	NULL,						// ISetFns
+	toString,					// toString
+	EqualsVector,				// Equals
+	HashEqVector,				// HashEq
 };
 
-const Vector _EmptyVector = {{VECTOR_type, sizeof(Vector), toString, EqualsAVector, NULL, &Vector_interfaces},
+const Vector _EmptyVector = {{VECTOR_type, sizeof(Vector), NULL, &Vector_interfaces},
                    0,
-                   LOG_NODE_SIZE,
+                   NODE_LOG_SIZE,
                    &_EmptyNode,
+                   0,
+                   0,
+                   false,
                    {NULL}};
 const Vector *const EmptyVector = &_EmptyVector;
 
 // Node Function Definitions.
 
-Node *NewNode(bool editable, pthread_t thread_id, size_t count, const lisp_object* const* array) {
+Node *NewNode(const EditToken *edit, size_t count, const lisp_object* const* array) {
 	Node *ret = GC_MALLOC(sizeof(*ret));
 	memcpy(ret, EmptyNode, sizeof(*ret));
-	ret->editable = editable;
-	ret->thread_id = thread_id;
+	ret->edit = edit;
 	if(count > 0)
 		memcpy(ret->array, array, count * sizeof(*(ret->array)));
 
 	return ret;
 }
 
-Node *editableRoot(const Node *const root) {
-    Node *ret = GC_MALLOC(sizeof(*ret));
-    memset(ret, '\0', sizeof(*ret));
-    ret->obj.type = NODE_type;
-    ret->editable = true;
-    ret->thread_id = pthread_self();
+static Node *newPath(const EditToken *edit, size_t level, Node *node) {
+	if(level == 0) return node;
+	Node *ret = NewNode(edit, 0, NULL);
+	ret->array[0] = (lisp_object*) newPath(edit, level - NODE_LOG_SIZE, node);
+	return ret;
+}
 
-    for(size_t i = 0; i < NODE_SIZE; i++) {
-        const lisp_object *o = root->array[i];
-        if(o == NULL)
-            break;
-        ret->array[i] = copy(o);
-    }
+// NULL for a regular node.
+static const size_t *nodeSizes(const Node *node) {
+	return node->edit == &RelaxedEdit ? ((const RelaxedNode*)node)->sizes : NULL;
+}
 
-    return ret;
+// The index of node's child holding element *i of node, which has *count elements under it.  Makes *i and *count
+// relative to that child.
+static size_t childIndex(const Node *node, size_t level, size_t *i, size_t *count) {
+	size_t idx = (*i >> level) & NODE_BITMASK;
+	const size_t *sizes = nodeSizes(node);
+	if(sizes == NULL) {
+		size_t before = idx << level;
+		size_t width = (size_t)1 << level;
+		*i -= before;
+		*count = *count - before < width ? *count - before : width;
+		return idx;
+	}
+	// No child holds more than a regular one, so the child is at idx or to its right.
+	while(sizes[idx] <= *i)
+		idx++;
+	size_t before = idx > 0 ? sizes[idx-1] : 0;
+	*i -= before;
+	*count = sizes[idx] - before;
+	return idx;
 }
 
-static Node *newPath(bool editable, pthread_t thread_id, size_t level, Node *node) {
-	if(level == 0) return node;
-	Node *ret = NewNode(editable, thread_id, 0, NULL);
-	ret->array[0] = (lisp_object*) newPath(editable, thread_id, level - LOG_NODE_SIZE, node);
+// Puts the children of node, which has count elements under it, in out.  Returns how many there are.
+static size_t children(const Node *node, size_t level, size_t count, Subtree *out) {
+	const size_t *sizes = nodeSizes(node);
+	size_t width = (size_t)1 << level;
+	size_t n = 0;
+	for(size_t before = 0; before < count; n++) {
+		size_t after = sizes ? sizes[n] : (count - before < width ? count : before + width);
+		out[n].node = (const Node*) node->array[n];
+		out[n].count = after - before;
+		before = after;
+	}
+	return n;
+}
+
+// A node at level over n subtrees.  It is regular if every subtree but the last is full, and relaxed otherwise.
+static Node *packNode(size_t level, size_t n, const Subtree *subtrees) {
+	assert(n > 0 && n <= NODE_SIZE);
+	const lisp_object *array[NODE_SIZE];
+	bool regular = true;
+	for(size_t i = 0; i < n; i++) {
+		array[i] = (const lisp_object*) subtrees[i].node;
+		if(i + 1 < n && subtrees[i].count != (size_t)1 << level)
+			regular = false;
+	}
+	if(regular)
+		return NewNode(NULL, n, array);
+
+	RelaxedNode *ret = GC_MALLOC(sizeof(*ret));
+	memset(ret, '\0', sizeof(*ret));
+	ret->node.edit = &RelaxedEdit;
+	memcpy(ret->node.array, array, n * sizeof(array[0]));
+	size_t total = 0;
+	for(size_t i = 0; i < NODE_SIZE; i++) {
+		if(i < n)
+			total += subtrees[i].count;
+		ret->sizes[i] = total;
+	}
+	return &ret->node;
+}
+
+// The elements of t from start on.  Only the nodes on the path to start are copied.
+static Subtree sliceLeft(Subtree t, size_t level, size_t start) {
+	assert(start < t.count);
+	if(start == 0)
+		return t;
+	if(level == 0)
+		return (Subtree){NewNode(NULL, t.count - start, t.node->array + start), t.count - start};
+	Subtree kids[NODE_SIZE];
+	size_t n = children(t.node, level, t.count, kids);
+	size_t i = start;
+	size_t count = t.count;
+	size_t idx = childIndex(t.node, level, &i, &count);
+	kids[idx] = sliceLeft(kids[idx], level - NODE_LOG_SIZE, i);
+	return (Subtree){packNode(level, n - idx, kids + idx), t.count - start};
+}
+
+// The first end elements of t.  Only the nodes on the path to end are copied.
+static Subtree sliceRight(Subtree t, size_t level, size_t end) {
+	assert(end > 0 && end <= t.count);
+	if(end == t.count)
+		return t;
+	if(level == 0)
+		return (Subtree){NewNode(NULL, end, t.node->array), end};
+	Subtree kids[NODE_SIZE];
+	children(t.node, level, t.count, kids);
+	size_t i = end - 1;
+	size_t count = t.count;
+	size_t idx = childIndex(t.node, level, &i, &count);
+	kids[idx] = sliceRight(kids[idx], level - NODE_LOG_SIZE, i + 1);
+	return (Subtree){packNode(level, idx + 1, kids), end};
+}
+
+// Drops roots with a single child, down to one at NODE_LOG_SIZE, as pop does.
+static Subtree trimRoot(Subtree t, size_t *shift) {
+	while(*shift > NODE_LOG_SIZE && (nodeSizes(t.node) ? nodeSizes(t.node)[0] == t.count : t.count <= (size_t)1 << *shift)) {
+		t.node = (const Node*) t.node->array[0];
+		*shift -= NODE_LOG_SIZE;
+	}
+	return t;
+}
+
+// Joins two leaves into one, or into two where they hold more than a node, filling the left one.
+static size_t concatLeaves(Subtree x, Subtree y, Subtree *out) {
+	if(x.count == NODE_SIZE) {
+		out[0] = x;
+		out[1] = y;
+		return 2;
+	}
+	size_t moved = x.count + y.count < NODE_SIZE ? y.count : NODE_SIZE - x.count;
+	Node *left = NewNode(NULL, x.count, x.node->array);
+	memcpy(left->array + x.count, y.node->array, moved * sizeof(*(left->array)));
+	out[0] = (Subtree){left, x.count + moved};
+	if(moved == y.count)
+		return 1;
+	out[1] = (Subtree){NewNode(NULL, y.count - moved, y.node->array + moved), y.count - moved};
+	return 2;
+}
+
+// Joins x and y along the seam between them: the right edge of x and the left edge of y are merged level by level, and
+// the children of each level are packed into as few nodes as fit.  Puts the one or two subtrees this makes, at the
+// higher of xlevel and ylevel, in out.  The nodes off the seam are shared.
+static size_t concatSubtrees(Subtree x, size_t xlevel, Subtree y, size_t ylevel, Subtree *out) {
+	if(xlevel == 0 && ylevel == 0)
+		return concatLeaves(x, y, out);
+	size_t level = xlevel > ylevel ? xlevel : ylevel;
+	Subtree xs[NODE_SIZE];
+	Subtree ys[NODE_SIZE];
+	size_t nx = 1;
+	size_t ny = 1;
+	xs[0] = x;
+	ys[0] = y;
+	if(xlevel == level) {
+		nx = children(x.node, level, x.count, xs);
+		xlevel -= NODE_LOG_SIZE;
+	}
+	if(ylevel == level) {
+		ny = children(y.node, level, y.count, ys);
+		ylevel -= NODE_LOG_SIZE;
+	}
+
+	Subtree merged[2 * NODE_SIZE];
+	size_t n = nx - 1;
+	memcpy(merged, xs, n * sizeof(*merged));
+	n += concatSubtrees(xs[nx-1], xlevel, ys[0], ylevel, merged + n);
+	memcpy(merged + n, ys + 1, (ny - 1) * sizeof(*merged));
+	n += ny - 1;
+
+	size_t ret = 0;
+	for(size_t i = 0; i < n; i += NODE_SIZE, ret++) {
+		size_t width = n - i < NODE_SIZE ? n - i : NODE_SIZE;
+		size_t count = 0;
+		for(size_t j = i; j < i + width; j++)
+			count += merged[j].count;
+		out[ret] = (Subtree){packNode(level, width, merged + i), count};
+	}
 	return ret;
 }
 
+// The trie of x's elements followed by y's, where x is at xlevel and y at ylevel.  Sets *level to the new root's.
+static Subtree concatTrees(Subtree x, size_t xlevel, Subtree y, size_t ylevel, size_t *level) {
+	Subtree out[2];
+	size_t n = concatSubtrees(x, xlevel, y, ylevel, out);
+	*level = xlevel > ylevel ? xlevel : ylevel;
+	if(n == 1 && *level > 0)
+		return out[0];
+	*level += NODE_LOG_SIZE;
+	return (Subtree){packNode(*level, n, out), x.count + y.count};
+}
+
 // ChunkedSeq Function Declarations.
 
-static ChunkedSeq* NewChunkedSeq(const IMap *meta, const Vector *v, size_t count, const lisp_object* const* node, size_t i, size_t offset) {
+static ChunkedSeq* NewChunkedSeq(const IMap *meta, const Vector *v, const lisp_object* const* node, size_t i, size_t count, size_t offset) {
 	ChunkedSeq *ret = GC_MALLOC(sizeof(*ret));
 	ret->obj.type = CHUNKEDSEQ_type;
 	ret->obj.size = sizeof(*ret);
-	ret->obj.toString = toString;
-	ret->obj.Equals = EqualsASeq;
 	ret->obj.meta = meta ? meta : (IMap*) EmptyHashMap;
 	ret->obj.fns = &ChunkSeq_interfaces;
 
 	ret->vec = v;
+	ret->node = node ? node : leafFor(v, i, &i, &count);
 	ret->i = i;
+	ret->count = count;
 	ret->offset = offset;
-	if(node) {
-		memcpy(ret->node, node, count);
-		ret->count = count;
-	} else {
-		memcpy(ret->node, arrayForV(v, i), NODE_SIZE);
-		ret->count = NODE_SIZE;
-	}
 
 	return ret;
 }
@@ -262,37 +457,54 @@ static const ISeq* nextChunkedSeq(const ISeq *is) {
 	assert(is->obj.type == CHUNKEDSEQ_type);
 	const ChunkedSeq *cs = (ChunkedSeq*)is;
 	if(cs->offset + 1 < cs->count)
-		return (ISeq*) NewChunkedSeq(NULL, cs->vec, cs->count, cs->node, cs->i, cs->offset+1);
+		return (ISeq*) NewChunkedSeq(NULL, cs->vec, cs->node, cs->i, cs->count, cs->offset+1);
 	return chunkedNextChunkedSeq(cs);
 }
 
 static const ISeq* chunkedNextChunkedSeq(const ChunkedSeq *cs) {
 	if(cs->i + cs->count < cs->vec->count) {
-		return (ISeq*) NewChunkedSeq(NULL, cs->vec, 0, NULL, cs->i + cs->count, 0);
+		return (ISeq*) NewChunkedSeq(NULL, cs->vec, NULL, cs->i + cs->count, 0, 0);
 	}
 	return NULL;
 }
 
+bool isChunkedSeq(const ISeq *s) {
+	return s != NULL && s->obj.type == CHUNKEDSEQ_type;
+}
+
+const lisp_object *const *chunkFirst(const ISeq *s, size_t *count) {
+	assert(s->obj.type == CHUNKEDSEQ_type);
+	const ChunkedSeq *cs = (ChunkedSeq*)s;
+	*count = cs->count - cs->offset;
+	return cs->node + cs->offset;
+}
+
+const ISeq *chunkRest(const ISeq *s) {
+	assert(s->obj.type == CHUNKEDSEQ_type);
+	return chunkedNextChunkedSeq((ChunkedSeq*)s);
+}
+
 // TransientVector Function Definitions.
 
 static TransientVector *TransVecConj(TransientVector *v, const lisp_object *obj) {
-    assert(v->root->editable);
+    assert(v->edit.editable);
+    assert(pthread_equal(v->edit.thread_id, pthread_self()));
     size_t i = v->count;
     if(i-tailoffTV(v) < NODE_SIZE) {
-        v->tail[i & BITMASK] = obj;
+        v->tail[i & NODE_BITMASK] = obj;
         v->count++;
         return v;
     }
 	int newshift = v->shift;
 	Node *newroot = NULL;
-	Node *tailnode = NewNode(v->root->editable, v->root->thread_id, i, v->tail);
-	memset(v->tail, '0', NODE_SIZE * sizeof(*(v->tail)));
+	Node *tailnode = NewNode(&v->edit, NODE_SIZE, v->tail);
+	memset(v->tail, '\0', NODE_SIZE * sizeof(*(v->tail)));
 	v->tail[0] = obj;
-	if((v->count >> LOG_NODE_SIZE) > (((size_t)1) << v->shift)) {
-		newroot = NewNode(v->root->editable, v->root->thread_id, 0, NULL);
+	if((v->count >> NODE_LOG_SIZE) > (((size_t)1) << v->shift)) {
+		newroot = NewNode(&v->edit, 0, NULL);
 		newroot->array[0] = (const lisp_object*) v->root;
-		newroot->array[1] = (lisp_object*) newPath(true, v->root->thread_id, newshift, tailnode);
-		newshift += LOG_NODE_SIZE;
+		newroot->array[1] = (lisp_object*) newPath(&v->edit, newshift, tailnode);
+		newshift += NODE_LOG_SIZE;
 	} else {
 		newroot = pushTailTV(v, newshift, v->root, tailnode);
 	}
@@ -305,21 +517,21 @@ static TransientVector *TransVecConj(TransientVector *v, const lisp_object *obj)
 static size_t tailoffTV(TransientVector *v) {
     if(v->count <= 32)
         return 0;
-    return (v->count - 1) & ~BITMASK;
+    return (v->count - 1) & ~NODE_BITMASK;
 }
 
 static Node *pushTailTV(TransientVector *v, size_t level, const Node *parent, Node *tail) {
 	Node *ret = ensureEditable(v, parent);
-	size_t idx = ((v->count - 1) >> level) & BITMASK;
+	size_t idx = ((v->count - 1) >> level) & NODE_BITMASK;
 	Node *node_to_insert = NULL;
 	if(level == 5) {
 		node_to_insert = tail;
 	} else {
 		Node *child = (Node*) parent->array[idx];
 		if(child == NULL) {
-			node_to_insert = newPath(true, v->root->thread_id, level - LOG_NODE_SIZE, tail);
+			node_to_insert = newPath(&v->edit, level - NODE_LOG_SIZE, tail);
 		} else {
-			node_to_insert = pushTailTV(v, level - LOG_NODE_SIZE, child, tail);
+			node_to_insert = pushTailTV(v, level - NODE_LOG_SIZE, child, tail);
 		}
 	}
 	ret->array[idx] = (lisp_object*) node_to_insert;
@@ -327,69 +539,150 @@ static Node *pushTailTV(TransientVector *v, size_t level, const Node *parent, No
 }
 
 static Node *ensureEditable(TransientVector *v, const Node *node) {
-	assert(v->root->editable);
-	if(node->editable && (v->root->thread_id == node->thread_id))
+	assert(v->edit.editable);
+	if(node->edit == &v->edit)
 		return (Node*) node;
-	return NewNode(true, v->root->thread_id, NODE_SIZE, node->array);
+	return NewNode(&v->edit, NODE_SIZE, node->array);
 }
 
 static const Vector *asPersistent(TransientVector *v) {
-	assert(v->root->editable);
-	v->root->editable = false;
+	assert(v->edit.editable);
+	v->edit.editable = false;	// Releases every node the transient owns.
 	size_t new_cnt = v->count - tailoffTV(v);
-	return NewVector(v->count, v->shift, v->root, new_cnt, v->tail);
+	return NewVector(v->count, v->shift, v->root, new_cnt, v->tail, false);
 }
 
 // Vector Function Definitions.
 
-static const Vector *NewVector(size_t cnt, size_t shift, const Node *root, size_t count, const lisp_object* const* array) {
+static const Vector *NewVector(size_t cnt, size_t shift, const Node *root, size_t count, const lisp_object* const* array, bool relaxed) {
     Vector *ret = GC_MALLOC(sizeof(*ret));
 	assert(ret);
+	assert(count <= NODE_SIZE);
     memcpy(ret, EmptyVector, sizeof(*ret));
 	memcpy((void*) &ret->count, &cnt, sizeof(cnt));
 	memcpy((void*) &ret->shift, &shift, sizeof(shift));
 	memcpy((void*) &ret->root, &root, sizeof(root));
+	ret->tailCount = count;
+	ret->relaxed = relaxed;
 	memcpy(ret->tail, array, count * sizeof(*array));
 
 	return ret;
 }
 
+// Builds the trie from the bottom up: the entries fill the leaves in order, and each level's nodes fill the level above
+// it, until one node is left to be the root.  The last 1 to 32 entries are the tail.
 const Vector *CreateVector(size_t count, const lisp_object *const *entries) {
 	if(count == 0) return EmptyVector;
-    Vector *ret = GC_MALLOC(sizeof(*ret));
-    size_t cnt = count < NODE_SIZE ? count : NODE_SIZE;
-    memcpy(ret, EmptyVector, sizeof(*ret));
-	memcpy((void*) &ret->count, &cnt, sizeof(cnt));
+	if(count <= NODE_SIZE)
+		return NewVector(count, NODE_LOG_SIZE, EmptyNode, count, entries, false);
+	size_t tailoff = (count - 1) & ~NODE_BITMASK;
+	size_t n = tailoff >> NODE_LOG_SIZE;
+	const lisp_object **level = GC_MALLOC(n * sizeof(*level));
+	for(size_t i = 0; i < n; i++)
+		level[i] = (lisp_object*) NewNode(NULL, NODE_SIZE, entries + (i << NODE_LOG_SIZE));
+	size_t shift = NODE_LOG_SIZE;
+	while(n > NODE_SIZE) {
+		// Each parent is made from children already read, so the level is overwritten in place.
+		size_t parents = (n + NODE_BITMASK) >> NODE_LOG_SIZE;
+		for(size_t i = 0; i < parents; i++) {
+			size_t first = i << NODE_LOG_SIZE;
+			size_t width = n - first < NODE_SIZE ? n - first : NODE_SIZE;
+			level[i] = (lisp_object*) NewNode(NULL, width, level + first);
+		}
+		n = parents;
+		shift += NODE_LOG_SIZE;
+	}
 
-    for(size_t i = 0; i < cnt; i++) {
-        ret->tail[i] = entries[i];
-    }
+	return NewVector(count, shift, NewNode(NULL, n, level), count - tailoff, entries + tailoff, false);
+}
 
-    if(count <= NODE_SIZE)
-        return ret;
-    TransientVector *trans = asTransient(ret);
-    for(size_t i = NODE_SIZE; i < count; i++) {
+const Vector *intoVector(const Vector *v, size_t count, const lisp_object *const *entries) {
+	if(count == 0) return v;
+	if(v->count == 0) return CreateVector(count, entries);
+	if(v->relaxed) return catvec(v, CreateVector(count, entries));
+	TransientVector *trans = asTransient(v);
+	for(size_t i = 0; i < count; i++) {
 		trans = TransVecConj(trans, entries[i]);
-    }
+	}
 
 	return asPersistent(trans);
 }
 
+// The new trie is cut from v's along the paths to start and to the new tail, and shares every node off them.
+const Vector *subvec(const Vector *v, size_t start, size_t end) {
+	if(start > end || end > v->count) {
+		exception e = {IndexOutOfBoundException, "subvec out of range"};
+		Raise(e);
+	}
+	if(start == end)
+		return EmptyVector;
+	if(start == 0 && end == v->count)
+		return v;
+
+	// The new tail is the rest of the leaf holding end - 1, so the trie is cut between leaves on the right.
+	size_t tailoff = tailoffV(v);
+	size_t leafStart = tailoff;
+	const lisp_object *const *leaf = v->tail;
+	if(end <= tailoff) {
+		size_t leafCount;
+		leaf = leafFor(v, end - 1, &leafStart, &leafCount);
+	}
+	size_t split = leafStart > start ? leafStart : start;
+	const lisp_object *const *tail = leaf + (split - leafStart);
+	if(split == start)
+		return NewVector(end - start, NODE_LOG_SIZE, EmptyNode, end - start, tail, false);
+
+	size_t shift = v->shift;
+	Subtree tree = sliceRight((Subtree){v->root, tailoff}, shift, split);
+	tree = trimRoot(sliceLeft(tree, shift, start), &shift);
+	return NewVector(end - start, shift, tree.node, end - split, tail, v->relaxed || start > 0);
+}
+
+// x's tail becomes a leaf at the right edge of x's trie, which is then joined to y's trie.  y's tail is the new tail.
+const Vector *catvec(const Vector *x, const Vector *y) {
+	if(x->count == 0)
+		return y;
+	if(y->count == 0)
+		return x;
+	if(tailoffV(y) == 0 && x->tailCount + y->count <= NODE_SIZE) {
+		const lisp_object *newTail[NODE_SIZE];
+		memcpy(newTail, x->tail, x->tailCount * sizeof(newTail[0]));
+		memcpy(newTail + x->tailCount, y->tail, y->count * sizeof(newTail[0]));
+		return NewVector(x->count + y->count, x->shift, x->root, x->tailCount + y->count, newTail, x->relaxed);
+	}
+
+	size_t level = 0;
+	Subtree tree = {NewNode(NULL, x->tailCount, x->tail), x->tailCount};
+	if(tailoffV(x) > 0)
+		tree = concatTrees((Subtree){x->root, tailoffV(x)}, x->shift, tree, 0, &level);
+	if(tailoffV(y) > 0)
+		tree = concatTrees(tree, level, (Subtree){y->root, tailoffV(y)}, y->shift, &level);
+	if(level == 0) {
+		tree.node = packNode(NODE_LOG_SIZE, 1, &tree);
+		level = NODE_LOG_SIZE;
+	}
+	tree = trimRoot(tree, &level);
+	return NewVector(x->count + y->count, level, tree.node, y->tailCount, y->tail, true);
+}
+
+const Vector *insertVector(const Vector *v, size_t i, const lisp_object *x) {
+	const IVector *left = (IVector*)subvec(v, 0, i);
+	left = consVector(left, x);
+	return catvec((Vector*)left, subvec(v, i, v->count));
+}
+
+// O(1): the root is shared, and the tail is the vector's own array of pointers.
 static TransientVector *asTransient(const Vector *v) {
-    assert(sizeof(TransientVector) == sizeof(Vector));
+    assert(!v->relaxed);
     TransientVector *ret = GC_MALLOC(sizeof(*ret));
 
-    memset(ret, '\0', sizeof(*ret));
     memcpy(&ret->obj, &v->obj, sizeof(ret->obj));
     ret->count = v->count;
     ret->shift = v->shift;
-    ret->root = editableRoot(v->root);
-    for(size_t i = 0; i <NODE_SIZE; i++) {
-        const lisp_object *o = v->tail[i];
-        if(o == NULL)
-            break;
-        ret->tail[i] = copy(o);
-    }
+    ret->root = v->root;
+    ret->edit.editable = true;
+    ret->edit.thread_id = pthread_self();
+    memcpy(ret->tail, v->tail, sizeof(ret->tail));
 
     return ret;
 }
@@ -400,7 +693,7 @@ static const ISeq* seqVector(const Seqable *self) {
 
 	if(v->count == 0)
 		return NULL;
-	return (ISeq*)NewChunkedSeq(NULL, v, 0, NULL, 0, 0);
+	return (ISeq*)NewChunkedSeq(NULL, v, NULL, 0, 0, 0);
 }
 
 static size_t countVector(const ICollection *o) {
@@ -412,35 +705,43 @@ static size_t countVector(const ICollection *o) {
 static const IVector* consVector(const IVector *iv, const lisp_object *x) {
 	assert(iv->obj.type == VECTOR_type);
 	const Vector *v = (const Vector*) iv;
-	if(v->count - tailoffV(v) < NODE_SIZE) {
+	size_t tailCount = v->tailCount;
+	if(tailCount < NODE_SIZE) {
 		const lisp_object *newTail[NODE_SIZE];
-		memcpy(newTail, v->tail, (v->count & BITMASK) * sizeof(newTail[0]));
-		newTail[v->count] = x;
-		return (IVector*)NewVector(v->count + 1, v->shift, v->root, v->count & BITMASK, newTail);
+		memcpy(newTail, v->tail, tailCount * sizeof(newTail[0]));
+		newTail[tailCount] = x;
+		return (IVector*)NewVector(v->count + 1, v->shift, v->root, tailCount + 1, newTail, v->relaxed);
 	}
 	Node *NewRoot = NULL;
-	Node *TailNode = NewNode(v->root->editable, v->root->thread_id, v->count & BITMASK, v->tail);
+	Node *TailNode = NewNode(NULL, NODE_SIZE, v->tail);
 	size_t newshift = v->shift;
-	if((v->count >> LOG_NODE_SIZE) > ((size_t)1 << v->shift)) {
-		NewRoot = NewNode(v->root->editable, v->root->thread_id, 0, NULL);
+	if(v->relaxed) {
+		// The tail joins the right edge of the trie, as in catvec.
+		Subtree tree = {v->root, tailoffV(v)};
+		Subtree leaf = {TailNode, NODE_SIZE};
+		const Node *root = concatTrees(tree, v->shift, leaf, 0, &newshift).node;
+		return (IVector*)NewVector(v->count + 1, newshift, root, 1, &x, true);
+	}
+	if((v->count >> NODE_LOG_SIZE) > ((size_t)1 << v->shift)) {
+		NewRoot = NewNode(NULL, 0, NULL);
 		NewRoot->array[0] = (lisp_object*)v->root;
-		NewRoot->array[1] = (lisp_object*)newPath(v->root->editable, v->root->thread_id, v->shift, TailNode);
-		newshift += LOG_NODE_SIZE;
+		NewRoot->array[1] = (lisp_object*)newPath(NULL, v->shift, TailNode);
+		newshift += NODE_LOG_SIZE;
 	} else {
 		NewRoot = pushTailV(v, v->shift, v->root, TailNode);
 	}
 	const lisp_object *NewTail[NODE_SIZE];
 	NewTail[0] = x;
-	return (IVector*)NewVector(v->count + 1, newshift, NewRoot, 1, NewTail);
+	return (IVector*)NewVector(v->count + 1, newshift, NewRoot, 1, NewTail, false);
 }
 
 static const Node* popTail(const Vector *v, size_t shift, const Node *node) {
-	size_t subindex = ((v->count - 2) >> shift) & BITMASK;
-	if(shift > LOG_NODE_SIZE) {
-		const Node *newChild = popTail(v, shift - LOG_NODE_SIZE, (Node*) node->array[subindex]);
+	size_t subindex = ((v->count - 2) >> shift) & NODE_BITMASK;
+	if(shift > NODE_LOG_SIZE) {
+		const Node *newChild = popTail(v, shift - NODE_LOG_SIZE, (Node*) node->array[subindex]);
 		if(newChild == NULL && subindex == 0)
 			return NULL;
-		Node *ret = NewNode(v->root->editable, v->root->thread_id, NODE_SIZE, node->array);
+		Node *ret = NewNode(NULL, NODE_SIZE, node->array);
 		ret->array[subindex] = (lisp_object*)newChild;
 		return ret;
 	}
@@ -448,7 +749,7 @@ static const Node* popTail(const Vector *v, size_t shift, const Node *node) {
 	if(subindex == 0)
 		return NULL;
 
-	Node *ret = NewNode(v->root->editable, v->root->thread_id, NODE_SIZE, node->array);
+	Node *ret = NewNode(NULL, NODE_SIZE, node->array);
 	ret->array[subindex] = NULL;
 	return ret;
 }
@@ -463,33 +764,39 @@ static const IStack* popVector(const IStack *is) {
 	if(v->count == 1)
 		return (IStack*)withMeta((lisp_object*)EmptyVector, v->obj.meta);
 
-	if(v->count  - tailoffV(v) > 1) {
-		const lisp_object *newTail[NODE_SIZE];
-		memcpy(newTail, v->tail, sizeof(newTail));
-		return (IStack*)NewVector(v->count - 1, v->shift, v->root, NODE_SIZE, newTail);
-	}
+	if(v->tailCount > 1)
+		return (IStack*)NewVector(v->count - 1, v->shift, v->root, v->tailCount - 1, v->tail, v->relaxed);
+	if(v->relaxed)
+		return (IStack*)subvec(v, 0, v->count - 1);	// Takes the last leaf for its tail.
 
 	const lisp_object * const* newTail = arrayForV(v, v->count -2);
 	const Node *newRoot = popTail(v, v->shift, v->root);
 	size_t newshift = v->shift;
-	if(newRoot == NULL) {
+	if(newRoot == NULL)
 		newRoot = EmptyNode;
-	} else {
+	if(v->shift > NODE_LOG_SIZE && newRoot->array[1] == NULL) {
 		newRoot = (Node*)newRoot->array[0];
-		newshift -= LOG_NODE_SIZE;
+		newshift -= NODE_LOG_SIZE;
 	}
 
-	return (IStack*) NewVector(v->count - 1, newshift, newRoot, NODE_SIZE, newTail);
+	return (IStack*) NewVector(v->count - 1, newshift, newRoot, NODE_SIZE, newTail, false);
 }
 
-static const Node* doAssoc(size_t shift, const Node *node, size_t n, const lisp_object *val) {
-	Node *ret = NewNode(node->editable, node->thread_id, NODE_SIZE, node->array);
+// n is relative to node, which has count elements under it.
+static const Node* doAssoc(size_t shift, const Node *node, size_t n, size_t count, const lisp_object *val) {
+	Node *ret = NULL;
+	if(nodeSizes(node)) {
+		ret = GC_MALLOC(sizeof(RelaxedNode));
+		memcpy(ret, node, sizeof(RelaxedNode));
+	} else {
+		ret = NewNode(NULL, NODE_SIZE, node->array);
+	}
 
 	if(shift == 0) {
-		ret->array[n & BITMASK] = val;
+		ret->array[n] = val;
 	} else {
-		size_t subindex = (n >> shift) & BITMASK;
-		ret->array[subindex] = (lisp_object*) doAssoc(shift - LOG_NODE_SIZE, (Node*) node->array[subindex], n, val);
+		size_t subindex = childIndex(node, shift, &n, &count);
+		ret->array[subindex] = (lisp_object*) doAssoc(shift - NODE_LOG_SIZE, (Node*) node->array[subindex], n, count, val);
 	}
 	
 	return ret;
@@ -499,13 +806,15 @@ static const IVector* assocNVector(const IVector *iv, size_t n, const lisp_objec
 	assert(iv->obj.type == VECTOR_type);
 	const Vector *v = (Vector*)iv;
 	if(n < v->count) {
-		if(n >= tailoffV(v)) {
+		size_t tailoff = tailoffV(v);
+		if(n >= tailoff) {
 			const lisp_object *newTail[NODE_SIZE];
 			memcpy(newTail, v->tail, sizeof(newTail));
-			newTail[n & BITMASK] = val;
-			return (IVector*) NewVector(v->count, v->shift, v->root, v->count & BITMASK, newTail);
+			newTail[n - tailoff] = val;
+			return (IVector*) NewVector(v->count, v->shift, v->root, v->tailCount, newTail, v->relaxed);
 		}
-		return (IVector*) NewVector(v->count, v->shift, doAssoc(v->shift, v->root, n, val), v->count & BITMASK, v->tail);
+		const Node *root = doAssoc(v->shift, v->root, n, tailoff, val);
+		return (IVector*) NewVector(v->count, v->shift, root, v->tailCount, v->tail, v->relaxed);
 	}
 
 	if(n == v->count)
@@ -519,45 +828,142 @@ static const lisp_object *nthVector(const IVector *iv, size_t n, const lisp_obje
 	assert(iv->obj.type == VECTOR_type);
 	const Vector *v = (const Vector*) iv;
 	if(n < v->count) {
+		if(v->relaxed) {
+			size_t start, count;
+			const lisp_object *const *node = leafFor(v, n, &start, &count);
+			return node[n - start];
+		}
 		const lisp_object *const *node = arrayForV(v, n);
-		return node[n & BITMASK];
+		return node[n & NODE_BITMASK];
 	}
 	return notFound;
 }
 
+// The leaf holding i in a vector that is not relaxed, where each leaf starts at a multiple of NODE_SIZE.
 static const lisp_object *const *arrayForV(const Vector *v, size_t i) {
 	assert(i < v->count);
+	assert(!v->relaxed);
 	if(i >= tailoffV(v))
 		return v->tail;
 	const Node *node = v->root;
 	assert(v->shift % 5 == 0);
-	for(size_t level = v->shift; level > 0; level -= LOG_NODE_SIZE) {
-		node = (const Node*) node->array[(i >> level) & BITMASK];
+	for(size_t level = v->shift; level > 0; level -= NODE_LOG_SIZE) {
+		node = (const Node*) node->array[(i >> level) & NODE_BITMASK];
 	}
 	return node->array;
 }
 
+// The leaf holding i in any vector.  Sets *start to the index of the leaf's first element, and *count to its length.
+static const lisp_object *const *leafFor(const Vector *v, size_t i, size_t *start, size_t *count) {
+	assert(i < v->count);
+	size_t tailoff = tailoffV(v);
+	if(i >= tailoff) {
+		*start = tailoff;
+		*count = v->tailCount;
+		return v->tail;
+	}
+	const Node *node = v->root;
+	size_t n = i;
+	*count = tailoff;
+	for(size_t level = v->shift; level > 0; level -= NODE_LOG_SIZE)
+		node = (const Node*) node->array[childIndex(node, level, &n, count)];
+	*start = i - n;
+	return node->array;
+}
+
 static size_t tailoffV(const Vector *v) {
-    if(v->count <= 32)
-        return 0;
-    return (v->count - 1) & ~BITMASK;
+    return v->count - v->tailCount;
 }
 
 static Node *pushTailV(const Vector *v, size_t level, const Node *parent, Node *tail) {
-	size_t idx = ((v->count) >> level) & BITMASK;
-	Node *ret = NewNode(parent->editable, parent->thread_id, v->count & BITMASK, parent->array);
+	size_t idx = ((v->count - 1) >> level) & NODE_BITMASK;
+	Node *ret = NewNode(NULL, NODE_SIZE, parent->array);
 	Node *NodeToInsert = NULL;
-	if(level == LOG_NODE_SIZE) {
+	if(level == NODE_LOG_SIZE) {
 		NodeToInsert = tail;
 	} else {
 		Node *child = (Node*)parent->array[idx];
-		NodeToInsert = child ? newPath(v->root->editable, v->root->thread_id, level - LOG_NODE_SIZE, tail)
-							 : pushTailV(v, level - LOG_NODE_SIZE, child, tail);
+		NodeToInsert = child ? pushTailV(v, level - NODE_LOG_SIZE, child, tail)
+							 : newPath(NULL, level - NODE_LOG_SIZE, tail);
 	}
 	ret->array[idx] = (lisp_object*)NodeToInsert;
 	return ret;
 }
 
+// Vectors of the same count and shift that are not relaxed have tries of the same shape, so they are compared node by
+// node.  Subtrees the
+// two vectors share are equal without looking inside them.  count is the number of elements under x and y.
+static bool equalNodes(const Node *x, const Node *y, size_t level, size_t count, bool (*equal)(const lisp_object*, const lisp_object*)) {
+	if(x == y)
+		return true;
+	if(level == 0) {
+		for(size_t i = 0; i < count; i++)
+			if(!equal(x->array[i], y->array[i]))
+				return false;
+		return true;
+	}
+	size_t width = (size_t)1 << level;
+	for(size_t i = 0; count > 0; i++) {
+		size_t n = count < width ? count : width;
+		if(!equalNodes((const Node*)x->array[i], (const Node*)y->array[i], level - NODE_LOG_SIZE, n, equal))
+			return false;
+		count -= n;
+	}
+	return true;
+}
+
+static bool equalVectors(const Vector *x, const Vector *y, bool (*equal)(const lisp_object*, const lisp_object*)) {
+	if(x->count != y->count)
+		return false;
+	if(x->hash != 0 && y->hash != 0 && x->hash != y->hash)
+		return false;
+	size_t tailoff = tailoffV(x);
+	if(!equalNodes(x->root, y->root, x->shift, tailoff, equal))
+		return false;
+	for(size_t i = 0; i < x->count - tailoff; i++)
+		if(!equal(x->tail[i], y->tail[i]))
+			return false;
+	return true;
+}
+
+static bool sameShape(const Vector *x, const Vector *y) {
+	return x->shift == y->shift && !x->relaxed && !y->relaxed;
+}
+
+static bool EquivVector(const ICollection *ic, const lisp_object *obj) {
+	assert(ic->obj.type == VECTOR_type);
+	const Vector *v = (Vector*)ic;
+	if(obj != NULL && objectType(obj) == VECTOR_type && sameShape(v, (Vector*)obj))
+		return equalVectors(v, (Vector*)obj, Equiv);
+	return EquivAVector(ic, obj);
+}
+
+static bool EqualsVector(const lisp_object *x, const lisp_object *y) {
+	assert(x->type == VECTOR_type);
+	const Vector *v = (Vector*)x;
+	if(y != NULL && objectType(y) == VECTOR_type && sameShape(v, (Vector*)y))
+		return equalVectors(v, (Vector*)y, Equals);
+	return EqualsAVector(x, y);
+}
+
+static uint32_t HashEqVector(const lisp_object *obj) {
+	assert(obj->type == VECTOR_type);
+	const Vector *v = (Vector*)obj;
+	if(v->count == 0)
+		return mixCollHash(1, 0);
+	if(v->hash == 0) {
+		uint32_t hash = 1;
+		size_t start, n;
+		for(size_t i = 0; i < v->count; i += n) {
+			const lisp_object *const *array = leafFor(v, i, &start, &n);
+			for(size_t j = 0; j < n; j++)
+				hash = 31 * hash + HashEq(array[j]);
+		}
+		((Vector*)v)->hash = mixCollHash(hash, v->count);
+	}
+	return v->hash;
+}
+
 int indexOf(const IVector *iv, const lisp_object *o) {
 	for(size_t i = 0; i< iv->obj.fns->ICollectionFns->count((ICollection*)iv); i++) {
 		if(Equiv(o, iv->obj.fns->IVectorFns->nth(iv, i, NULL)))
@@ -6,11 +6,24 @@
 typedef struct Vector_struct Vector;
 
 const Vector *CreateVector(size_t count, lisp_object const* const* entries);
+// v with count entries appended.  An empty v is built bottom-up by CreateVector, any other through a transient.
+const Vector *intoVector(const Vector *v, size_t count, lisp_object const* const* entries);
+// Slicing and joining take O(log n) and share all but the nodes along the cuts.  Their results are relaxed radix
+// balanced: nodes may hold short children, and find them through a table of sizes.
+const Vector *subvec(const Vector *v, size_t start, size_t end);	// The elements from start to before end.
+const Vector *catvec(const Vector *x, const Vector *y);
+const Vector *insertVector(const Vector *v, size_t i, const lisp_object *x);	// v with x before its element i.
 
 const Vector *const EmptyVector;
 
 #include "Interfaces.h"
 
 int indexOf(const IVector *iv, const lisp_object *o);
+// A vector's seq can be consumed a leaf at a time.  chunkFirst returns the elements left in s's current leaf and sets
+// *count to their number.  The array is the vector's own, so it must not be written.  chunkRest is the seq of the
+// elements after them, or NULL.
+bool isChunkedSeq(const ISeq *s);
+const lisp_object *const *chunkFirst(const ISeq *s, size_t *count);
+const ISeq *chunkRest(const ISeq *s);
 
 #endif /* VECTOR_H */
@@ -2832,6 +2832,15 @@
 #define HEURISTIC2
 #undef LINUX_STACKBOTTOM
 #undef USE_GET_STACKBASE_FOR_MAIN
-#undef THREADS
+#ifdef GC_PTHREADS
+  /* Counting processors reads /proc/stat, and the Reader's read() */
+  /* shadows the system call.                                       */
+# include <unistd.h>
+# include <sys/syscall.h>
+# define STAT_BUF_SIZE 4096
+# define STAT_READ(fd, buf, n) syscall(SYS_read, (fd), (buf), (n))
+#else
+# undef THREADS
+#endif
 
 #endif /* GCCONFIG_H */
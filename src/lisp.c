@@ -2,6 +2,7 @@
 #include <unistd.h>
 
 #include "LineNumberReader.h"
+#include "Native.h"
 #include "Repl.h"
 #include "RunTime.h"
 #include "Symbol.h"
@@ -13,7 +14,7 @@ void cmd_line_err(void) {
 
 int main(int argc, char **argv) {
     int c;
-    __attribute__((unused)) char *out_file = "a.out";
+    char *out_file = "a.out";
 
     while((c = getopt(argc, argv, ":o:")) != -1) {
         switch(c) {
@@ -33,6 +34,11 @@ int main(int argc, char **argv) {
         }
     }
 
+	if(optind < argc) {
+		// Compile the file to a native executable, instead of starting the repl.
+		return CompileFile(argv[optind], out_file) ? 0 : 1;
+	}
+
 	initRT();
 	printf("Finished initRT()\n");
 	fflush(stdout);
@@ -14,6 +14,10 @@ static inline pthread_t pthread_self(void) {
 	return (pthread_t) 1;
 }
 
+static inline int pthread_equal(pthread_t t1, pthread_t t2) {
+	return t1 == t2;
+}
+
 static inline int pthread_mutex_lock(__attribute__((unused)) pthread_mutex_t *x) {
 	return 0;
 }
@@ -1,8 +1,27 @@
 #ifndef NODES_H
 #define NODES_H
 
+#include <stddef.h>
+#include <stdint.h>
+
+#include "intrinsics.h"
+
 #define NODE_LOG_SIZE 5
 #define NODE_SIZE (1 << NODE_LOG_SIZE)
 #define NODE_BITMASK (NODE_SIZE - 1)
 
+// Support functions for bitmap indexed hash trie nodes.
+
+static inline uint32_t mask(uint32_t hash, size_t shift) {
+	return (hash >> shift) & NODE_BITMASK;
+}
+
+static inline uint32_t bitpos(uint32_t hash, size_t shift) {
+	return 1 << mask(hash, shift);
+}
+
+static inline size_t index(uint32_t mask, uint32_t bit) {
+	return popcount(mask & (bit - 1));
+}
+
 #endif /* NODES_H */
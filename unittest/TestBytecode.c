@@ -0,0 +1,238 @@
+#include <string.h>
+
+#include "unity.h"
+
+#include "AFn.h"
+#include "Bool.h"
+#include "Bytecode.h"
+#include "Compiler.h"
+#include "LineNumberReader.h"
+#include "Numbers.h"
+#include "Reader.h"
+#include "RunTime.h"
+#include "Symbol.h"
+#include "Util.h"
+#include "Var.h"
+
+static Var *useBytecode = NULL;
+
+void setUp(void) {
+}
+
+void tearDown(void) {
+}
+
+// inc and <, which the runtime does not define yet.
+
+static const lisp_object* invokeInc(__attribute__((unused)) const IFn *self, const lisp_object *x) {
+    return (lisp_object*)NewInteger(IntegerValue((Integer*)x) + 1);
+}
+
+static const lisp_object* invokeLess(__attribute__((unused)) const IFn *self, const lisp_object *x, const lisp_object *y) {
+    return (lisp_object*)(IntegerValue((Integer*)x) < IntegerValue((Integer*)y) ? True : False);
+}
+
+const IFn_vtable Inc_IFn_vtable = {
+    invoke0AFn, // invoke0
+    invokeInc,  // invoke1
+    invoke2AFn, // invoke2
+    invoke3AFn, // invoke3
+    invoke4AFn, // invoke4
+    invoke5AFn, // invoke5
+    applyToAFn, // applyTo
+};
+
+const IFn_vtable Less_IFn_vtable = {
+    invoke0AFn, // invoke0
+    invoke1AFn, // invoke1
+    invokeLess, // invoke2
+    invoke3AFn, // invoke3
+    invoke4AFn, // invoke4
+    invoke5AFn, // invoke5
+    applyToAFn, // applyTo
+};
+
+interfaces Inc_interfaces = {NULL, NULL, NULL, NULL, NULL, &Inc_IFn_vtable, NULL, NULL, NULL, NULL, NULL, NULL};
+interfaces Less_interfaces = {NULL, NULL, NULL, NULL, NULL, &Less_IFn_vtable, NULL, NULL, NULL, NULL, NULL, NULL};
+
+const lisp_object Inc = {IFN_type, sizeof(lisp_object), NULL, &Inc_interfaces};
+const lisp_object Less = {IFN_type, sizeof(lisp_object), NULL, &Less_interfaces};
+
+typedef struct test_data {
+    char *input;
+    char *expected;
+} test_data;
+
+// Each form is evaluated by the tree walker and then by the bytecode VM, and both must print as expected.
+static void evalBoth(const test_data *data, size_t count) {
+    for(size_t i = 0; i < count; i++) {
+        LineNumberReader *stream = MemOpenLineNumberReader(data[i].input, strlen(data[i].input));
+        const lisp_object *form = read(stream, false, '\0');
+        closeLineNumberReader(stream);
+
+        bindRoot(useBytecode, (lisp_object*)False);
+        TEST_ASSERT_EQUAL_STRING_MESSAGE(data[i].expected, toString(Eval(form)), data[i].input);
+        bindRoot(useBytecode, (lisp_object*)True);
+        TEST_ASSERT_EQUAL_STRING_MESSAGE(data[i].expected, toString(Eval(form)), data[i].input);
+        TEST_ASSERT_EQUAL_STRING_MESSAGE(data[i].expected, toString(Eval(form)), data[i].input);
+    }
+}
+
+void test_literals(void) {
+    test_data data[] = {
+        {"42", "42"},
+        {"nil", "nil"},
+        {"true", "true"},
+        {"false", "false"},
+        {":k", ":k"},
+    };
+    evalBoth(data, sizeof(data)/sizeof(data[0]));
+}
+
+void test_if(void) {
+    test_data data[] = {
+        {"(if true 1 2)", "1"},
+        {"(if nil 1 2)", "2"},
+        {"(if false 1)", "nil"},
+        {"(if (< 1 2) :lt :ge)", ":lt"},
+        {"(if (if false true nil) 1 (if true 2 3))", "2"},
+    };
+    evalBoth(data, sizeof(data)/sizeof(data[0]));
+}
+
+void test_let_loop_recur(void) {
+    test_data data[] = {
+        {"(let* [a 1 b (inc a)] b)", "2"},
+        {"(let* [a 1] (let* [a (inc a) b a] (inc b)))", "3"},
+        {"(loop [i 0] (if (< i 10) (recur (inc i)) i))", "10"},
+        {"(loop [i 0 j 0] (if (< i 5) (recur (inc i) (inc (inc j))) j))", "10"},
+        {"(loop [i 0] (if (< i 5) (recur (let* [a (inc i) b a] b)) i))", "5"},
+    };
+    evalBoth(data, sizeof(data)/sizeof(data[0]));
+}
+
+void test_invoke(void) {
+    test_data data[] = {
+        {"(inc 41)", "42"},
+        {"(inc (inc (inc 0)))", "3"},
+        {"(:a {:a 1})", "1"},
+        {"((fn* [x] (inc x)) 1)", "2"},
+        {"((fn* [n] (loop [i 0] (if (< i n) (recur (inc i)) i))) 7)", "7"},
+        {"((fn* [i n] (if (< i n) (recur (inc i) n) i)) 0 9)", "9"},
+        // Deep enough that the tail calls must run in constant stack.
+        {"((fn* f ([n] (f 0 n)) ([i n] (if (< i n) (f (inc i) n) i))) 1000000)", "1000000"},
+    };
+    evalBoth(data, sizeof(data)/sizeof(data[0]));
+}
+
+void test_eval_fallback(void) {
+    // Vectors and maps have no opcodes, and are handed back to the tree walker over the same locals.
+    test_data data[] = {
+        {"[1 (inc 1)]", "[1 2]"},
+        {"(let* [a 1] [a (inc a)])", "[1 2]"},
+        {"(loop [i 0 v nil] (if (< i 3) (recur (inc i) [i v]) v))", "[2 [1 [0 nil]]]"},
+        {"((fn* [x] {:x (inc x)}) 1)", "{:x 2}"},
+    };
+    evalBoth(data, sizeof(data)/sizeof(data[0]));
+}
+
+static const lisp_object* evalString(char *s) {
+    LineNumberReader *stream = MemOpenLineNumberReader(s, strlen(s));
+    const lisp_object *form = read(stream, false, '\0');
+    closeLineNumberReader(stream);
+    return Eval(form);
+}
+
+void test_relink(void) {
+    // A call site through a non-dynamic Var links to the Var's root, and relinks once the Var is rebound.
+    Var *g = internVar(LISP_ns, internSymbol1("g"), &Inc, true);
+    bindRoot(useBytecode, (lisp_object*)False);
+    const IFn *f = (IFn*)evalString("(fn* [] (g 1))");
+    TEST_ASSERT_EQUAL_INT(2, IntegerValue((Integer*)f->obj.fns->IFnFns->invoke0(f)));
+    TEST_ASSERT_EQUAL_INT(2, IntegerValue((Integer*)f->obj.fns->IFnFns->invoke0(f)));
+    bindRoot(g, evalString("(fn* [x] x)"));
+    TEST_ASSERT_EQUAL_INT(1, IntegerValue((Integer*)f->obj.fns->IFnFns->invoke0(f)));
+}
+
+void test_jit_resolves_vars(void) {
+    // A jitted fn inlines the primitive its Var holds, not the one the Var is named after.
+    Var *add = internVar(LISP_ns, internSymbol1("fx+"), NULL, false);
+    const lisp_object *fxAdd = deref(add);
+    const lisp_object *fxSub = deref(internVar(LISP_ns, internSymbol1("fx-"), NULL, false));
+    bindRoot(useBytecode, (lisp_object*)False);
+    bindRoot(add, fxSub);
+    const IFn *f = (IFn*)evalString("(fn* [x] (fx+ x 1))");
+    TEST_ASSERT_EQUAL_INT(NATIVEFN_type, f->obj.type);
+    TEST_ASSERT_EQUAL_INT(4, IntegerValue((Integer*)f->obj.fns->IFnFns->invoke1(f, (lisp_object*)NewInteger(5))));
+
+    // The if is analyzed, and the fn jitted, before the def rebinds fx+, so the jitted fn is stale by the time it is made.
+    bindRoot(add, fxAdd);
+    f = (IFn*)evalString("(if (def fx+ fx-) (fn* [x] (fx+ x 1)))");
+    TEST_ASSERT_EQUAL_INT(4, IntegerValue((Integer*)f->obj.fns->IFnFns->invoke1(f, (lisp_object*)NewInteger(5))));
+    bindRoot(add, fxAdd);
+}
+
+static const lisp_object* evalIdentity(const lisp_object *expr) {
+    return expr;
+}
+
+static const lisp_object* tailCallDirect(const IFn *f, size_t argc, const lisp_object *const *argv) {
+    TEST_ASSERT_EQUAL_INT(1, argc);
+    return f->obj.fns->IFnFns->invoke1(f, argv[0]);
+}
+
+void test_code(void) {
+    // L[0] counts up to K[1] through calls to K[0] and K[2], then a tail call hands the count to inc.
+    const lisp_object *constants[] = {&Less, (lisp_object*)NewInteger(5), &Inc};
+    const lisp_object *exprs[] = {(lisp_object*)NewInteger(0)};
+    const instruction code[] = {
+        {OP_EVAL, 0, 0, 0},     // 0: R[0] = X[0]
+        {OP_SETLOCAL, 0, 0, 0}, // 1: L[0] = R[0]
+        {OP_LOADK, 0, 0, 0},    // 2: R[0] = <
+        {OP_GETLOCAL, 0, 1, 0}, // 3: R[1] = L[0]
+        {OP_LOADK, 0, 2, 1},    // 4: R[2] = 5
+        {OP_CALL, 2, 0, 0},     // 5: R[0] = (< R[1] R[2])
+        {OP_JMPF, 0, 0, 6},     // 6: if R[0] is false, to 12
+        {OP_LOADK, 0, 0, 2},    // 7: R[0] = inc
+        {OP_GETLOCAL, 0, 1, 0}, // 8: R[1] = L[0]
+        {OP_CALL, 1, 0, 0},     // 9: R[0] = (inc R[1])
+        {OP_SETLOCAL, 0, 0, 0}, // 10: L[0] = R[0]
+        {OP_JMP, 0, 0, -9},     // 11: to 2
+        {OP_LOADK, 0, 1, 2},    // 12: R[1] = inc
+        {OP_GETLOCAL, 0, 2, 0}, // 13: R[2] = L[0]
+        {OP_TAILCALL, 1, 1, 0}, // 14: return (inc R[2])
+    };
+    const lisp_object *locals[1] = {NULL};
+    const Code *c = NewCode(sizeof(code)/sizeof(code[0]), code, 3, constants, 1, exprs, evalIdentity, tailCallDirect, 3, 1);
+    TEST_ASSERT_EQUAL_INT(6, IntegerValue((Integer*)RunCode(c, locals)));
+    TEST_ASSERT_EQUAL_INT(5, IntegerValue((Integer*)locals[0]));
+
+    const instruction moves[] = {
+        {OP_LOADK, 0, 0, 1},    // R[0] = 5
+        {OP_MOVE, 0, 1, 0},     // R[1] = R[0]
+        {OP_LOADNIL, 0, 0, 0},  // R[0] = nil
+        {OP_JMPF, 0, 0, 2},     // R[0] is nil, so to RET R[1]
+        {OP_RET, 0, 0, 0},
+        {OP_RET, 0, 1, 0},
+    };
+    c = NewCode(sizeof(moves)/sizeof(moves[0]), moves, 3, constants, 0, NULL, evalIdentity, tailCallDirect, 2, 0);
+    TEST_ASSERT_EQUAL_INT(5, IntegerValue((Integer*)RunCode(c, NULL)));
+}
+
+int main(void) {
+    initRT();
+    internVar(LISP_ns, internSymbol1("inc"), &Inc, true);
+    internVar(LISP_ns, internSymbol1("<"), &Less, true);
+    useBytecode = internVar(LISP_ns, internSymbol1("*use-bytecode*"), (lisp_object*)False, false);
+
+    UNITY_BEGIN();
+    RUN_TEST(test_literals);
+    RUN_TEST(test_if);
+    RUN_TEST(test_let_loop_recur);
+    RUN_TEST(test_invoke);
+    RUN_TEST(test_eval_fallback);
+    RUN_TEST(test_relink);
+    RUN_TEST(test_jit_resolves_vars);
+    RUN_TEST(test_code);
+    return UNITY_END();
+}
@@ -3,7 +3,10 @@
 #include "unity.h"
 
 #include "List.h"
+#include "Numbers.h"
+#include "PrimVector.h"
 #include "Util.h"
+#include "Vector.h"
 
 typedef struct test_data {
     char *input;
@@ -21,8 +24,135 @@ void test_EmptyList_toString(void) {
     TEST_ASSERT_EQUAL_STRING("()", toString(obj));
 }
 
+void test_List_HashEq(void) {
+    const lisp_object *entries[100];
+    for(size_t i = 0; i < 100; i++)
+        entries[i] = (lisp_object*)NewInteger(i);
+    const lisp_object *list = (lisp_object*)CreateList(100, entries);
+    const lisp_object *vector = (lisp_object*)CreateVector(100, entries);
+
+    TEST_ASSERT_EQUAL_INT(HashEq((lisp_object*)EmptyVector), HashEq((lisp_object*)EmptyList));
+    TEST_ASSERT_EQUAL_INT(HashEq(vector), HashEq(list));
+    TEST_ASSERT_EQUAL_INT(HashEq(list), HashEq((lisp_object*)CreateList(100, entries)));
+    TEST_ASSERT(HashEq(list) != HashEq((lisp_object*)CreateList(99, entries)));
+}
+
+void test_CreateVector_matches_cons(void) {
+    static const lisp_object *entries[32 * 32 * 32 + 66];
+    const size_t counts[] = {1, 32, 33, 64, 65, 1056, 1057, 1089, 32 * 32 * 32 + 32, 32 * 32 * 32 + 33, 32 * 32 * 32 + 65};
+    const size_t max = sizeof(entries) / sizeof(entries[0]);
+    static const IVector *consed[sizeof(entries) / sizeof(entries[0]) + 1];
+    consed[0] = (IVector*)EmptyVector;
+    for(size_t i = 0; i < max; i++) {
+        entries[i] = (lisp_object*)NewInteger(i);
+        consed[i+1] = consed[i]->obj.fns->IVectorFns->cons(consed[i], entries[i]);
+    }
+
+    for(size_t i = 0; i < sizeof(counts) / sizeof(counts[0]); i++) {
+        const IVector *v = (IVector*)CreateVector(counts[i], entries);
+        TEST_ASSERT_EQUAL_INT(counts[i], count((lisp_object*)v));
+        TEST_ASSERT(Equals((lisp_object*)v, (lisp_object*)consed[counts[i]]));
+        TEST_ASSERT(Equals(v->obj.fns->IVectorFns->nth(v, counts[i] - 1, NULL), entries[counts[i] - 1]));
+        const IVector *w = v->obj.fns->IVectorFns->cons(v, entries[counts[i]]);
+        TEST_ASSERT(Equals((lisp_object*)w, (lisp_object*)consed[counts[i] + 1]));
+
+        const Vector *into = intoVector(CreateVector(counts[i] / 2, entries), counts[i] - counts[i] / 2, entries + counts[i] / 2);
+        TEST_ASSERT(Equals((lisp_object*)into, (lisp_object*)consed[counts[i]]));
+    }
+}
+
+void test_Vector_chunks(void) {
+    const lisp_object *entries[100];
+    for(size_t i = 0; i < 100; i++)
+        entries[i] = (lisp_object*)NewInteger(i);
+    const lisp_object *v = (lisp_object*)CreateVector(100, entries);
+
+    const ISeq *s = next((lisp_object*)next(v));
+    TEST_ASSERT(isChunkedSeq(s));
+    TEST_ASSERT_EQUAL_INT(98, count((lisp_object*)s));
+    size_t n = 2;
+    for(; s != NULL; s = chunkRest(s)) {
+        size_t chunkCount;
+        const lisp_object *const *chunk = chunkFirst(s, &chunkCount);
+        TEST_ASSERT(chunkCount == 30 || chunkCount == 32 || chunkCount == 4);
+        for(size_t i = 0; i < chunkCount; i++, n++)
+            TEST_ASSERT(Equals(chunk[i], entries[n]));
+    }
+    TEST_ASSERT_EQUAL_INT(100, n);
+    TEST_ASSERT_EQUAL_INT(HashEq((lisp_object*)CreateList(100, entries)), hashOrdered(v));
+}
+
+void test_Vector_subvec_catvec(void) {
+    static const lisp_object *entries[5000];
+    for(size_t i = 0; i < 5000; i++)
+        entries[i] = (lisp_object*)NewInteger(i);
+    const Vector *v = CreateVector(5000, entries);
+
+    // Split at points that cut leaves, and rejoin.
+    const size_t cuts[] = {0, 1, 31, 32, 33, 1000, 1057, 4967, 4999, 5000};
+    for(size_t i = 0; i < sizeof(cuts) / sizeof(cuts[0]); i++) {
+        const Vector *left = subvec(v, 0, cuts[i]);
+        const Vector *right = subvec(v, cuts[i], 5000);
+        TEST_ASSERT(Equals((lisp_object*)left, (lisp_object*)CreateVector(cuts[i], entries)));
+        TEST_ASSERT(Equals((lisp_object*)right, (lisp_object*)CreateVector(5000 - cuts[i], entries + cuts[i])));
+        TEST_ASSERT(Equals((lisp_object*)catvec(left, right), (lisp_object*)v));
+        TEST_ASSERT_EQUAL_INT(HashEq((lisp_object*)v), HashEq((lisp_object*)catvec(left, right)));
+    }
+
+    // A relaxed vector still conses, pops and assocs.
+    const IVector *mid = (IVector*)catvec(subvec(v, 10, 100), subvec(v, 100, 3000));
+    TEST_ASSERT(Equals((lisp_object*)mid, (lisp_object*)CreateVector(2990, entries + 10)));
+    mid = mid->obj.fns->IVectorFns->cons(mid, entries[3000]);
+    TEST_ASSERT(Equals((lisp_object*)mid, (lisp_object*)CreateVector(2991, entries + 10)));
+    const IStack *popped = ((IStack*)mid)->obj.fns->IStackFns->pop((IStack*)mid);
+    TEST_ASSERT(Equals((lisp_object*)popped, (lisp_object*)CreateVector(2990, entries + 10)));
+    mid = mid->obj.fns->IVectorFns->assocN(mid, 5, entries[0]);
+    TEST_ASSERT(Equals(mid->obj.fns->IVectorFns->nth(mid, 5, NULL), entries[0]));
+
+    const Vector *inserted = insertVector(v, 40, entries[0]);
+    TEST_ASSERT_EQUAL_INT(5001, count((lisp_object*)inserted));
+    TEST_ASSERT(Equals(((IVector*)inserted)->obj.fns->IVectorFns->nth((IVector*)inserted, 40, NULL), entries[0]));
+    TEST_ASSERT(Equals((lisp_object*)subvec(inserted, 41, 5001), (lisp_object*)subvec(v, 40, 5000)));
+}
+
+void test_PrimVector_kernels(void) {
+    static const lisp_object *entries[1100];
+    static long longs[1100];
+    long sum = 0, dot = 0;
+    for(size_t i = 0; i < 1100; i++) {
+        longs[i] = (long)i - 500;
+        entries[i] = (lisp_object*)NewInteger(longs[i]);
+        sum += longs[i];
+        dot += longs[i] * longs[i];
+    }
+    // Past 1056 elements the trie gains a level.
+    const IVector *pv = (IVector*)EmptyPrimVector(PRIM_LONG);
+    for(size_t i = 0; i < 1100; i++)
+        pv = pv->obj.fns->IVectorFns->cons(pv, entries[i]);
+    const PrimVector *v = CreatePrimVectorFromArray(PRIM_LONG, 1100, longs);
+    TEST_ASSERT(Equals((lisp_object*)pv, (lisp_object*)v));
+    TEST_ASSERT(Equiv((lisp_object*)v, (lisp_object*)CreateVector(1100, entries)));
+    TEST_ASSERT_EQUAL_INT(HashEq((lisp_object*)CreateVector(1100, entries)), HashEq((lisp_object*)v));
+
+    TEST_ASSERT_EQUAL_INT(sum, IntegerValue((Integer*)sumPrimVector(v)));
+    TEST_ASSERT_EQUAL_INT(dot, IntegerValue((Integer*)dotPrimVector(v, v)));
+    const IVector *m = (IVector*)mulAddPrimVector(v, (lisp_object*)NewInteger(2), (lisp_object*)NewInteger(1));
+    TEST_ASSERT_EQUAL_INT(2 * longs[1057] + 1, IntegerValue((Integer*)m->obj.fns->IVectorFns->nth(m, 1057, NULL)));
+
+    // Bytes are summed and multiplied past their own range without overflowing.
+    const PrimVector *bytes = CreatePrimVector(PRIM_BYTE, 100, entries + 450);
+    TEST_ASSERT_EQUAL_INT(-50, IntegerValue((Integer*)sumPrimVector(bytes)));
+    TEST_ASSERT_EQUAL_INT(2 * 49 * 50 * 99 / 6 + 50 * 50, IntegerValue((Integer*)dotPrimVector(bytes, bytes)));
+    TEST_ASSERT_EQUAL_STRING("[-100 -99 -98]", toString((lisp_object*)CreatePrimVector(PRIM_BYTE, 3, entries + 400)));
+}
+
 int main(void) {
     UNITY_BEGIN();
     RUN_TEST(test_EmptyList_toString);
+    RUN_TEST(test_List_HashEq);
+    RUN_TEST(test_CreateVector_matches_cons);
+    RUN_TEST(test_Vector_chunks);
+    RUN_TEST(test_Vector_subvec_catvec);
+    RUN_TEST(test_PrimVector_kernels);
     return UNITY_END();
 }
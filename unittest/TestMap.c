@@ -0,0 +1,486 @@
+#include "unity.h"
+
+#include "AFn.h"
+#include "ArrayMap.h"
+#include "ChampMap.h"
+#include "Cons.h"
+#include "gc.h"
+#include "Interfaces.h"
+#include "Map.h"
+#include "MapEntry.h"
+#include "Numbers.h"
+#include "Util.h"
+
+void setUp(void) {
+}
+
+void tearDown(void) {
+}
+
+// (fn [acc k v] (+ acc v)) and (fn ([] 0) ([x y] (+ x y))), as reducef and combinef for fold.
+
+static const lisp_object* invokeSumEntry(__attribute__((unused)) const IFn *self, const lisp_object *acc, __attribute__((unused)) const lisp_object *key, const lisp_object *val) {
+    return (lisp_object*)NewInteger(IntegerValue((Integer*)acc) + IntegerValue((Integer*)val));
+}
+
+static const lisp_object* invokeZero(__attribute__((unused)) const IFn *self) {
+    return (lisp_object*)NewInteger(0);
+}
+
+static const lisp_object* invokePlus(__attribute__((unused)) const IFn *self, const lisp_object *x, const lisp_object *y) {
+    return (lisp_object*)NewInteger(IntegerValue((Integer*)x) + IntegerValue((Integer*)y));
+}
+
+const IFn_vtable SumEntry_IFn_vtable = {
+    invoke0AFn,     // invoke0
+    invoke1AFn,     // invoke1
+    invoke2AFn,     // invoke2
+    invokeSumEntry, // invoke3
+    invoke4AFn,     // invoke4
+    invoke5AFn,     // invoke5
+    applyToAFn,     // applyTo
+};
+
+const IFn_vtable Plus_IFn_vtable = {
+    invokeZero, // invoke0
+    invoke1AFn, // invoke1
+    invokePlus, // invoke2
+    invoke3AFn, // invoke3
+    invoke4AFn, // invoke4
+    invoke5AFn, // invoke5
+    applyToAFn, // applyTo
+};
+
+interfaces SumEntry_interfaces = {NULL, NULL, NULL, NULL, NULL, &SumEntry_IFn_vtable, NULL, NULL, NULL, NULL, NULL, NULL};
+interfaces Plus_interfaces = {NULL, NULL, NULL, NULL, NULL, &Plus_IFn_vtable, NULL, NULL, NULL, NULL, NULL, NULL};
+
+const lisp_object SumEntry = {IFN_type, sizeof(lisp_object), NULL, &SumEntry_interfaces};
+const lisp_object Plus = {IFN_type, sizeof(lisp_object), NULL, &Plus_interfaces};
+
+void test_foldHashMap_nil_key(void) {
+    // A map holding only nil has no trie, and one holding nil and other keys folds the nil entry in separately.
+    const lisp_object *onlyNil[] = {NULL, (lisp_object*)NewInteger(5)};
+    const HashMap *hm = CreateHashMap(2, onlyNil);
+    for(size_t n = 0; n < 2; n++)
+        TEST_ASSERT_EQUAL_INT(5, IntegerValue((Integer*)foldHashMap(hm, n, (IFn*)&Plus, (IFn*)&SumEntry)));
+
+    static const lisp_object *entries[2 * 101];
+    entries[0] = NULL;
+    entries[1] = (lisp_object*)NewInteger(1000);
+    for(size_t i = 1; i < 101; i++) {
+        entries[2*i] = (lisp_object*)NewInteger(i);
+        entries[2*i+1] = (lisp_object*)NewInteger(i);
+    }
+    hm = CreateHashMap(2 * 101, entries);
+    for(size_t n = 0; n < 200; n += 7)
+        TEST_ASSERT_EQUAL_INT(1000 + 5050, IntegerValue((Integer*)foldHashMap(hm, n, (IFn*)&Plus, (IFn*)&SumEntry)));
+}
+
+// (fn [acc k v] (+ acc (fold + inner))), which starts a fold from inside one.
+static const HashMap *inner;
+
+static const lisp_object* invokeSumFold(__attribute__((unused)) const IFn *self, const lisp_object *acc, __attribute__((unused)) const lisp_object *key, __attribute__((unused)) const lisp_object *val) {
+    const lisp_object *sum = foldHashMap(inner, 0, (IFn*)&Plus, (IFn*)&SumEntry);
+    return (lisp_object*)NewInteger(IntegerValue((Integer*)acc) + IntegerValue((Integer*)sum));
+}
+
+const IFn_vtable SumFold_IFn_vtable = {
+    invoke0AFn,     // invoke0
+    invoke1AFn,     // invoke1
+    invoke2AFn,     // invoke2
+    invokeSumFold,  // invoke3
+    invoke4AFn,     // invoke4
+    invoke5AFn,     // invoke5
+    applyToAFn,     // applyTo
+};
+
+interfaces SumFold_interfaces = {NULL, NULL, NULL, NULL, NULL, &SumFold_IFn_vtable, NULL, NULL, NULL, NULL, NULL, NULL};
+const lisp_object SumFold = {IFN_type, sizeof(lisp_object), NULL, &SumFold_interfaces};
+
+void test_foldHashMap_nested(void) {
+    // Every entry of the outer fold folds inner, so with threads the workers queue tasks while running one.
+    static const lisp_object *entries[2 * 100];
+    for(size_t i = 0; i < 100; i++) {
+        entries[2*i] = (lisp_object*)NewInteger(i + 1);
+        entries[2*i+1] = (lisp_object*)NewInteger(i + 1);
+    }
+    inner = CreateHashMap(2 * 100, entries);
+    TEST_ASSERT_EQUAL_INT(100 * 5050, IntegerValue((Integer*)foldHashMap(inner, 0, (IFn*)&Plus, (IFn*)&SumFold)));
+}
+
+static size_t seqLength(const lisp_object *o) {
+    size_t n = 0;
+    for(const ISeq *s = seq(o); s != NULL; s = s->obj.fns->ISeqFns->next(s))
+        n++;
+    return n;
+}
+
+void test_mergeHashMap_shared(void) {
+    // x and y share all but a few subtrees, and the count of the merge comes from the keys y adds.
+    static const lisp_object *entries[2 * 1000];
+    for(size_t i = 0; i < 1000; i++) {
+        entries[2*i] = (lisp_object*)NewInteger(i);
+        entries[2*i+1] = (lisp_object*)NewInteger(i);
+    }
+    const IMap *x = (IMap*)CreateHashMap(2 * 1000, entries);
+    const IMap *y = x->obj.fns->IMapFns->assoc(x, (lisp_object*)NewInteger(5), (lisp_object*)NewInteger(6));
+    y = y->obj.fns->IMapFns->assoc(y, (lisp_object*)NewInteger(5000), (lisp_object*)NewInteger(1));
+    y = y->obj.fns->IMapFns->assoc(y, NULL, (lisp_object*)NewInteger(1));
+    x = x->obj.fns->IMapFns->without(x, (lisp_object*)NewInteger(7));
+
+    const lisp_object *m = (lisp_object*)mergeHashMap((HashMap*)x, (HashMap*)y);
+    TEST_ASSERT_EQUAL_INT(1002, count(m));
+    TEST_ASSERT_EQUAL_INT(1002, seqLength(m));
+    m = (lisp_object*)mergeHashMap((HashMap*)x, (HashMap*)x);
+    TEST_ASSERT_EQUAL_INT(999, count(m));
+}
+
+void test_siteLookup(void) {
+    // A site keeps answering correctly as it moves between maps, and back to the one it has cached.
+    static const lisp_object *entries[2 * 1000];
+    for(size_t i = 0; i < 1000; i++) {
+        entries[2*i] = (lisp_object*)NewInteger(i);
+        entries[2*i+1] = (lisp_object*)NewInteger(i);
+    }
+    const IMap *m = (IMap*)CreateHashMap(2 * 1000, entries);
+    const IMap *small = CreateArrayMap(4, entries);
+    for(size_t i = 0; i < 1000; i += 37) {
+        const lisp_object *key = entries[2*i];
+        KeyLookupSite site;
+        initKeyLookupSite(&site, key);
+        TEST_ASSERT_EQUAL_INT(i, IntegerValue((Integer*)siteLookupHashMap((HashMap*)m, &site, NULL)));
+        TEST_ASSERT_EQUAL_INT(i, IntegerValue((Integer*)siteLookupHashMap((HashMap*)m, &site, NULL)));
+
+        const IMap *other = m->obj.fns->IMapFns->assoc(m, entries[2*((i+1) % 1000)], NULL);
+        TEST_ASSERT_EQUAL_INT(i, IntegerValue((Integer*)siteLookupHashMap((HashMap*)other, &site, NULL)));
+        const IMap *changed = m->obj.fns->IMapFns->assoc(m, key, (lisp_object*)NewInteger(-1));
+        TEST_ASSERT_EQUAL_INT(-1, IntegerValue((Integer*)siteLookupHashMap((HashMap*)changed, &site, NULL)));
+        const IMap *removed = m->obj.fns->IMapFns->without(m, key);
+        TEST_ASSERT_NULL(siteLookupHashMap((HashMap*)removed, &site, NULL));
+        TEST_ASSERT_NULL(siteLookupHashMap((HashMap*)removed, &site, NULL));
+        TEST_ASSERT_EQUAL_INT(-1, IntegerValue((Integer*)siteLookupHashMap((HashMap*)changed, &site, NULL)));
+
+        const lisp_object *found = siteLookupArrayMap((ArrayMap*)small, &site, NULL);
+        if(i < 2)
+            TEST_ASSERT_EQUAL_INT(i, IntegerValue((Integer*)found));
+        else
+            TEST_ASSERT_NULL(found);
+        TEST_ASSERT_EQUAL_INT(i, IntegerValue((Integer*)siteLookupHashMap((HashMap*)m, &site, NULL)));
+    }
+}
+
+// Keys with a hash of our choosing, equal when their ids are, to build collisions.
+
+typedef struct {
+    lisp_object obj;
+    long id;
+    uint32_t hash;
+} CollidingKey;
+
+static bool EqualsCollidingKey(const lisp_object *x, const lisp_object *y);
+
+static uint32_t HashEqCollidingKey(const lisp_object *obj) {
+    return ((CollidingKey*)obj)->hash;
+}
+
+interfaces CollidingKey_interfaces = {NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, EqualsCollidingKey, HashEqCollidingKey};
+
+static bool EqualsCollidingKey(const lisp_object *x, const lisp_object *y) {
+    return y != NULL && !isImmediate(y) && y->fns == &CollidingKey_interfaces && ((CollidingKey*)x)->id == ((CollidingKey*)y)->id;
+}
+
+static const lisp_object *NewCollidingKey(long id, uint32_t hash) {
+    CollidingKey *ret = GC_MALLOC(sizeof(*ret));
+    ret->obj.type = LISPOBJECT_type;
+    ret->obj.size = sizeof(CollidingKey);
+    ret->obj.fns = &CollidingKey_interfaces;
+    ret->id = id;
+    ret->hash = hash;
+    return (lisp_object*)ret;
+}
+
+// A hash, and one that agrees with it on every level of the trie but the last.
+#define COLLIDING_HASH 0x0badf00du
+#define DEEP_HASH (COLLIDING_HASH ^ (1u << 30))
+
+static const IMap *assocAll(const IMap *m, size_t count, const lisp_object **entries) {
+    for(size_t i = 0; i < count; i += 2)
+        m = m->obj.fns->IMapFns->assoc(m, entries[i], entries[i+1]);
+    return m;
+}
+
+// Two CHAMP maps with the same shape seq their entries in the same order of hashes.  Only keys sharing a hash, in a
+// collision node, may come in either order.
+static void assertSameShape(const lisp_object *x, const lisp_object *y) {
+    TEST_ASSERT_MESSAGE(Equiv(x, y), "Maps not Equiv");
+    TEST_ASSERT_MESSAGE(Equiv(y, x), "Maps not Equiv");
+    const ISeq *s = seq(x);
+    const ISeq *t = seq(y);
+    for(; s != NULL && t != NULL; s = s->obj.fns->ISeqFns->next(s), t = t->obj.fns->ISeqFns->next(t)) {
+        const MapEntry *e = (MapEntry*)s->obj.fns->ISeqFns->first(s);
+        const MapEntry *f = (MapEntry*)t->obj.fns->ISeqFns->first(t);
+        TEST_ASSERT_MESSAGE(HashEq(e->key) == HashEq(f->key), "Maps seq in different orders");
+    }
+    TEST_ASSERT_NULL(s);
+    TEST_ASSERT_NULL(t);
+}
+
+void test_champ_without_canonical(void) {
+    // However a map is cut down, it has the shape of one built from scratch with the keys left, so the structural
+    // Equiv between CHAMP maps agrees with a lookup based Equiv against a HashMap.
+    #define N 1006
+    static const lisp_object *entries[2 * N];
+    static const lisp_object *kept[2 * N];
+    for(size_t i = 0; i < 1000; i++) {
+        entries[2*i] = (lisp_object*)NewInteger(i);
+        entries[2*i+1] = (lisp_object*)NewInteger(i);
+    }
+    const uint32_t hashes[] = {COLLIDING_HASH, COLLIDING_HASH, COLLIDING_HASH, DEEP_HASH, COLLIDING_HASH ^ 0x1f, COLLIDING_HASH ^ 0x1f};
+    for(size_t i = 1000; i < N; i++) {
+        entries[2*i] = NewCollidingKey(i, hashes[i - 1000]);
+        entries[2*i+1] = (lisp_object*)NewInteger(i);
+    }
+    const IMap *full = (IMap*)CreateChampMap(2 * N, entries);
+    TEST_ASSERT_EQUAL_INT(N, count((lisp_object*)full));
+    static const lisp_object *reversed[2 * N];
+    for(size_t i = 0; i < N; i++) {
+        reversed[2*i] = entries[2*(N-1-i)];
+        reversed[2*i+1] = entries[2*(N-1-i)+1];
+    }
+    assertSameShape((lisp_object*)full, (lisp_object*)assocAll((IMap*)EmptyChampMap, 2 * N, reversed));
+
+    // Keep every k-th key, removing the rest in a scattered order.
+    for(size_t k = 2; k <= N + 1; k = k * 3 + 1) {
+        const IMap *cut = full;
+        for(size_t j = 0; j < N; j++) {
+            size_t i = (j * 7) % N;
+            if(i % k != 0)
+                cut = cut->obj.fns->IMapFns->without(cut, entries[2*i]);
+        }
+        size_t n = 0;
+        for(size_t i = 0; i < N; i += k) {
+            kept[n++] = entries[2*i];
+            kept[n++] = entries[2*i+1];
+        }
+        TEST_ASSERT_EQUAL_INT(n / 2, count((lisp_object*)cut));
+        assertSameShape((lisp_object*)cut, (lisp_object*)CreateChampMap(n, kept));
+        TEST_ASSERT_MESSAGE(Equiv((lisp_object*)cut, (lisp_object*)CreateHashMap(n, kept)), "Not Equiv to a HashMap");
+        for(size_t i = 0; i < N; i++)
+            TEST_ASSERT_EQUAL_INT(i % k == 0, cut->obj.fns->IMapFns->containsKey(cut, entries[2*i]));
+    }
+
+    const IMap *empty = full;
+    for(size_t i = 0; i < N; i++)
+        empty = empty->obj.fns->IMapFns->without(empty, entries[2*i]);
+    TEST_ASSERT_EQUAL_INT(0, count((lisp_object*)empty));
+    TEST_ASSERT_NULL(seq((lisp_object*)empty));
+    TEST_ASSERT_MESSAGE(Equiv((lisp_object*)empty, (lisp_object*)EmptyChampMap), "Not Equiv to the empty map");
+    #undef N
+}
+
+void test_champ_collisions(void) {
+    // a, b and c share a hash, d agrees with it down to the last level, and e shares it but is never added.
+    const lisp_object *a = NewCollidingKey(1, COLLIDING_HASH);
+    const lisp_object *b = NewCollidingKey(2, COLLIDING_HASH);
+    const lisp_object *c = NewCollidingKey(3, COLLIDING_HASH);
+    const lisp_object *d = NewCollidingKey(4, DEEP_HASH);
+    const lisp_object *e = NewCollidingKey(5, COLLIDING_HASH);
+    const lisp_object *one = (lisp_object*)NewInteger(1);
+    const lisp_object *two = (lisp_object*)NewInteger(2);
+    const lisp_object *three = (lisp_object*)NewInteger(3);
+    const lisp_object *four = (lisp_object*)NewInteger(4);
+    const lisp_object *forward[] = {a, one, b, two, c, three, d, four};
+    const lisp_object *backward[] = {d, four, c, three, b, two, a, one};
+
+    const IMap *m = assocAll((IMap*)EmptyChampMap, 8, forward);
+    TEST_ASSERT_EQUAL_INT(4, count((lisp_object*)m));
+    for(size_t i = 0; i < 8; i += 2)
+        TEST_ASSERT_EQUAL_PTR(forward[i+1], m->obj.fns->IMapFns->valAt(m, forward[i], NULL));
+    TEST_ASSERT_MESSAGE(!m->obj.fns->IMapFns->containsKey(m, e), "Found a key never added");
+    TEST_ASSERT_EQUAL_PTR(four, m->obj.fns->IMapFns->valAt(m, e, four));
+    TEST_ASSERT_EQUAL_PTR(m, m->obj.fns->IMapFns->without(m, e));
+    TEST_ASSERT_EQUAL_PTR(m, m->obj.fns->IMapFns->assoc(m, b, two));
+
+    // Collision nodes hold their entries in insertion order, which Equiv must not depend on.
+    TEST_ASSERT_MESSAGE(Equiv((lisp_object*)m, (lisp_object*)assocAll((IMap*)EmptyChampMap, 8, backward)), "Collision order matters");
+    TEST_ASSERT_MESSAGE(Equiv((lisp_object*)m, (lisp_object*)CreateChampMap(8, backward)), "Collision order matters");
+
+    const IMap *changed = m->obj.fns->IMapFns->assoc(m, b, four);
+    TEST_ASSERT_EQUAL_INT(4, count((lisp_object*)changed));
+    TEST_ASSERT_EQUAL_PTR(four, changed->obj.fns->IMapFns->valAt(changed, b, NULL));
+    TEST_ASSERT_MESSAGE(!Equiv((lisp_object*)m, (lisp_object*)changed), "Changed value still Equiv");
+
+    // Removing d leaves the collision node alone at the bottom of the trie, and it moves up to the root.
+    const lisp_object *abc[] = {a, one, b, two, c, three};
+    assertSameShape((lisp_object*)m->obj.fns->IMapFns->without(m, d), (lisp_object*)CreateChampMap(6, abc));
+    // Removing all but one colliding key puts the last one inline next to d.
+    const IMap *ad = m->obj.fns->IMapFns->without(m->obj.fns->IMapFns->without(m, b), c);
+    const lisp_object *adEntries[] = {a, one, d, four};
+    assertSameShape((lisp_object*)ad, (lisp_object*)CreateChampMap(4, adEntries));
+    assertSameShape((lisp_object*)ad->obj.fns->IMapFns->without(ad, d), (lisp_object*)CreateChampMap(2, adEntries));
+    assertSameShape((lisp_object*)ad->obj.fns->IMapFns->without(ad, a), (lisp_object*)CreateChampMap(2, &adEntries[2]));
+}
+
+void test_champ_null_key(void) {
+    // nil is kept outside the trie, but counts, seqs and compares like any other key.
+    const lisp_object *entries[] = {(lisp_object*)NewInteger(1), (lisp_object*)NewInteger(10), NULL, (lisp_object*)NewInteger(0),
+        (lisp_object*)NewInteger(2), (lisp_object*)NewInteger(20)};
+    const IMap *m = (IMap*)CreateChampMap(6, entries);
+    TEST_ASSERT_EQUAL_INT(3, count((lisp_object*)m));
+    TEST_ASSERT_EQUAL_INT(3, seqLength((lisp_object*)m));
+    TEST_ASSERT_MESSAGE(m->obj.fns->IMapFns->containsKey(m, NULL), "nil missing");
+    TEST_ASSERT_EQUAL_INT(0, IntegerValue((Integer*)m->obj.fns->IMapFns->valAt(m, NULL, NULL)));
+    TEST_ASSERT_NULL(((MapEntry*)first((lisp_object*)m))->key);
+    TEST_ASSERT_EQUAL_PTR(m, m->obj.fns->IMapFns->assoc(m, NULL, entries[3]));
+    TEST_ASSERT_MESSAGE(Equiv((lisp_object*)m, (lisp_object*)CreateHashMap(6, entries)), "Not Equiv to a HashMap");
+    TEST_ASSERT_MESSAGE(Equiv((lisp_object*)m, (lisp_object*)assocAll((IMap*)EmptyChampMap, 6, entries)), "Not Equiv when built by assoc");
+
+    const IMap *other = m->obj.fns->IMapFns->assoc(m, NULL, entries[1]);
+    TEST_ASSERT_EQUAL_INT(3, count((lisp_object*)other));
+    TEST_ASSERT_MESSAGE(!Equiv((lisp_object*)m, (lisp_object*)other), "nil values differ");
+
+    const IMap *without = m->obj.fns->IMapFns->without(m, NULL);
+    TEST_ASSERT_EQUAL_INT(2, count((lisp_object*)without));
+    TEST_ASSERT_MESSAGE(!without->obj.fns->IMapFns->containsKey(without, NULL), "nil still present");
+    TEST_ASSERT_EQUAL_PTR(entries[1], without->obj.fns->IMapFns->valAt(without, NULL, entries[1]));
+    TEST_ASSERT_EQUAL_PTR(without, without->obj.fns->IMapFns->without(without, NULL));
+    const lisp_object *noNull[] = {entries[0], entries[1], entries[4], entries[5]};
+    assertSameShape((lisp_object*)without, (lisp_object*)CreateChampMap(4, noNull));
+    TEST_ASSERT_MESSAGE(!Equiv((lisp_object*)m, (lisp_object*)without), "nil ignored");
+
+    // A map of only nil has no trie, and loses nothing else when its other keys go.
+    const IMap *onlyNull = (IMap*)CreateChampMap(2, &entries[2]);
+    TEST_ASSERT_EQUAL_INT(1, count((lisp_object*)onlyNull));
+    TEST_ASSERT_EQUAL_INT(1, seqLength((lisp_object*)onlyNull));
+    const IMap *cut = m->obj.fns->IMapFns->without(m->obj.fns->IMapFns->without(m, entries[0]), entries[4]);
+    assertSameShape((lisp_object*)cut, (lisp_object*)onlyNull);
+    TEST_ASSERT_MESSAGE(Equiv((lisp_object*)onlyNull, (lisp_object*)((IMap*)EmptyChampMap)->obj.fns->IMapFns->assoc((IMap*)EmptyChampMap, NULL, entries[3])), "nil only maps differ");
+    TEST_ASSERT_EQUAL_INT(0, count((lisp_object*)onlyNull->obj.fns->IMapFns->without(onlyNull, NULL)));
+}
+
+// Every key the merge tests use: integers, keys in two collision groups with one agreeing down to the last level, and
+// nil.  Lookups use universe, while maps hold the keys of ycopies, whose colliding keys are equal but not identical.
+#define INTS 1500
+#define UNIVERSE (INTS + 7)
+
+static const lisp_object *universe[UNIVERSE];
+static const lisp_object *ycopies[UNIVERSE];
+
+static void initUniverse(void) {
+    const uint32_t hashes[] = {COLLIDING_HASH, COLLIDING_HASH, COLLIDING_HASH, DEEP_HASH, COLLIDING_HASH ^ 0x1f, COLLIDING_HASH ^ 0x1f};
+    for(size_t i = 0; i < INTS; i++)
+        universe[i] = ycopies[i] = (lisp_object*)NewInteger(i);
+    for(size_t i = INTS; i < UNIVERSE - 1; i++) {
+        universe[i] = NewCollidingKey(i, hashes[i - INTS]);
+        ycopies[i] = NewCollidingKey(i, hashes[i - INTS]);
+    }
+    universe[UNIVERSE - 1] = ycopies[UNIVERSE - 1] = NULL;
+}
+
+// The map of keys[i] to vals[i], for each i with a value.
+static const HashMap *mapOf(const lisp_object **keys, const lisp_object **vals) {
+    static const lisp_object *entries[2 * UNIVERSE];
+    size_t n = 0;
+    for(size_t i = 0; i < UNIVERSE; i++) {
+        if(vals[i] != NULL) {
+            entries[n++] = keys[i];
+            entries[n++] = vals[i];
+        }
+    }
+    return CreateHashMap(n, entries);
+}
+
+static void assertMapHolds(const HashMap *hm, const lisp_object **vals) {
+    const IMap *m = (IMap*)hm;
+    const lisp_object *NotFound = (lisp_object*)NewInteger(-1);
+    size_t n = 0;
+    for(size_t i = 0; i < UNIVERSE; i++) {
+        const lisp_object *val = m->obj.fns->IMapFns->valAt(m, universe[i], NotFound);
+        if(vals[i] == NULL) {
+            TEST_ASSERT_EQUAL_PTR(NotFound, val);
+        } else {
+            TEST_ASSERT_EQUAL_INT(IntegerValue((Integer*)vals[i]), IntegerValue((Integer*)val));
+            n++;
+        }
+    }
+    TEST_ASSERT_EQUAL_INT(n, count((lisp_object*)hm));
+    TEST_ASSERT_EQUAL_INT(n, seqLength((lisp_object*)hm));
+    TEST_ASSERT_MESSAGE(Equiv((lisp_object*)hm, (lisp_object*)mapOf(universe, vals)), "Not Equiv to the map built from scratch");
+}
+
+// Checks merge, mergeWith +, and select-keys with a selection of keys, on x and y holding xvals and yvals.
+static void checkMerges(const HashMap *x, const lisp_object **xvals, const HashMap *y, const lisp_object **yvals) {
+    static const lisp_object *merged[UNIVERSE];
+    static const lisp_object *summed[UNIVERSE];
+    static const lisp_object *selected[UNIVERSE];
+    for(size_t i = 0; i < UNIVERSE; i++) {
+        merged[i] = yvals[i] ? yvals[i] : xvals[i];
+        summed[i] = xvals[i] && yvals[i] ? invokePlus(NULL, xvals[i], yvals[i]) : merged[i];
+    }
+    assertMapHolds(mergeHashMap(x, y), merged);
+    assertMapHolds(mergeWithHashMap((IFn*)&Plus, x, y), summed);
+    assertMapHolds(mergeWithHashMap((IFn*)&Plus, x, EmptyHashMap), xvals);
+    assertMapHolds(mergeWithHashMap((IFn*)&Plus, EmptyHashMap, y), yvals);
+
+    // Select every third key of the universe, and the keys y holds, whether or not x has them.
+    const ISeq *selection = NULL;
+    for(size_t i = 0; i < UNIVERSE; i++) {
+        bool select = i % 3 == 0 || yvals[i] != NULL;
+        selected[i] = select ? xvals[i] : NULL;
+        if(select)
+            selection = (ISeq*)NewCons(ycopies[i], selection);
+    }
+    assertMapHolds(selectKeysHashMap(x, (lisp_object*)selection), selected);
+    TEST_ASSERT_EQUAL_PTR(x, selectKeysHashMap(x, (lisp_object*)keys((lisp_object*)x)));
+    TEST_ASSERT_EQUAL_INT(0, count((lisp_object*)selectKeysHashMap(x, NULL)));
+}
+
+void test_merge_select(void) {
+    static const lisp_object *xvals[UNIVERSE];
+    static const lisp_object *yvals[UNIVERSE];
+    initUniverse();
+
+    // Disjoint: x holds the even integers, two colliding keys and nil, and y holds the rest.
+    for(size_t i = 0; i < UNIVERSE; i++) {
+        bool inX = i < INTS ? i % 2 == 0 : i < INTS + 2 || i == UNIVERSE - 1;
+        xvals[i] = inX ? (lisp_object*)NewInteger(i) : NULL;
+        yvals[i] = inX ? NULL : (lisp_object*)NewInteger(10000 + i);
+    }
+    const HashMap *x = mapOf(universe, xvals);
+    checkMerges(x, xvals, mapOf(ycopies, yvals), yvals);
+
+    // Identical: the same map, and an equal one built separately.
+    for(size_t i = 0; i < UNIVERSE; i++)
+        yvals[i] = xvals[i];
+    checkMerges(x, xvals, x, xvals);
+    checkMerges(x, xvals, mapOf(ycopies, yvals), yvals);
+    TEST_ASSERT_EQUAL_PTR(x, mergeHashMap(x, x));
+
+    // Shared: y is x with a few keys added, changed and removed, so most of its subtrees are x's.
+    const IMap *m = (IMap*)x;
+    for(size_t i = 0; i < UNIVERSE; i++) {
+        const lisp_object *key = ycopies[i];
+        if(i % 97 == 1 || i == INTS + 2 || i == INTS + 3) {
+            yvals[i] = (lisp_object*)NewInteger(20000 + i);
+            m = m->obj.fns->IMapFns->assoc(m, key, yvals[i]);
+        } else if(xvals[i] && (i % 89 == 0 || i == INTS + 1 || i == UNIVERSE - 1)) {
+            yvals[i] = NULL;
+            m = m->obj.fns->IMapFns->without(m, key);
+        }
+    }
+    checkMerges(x, xvals, (HashMap*)m, yvals);
+    checkMerges((HashMap*)m, yvals, x, xvals);
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_foldHashMap_nil_key);
+    RUN_TEST(test_foldHashMap_nested);
+    RUN_TEST(test_mergeHashMap_shared);
+    RUN_TEST(test_siteLookup);
+    RUN_TEST(test_champ_without_canonical);
+    RUN_TEST(test_champ_collisions);
+    RUN_TEST(test_champ_null_key);
+    RUN_TEST(test_merge_select);
+    return UNITY_END();
+}
@@ -0,0 +1,291 @@
+#define _DEFAULT_SOURCE	// setitimer
+
+#include <signal.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/time.h>
+
+#include "unity.h"
+
+#include "Interfaces.h"
+#include "LineNumberReader.h"
+#include "Native.h"
+#include "Numbers.h"
+#include "Reader.h"
+#include "Util.h"
+
+#define PROGRAM "./TestNativeProgram.out"
+
+char *msg(char *restrict s, size_t n, const char *restrict format, ...) {
+	va_list argp;
+	va_start(argp, format);
+	vsnprintf(s, n, format, argp);
+	va_end(argp);
+	return s;
+}
+
+typedef struct test_data {
+	char *input;
+	char *expected;
+} test_data;
+
+void setUp(void) {
+	init_reader();
+}
+
+void tearDown(void) {
+	remove(PROGRAM);
+}
+
+static void run_tests(const test_data *data, size_t count) {
+	char err[256] = "";
+	char output[256];
+
+	for(size_t i = 0; i < count; i++) {
+		const test_data *d = &(data[i]);
+		LineNumberReader *stream = MemOpenLineNumberReader(d->input, strlen(d->input));
+		const lisp_object *form = read(stream, false, '\0');
+		closeLineNumberReader(stream);
+		TEST_ASSERT_MESSAGE(CompileProgram(form, PROGRAM), msg(err, 256, "Unable to compile %s.", d->input));
+
+		FILE *p = popen(PROGRAM, "r");
+		TEST_ASSERT_NOT_NULL(p);
+		size_t len = fread(output, 1, sizeof(output) - 1, p);
+		output[len] = '\0';
+		pclose(p);
+		TEST_ASSERT_EQUAL_STRING_MESSAGE(d->expected, output, d->input);
+	}
+}
+
+void test_integers(void) {
+	test_data data[] = {
+		{"0", "0\n"},
+		{"1", "1\n"},
+		{"-1", "-1\n"},
+		{"2736", "2736\n"},
+		{"-2736", "-2736\n"},
+		{"536870911", "536870911\n"},
+		{"-536870912", "-536870912\n"},
+	};
+	run_tests(data, sizeof(data)/sizeof(data[0]));
+}
+
+void test_immediate_constants(void) {
+	test_data data[] = {
+		{"false", "false\n"},
+		{"true", "true\n"},
+		{"nil", "nil\n"},
+		{"()", "()\n"},
+		{"\\a", "\\a\n"},
+		{"\\space", "\\space\n"},
+		{"\\newline", "\\newline\n"},
+	};
+	run_tests(data, sizeof(data)/sizeof(data[0]));
+}
+
+void test_unary_primitives(void) {
+	test_data data[] = {
+		{"($fxadd1 -1)", "0\n"},
+		{"($fxadd1 536870910)", "536870911\n"},
+		{"(fxadd1 (fxadd1 (fxadd1 12)))", "15\n"},
+		{"(fxsub1 -536870911)", "-536870912\n"},
+		{"($fixnum->char 65)", "\\A\n"},
+		{"($char->fixnum \\z)", "122\n"},
+		{"(fixnum->char (char->fixnum \\x))", "\\x\n"},
+		{"(fixnum? -23873)", "true\n"},
+		{"(fixnum? \\a)", "false\n"},
+		{"(fxzero? 0)", "true\n"},
+		{"(fxzero? 1)", "false\n"},
+		{"(nil? nil)", "true\n"},
+		{"(null? ())", "true\n"},
+		{"(null? false)", "false\n"},
+		{"(boolean? true)", "true\n"},
+		{"(boolean? 0)", "false\n"},
+		{"(char? \\a)", "true\n"},
+		{"(char? 12)", "false\n"},
+		{"(not nil)", "true\n"},
+		{"(not 15)", "false\n"},
+		{"(fxlognot -7)", "6\n"},
+	};
+	run_tests(data, sizeof(data)/sizeof(data[0]));
+}
+
+void test_if(void) {
+	test_data data[] = {
+		{"(if true 12 13)", "12\n"},
+		{"(if false 12 13)", "13\n"},
+		{"(if nil 12 13)", "13\n"},
+		{"(if 0 12 13)", "12\n"},
+		{"(if () 43 ())", "43\n"},
+		{"(if (not (boolean? true)) 15 (boolean? false))", "true\n"},
+		{"(if (if (char? \\a) (boolean? \\b) (fixnum? \\c)) 119 -23)", "-23\n"},
+		{"(not (if (not (if (if (not 1) (not 2) (not 3)) 4 5)) 6 7))", "false\n"},
+		{"($fxadd1 (if ($fxsub1 1) ($fxsub1 13) 14))", "13\n"},
+	};
+	run_tests(data, sizeof(data)/sizeof(data[0]));
+}
+
+void test_binary_primitives(void) {
+	test_data data[] = {
+		{"(fx+ 536870911 -536870912)", "-1\n"},
+		{"(fx+ (fx+ (fx+ (fx+ (fx+ (fx+ (fx+ (fx+ 1 2) 3) 4) 5) 6) 7) 8) 9)", "45\n"},
+		{"(fx+ 1 (fx+ 2 (fx+ 3 (fx+ 4 (fx+ 5 (fx+ 6 (fx+ 7 (fx+ 8 9))))))))", "45\n"},
+		{"(fx- (fx- 1 -2) (fx- -3 4))", "10\n"},
+		{"(fx* (fx* 2 -3) (fx* -4 5))", "120\n"},
+		{"(fxlognot (fxlogor (fxlognot 7) (fxlognot 2)))", "2\n"},
+		{"(fxlogand (fxlognot (fxlognot 12)) (fxlognot (fxlognot 12)))", "12\n"},
+		{"(fx= 12 13)", "false\n"},
+		{"(fx< -1 2)", "true\n"},
+		{"(fx<= 2 2)", "true\n"},
+		{"(fx> 2 2)", "false\n"},
+		{"(fx>= 3 2)", "true\n"},
+		{"(char= \\a \\a)", "true\n"},
+		{"(if (fx< 12 13) 12 13)", "12\n"},
+	};
+	run_tests(data, sizeof(data)/sizeof(data[0]));
+}
+
+void test_let(void) {
+	test_data data[] = {
+		{"(let [x 5] x)", "5\n"},
+		{"(let [x (fx+ 1 2) y (fx+ 3 4)] (fx- y x))", "4\n"},
+		{"(let [x (let [y (fx+ 1 2)] (fx* y y))] (fx+ x x))", "18\n"},
+		{"(let [x (fx+ 1 2)] (let [x (fx+ x 4)] x))", "7\n"},
+		{"(let [x 12] (let [x (fx+ x x)] (let [x (fx+ x x)] (let [x (fx+ x x)] (fx+ x x)))))", "192\n"},
+	};
+	run_tests(data, sizeof(data)/sizeof(data[0]));
+}
+
+void test_cons(void) {
+	test_data data[] = {
+		{"(pair? (cons 1 2))", "true\n"},
+		{"(pair? ())", "false\n"},
+		{"(car (car (cons (cons 12 3) (cons true false))))", "12\n"},
+		{"(cdr (cdr (cons (cons 12 3) (cons true false))))", "false\n"},
+		{"(let [x (let [y (fx+ 1 2)] (fx* y y))] (cons x (fx+ x x)))", "(9 . 18)\n"},
+		{"(cons 1 (cons 2 ()))", "(1 2)\n"},
+		{"(let [x ()] (let [x (cons x x)] (cons x x)))", "((()) ())\n"},
+	};
+	run_tests(data, sizeof(data)/sizeof(data[0]));
+}
+
+void test_do(void) {
+	test_data data[] = {
+		{"(do 12)", "12\n"},
+		{"(do 123 2343 true)", "true\n"},
+		{"(let [t (do 13 (cons 1 2))] (cons 1 t) t)", "(1 . 2)\n"},
+		{"(let [x (cons 12 13) y (cons 14 15)] (set-cdr! x y) x)", "(12 14 . 15)\n"},
+		{"(let [x (cons 1 2)] (set-car! x true) (set-cdr! x ()) x)", "(true)\n"},
+	};
+	run_tests(data, sizeof(data)/sizeof(data[0]));
+}
+
+void test_fn(void) {
+	test_data data[] = {
+		{"(fn [] 12)", "#<fn>\n"},
+		{"(fn? (fn [] 12))", "true\n"},
+		{"((fn [x] (fx+ x 1)) 41)", "42\n"},
+		{"(let [y 12] (let [f (fn [x] (fx+ y x))] (fx+ (f 10) (f 0))))", "34\n"},
+		{"((fn [f x] (f (f x))) (fn [y] (fx* y y)) 3)", "81\n"},
+		{"(let [a 1 b 2 c 3] ((fn [] ((fn [] (fx+ a (fx+ b c)))))))", "6\n"},
+		{"((fn fact [n] (if (fxzero? n) 1 (fx* n (fact (fxsub1 n))))) 10)", "3628800\n"},
+	};
+	run_tests(data, sizeof(data)/sizeof(data[0]));
+}
+
+void test_tail_calls(void) {
+	test_data data[] = {
+		{"((fn f [n acc] (if (fxzero? n) acc (f (fxsub1 n) (fx+ acc n)))) 1000000 0)", "500000500000\n"},
+		{"((fn [n] (if (fxzero? n) 0 (recur (fxsub1 n)))) 1000000)", "0\n"},
+		{"(loop [i 0 acc 0] (if (fx= i 1000) acc (recur (fxadd1 i) (fx+ acc i))))", "499500\n"},
+		{"(fx+ 1 (loop [i 0] (if (fx< i 10) (recur (fxadd1 i)) i)))", "11\n"},
+	};
+	run_tests(data, sizeof(data)/sizeof(data[0]));
+}
+
+void test_jit(void) {
+	struct {
+		char *input;
+		long arg;
+		char *expected;
+	} data[] = {
+		{"(fn [x] (fx+ x 1))", 41, "42"},
+		{"(fn fact [n] (if (fxzero? n) 1 (fx* n (fact (fxsub1 n)))))", 10, "3628800"},
+		{"(fn [n] (loop [i 0 acc 0] (if (fx= i n) acc (recur (fxadd1 i) (fx+ acc i)))))", 1000, "499500"},
+		{"(fn f [n] (if (fxzero? n) true (f (fxsub1 n))))", 1000000, "true"},
+		{"(fn [n] (let [x (fx* n n)] (fx< x 100)))", 12, "false"},
+		{"(fn [n] (fixnum->char (fx+ n 65)))", 1, "B"},
+	};
+	char err[256] = "";
+
+	for(size_t i = 0; i < sizeof(data)/sizeof(data[0]); i++) {
+		LineNumberReader *stream = MemOpenLineNumberReader(data[i].input, strlen(data[i].input));
+		const lisp_object *form = read(stream, false, '\0');
+		closeLineNumberReader(stream);
+		const IFn *f = JitFn(form, NULL);
+		TEST_ASSERT_MESSAGE(f != NULL, msg(err, 256, "Unable to jit %s.", data[i].input));
+		const lisp_object *ret = f->obj.fns->IFnFns->invoke1(f, (lisp_object*)NewInteger(data[i].arg));
+		TEST_ASSERT_EQUAL_STRING_MESSAGE(data[i].expected, toString(ret), data[i].input);
+	}
+
+	char *unsupported[] = {
+		"(fn [x] (cons x x))",
+		"(fn [x] (fn [] x))",
+		"(fn [x] (foo x))",
+	};
+	for(size_t i = 0; i < sizeof(unsupported)/sizeof(unsupported[0]); i++) {
+		LineNumberReader *stream = MemOpenLineNumberReader(unsupported[i], strlen(unsupported[i]));
+		const lisp_object *form = read(stream, false, '\0');
+		closeLineNumberReader(stream);
+		TEST_ASSERT_MESSAGE(JitFn(form, NULL) == NULL, msg(err, 256, "Expected %s not to jit.", unsupported[i]));
+	}
+}
+
+static volatile sig_atomic_t ticks;
+
+static void onTick(__attribute__((unused)) int sig) {
+	ticks++;
+}
+
+void test_jit_frame(void) {
+	// The locals go deeper than the red zone, so they only survive the signal handlers if they are inside the frame.
+	char *input = "(fn [n] (loop [i 0 acc 0] (if (fx= i n) acc "
+		"(let [a 1 b 2 c 3 d 4 e 5 f 6 g 7 h 8 j 9 k 10 l 11 m 12 o 13 p 14 q 15 r 16] "
+		"(recur (fxadd1 i) (fx+ acc (fx+ a (fx+ b (fx+ c (fx+ d (fx+ e (fx+ f (fx+ g (fx+ h (fx+ j (fx+ k (fx+ l (fx+ m (fx+ o (fx+ p (fx+ q r)))))))))))))))))))))";
+	LineNumberReader *stream = MemOpenLineNumberReader(input, strlen(input));
+	const lisp_object *form = read(stream, false, '\0');
+	closeLineNumberReader(stream);
+	const IFn *f = JitFn(form, NULL);
+	TEST_ASSERT_NOT_NULL(f);
+
+	struct sigaction sa, old;
+	memset(&sa, 0, sizeof(sa));
+	sa.sa_handler = onTick;
+	sigaction(SIGALRM, &sa, &old);
+	struct itimerval on = {{0, 20}, {0, 20}}, off = {{0, 0}, {0, 0}};
+	ticks = 0;
+	setitimer(ITIMER_REAL, &on, NULL);
+	const lisp_object *ret = f->obj.fns->IFnFns->invoke1(f, (lisp_object*)NewInteger(1000000));
+	setitimer(ITIMER_REAL, &off, NULL);
+	sigaction(SIGALRM, &old, NULL);
+	TEST_ASSERT_MESSAGE(ticks > 0, "The timer never fired.");
+	TEST_ASSERT_EQUAL_STRING("136000000", toString(ret));
+}
+
+int main(void) {
+	UNITY_BEGIN();
+	RUN_TEST(test_integers);
+	RUN_TEST(test_immediate_constants);
+	RUN_TEST(test_unary_primitives);
+	RUN_TEST(test_if);
+	RUN_TEST(test_binary_primitives);
+	RUN_TEST(test_let);
+	RUN_TEST(test_cons);
+	RUN_TEST(test_do);
+	RUN_TEST(test_fn);
+	RUN_TEST(test_tail_calls);
+	RUN_TEST(test_jit);
+	RUN_TEST(test_jit_frame);
+	return UNITY_END();
+}
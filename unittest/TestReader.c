@@ -3,7 +3,10 @@
 
 #include "unity.h"
 
+#include "ArrayMap.h"
+#include "Error.h"
 #include "gc.h"
+#include "Interfaces.h"
 #include "LineNumberReader.h"
 #include "Reader.h"
 #include "Util.h"
@@ -242,8 +245,13 @@ void test_read_char(void) {
     for(size_t i=0; i<count; i++) {
         test_data *d = &(data[i]);
         LineNumberReader *stream = MemOpenLineNumberReader(d->input, strlen(d->input));
-        const lisp_object *ret = read(stream, false, '\0');
-        const char *result = toString(ret);
+        // An unsupported character raises, and the message is the result.
+        const char *volatile result = NULL;
+        TRY
+            result = toString(read(stream, false, '\0'));
+        EXCEPT(ANY)
+            result = _ctx.id->msg;
+        ENDTRY
         TEST_ASSERT_EQUAL_STRING(d->expected, result);
         closeLineNumberReader(stream);
     }
@@ -334,7 +342,9 @@ void test_read_map(void) {
 		test_data *d = &(data[i]);
 		LineNumberReader *stream = MemOpenLineNumberReader(d->input, strlen(d->input));
 		const lisp_object *ret = read(stream, false, '\0');
-		TEST_ASSERT_MESSAGE(ret->type == HASHMAP_type, msg(err, 256, "Expected Map type.  Got %s.", object_type_string[ret->type]));
+		size_t entries = ret->fns->ICollectionFns->count((ICollection*)ret);
+		object_type expected = entries <= ARRAYMAP_THRESHOLD ? ARRAYMAP_type : HASHMAP_type;
+		TEST_ASSERT_MESSAGE(ret->type == expected, msg(err, 256, "Expected %s.  Got %s.", object_type_string[expected], object_type_string[ret->type]));
 		const char *result = toString(ret);
 		size_t len = strlen(d->expected);
 		char *expected_loc = GC_MALLOC_ATOMIC((len + 1) * sizeof(*expected_loc));
@@ -346,6 +356,39 @@ void test_read_map(void) {
 	}
 }
 
+void test_read_set(void) {
+	test_data data[] = {
+		{ "#{}", ""},
+		{ "#{1}", "1"},
+		{ "#{1 2 3}", "1,2,3"},
+		{ "#{1 2 3 4 5 6 7 8 9 10 11 12 13 14 15 16 17 18 19 20 21 22 23 24 25 26 27 28 29 30 31 32 33 34 35 36 37 38 39 40}",
+			"1,2,3,4,5,6,7,8,9,10,11,12,13,14,15,16,17,18,19,20,21,22,23,24,25,26,27,28,29,30,31,32,33,34,35,36,37,38,39,40"},
+	};
+	size_t count = sizeof(data)/sizeof(data[0]);
+	char err[256] = "";
+
+	for(size_t i=0; i<count; i++) {
+		test_data *d = &(data[i]);
+		LineNumberReader *stream = MemOpenLineNumberReader(d->input, strlen(d->input));
+		const lisp_object *ret = read(stream, false, '\0');
+		TEST_ASSERT_MESSAGE(ret->type == HASHSET_type, msg(err, 256, "Expected HASHSET_type.  Got %s.", object_type_string[ret->type]));
+		const ISet *set = (ISet*)ret;
+		size_t len = strlen(d->expected);
+		char *expected_loc = GC_MALLOC_ATOMIC((len + 1) * sizeof(*expected_loc));
+		strncpy(expected_loc, d->expected, len+1);
+		size_t elements = 0;
+		for(char *tok = strtok(expected_loc, ","); tok != NULL; tok = strtok(NULL, ",")) {
+			LineNumberReader *elem = MemOpenLineNumberReader(tok, strlen(tok));
+			const lisp_object *key = read(elem, false, '\0');
+			TEST_ASSERT_MESSAGE(set->obj.fns->ISetFns->contains(set, key), msg(err, 256, "Could not find %s in %s.", tok, toString(ret)));
+			closeLineNumberReader(elem);
+			elements++;
+		}
+		TEST_ASSERT_EQUAL_INT(elements, ret->fns->ICollectionFns->count((ICollection*)ret));
+		closeLineNumberReader(stream);
+	}
+}
+
 int main(void) {
 	UNITY_BEGIN();
 	RUN_TEST(test_read_integer);
@@ -355,5 +398,6 @@ int main(void) {
 	RUN_TEST(test_read_list);
 	RUN_TEST(test_read_vector);
 	RUN_TEST(test_read_map);
+	RUN_TEST(test_read_set);
 	return UNITY_END();
 }
@@ -0,0 +1,159 @@
+#include "unity.h"
+
+#include "gc.h"
+#include "Interfaces.h"
+#include "Numbers.h"
+#include "Set.h"
+#include "Util.h"
+
+void setUp(void) {
+}
+
+void tearDown(void) {
+}
+
+// Keys with a hash of our choosing, equal when their ids are, to build collisions.
+
+typedef struct {
+    lisp_object obj;
+    long id;
+    uint32_t hash;
+} CollidingKey;
+
+static bool EqualsCollidingKey(const lisp_object *x, const lisp_object *y);
+
+static uint32_t HashEqCollidingKey(const lisp_object *obj) {
+    return ((CollidingKey*)obj)->hash;
+}
+
+interfaces CollidingKey_interfaces = {NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, EqualsCollidingKey, HashEqCollidingKey};
+
+static bool EqualsCollidingKey(const lisp_object *x, const lisp_object *y) {
+    return y != NULL && !isImmediate(y) && y->fns == &CollidingKey_interfaces && ((CollidingKey*)x)->id == ((CollidingKey*)y)->id;
+}
+
+static const lisp_object *NewCollidingKey(long id, uint32_t hash) {
+    CollidingKey *ret = GC_MALLOC(sizeof(*ret));
+    ret->obj.type = LISPOBJECT_type;
+    ret->obj.size = sizeof(CollidingKey);
+    ret->obj.fns = &CollidingKey_interfaces;
+    ret->id = id;
+    ret->hash = hash;
+    return (lisp_object*)ret;
+}
+
+// Every key the tests use: integers, keys in two collision groups with one agreeing down to the last level, and nil.
+// Lookups use universe, while y is built from ycopies, whose colliding keys are equal but not identical.
+#define COLLIDING_HASH 0x0badf00du
+#define DEEP_HASH (COLLIDING_HASH ^ (1u << 30))
+#define INTS 1500
+#define UNIVERSE (INTS + 7)
+
+static const lisp_object *universe[UNIVERSE];
+static const lisp_object *ycopies[UNIVERSE];
+
+static void initUniverse(void) {
+    const uint32_t hashes[] = {COLLIDING_HASH, COLLIDING_HASH, COLLIDING_HASH, DEEP_HASH, COLLIDING_HASH ^ 0x1f, COLLIDING_HASH ^ 0x1f};
+    for(size_t i = 0; i < INTS; i++)
+        universe[i] = ycopies[i] = (lisp_object*)NewInteger(i);
+    for(size_t i = INTS; i < UNIVERSE - 1; i++) {
+        universe[i] = NewCollidingKey(i, hashes[i - INTS]);
+        ycopies[i] = NewCollidingKey(i, hashes[i - INTS]);
+    }
+    universe[UNIVERSE - 1] = ycopies[UNIVERSE - 1] = NULL;
+}
+
+// The set of keys[i] for each i in members.
+static const HashSet *setOf(const lisp_object **keys, const bool *members) {
+    static const lisp_object *chosen[UNIVERSE];
+    size_t n = 0;
+    for(size_t i = 0; i < UNIVERSE; i++) {
+        if(members[i])
+            chosen[n++] = keys[i];
+    }
+    return CreateHashSet(n, chosen);
+}
+
+static size_t seqLength(const lisp_object *o) {
+    size_t n = 0;
+    for(const ISeq *s = seq(o); s != NULL; s = s->obj.fns->ISeqFns->next(s))
+        n++;
+    return n;
+}
+
+static void assertSetHolds(const HashSet *hs, const bool *members) {
+    const ISet *set = (ISet*)hs;
+    size_t n = 0;
+    for(size_t i = 0; i < UNIVERSE; i++) {
+        TEST_ASSERT_EQUAL_INT(members[i], set->obj.fns->ISetFns->contains(set, universe[i]));
+        n += members[i];
+    }
+    TEST_ASSERT_EQUAL_INT(n, count((lisp_object*)hs));
+    TEST_ASSERT_EQUAL_INT(n, seqLength((lisp_object*)hs));
+    TEST_ASSERT_MESSAGE(Equiv((lisp_object*)hs, (lisp_object*)setOf(universe, members)), "Not Equiv to the set built from scratch");
+}
+
+// Checks union, intersection and difference both ways round, on x and y holding xs and ys.
+static void checkAlgebra(const HashSet *x, const bool *xs, const HashSet *y, const bool *ys) {
+    static bool expected[UNIVERSE];
+    for(size_t i = 0; i < UNIVERSE; i++)
+        expected[i] = xs[i] || ys[i];
+    assertSetHolds(unionHashSet(x, y), expected);
+    assertSetHolds(unionHashSet(y, x), expected);
+    for(size_t i = 0; i < UNIVERSE; i++)
+        expected[i] = xs[i] && ys[i];
+    assertSetHolds(intersectionHashSet(x, y), expected);
+    assertSetHolds(intersectionHashSet(y, x), expected);
+    for(size_t i = 0; i < UNIVERSE; i++)
+        expected[i] = xs[i] && !ys[i];
+    assertSetHolds(differenceHashSet(x, y), expected);
+    for(size_t i = 0; i < UNIVERSE; i++)
+        expected[i] = ys[i] && !xs[i];
+    assertSetHolds(differenceHashSet(y, x), expected);
+
+    assertSetHolds(unionHashSet(x, EmptyHashSet), xs);
+    assertSetHolds(differenceHashSet(x, EmptyHashSet), xs);
+    TEST_ASSERT_EQUAL_INT(0, count((lisp_object*)intersectionHashSet(EmptyHashSet, x)));
+    TEST_ASSERT_EQUAL_INT(0, count((lisp_object*)differenceHashSet(x, x)));
+}
+
+void test_set_algebra(void) {
+    static bool xs[UNIVERSE];
+    static bool ys[UNIVERSE];
+    initUniverse();
+
+    // Disjoint: x holds the even integers, two colliding keys and nil, and y holds the rest.
+    for(size_t i = 0; i < UNIVERSE; i++) {
+        xs[i] = i < INTS ? i % 2 == 0 : i < INTS + 2 || i == UNIVERSE - 1;
+        ys[i] = !xs[i];
+    }
+    const HashSet *x = setOf(universe, xs);
+    checkAlgebra(x, xs, setOf(ycopies, ys), ys);
+
+    // Identical: the same set, and an equal one built separately.
+    for(size_t i = 0; i < UNIVERSE; i++)
+        ys[i] = xs[i];
+    checkAlgebra(x, xs, x, xs);
+    checkAlgebra(x, xs, setOf(ycopies, ys), ys);
+    TEST_ASSERT_EQUAL_PTR(x, unionHashSet(x, x));
+    TEST_ASSERT_EQUAL_PTR(x, intersectionHashSet(x, x));
+
+    // Shared: y is x with a few keys added and removed, so most of its subtrees are x's.
+    const ISet *s = (ISet*)x;
+    for(size_t i = 0; i < UNIVERSE; i++) {
+        if(!xs[i] && (i % 97 == 1 || i == INTS + 2 || i == INTS + 3)) {
+            ys[i] = true;
+            s = (ISet*)s->obj.fns->ICollectionFns->cons((ICollection*)s, ycopies[i]);
+        } else if(xs[i] && (i % 89 == 0 || i == INTS + 1 || i == UNIVERSE - 1)) {
+            ys[i] = false;
+            s = s->obj.fns->ISetFns->disjoin(s, ycopies[i]);
+        }
+    }
+    checkAlgebra(x, xs, (HashSet*)s, ys);
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_set_algebra);
+    return UNITY_END();
+}
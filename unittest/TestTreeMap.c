@@ -0,0 +1,265 @@
+#include "unity.h"
+
+#include "AFn.h"
+#include "Error.h"
+#include "Interfaces.h"
+#include "MapEntry.h"
+#include "Numbers.h"
+#include "TreeMap.h"
+#include "Util.h"
+
+void setUp(void) {
+}
+
+void tearDown(void) {
+}
+
+// (fn [x y] (compare x y)) and (fn [x y] (compare y x)), counting the comparisons they make.
+
+static size_t comparisons;
+
+static const lisp_object* invokeAscending(__attribute__((unused)) const IFn *self, const lisp_object *x, const lisp_object *y) {
+    comparisons++;
+    return (lisp_object*)NewInteger(Compare(x, y));
+}
+
+static const lisp_object* invokeDescending(__attribute__((unused)) const IFn *self, const lisp_object *x, const lisp_object *y) {
+    comparisons++;
+    return (lisp_object*)NewInteger(Compare(y, x));
+}
+
+const IFn_vtable Ascending_IFn_vtable = {
+    invoke0AFn,      // invoke0
+    invoke1AFn,      // invoke1
+    invokeAscending, // invoke2
+    invoke3AFn,      // invoke3
+    invoke4AFn,      // invoke4
+    invoke5AFn,      // invoke5
+    applyToAFn,      // applyTo
+};
+
+const IFn_vtable Descending_IFn_vtable = {
+    invoke0AFn,       // invoke0
+    invoke1AFn,       // invoke1
+    invokeDescending, // invoke2
+    invoke3AFn,       // invoke3
+    invoke4AFn,       // invoke4
+    invoke5AFn,       // invoke5
+    applyToAFn,       // applyTo
+};
+
+interfaces Ascending_interfaces = {NULL, NULL, NULL, NULL, NULL, &Ascending_IFn_vtable, NULL, NULL, NULL, NULL, NULL, NULL};
+interfaces Descending_interfaces = {NULL, NULL, NULL, NULL, NULL, &Descending_IFn_vtable, NULL, NULL, NULL, NULL, NULL, NULL};
+
+const lisp_object Ascending = {IFN_type, sizeof(lisp_object), NULL, &Ascending_interfaces};
+const lisp_object Descending = {IFN_type, sizeof(lisp_object), NULL, &Descending_interfaces};
+
+// The keys 0, 2, ... 98, each mapped to ten times itself, so that odd bounds are never present.
+#define KEYS 50
+
+static const TreeMap *evenMap(const IFn *comparator) {
+    static const lisp_object *entries[2 * KEYS];
+    for(size_t i = 0; i < KEYS; i++) {
+        entries[2*i] = (lisp_object*)NewInteger(2 * i);
+        entries[2*i+1] = (lisp_object*)NewInteger(20 * i);
+    }
+    return CreateTreeMap(comparator, 2 * KEYS, entries);
+}
+
+static const TreeSet *evenSet(void) {
+    static const lisp_object *keys[KEYS];
+    for(size_t i = 0; i < KEYS; i++)
+        keys[i] = (lisp_object*)NewInteger(2 * i);
+    return CreateTreeSet(NULL, KEYS, keys);
+}
+
+static bool passes(RangeTest test, long key, long bound) {
+    switch(test) {
+        case RANGE_LT: return key < bound;
+        case RANGE_LE: return key <= bound;
+        case RANGE_GT: return key > bound;
+        case RANGE_GE: return key >= bound;
+    }
+    return false;
+}
+
+// Checks that s holds exactly the keys of evenMap or evenSet, in order, that pass every test against its bound.
+static void checkRange(const ISeq *s, bool keysOnly, bool ascending, size_t n, const RangeTest *tests, const long *bounds) {
+    for(size_t i = 0; i < KEYS; i++) {
+        long key = 2 * (long)(ascending ? i : KEYS - 1 - i);
+        bool in = true;
+        for(size_t j = 0; j < n; j++)
+            in = in && passes(tests[j], key, bounds[j]);
+        if(!in)
+            continue;
+        TEST_ASSERT_NOT_NULL(s);
+        const lisp_object *first = s->obj.fns->ISeqFns->first(s);
+        if(keysOnly) {
+            TEST_ASSERT_EQUAL_INT(key, IntegerValue((Integer*)first));
+        } else {
+            TEST_ASSERT_EQUAL_INT(key, IntegerValue((Integer*)((MapEntry*)first)->key));
+            TEST_ASSERT_EQUAL_INT(10 * key, IntegerValue((Integer*)((MapEntry*)first)->val));
+        }
+        s = s->obj.fns->ISeqFns->next(s);
+    }
+    TEST_ASSERT_NULL(s);
+}
+
+static bool raises(const lisp_object *sc, bool ascending, RangeTest startTest, long start, RangeTest endTest, long end) {
+    volatile bool raised = false;
+    TRY
+        if(ascending)
+            subseq2(sc, startTest, (lisp_object*)NewInteger(start), endTest, (lisp_object*)NewInteger(end));
+        else
+            rsubseq2(sc, startTest, (lisp_object*)NewInteger(start), endTest, (lisp_object*)NewInteger(end));
+    EXCEPT(ANY)
+        raised = true;
+    ENDTRY
+    return raised;
+}
+
+void test_rank_nth(void) {
+    // Ranks count the keys below, present or not, and ranks past the end find nothing.
+    const lisp_object *sorted[] = {(lisp_object*)evenMap(NULL), (lisp_object*)evenSet()};
+    const lisp_object *NotFound = (lisp_object*)NewInteger(-1);
+    for(size_t s = 0; s < 2; s++) {
+        const lisp_object *sc = sorted[s];
+        for(long k = -3; k < 2 * KEYS + 3; k++)
+            TEST_ASSERT_EQUAL_INT(k <= 0 ? 0 : k >= 2 * KEYS ? KEYS : (k + 1) / 2, rankSorted(sc, (lisp_object*)NewInteger(k)));
+        for(size_t n = 0; n < KEYS; n++) {
+            const lisp_object *found = nthSorted(sc, n, NotFound);
+            const lisp_object *key = s == 0 ? ((MapEntry*)found)->key : found;
+            TEST_ASSERT_EQUAL_INT(2 * n, IntegerValue((Integer*)key));
+            TEST_ASSERT_EQUAL_INT(n, rankSorted(sc, key));
+        }
+        TEST_ASSERT_EQUAL_PTR(NotFound, nthSorted(sc, KEYS, NotFound));
+        TEST_ASSERT_EQUAL_PTR(NotFound, nthSorted(sc, (size_t)-1, NotFound));
+    }
+    TEST_ASSERT_EQUAL_INT(0, rankSorted((lisp_object*)EmptyTreeMap, (lisp_object*)NewInteger(1)));
+    TEST_ASSERT_EQUAL_PTR(NotFound, nthSorted((lisp_object*)EmptyTreeMap, 0, NotFound));
+    TEST_ASSERT_EQUAL_PTR(NotFound, nthSorted((lisp_object*)EmptyTreeSet, 0, NotFound));
+}
+
+void test_subseq(void) {
+    // Every test against bounds below, between, on and above the keys, ascending and descending, on a map and a set.
+    static const RangeTest allTests[] = {RANGE_LT, RANGE_LE, RANGE_GT, RANGE_GE};
+    static const RangeTest lower[] = {RANGE_GT, RANGE_GE};
+    static const RangeTest upper[] = {RANGE_LT, RANGE_LE};
+    static const long bounds[] = {-5, 0, 1, 2, 37, 38, 97, 98, 99, 200};
+    const size_t nb = sizeof(bounds) / sizeof(bounds[0]);
+    const lisp_object *sorted[] = {(lisp_object*)evenMap(NULL), (lisp_object*)evenSet()};
+
+    for(size_t s = 0; s < 2; s++) {
+        const lisp_object *sc = sorted[s];
+        bool keysOnly = s == 1;
+        for(size_t t = 0; t < 4; t++) {
+            for(size_t b = 0; b < nb; b++) {
+                const lisp_object *bound = (lisp_object*)NewInteger(bounds[b]);
+                checkRange(subseq1(sc, allTests[t], bound), keysOnly, true, 1, &allTests[t], &bounds[b]);
+                checkRange(rsubseq1(sc, allTests[t], bound), keysOnly, false, 1, &allTests[t], &bounds[b]);
+            }
+        }
+        for(size_t lt = 0; lt < 2; lt++) {
+            for(size_t ut = 0; ut < 2; ut++) {
+                for(size_t lb = 0; lb < nb; lb++) {
+                    for(size_t ub = 0; ub < nb; ub++) {
+                        const RangeTest tests[] = {lower[lt], upper[ut]};
+                        const long both[] = {bounds[lb], bounds[ub]};
+                        const lisp_object *lo = (lisp_object*)NewInteger(both[0]);
+                        const lisp_object *hi = (lisp_object*)NewInteger(both[1]);
+                        checkRange(subseq2(sc, tests[0], lo, tests[1], hi), keysOnly, true, 2, tests, both);
+                        checkRange(rsubseq2(sc, tests[1], hi, tests[0], lo), keysOnly, false, 2, tests, both);
+                    }
+                }
+                // The tests must bound the scan in its own order.
+                TEST_ASSERT_MESSAGE(raises(sc, true, upper[ut], 90, lower[lt], 10), "subseq ends reversed");
+                TEST_ASSERT_MESSAGE(raises(sc, false, lower[lt], 10, upper[ut], 90), "rsubseq ends reversed");
+                TEST_ASSERT_MESSAGE(raises(sc, true, lower[lt], 10, lower[ut], 90), "subseq two lower bounds");
+                TEST_ASSERT_MESSAGE(raises(sc, false, upper[lt], 90, upper[ut], 10), "rsubseq two upper bounds");
+            }
+        }
+    }
+    TEST_ASSERT_NULL(subseq1((lisp_object*)EmptyTreeMap, RANGE_GE, (lisp_object*)NewInteger(0)));
+    TEST_ASSERT_NULL(rsubseq2((lisp_object*)EmptyTreeSet, RANGE_LE, (lisp_object*)NewInteger(9), RANGE_GE, (lisp_object*)NewInteger(0)));
+}
+
+void test_comparator(void) {
+    // Under a descending comparator, seqs, ranks and ranges all follow its order rather than the numbers'.
+    const TreeMap *tm = evenMap((IFn*)&Descending);
+    const lisp_object *sc = (lisp_object*)tm;
+    TEST_ASSERT_EQUAL_INT(KEYS, count(sc));
+
+    long expected = 2 * (KEYS - 1);
+    for(const ISeq *s = seq(sc); s != NULL; s = s->obj.fns->ISeqFns->next(s), expected -= 2)
+        TEST_ASSERT_EQUAL_INT(expected, IntegerValue((Integer*)((MapEntry*)s->obj.fns->ISeqFns->first(s))->key));
+    TEST_ASSERT_EQUAL_INT(-2, expected);
+
+    TEST_ASSERT_EQUAL_INT(0, IntegerValue((Integer*)((MapEntry*)nthSorted(sc, KEYS - 1, NULL))->key));
+    TEST_ASSERT_EQUAL_INT(0, rankSorted(sc, (lisp_object*)NewInteger(1000)));
+    TEST_ASSERT_EQUAL_INT(KEYS - 5, rankSorted(sc, (lisp_object*)NewInteger(9)));
+    TEST_ASSERT_EQUAL_INT(KEYS - 5, rankSorted(sc, (lisp_object*)NewInteger(8)));
+
+    // (subseq sc > 9) runs after 9 in the comparator's order: 8, 6, 4, 2, 0.
+    expected = 8;
+    for(const ISeq *s = subseq1(sc, RANGE_GT, (lisp_object*)NewInteger(9)); s != NULL; s = s->obj.fns->ISeqFns->next(s), expected -= 2)
+        TEST_ASSERT_EQUAL_INT(expected, IntegerValue((Integer*)((MapEntry*)s->obj.fns->ISeqFns->first(s))->key));
+    TEST_ASSERT_EQUAL_INT(-2, expected);
+
+    const IMap *m = (IMap*)tm;
+    TEST_ASSERT_EQUAL_INT(200, IntegerValue((Integer*)m->obj.fns->IMapFns->valAt(m, (lisp_object*)NewInteger(20), NULL)));
+    TEST_ASSERT_NULL(m->obj.fns->IMapFns->valAt(m, (lisp_object*)NewInteger(21), NULL));
+}
+
+void test_balance_after_deletions(void) {
+    // Built in ascending order and then cut down from both ends and the middle, the tree stays within the height a
+    // weight balanced tree allows, which a lookup of its deepest key reveals through the comparisons it makes.
+    #define N 10000
+    static const lisp_object *entries[2 * N];
+    for(size_t i = 0; i < N; i++) {
+        entries[2*i] = (lisp_object*)NewInteger(i);
+        entries[2*i+1] = (lisp_object*)NewInteger(i);
+    }
+    const IMap *m = (IMap*)CreateTreeMap((IFn*)&Ascending, 2 * N, entries);
+    for(size_t i = 0; i < N / 2; i++)
+        m = m->obj.fns->IMapFns->without(m, entries[2*i]);
+    for(size_t i = N - 1; i >= 9 * N / 10; i--)
+        m = m->obj.fns->IMapFns->without(m, entries[2*i]);
+    for(size_t i = N / 2; i < 9 * N / 10; i += 3)
+        m = m->obj.fns->IMapFns->without(m, entries[2*i]);
+    m = m->obj.fns->IMapFns->without(m, entries[0]);
+
+    size_t remaining = 0;
+    for(size_t i = N / 2; i < 9 * N / 10; i++)
+        remaining += (i - N / 2) % 3 != 0;
+    TEST_ASSERT_EQUAL_INT(remaining, count((lisp_object*)m));
+
+    // Every subtree of weight w has children of weight at least w / 4, so the height is at most log base 4/3 of n + 1.
+    size_t height = 0;
+    for(size_t w = remaining + 1; w > 1; w = 3 * w / 4)
+        height++;
+    size_t rank = 0;
+    for(size_t i = N / 2; i < 9 * N / 10; i++) {
+        const lisp_object *key = entries[2*i];
+        comparisons = 0;
+        const lisp_object *val = m->obj.fns->IMapFns->valAt(m, key, NULL);
+        TEST_ASSERT_MESSAGE(comparisons <= height + 1, "Tree deeper than balance allows");
+        if((i - N / 2) % 3 == 0) {
+            TEST_ASSERT_NULL(val);
+            continue;
+        }
+        TEST_ASSERT_EQUAL_PTR(entries[2*i+1], val);
+        TEST_ASSERT_EQUAL_INT(rank, rankSorted((lisp_object*)m, key));
+        TEST_ASSERT_EQUAL_PTR(key, ((MapEntry*)nthSorted((lisp_object*)m, rank, NULL))->key);
+        rank++;
+    }
+    #undef N
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_rank_nth);
+    RUN_TEST(test_subseq);
+    RUN_TEST(test_comparator);
+    RUN_TEST(test_balance_after_deletions);
+    return UNITY_END();
+}